@@ -0,0 +1,150 @@
+/**
+ * @file arena.c
+ * @brief Implementacion de la arena de memoria.
+ */
+
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALINEACION _Alignof(max_align_t) ///< Alineacion de cada objeto reservado.
+
+/**
+ * @struct BloqueArena
+ * @brief Bloque de memoria de una arena; los datos siguen a la cabecera.
+ */
+struct BloqueArena {
+    BloqueArena *anterior; ///< Bloque abierto antes que este.
+    size_t capacidad; ///< Bytes de datos del bloque.
+    size_t usado; ///< Bytes de datos ya entregados.
+    _Alignas(ARENA_ALINEACION) unsigned char datos[]; ///< Datos del bloque.
+};
+
+/**
+ * @brief Prepara una arena vacia.
+ *
+ * @param arena Arena a inicializar.
+ * @param tamanoBloque Tamano de cada bloque en bytes (0 para ARENA_TAMANO_BLOQUE).
+ */
+void iniciarArena(Arena *arena, size_t tamanoBloque) {
+    memset(arena, 0, sizeof(*arena));
+    arena->tamanoBloque = tamanoBloque;
+}
+
+/**
+ * @brief Abre un bloque nuevo con al menos la capacidad pedida.
+ *
+ * @param arena Arena.
+ * @param minimo Bytes de datos que debe tener el bloque.
+ */
+static void abrirBloque(Arena *arena, size_t minimo) {
+    size_t capacidad = arena->tamanoBloque ? arena->tamanoBloque : ARENA_TAMANO_BLOQUE;
+    if (capacidad < minimo) {
+        capacidad = minimo;
+    }
+    BloqueArena *bloque = malloc(sizeof(BloqueArena) + capacidad);
+    if (!bloque) {
+        perror("No se pudo reservar un bloque de memoria");
+        exit(EXIT_FAILURE);
+    }
+    bloque->anterior = arena->bloques;
+    bloque->capacidad = capacidad;
+    bloque->usado = 0;
+    arena->bloques = bloque;
+    arena->bytesReservados += sizeof(BloqueArena) + capacidad;
+    arena->numBloques++;
+}
+
+/**
+ * @brief Reserva memoria alineada para cualquier tipo.
+ *
+ * @param arena Arena.
+ * @param bytes Tamano pedido.
+ * @return Memoria sin inicializar, valida hasta reiniciar o liberar la arena.
+ */
+void *reservarArena(Arena *arena, size_t bytes) {
+    size_t tamano = (bytes + ARENA_ALINEACION - 1) & ~(size_t)(ARENA_ALINEACION - 1);
+    if (tamano == 0) {
+        tamano = ARENA_ALINEACION;
+    }
+    BloqueArena *bloque = arena->bloques;
+    if (!bloque || bloque->capacidad - bloque->usado < tamano) {
+        abrirBloque(arena, tamano);
+        bloque = arena->bloques;
+    }
+    void *memoria = bloque->datos + bloque->usado;
+    bloque->usado += tamano;
+    arena->reservas++;
+    arena->bytesUsados += tamano;
+    arena->reservasAcumuladas++;
+    arena->bytesAcumulados += tamano;
+    return memoria;
+}
+
+/**
+ * @brief Copia una cadena en la arena y le agrega el '\0' final.
+ *
+ * @param arena Arena.
+ * @param cadena Cadena (no necesita terminar en '\0').
+ * @param longitud Longitud en bytes.
+ * @return Copia de la cadena.
+ */
+char *copiarCadenaArena(Arena *arena, const char *cadena, size_t longitud) {
+    char *copia = reservarArena(arena, longitud + 1);
+    memcpy(copia, cadena, longitud);
+    copia[longitud] = '\0';
+    return copia;
+}
+
+/**
+ * @brief Descarta todos los objetos de la arena.
+ *
+ * @param arena Arena.
+ */
+void reiniciarArena(Arena *arena) {
+    BloqueArena *actual = arena->bloques;
+    if (!actual) {
+        return;
+    }
+    BloqueArena *bloque = actual->anterior;
+    while (bloque) {
+        BloqueArena *anterior = bloque->anterior;
+        free(bloque);
+        bloque = anterior;
+    }
+    actual->anterior = NULL;
+    actual->usado = 0;
+    arena->reservas = 0;
+    arena->bytesUsados = 0;
+    arena->bytesReservados = sizeof(BloqueArena) + actual->capacidad;
+    arena->numBloques = 1;
+}
+
+/**
+ * @brief Devuelve al sistema todos los bloques de la arena.
+ *
+ * @param arena Arena.
+ */
+void liberarArena(Arena *arena) {
+    reiniciarArena(arena);
+    free(arena->bloques);
+    arena->bloques = NULL;
+    arena->bytesReservados = 0;
+    arena->numBloques = 0;
+}
+
+/**
+ * @brief Suma el uso de una arena a unas estadisticas.
+ *
+ * @param arena Arena.
+ * @param estadisticas Estadisticas a las que se suma el uso.
+ */
+void acumularEstadisticasArena(const Arena *arena, EstadisticasArena *estadisticas) {
+    estadisticas->reservas += arena->reservas;
+    estadisticas->bytesUsados += arena->bytesUsados;
+    estadisticas->bytesReservados += arena->bytesReservados;
+    estadisticas->bloques += arena->numBloques;
+    estadisticas->reservasAcumuladas += arena->reservasAcumuladas;
+    estadisticas->bytesAcumulados += arena->bytesAcumulados;
+}
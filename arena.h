@@ -0,0 +1,113 @@
+/**
+ * @file arena.h
+ * @brief Reserva de memoria por bloques para objetos que se liberan juntos.
+ *
+ * Una arena entrega memoria avanzando un puntero dentro de bloques grandes, sin
+ * cabeceras por objeto. Los objetos no se liberan uno a uno: la arena completa se
+ * vacia con reiniciarArena() o se devuelve al sistema con liberarArena(). Los
+ * objetos reservados seguidos quedan contiguos en memoria.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_TAMANO_BLOQUE (256 * 1024) ///< Tamano por defecto de cada bloque, en bytes.
+
+/**
+ * @struct BloqueArena
+ * @brief Bloque de memoria de una arena; los datos siguen a la cabecera.
+ */
+typedef struct BloqueArena BloqueArena;
+
+/**
+ * @struct Arena
+ * @brief Arena de memoria.
+ *
+ * Una arena con todos sus campos en 0 es valida y usa ARENA_TAMANO_BLOQUE.
+ * No es segura entre hilos: cada hilo que reserve debe usar su propia arena.
+ */
+typedef struct {
+    BloqueArena *bloques; ///< Bloque actual, seguido de los anteriores.
+    size_t tamanoBloque; ///< Tamano de los bloques nuevos (0 para el valor por defecto).
+    long reservas; ///< Objetos reservados desde el ultimo reinicio.
+    size_t bytesUsados; ///< Bytes entregados desde el ultimo reinicio, con relleno de alineacion.
+    size_t bytesReservados; ///< Bytes pedidos al sistema en los bloques vigentes.
+    int numBloques; ///< Bloques vigentes.
+    long reservasAcumuladas; ///< Objetos reservados desde que se inicio la arena.
+    size_t bytesAcumulados; ///< Bytes entregados desde que se inicio la arena.
+} Arena;
+
+/**
+ * @struct EstadisticasArena
+ * @brief Uso de memoria de una o varias arenas.
+ */
+typedef struct {
+    long reservas; ///< Objetos vigentes.
+    size_t bytesUsados; ///< Bytes entregados a los objetos vigentes.
+    size_t bytesReservados; ///< Bytes pedidos al sistema en los bloques vigentes.
+    int bloques; ///< Bloques vigentes.
+    long reservasAcumuladas; ///< Objetos reservados en total, contando los descartados.
+    size_t bytesAcumulados; ///< Bytes entregados en total, contando los descartados.
+} EstadisticasArena;
+
+/**
+ * @brief Prepara una arena vacia.
+ *
+ * @param arena Arena a inicializar.
+ * @param tamanoBloque Tamano de cada bloque en bytes (0 para ARENA_TAMANO_BLOQUE).
+ */
+void iniciarArena(Arena *arena, size_t tamanoBloque);
+
+/**
+ * @brief Reserva memoria alineada para cualquier tipo.
+ *
+ * Si el pedido no cabe en el bloque actual se abre uno nuevo; los pedidos mas
+ * grandes que un bloque reciben un bloque propio. Termina el programa si no hay
+ * memoria.
+ *
+ * @param arena Arena.
+ * @param bytes Tamano pedido.
+ * @return Memoria sin inicializar, valida hasta reiniciar o liberar la arena.
+ */
+void *reservarArena(Arena *arena, size_t bytes);
+
+/**
+ * @brief Copia una cadena en la arena y le agrega el '\0' final.
+ *
+ * @param arena Arena.
+ * @param cadena Cadena (no necesita terminar en '\0').
+ * @param longitud Longitud en bytes.
+ * @return Copia de la cadena.
+ */
+char *copiarCadenaArena(Arena *arena, const char *cadena, size_t longitud);
+
+/**
+ * @brief Descarta todos los objetos de la arena.
+ *
+ * Conserva el bloque actual para las reservas siguientes y devuelve los demas al
+ * sistema. Los contadores acumulados no se reinician.
+ *
+ * @param arena Arena.
+ */
+void reiniciarArena(Arena *arena);
+
+/**
+ * @brief Devuelve al sistema todos los bloques de la arena.
+ *
+ * La arena queda vacia y se puede seguir usando.
+ *
+ * @param arena Arena.
+ */
+void liberarArena(Arena *arena);
+
+/**
+ * @brief Suma el uso de una arena a unas estadisticas.
+ *
+ * @param arena Arena.
+ * @param estadisticas Estadisticas a las que se suma el uso.
+ */
+void acumularEstadisticasArena(const Arena *arena, EstadisticasArena *estadisticas);
+
+#endif
@@ -0,0 +1,498 @@
+/**
+ * @file bench_motor.c
+ * @brief Benchmark de extremo a extremo sobre un directorio de documentos.
+ *
+ * Carga el directorio con cargarArchivosEnIndiceYGrafo() y mide, en este orden:
+ *
+ * - la velocidad de la carga en MB/s y documentos/s;
+ * - la memoria del indice (nodos, postings comprimidos y saltos), la de los
+ *   arreglos CSR/CSC del grafo y el maximo de memoria residente del proceso;
+ * - los enlaces leidos y descartados por la carga, y lo que tardo cada etapa de
+ *   su armado (ver enlaces.h);
+ * - calcularHash() sobre las palabras del indice;
+ * - calcularPageRank(), en total y por iteracion;
+ * - el armado del diccionario ordenado de palabras y lo que ocupa;
+ * - la latencia de consultas booleanas y por relevancia (percentiles 50, 90 y 99),
+ *   primero sin la cache de consultas y despues con la cache ya cargada;
+ * - con el indice posicional, la latencia de frases de dos palabras junto a la
+ *   de "a b" con las mismas palabras ("y_frase"), para ver cuanto cuestan las
+ *   posiciones por encima de la interseccion;
+ * - la latencia de prefijos ("pal*", con la primera mitad de una palabra) y de
+ *   busquedas difusas ("palxbra~1", con un caracter cambiado).
+ *
+ * Las palabras de las consultas se eligen entre las del indice con una
+ * distribucion de Zipf sobre su frecuencia de documento, de modo que las
+ * palabras frecuentes aparecen mas, como en las consultas reales.
+ *
+ * El resultado es un objeto JSON en una sola linea en la salida estandar, para
+ * acumularlo en un archivo y comparar versiones; los mensajes de la carga se
+ * descartan y los errores van a stderr. Si la variable de entorno BENCH_VERSION
+ * esta definida se copia en el campo "version".
+ *
+ * Compilacion desde la raiz del repositorio:
+ *     make bench/bench_motor
+ *
+ * Uso:
+ *     ./bench/bench_motor DIRECTORIO [consultas] [hilos] [posiciones] [memoria_mb]
+ *
+ * Con posiciones distinto de 0 el corpus se carga con el indice posicional.
+ *
+ * Con memoria_mb mayor que 0 el indice se arma en memoria externa (ver
+ * externo.h) con ese limite, en una instantanea de paso en /tmp, y las consultas
+ * corren sobre ella. La ingesta incluye entonces la fusion de las corridas (no el
+ * PageRank que la instantanea necesita), y el objeto "externo" informa las
+ * corridas y el maximo de memoria residente hasta terminar la fusion, antes de
+ * proyectar la instantanea.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "cache.h"
+#include "consulta.h"
+#include "diccionario.h"
+#include "enlaces.h"
+#include "externo.h"
+#include "graph.h"
+#include "index.h"
+#include "ingesta.h"
+#include "snapshot.h"
+
+#define BENCH_K 10 ///< Resultados de las consultas por relevancia.
+#define BENCH_REPETICIONES_HASH 20 ///< Pasadas de calcularHash() sobre las palabras del indice.
+
+/**
+ * @struct PalabraBench
+ * @brief Palabra del indice con su frecuencia de documento.
+ */
+typedef struct {
+    const char *palabra; ///< Palabra (apunta al indice).
+    size_t longitud; ///< Longitud de la palabra.
+    int conteoDocs; ///< Documentos en los que aparece.
+} PalabraBench;
+
+/**
+ * @struct RecorridoBench
+ * @brief Acumulador del recorrido del indice.
+ */
+typedef struct {
+    PalabraBench *palabras; ///< Palabras encontradas.
+    int numPalabras; ///< Palabras usadas.
+    int capacidad; ///< Capacidad reservada.
+    size_t bytesPostings; ///< Suma de los postings comprimidos.
+    size_t bytesSaltos; ///< Suma de los punteros de salto.
+    size_t bytesPosiciones; ///< Suma de las posiciones codificadas.
+} RecorridoBench;
+
+/**
+ * @brief Generador xorshift64* para que las consultas sean reproducibles.
+ *
+ * @param estado Estado del generador; se actualiza.
+ * @return Siguiente valor pseudoaleatorio.
+ */
+static unsigned long long siguienteAleatorio(unsigned long long *estado) {
+    *estado ^= *estado >> 12;
+    *estado ^= *estado << 25;
+    *estado ^= *estado >> 27;
+    return *estado * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ * @brief Devuelve el tiempo monotono actual en segundos.
+ *
+ * @return Segundos desde un origen arbitrario.
+ */
+static double segundosActuales() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Registra una lista del indice en el recorrido.
+ *
+ * @param lista Lista de postings.
+ * @param contexto RecorridoBench.
+ */
+static void visitarLista(const ListaPostings *lista, void *contexto) {
+    RecorridoBench *recorrido = contexto;
+    if (recorrido->numPalabras == recorrido->capacidad) {
+        recorrido->capacidad = recorrido->capacidad ? recorrido->capacidad * 2 : 1024;
+        recorrido->palabras = realloc(recorrido->palabras, recorrido->capacidad * sizeof(PalabraBench));
+        if (!recorrido->palabras) {
+            perror("No se pudo reservar memoria");
+            exit(EXIT_FAILURE);
+        }
+    }
+    PalabraBench *palabra = &recorrido->palabras[recorrido->numPalabras++];
+    palabra->palabra = lista->palabra;
+    palabra->longitud = lista->longitud;
+    palabra->conteoDocs = lista->conteoDocs;
+    recorrido->bytesPostings += lista->bytes;
+    recorrido->bytesSaltos += (size_t)lista->numSaltos * sizeof(SaltoPosting);
+    if (lista->posiciones) {
+        recorrido->bytesPosiciones += lista->bytesPosiciones + (size_t)lista->numSaltos * sizeof(uint32_t);
+    }
+}
+
+/**
+ * @brief Ordena palabras de mayor a menor frecuencia de documento.
+ *
+ * @param a Primera palabra.
+ * @param b Segunda palabra.
+ * @return Negativo si a va antes que b.
+ */
+static int compararFrecuencia(const void *a, const void *b) {
+    const PalabraBench *x = a;
+    const PalabraBench *y = b;
+    if (x->conteoDocs != y->conteoDocs) {
+        return x->conteoDocs > y->conteoDocs ? -1 : 1;
+    }
+    return strcmp(x->palabra, y->palabra);
+}
+
+/**
+ * @brief Compara dos tiempos para qsort.
+ *
+ * @param a Primer tiempo.
+ * @param b Segundo tiempo.
+ * @return Negativo, cero o positivo.
+ */
+static int compararTiempos(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Elige una palabra con probabilidad proporcional a 1 / rango.
+ *
+ * @param recorrido Palabras ordenadas por frecuencia.
+ * @param estado Estado del generador.
+ * @return Palabra elegida.
+ */
+static const char *elegirPalabra(const RecorridoBench *recorrido, unsigned long long *estado) {
+    // Inversa aproximada de la acumulada de Zipf con exponente 1: rango = n^u.
+    double u = (siguienteAleatorio(estado) >> 11) * (1.0 / 9007199254740992.0);
+    int rango = (int)pow(recorrido->numPalabras, u) - 1;
+    if (rango >= recorrido->numPalabras) {
+        rango = recorrido->numPalabras - 1;
+    }
+    return recorrido->palabras[rango < 0 ? 0 : rango].palabra;
+}
+
+/**
+ * @brief Arma una consulta de prefijo y una difusa a partir de una palabra.
+ *
+ * @param palabra Palabra del indice.
+ * @param prefijo Salida: la primera mitad de la palabra (al menos dos bytes) y '*'.
+ * @param difusa Salida: la palabra con el caracter del medio cambiado, y "~1".
+ * @param capacidad Bytes de cada salida.
+ */
+static void armarExpansiones(const char *palabra, char *prefijo, char *difusa, size_t capacidad) {
+    size_t longitud = strlen(palabra);
+    size_t corte = longitud > 4 ? longitud / 2 : (longitud < 2 ? longitud : 2);
+    // Sin cortar un caracter de varios bytes.
+    while (corte < longitud && ((unsigned char)palabra[corte] & 0xC0) == 0x80) {
+        corte++;
+    }
+    snprintf(prefijo, capacidad, "%.*s*", (int)corte, palabra);
+    snprintf(difusa, capacidad, "%s~1", palabra);
+    size_t medio = longitud / 2;
+    if ((unsigned char)difusa[medio] < 0x80) {
+        difusa[medio] = difusa[medio] == 'q' ? 'x' : 'q';
+    }
+}
+
+/**
+ * @brief Escribe los percentiles de una serie de latencias como objeto JSON.
+ *
+ * @param salida Flujo de salida.
+ * @param nombre Nombre del objeto.
+ * @param tiempos Latencias en segundos; se ordenan.
+ * @param n Numero de latencias.
+ */
+static void escribirPercentiles(FILE *salida, const char *nombre, double *tiempos, int n) {
+    qsort(tiempos, n, sizeof(double), compararTiempos);
+    static const int percentiles[3] = {50, 90, 99};
+    double suma = 0.0;
+    for (int i = 0; i < n; i++) {
+        suma += tiempos[i];
+    }
+    fprintf(salida, "\"%s\":{\"consultas\":%d,\"media_us\":%.2f", nombre, n, n ? 1e6 * suma / n : 0.0);
+    for (int p = 0; p < 3; p++) {
+        int i = (int)ceil(percentiles[p] / 100.0 * n) - 1;
+        fprintf(salida, ",\"p%d_us\":%.2f", percentiles[p], n ? 1e6 * tiempos[i < 0 ? 0 : i] : 0.0);
+    }
+    fprintf(salida, ",\"max_us\":%.2f}", n ? 1e6 * tiempos[n - 1] : 0.0);
+}
+
+/**
+ * @brief Mide una pasada de consultas.
+ *
+ * @param consultas Consultas.
+ * @param n Numero de consultas.
+ * @param rankeada 1 para consultas por relevancia, 0 para booleanas.
+ * @param tiempos Salida: latencia de cada consulta en segundos.
+ * @return Suma de los resultados, para que la evaluacion no se descarte.
+ */
+static long medirConsultas(char **consultas, int n, int rankeada, double *tiempos) {
+    ResultadoRanking resultados[BENCH_K];
+    long total = 0;
+    for (int i = 0; i < n; i++) {
+        double inicio = segundosActuales();
+        if (rankeada) {
+            total += ejecutarConsultaRankeada(consultas[i], BENCH_K, resultados);
+        } else {
+            int *documentos = NULL;
+            total += ejecutarConsulta(consultas[i], &documentos);
+            free(documentos);
+        }
+        tiempos[i] = segundosActuales() - inicio;
+    }
+    return total;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Uso: %s DIRECTORIO [consultas] [hilos] [posiciones] [memoria_mb]\n", argv[0]);
+        return 1;
+    }
+    const char *directorio = argv[1];
+    int numConsultas = argc > 2 ? atoi(argv[2]) : 2000;
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    int hilos = argc > 3 ? atoi(argv[3]) : (nucleos > 0 ? (int)nucleos : 1);
+    int posicional = argc > 4 && atoi(argv[4]) != 0;
+    double memoriaExterna = argc > 5 ? atof(argv[5]) : 0.0;
+    if (numConsultas <= 0) {
+        numConsultas = 1;
+    }
+
+    // La salida estandar queda para el JSON; los mensajes de la carga se descartan.
+    FILE *salida = fdopen(dup(STDOUT_FILENO), "w");
+    if (!salida || !freopen("/dev/null", "w", stdout)) {
+        perror("No se pudo preparar la salida");
+        return 1;
+    }
+
+    int numArchivos;
+    char **rutas = listarArchivos(directorio, &numArchivos);
+    if (!rutas) {
+        return 1;
+    }
+    unsigned long long bytesCorpus = 0;
+    for (int i = 0; i < numArchivos; i++) {
+        struct stat info;
+        if (stat(rutas[i], &info) == 0) {
+            bytesCorpus += (unsigned long long)info.st_size;
+        }
+        free(rutas[i]);
+    }
+    free(rutas);
+
+    establecerHilosPageRank(hilos);
+    activarIndicePosicional(posicional);
+    inicializarIndice();
+    inicializarGrafo(0);
+    double inicio = segundosActuales();
+    long rssExterno = 0;
+    if (memoriaExterna > 0.0) {
+        char rutaExterna[64];
+        snprintf(rutaExterna, sizeof(rutaExterna), "/tmp/bench_externo_%d.snap", (int)getpid());
+        cargarArchivosEnCorridas(directorio, hilos, (size_t)(memoriaExterna * 1024 * 1024), rutaExterna);
+        double inicioPageRank = segundosActuales();
+        calcularPageRank(PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES, PAGERANK_TOLERANCIA);
+        inicio += segundosActuales() - inicioPageRank;
+        if (!fusionarCorridas(rutaExterna, 0)) {
+            return 1;
+        }
+        struct rusage usoExterno;
+        getrusage(RUSAGE_SELF, &usoExterno);
+        rssExterno = usoExterno.ru_maxrss;
+        int abierta = abrirSnapshot(rutaExterna, 0);
+        remove(rutaExterna);
+        if (!abierta) {
+            return 1;
+        }
+    } else {
+        cargarArchivosEnIndiceYGrafo(directorio, hilos);
+    }
+    double segundosCarga = segundosActuales() - inicio;
+    int documentos = totalDocumentosCargados();
+
+    RecorridoBench recorrido;
+    memset(&recorrido, 0, sizeof(recorrido));
+    if (memoriaExterna > 0.0) {
+        recorrerSnapshot(visitarLista, &recorrido);
+    } else {
+        recorrerIndice(visitarLista, &recorrido);
+    }
+    if (recorrido.numPalabras == 0) {
+        fprintf(stderr, "El directorio '%s' no tiene palabras indexadas.\n", directorio);
+        return 1;
+    }
+    qsort(recorrido.palabras, recorrido.numPalabras, sizeof(PalabraBench), compararFrecuencia);
+    EstadisticasArena memoriaIndice;
+    obtenerEstadisticasMemoriaIndice(&memoriaIndice);
+    const Grafo *g = obtenerGrafo();
+    size_t bytesGrafo = 2 * ((size_t)g->numDocs + 1) * sizeof(size_t) + 2 * g->numEnlaces * sizeof(int) +
+                        (size_t)g->numDocs * sizeof(double);
+
+    uint64_t mezcla = 0;
+    inicio = segundosActuales();
+    for (int r = 0; r < BENCH_REPETICIONES_HASH; r++) {
+        for (int i = 0; i < recorrido.numPalabras; i++) {
+            mezcla ^= calcularHash(recorrido.palabras[i].palabra, recorrido.palabras[i].longitud);
+        }
+    }
+    double segundosHash = segundosActuales() - inicio;
+    volatile uint64_t sumidero = mezcla; // Evita que el compilador descarte los hashes.
+    (void)sumidero;
+
+    inicio = segundosActuales();
+    int iteraciones = calcularPageRank(PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES, PAGERANK_TOLERANCIA);
+    double segundosPageRank = segundosActuales() - inicio;
+
+    EstadisticasDiccionario diccionario;
+    inicio = segundosActuales();
+    obtenerEstadisticasDiccionario(&diccionario);
+    double segundosDiccionario = segundosActuales() - inicio;
+
+    char **consultas = malloc(numConsultas * sizeof(char *));
+    double *tiempos = malloc(numConsultas * sizeof(double));
+    if (!consultas || !tiempos) {
+        perror("No se pudo reservar memoria");
+        return 1;
+    }
+    unsigned long long estado = 0x2545f4914f6cdd1dULL;
+    for (int i = 0; i < numConsultas; i++) {
+        static const char *const formatos[4] = {"%s", "%s %s", "%s OR %s", "%s -%s"};
+        consultas[i] = malloc(2 * TOKENIZADOR_LARGO_MAXIMO + 8);
+        if (!consultas[i]) {
+            perror("No se pudo reservar memoria");
+            return 1;
+        }
+        const char *a = elegirPalabra(&recorrido, &estado);
+        const char *b = elegirPalabra(&recorrido, &estado);
+        snprintf(consultas[i], 2 * TOKENIZADOR_LARGO_MAXIMO + 8, formatos[i % 4], a, b);
+    }
+    // Pares de palabras como AND y como frase, para comparar las dos evaluaciones.
+    char **pares = posicional ? malloc(2 * numConsultas * sizeof(char *)) : NULL;
+    if (posicional && !pares) {
+        perror("No se pudo reservar memoria");
+        return 1;
+    }
+    for (int i = 0; posicional && i < numConsultas; i++) {
+        pares[i] = malloc(2 * TOKENIZADOR_LARGO_MAXIMO + 8);
+        pares[numConsultas + i] = malloc(2 * TOKENIZADOR_LARGO_MAXIMO + 8);
+        if (!pares[i] || !pares[numConsultas + i]) {
+            perror("No se pudo reservar memoria");
+            return 1;
+        }
+        const char *a = elegirPalabra(&recorrido, &estado);
+        const char *b = elegirPalabra(&recorrido, &estado);
+        snprintf(pares[i], 2 * TOKENIZADOR_LARGO_MAXIMO + 8, "%s %s", a, b);
+        snprintf(pares[numConsultas + i], 2 * TOKENIZADOR_LARGO_MAXIMO + 8, "\"%s %s\"", a, b);
+    }
+
+    // Prefijos y busquedas difusas sobre palabras del indice.
+    char **expandidas = malloc(2 * numConsultas * sizeof(char *));
+    if (!expandidas) {
+        perror("No se pudo reservar memoria");
+        return 1;
+    }
+    for (int i = 0; i < numConsultas; i++) {
+        expandidas[i] = malloc(TOKENIZADOR_LARGO_MAXIMO + 8);
+        expandidas[numConsultas + i] = malloc(TOKENIZADOR_LARGO_MAXIMO + 8);
+        if (!expandidas[i] || !expandidas[numConsultas + i]) {
+            perror("No se pudo reservar memoria");
+            return 1;
+        }
+        armarExpansiones(elegirPalabra(&recorrido, &estado), expandidas[i], expandidas[numConsultas + i],
+                         TOKENIZADOR_LARGO_MAXIMO + 8);
+    }
+
+    fprintf(salida, "{\"benchmark\":\"motor\",\"version\":\"%s\",\"directorio\":\"%s\",\"documentos\":%d,"
+                    "\"bytes\":%llu,\"palabras\":%d,\"hilos\":%d,",
+            getenv("BENCH_VERSION") ? getenv("BENCH_VERSION") : "", directorio, documentos, bytesCorpus,
+            totalPalabrasIndexadas(), hilos);
+    fprintf(salida, "\"ingesta\":{\"segundos\":%.4f,\"mb_s\":%.2f,\"documentos_s\":%.0f},", segundosCarga,
+            bytesCorpus / (1024.0 * 1024.0) / segundosCarga, documentos / segundosCarga);
+    EstadisticasEnlaces enlaces;
+    obtenerEstadisticasEnlaces(&enlaces);
+    fprintf(salida, "\"enlaces\":{\"leidos\":%ld,\"en_grafo\":%ld,\"fuera_de_rango\":%ld,\"nombres_desconocidos\":%ld,"
+                    "\"repetidos\":%ld,\"ms_validar\":%.2f,\"ms_ordenar\":%.2f,\"ms_armar\":%.2f},",
+            enlaces.leidos, enlaces.agregados, enlaces.fueraDeRango, enlaces.nombresDesconocidos, enlaces.repetidos,
+            enlaces.nanosValidar / 1e6, enlaces.nanosOrdenar / 1e6, enlaces.nanosArmar / 1e6);
+    if (memoriaExterna > 0.0) {
+        EstadisticasExterno externo;
+        obtenerEstadisticasExterno(&externo);
+        fprintf(salida, "\"externo\":{\"memoria_mb\":%.1f,\"corridas\":%d,\"bytes_corridas\":%llu,"
+                        "\"palabras_combinadas\":%d,\"pasadas\":%d,\"rss_max_kb\":%ld},",
+                memoriaExterna, externo.corridas, (unsigned long long)externo.bytesCorridas,
+                externo.palabrasCombinadas, externo.pasadas, rssExterno);
+    }
+    struct rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+    fprintf(salida,
+            "\"memoria\":{\"nodos_bytes\":%zu,\"postings_bytes\":%zu,\"saltos_bytes\":%zu,\"posiciones_bytes\":%zu,"
+            "\"grafo_bytes\":%zu,\"rss_max_kb\":%ld},",
+            memoriaIndice.bytesReservados, recorrido.bytesPostings, recorrido.bytesSaltos, recorrido.bytesPosiciones,
+            bytesGrafo, uso.ru_maxrss);
+    fprintf(salida, "\"hash\":{\"palabras_s\":%.0f},",
+            (double)BENCH_REPETICIONES_HASH * recorrido.numPalabras / segundosHash);
+    fprintf(salida, "\"pagerank\":{\"iteraciones\":%d,\"segundos\":%.4f,\"ms_iteracion\":%.3f},", iteraciones,
+            segundosPageRank, 1000.0 * segundosPageRank / (iteraciones ? iteraciones : 1));
+    fprintf(salida, "\"diccionario\":{\"palabras\":%d,\"bytes\":%zu,\"segundos\":%.4f},", diccionario.palabras,
+            diccionario.bytes, segundosDiccionario);
+
+    configurarCacheConsultas(0);
+    fprintf(salida, "\"consultas\":{");
+    long total = medirConsultas(consultas, numConsultas, 0, tiempos);
+    escribirPercentiles(salida, "booleana", tiempos, numConsultas);
+    total += medirConsultas(consultas, numConsultas, 1, tiempos);
+    fputc(',', salida);
+    escribirPercentiles(salida, "relevancia", tiempos, numConsultas);
+    if (posicional) {
+        total += medirConsultas(pares, numConsultas, 0, tiempos);
+        fputc(',', salida);
+        escribirPercentiles(salida, "y_frase", tiempos, numConsultas);
+        total += medirConsultas(pares + numConsultas, numConsultas, 0, tiempos);
+        fputc(',', salida);
+        escribirPercentiles(salida, "frase", tiempos, numConsultas);
+        for (int i = 0; i < 2 * numConsultas; i++) {
+            free(pares[i]);
+        }
+        free(pares);
+    }
+    total += medirConsultas(expandidas, numConsultas, 0, tiempos);
+    fputc(',', salida);
+    escribirPercentiles(salida, "prefijo", tiempos, numConsultas);
+    total += medirConsultas(expandidas + numConsultas, numConsultas, 0, tiempos);
+    fputc(',', salida);
+    escribirPercentiles(salida, "difusa", tiempos, numConsultas);
+    for (int i = 0; i < 2 * numConsultas; i++) {
+        free(expandidas[i]);
+    }
+    free(expandidas);
+    configurarCacheConsultas(CACHE_CONSULTAS_BYTES);
+    medirConsultas(consultas, numConsultas, 1, tiempos);
+    total += medirConsultas(consultas, numConsultas, 1, tiempos);
+    fputc(',', salida);
+    escribirPercentiles(salida, "relevancia_cache", tiempos, numConsultas);
+    fprintf(salida, ",\"resultados\":%ld}}\n", total);
+    fclose(salida);
+
+    for (int i = 0; i < numConsultas; i++) {
+        free(consultas[i]);
+    }
+    free(consultas);
+    free(tiempos);
+    free(recorrido.palabras);
+    return 0;
+}
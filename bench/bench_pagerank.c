@@ -0,0 +1,296 @@
+/**
+ * @file bench_pagerank.c
+ * @brief Benchmark de escalabilidad del calculo de PageRank.
+ *
+ * Genera un grafo sintetico con destinos de distribucion sesgada (pocos documentos
+ * reciben la mayoria de los enlaces) y mide calcularPageRank() con 1 a N hilos,
+ * comparando cada resultado con el de un solo hilo. Luego mide obtenerTopPageRank()
+ * con el ranking sin calcular y ya en cache, reemplaza los enlaces de unos pocos
+ * documentos y compara actualizarPageRank() con un calculo completo. Luego
+ * mide calcularPageRankPorLotes() con un hilo y lotes de 1 a 16 vectores: el
+ * tiempo por vector frente al lote de 1 y al calculo global, y la diferencia de
+ * su primera columna, de teletransporte uniforme, con calcularPageRank(). Por
+ * ultimo repite la actualizacion incremental sobre un grafo con localidad, donde
+ * el residuo de cada cambio queda cerca del documento y se resuelve por empuje.
+ *
+ * Compilacion desde la raiz del repositorio:
+ *     make bench/bench_pagerank
+ *
+ * Uso:
+ *     ./bench/bench_pagerank [documentos] [enlacesPorDocumento] [maxHilos] [documentosCambiados]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "graph.h"
+
+#define VENTANA_LOCAL 100 ///< Distancia maxima entre origen y destino en el grafo con localidad.
+
+/**
+ * @brief Generador xorshift64* para que el grafo sea reproducible.
+ *
+ * @param estado Estado del generador; se actualiza.
+ * @return Siguiente valor pseudoaleatorio.
+ */
+static unsigned long long siguienteAleatorio(unsigned long long *estado) {
+    *estado ^= *estado >> 12;
+    *estado ^= *estado << 25;
+    *estado ^= *estado >> 27;
+    return *estado * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ * @brief Devuelve el tiempo monotono actual en segundos.
+ *
+ * @return Segundos desde un origen arbitrario.
+ */
+static double segundosActuales() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Elige un destino a lo sumo ventana documentos antes o despues del origen.
+ *
+ * @param origen Documento de origen.
+ * @param n Numero de documentos.
+ * @param ventana Distancia maxima.
+ * @param estado Estado del generador.
+ * @return Destino, entre 0 y n - 1.
+ */
+static int destinoCercano(int origen, int n, int ventana, unsigned long long *estado) {
+    long destino = origen + (long)(siguienteAleatorio(estado) % (2 * (unsigned long long)ventana + 1)) - ventana;
+    return (int)((destino % n + n) % n);
+}
+
+/**
+ * @brief Construye un grafo sintetico con destinos sesgados.
+ *
+ * El destino de cada enlace es floor(n * u^3) con u uniforme, lo que concentra los
+ * enlaces en los primeros documentos. Un 10% de los documentos queda sin enlaces
+ * salientes para ejercitar el reparto de masa.
+ *
+ * @param n Numero de documentos.
+ * @param grado Enlaces salientes por documento.
+ */
+static void generarGrafo(int n, int grado) {
+    unsigned long long estado = 0x9e3779b97f4a7c15ULL;
+    inicializarGrafo(n);
+    for (int u = 0; u < n; u++) {
+        if (siguienteAleatorio(&estado) % 10 == 0) {
+            continue;
+        }
+        for (int k = 0; k < grado; k++) {
+            double x = (siguienteAleatorio(&estado) >> 11) * (1.0 / 9007199254740992.0);
+            agregarEnlace(u, (int)(n * x * x * x));
+        }
+    }
+    congelarGrafo();
+}
+
+/**
+ * @brief Construye un grafo sintetico con localidad.
+ *
+ * Cada enlace apunta a un documento a lo sumo ventana posiciones antes o despues
+ * del origen (circularmente), como los enlaces entre paginas de un mismo sitio.
+ * Un 10% de los documentos queda sin enlaces salientes.
+ *
+ * @param n Numero de documentos.
+ * @param grado Enlaces salientes por documento.
+ * @param ventana Distancia maxima entre origen y destino.
+ */
+static void generarGrafoLocal(int n, int grado, int ventana) {
+    unsigned long long estado = 0x9e3779b97f4a7c15ULL;
+    inicializarGrafo(n);
+    for (int u = 0; u < n; u++) {
+        if (siguienteAleatorio(&estado) % 10 == 0) {
+            continue;
+        }
+        for (int k = 0; k < grado; k++) {
+            agregarEnlace(u, destinoCercano(u, n, ventana, &estado));
+        }
+    }
+    congelarGrafo();
+}
+
+/**
+ * @brief Reemplaza enlaces en rondas y compara actualizarPageRank() con un calculo completo.
+ *
+ * Las rondas impares cambian los enlaces de documentos existentes y las pares
+ * agregan documentos nuevos. Al final se compara el vector con el de un calculo
+ * completo, que se mide con el grafo ya congelado y con un cambio pendiente,
+ * porque tambien tiene que congelarlo.
+ *
+ * @param n Numero de documentos; se actualiza con los agregados.
+ * @param grado Enlaces salientes de cada documento cambiado.
+ * @param cambiados Documentos cambiados por ronda.
+ * @param ventana Distancia maxima de los destinos al origen, o 0 para destinos uniformes.
+ * @return 1 si termino, 0 si no hubo memoria.
+ */
+static int medirActualizacion(int *n, int grado, int cambiados, int ventana) {
+    // La primera actualizacion calcula el residuo completo; las siguientes solo lo corrigen.
+    unsigned long long estado = 0x2545f4914f6cdd1dULL;
+    actualizarPageRank(PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES, PAGERANK_TOLERANCIA_INCREMENTAL);
+    printf("%8s %10s %6s %12s %12s\n", "ronda", "ms", "iter", "empujes", "residuo");
+    for (int ronda = 1; ronda <= 4; ronda++) {
+        for (int c = 0; c < cambiados; c++) {
+            int origen = ronda % 2 ? (int)(siguienteAleatorio(&estado) % *n) : (*n)++;
+            int destinos[16];
+            for (int k = 0; k < grado && k < 16; k++) {
+                destinos[k] = ventana ? destinoCercano(origen, *n, ventana, &estado)
+                                      : (int)(siguienteAleatorio(&estado) % *n);
+            }
+            reemplazarEnlacesSalientes(origen, destinos, grado < 16 ? grado : 16);
+        }
+        double inicio = segundosActuales();
+        int iteraciones = actualizarPageRank(PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES,
+                                             PAGERANK_TOLERANCIA_INCREMENTAL);
+        double segundos = segundosActuales() - inicio;
+        printf("%8d %10.3f %6d %12ld %12.2e\n", ronda, 1000.0 * segundos, iteraciones, obtenerEmpujesPageRank(),
+               obtenerResiduoPageRank());
+    }
+
+    double *incremental = malloc(*n * sizeof(double));
+    if (!incremental) {
+        perror("No se pudo reservar memoria");
+        return 0;
+    }
+    for (int i = 0; i < *n; i++) {
+        incremental[i] = obtenerPageRank(i);
+    }
+    double inicio = segundosActuales();
+    int iteraciones = calcularPageRank(PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES, PAGERANK_TOLERANCIA);
+    double segundos = segundosActuales() - inicio;
+    double diferencia = 0.0;
+    for (int i = 0; i < *n; i++) {
+        diferencia += fabs(incremental[i] - obtenerPageRank(i));
+    }
+    free(incremental);
+    // Un cambio pendiente obliga al calculo completo a congelar el grafo, como a la actualizacion.
+    int origen = (int)(siguienteAleatorio(&estado) % *n);
+    int destino = ventana ? destinoCercano(origen, *n, ventana, &estado) : (int)(siguienteAleatorio(&estado) % *n);
+    reemplazarEnlacesSalientes(origen, &destino, 1);
+    inicio = segundosActuales();
+    calcularPageRank(PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES, PAGERANK_TOLERANCIA);
+    double segundosCongelando = segundosActuales() - inicio;
+    printf("Calculo completo: %.3f ms en %d iteraciones (%.3f ms con un cambio pendiente); diferencia L1 con el "
+           "incremental %.2e\n",
+           1000.0 * segundos, iteraciones, 1000.0 * segundosCongelando, diferencia);
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    int grado = argc > 2 ? atoi(argv[2]) : 10;
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    int maxHilos = argc > 3 ? atoi(argv[3]) : (nucleos > 0 ? (int)nucleos : 1);
+
+    printf("Generando grafo: %d documentos, %d enlaces por documento\n", n, grado);
+    generarGrafo(n, grado);
+
+    double *referencia = malloc(n * sizeof(double));
+    if (!referencia) {
+        perror("No se pudo reservar memoria");
+        return 1;
+    }
+
+    printf("%6s %10s %6s %12s %8s %12s\n", "hilos", "segundos", "iter", "ms/iter", "acel.", "dif. max");
+    double tiempoBase = 0.0;
+    for (int hilos = 1;; hilos = hilos * 2 < maxHilos ? hilos * 2 : maxHilos) {
+        establecerHilosPageRank(hilos);
+        double inicio = segundosActuales();
+        int iteraciones = calcularPageRank(PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES, PAGERANK_TOLERANCIA);
+        double segundos = segundosActuales() - inicio;
+
+        double diferencia = 0.0;
+        for (int i = 0; i < n; i++) {
+            if (hilos == 1) {
+                referencia[i] = obtenerPageRank(i);
+            } else if (fabs(obtenerPageRank(i) - referencia[i]) > diferencia) {
+                diferencia = fabs(obtenerPageRank(i) - referencia[i]);
+            }
+        }
+        if (hilos == 1) {
+            tiempoBase = segundos;
+        }
+        printf("%6d %10.3f %6d %12.3f %8.2f %12.2e\n", hilos, segundos, iteraciones,
+               1000.0 * segundos / (iteraciones ? iteraciones : 1), tiempoBase / segundos, diferencia);
+        if (hilos == maxHilos) {
+            break;
+        }
+    }
+    free(referencia);
+
+    ResultadoRanking top[10];
+    double inicio = segundosActuales();
+    obtenerTopPageRank(10, top);
+    double seleccion = segundosActuales() - inicio;
+    inicio = segundosActuales();
+    obtenerTopPageRank(10, top);
+    double cache = segundosActuales() - inicio;
+    printf("Top 10 por PageRank: %.3f ms con seleccion parcial, %.6f ms desde la cache\n",
+           1000.0 * seleccion, 1000.0 * cache);
+
+    int cambiados = argc > 4 ? atoi(argv[4]) : 10;
+    printf("Actualizacion incremental, destinos sesgados:\n");
+    if (!medirActualizacion(&n, grado, cambiados, 0)) {
+        return 1;
+    }
+
+    // Lotes: la columna 0 es uniforme y cada una de las demas tiene como semillas un documento de cada 97.
+    establecerHilosPageRank(1);
+    inicio = segundosActuales();
+    int iteraciones = calcularPageRank(PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES, PAGERANK_TOLERANCIA);
+    double segundosGlobal = (segundosActuales() - inicio) / (iteraciones ? iteraciones : 1);
+    const int lotes[] = {1, 4, 8, 16};
+    double *teletransporte = malloc((size_t)n * 16 * sizeof(double));
+    double *rank = malloc((size_t)n * 16 * sizeof(double));
+    if (!teletransporte || !rank) {
+        perror("No se pudo reservar memoria");
+        return 1;
+    }
+    printf("%6s %10s %6s %14s %10s %12s %12s\n", "lote", "ms", "iter", "ms/iter/vec", "vs. B=1", "vs. global",
+           "dif. max");
+    double porVectorBase = 0.0;
+    for (size_t l = 0; l < sizeof(lotes) / sizeof(lotes[0]); l++) {
+        int B = lotes[l];
+        for (int v = 0; v < n; v++) {
+            teletransporte[(size_t)v * B] = 1.0;
+            for (int b = 1; b < B; b++) {
+                teletransporte[(size_t)v * B + b] = v % 97 == b ? 1.0 : 0.0;
+            }
+        }
+        inicio = segundosActuales();
+        iteraciones = calcularPageRankPorLotes(teletransporte, B, PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES,
+                                               PAGERANK_TOLERANCIA, rank, NULL);
+        double segundos = segundosActuales() - inicio;
+        // Las iteraciones dependen de la columna que converge mas lento: se compara el costo de cada una.
+        double porVector = segundos / (iteraciones ? iteraciones : 1) / B;
+        if (B == 1) {
+            porVectorBase = porVector;
+        }
+        double diferencia = 0.0;
+        for (int v = 0; v < n; v++) {
+            if (fabs(rank[(size_t)v * B] - obtenerPageRank(v)) > diferencia) {
+                diferencia = fabs(rank[(size_t)v * B] - obtenerPageRank(v));
+            }
+        }
+        printf("%6d %10.3f %6d %14.3f %10.2f %12.2f %12.2e\n", B, 1000.0 * segundos, iteraciones, 1000.0 * porVector,
+               porVectorBase / porVector, segundosGlobal / porVector, diferencia);
+    }
+    free(teletransporte);
+    free(rank);
+
+    // Con localidad el residuo de un cambio queda cerca del documento y el empuje no recorre el grafo.
+    printf("Actualizacion incremental, destinos a lo sumo %d documentos del origen:\n", VENTANA_LOCAL);
+    generarGrafoLocal(n, grado, VENTANA_LOCAL);
+    calcularPageRank(PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES, PAGERANK_TOLERANCIA);
+    if (!medirActualizacion(&n, grado, cambiados, VENTANA_LOCAL)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,292 @@
+/**
+ * @file bench_roaring.c
+ * @brief Compara los conjuntos Roaring con los arreglos ordenados de docID.
+ *
+ * Genera pares de conjuntos aleatorios de distintas densidades sobre un universo
+ * de documentos y mide, para cada par:
+ *
+ * - la memoria: 4 bytes por docID en un arreglo frente a bytesConjunto();
+ * - el tiempo de la interseccion, la union y la diferencia: mezcla de arreglos
+ *   ordenados (con busqueda exponencial si uno es mucho mas chico, como los
+ *   cursores de consulta.c) frente a los nucleos de roaring.c.
+ *
+ * Cada resultado Roaring se compara con el de los arreglos.
+ *
+ * Compilacion desde la raiz del repositorio:
+ *     make bench/bench_roaring
+ *
+ * Uso:
+ *     ./bench/bench_roaring [documentos]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "roaring.h"
+
+#define OPERACIONES_POR_MEDICION 20000000L ///< docID de entrada que recorre cada medicion, sumando repeticiones.
+
+/**
+ * @brief Operacion de conjuntos medida.
+ */
+typedef enum {
+    OPERACION_INTERSECCION,
+    OPERACION_UNION,
+    OPERACION_DIFERENCIA,
+} Operacion;
+
+/**
+ * @brief Generador xorshift64* para que los conjuntos sean reproducibles.
+ *
+ * @param estado Estado del generador; se actualiza.
+ * @return Siguiente valor pseudoaleatorio.
+ */
+static unsigned long long siguienteAleatorio(unsigned long long *estado) {
+    *estado ^= *estado >> 12;
+    *estado ^= *estado << 25;
+    *estado ^= *estado >> 27;
+    return *estado * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ * @brief Devuelve el tiempo monotono actual en segundos.
+ *
+ * @return Segundos desde un origen arbitrario.
+ */
+static double segundosActuales() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Reserva memoria o termina el programa.
+ *
+ * @param bytes Bytes a reservar.
+ * @return Memoria reservada.
+ */
+static void *reservar(size_t bytes) {
+    void *p = malloc(bytes ? bytes : 1);
+    if (!p) {
+        perror("No se pudo reservar memoria");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/**
+ * @brief Genera un conjunto ordenado eligiendo cada documento con una probabilidad.
+ *
+ * @param universo Documentos posibles (0 a universo - 1).
+ * @param densidad Probabilidad de cada documento.
+ * @param estado Estado del generador.
+ * @param num Salida: elementos generados.
+ * @return Arreglo ordenado de docID (liberar con free).
+ */
+static int *generarConjunto(int universo, double densidad, unsigned long long *estado, long *num) {
+    int *docs = reservar((size_t)universo * sizeof(int));
+    unsigned long long umbral = (unsigned long long)(densidad * 18446744073709551615.0);
+    *num = 0;
+    for (int d = 0; d < universo; d++) {
+        if (siguienteAleatorio(estado) < umbral) {
+            docs[(*num)++] = d;
+        }
+    }
+    return docs;
+}
+
+/**
+ * @brief Busca con saltos exponenciales el primer elemento mayor o igual al objetivo.
+ *
+ * @param docs Arreglo ordenado.
+ * @param num Elementos del arreglo.
+ * @param desde Posicion desde la que buscar.
+ * @param objetivo Valor buscado.
+ * @return Posicion encontrada, o num si no hay ninguno.
+ */
+static long buscarExponencial(const int *docs, long num, long desde, int objetivo) {
+    long paso = 1;
+    long hasta = desde;
+    while (hasta < num && docs[hasta] < objetivo) {
+        desde = hasta + 1;
+        hasta += paso;
+        paso <<= 1;
+    }
+    if (hasta > num) {
+        hasta = num;
+    }
+    while (desde < hasta) {
+        long medio = desde + (hasta - desde) / 2;
+        if (docs[medio] < objetivo) {
+            desde = medio + 1;
+        } else {
+            hasta = medio;
+        }
+    }
+    return desde;
+}
+
+/**
+ * @brief Combina dos arreglos ordenados.
+ *
+ * @param op Operacion.
+ * @param a Primer arreglo.
+ * @param na Elementos de a.
+ * @param b Segundo arreglo.
+ * @param nb Elementos de b.
+ * @param destino Arreglo de al menos na + nb elementos.
+ * @return Elementos del resultado.
+ */
+static long combinarArreglos(Operacion op, const int *a, long na, const int *b, long nb, int *destino) {
+    long i = 0;
+    long j = 0;
+    long n = 0;
+    if (op == OPERACION_INTERSECCION && (na * 64 < nb || nb * 64 < na)) {
+        const int *chico = na < nb ? a : b;
+        const int *grande = na < nb ? b : a;
+        long nc = na < nb ? na : nb;
+        long ng = na < nb ? nb : na;
+        for (; i < nc && j < ng; i++) {
+            j = buscarExponencial(grande, ng, j, chico[i]);
+            if (j < ng && grande[j] == chico[i]) {
+                destino[n++] = chico[i];
+            }
+        }
+        return n;
+    }
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) {
+            if (op != OPERACION_INTERSECCION) {
+                destino[n++] = a[i];
+            }
+            i++;
+        } else if (a[i] > b[j]) {
+            if (op == OPERACION_UNION) {
+                destino[n++] = b[j];
+            }
+            j++;
+        } else {
+            if (op != OPERACION_DIFERENCIA) {
+                destino[n++] = a[i];
+            }
+            i++;
+            j++;
+        }
+    }
+    if (op != OPERACION_INTERSECCION) {
+        while (i < na) {
+            destino[n++] = a[i++];
+        }
+    }
+    if (op == OPERACION_UNION) {
+        while (j < nb) {
+            destino[n++] = b[j++];
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Combina dos conjuntos Roaring.
+ *
+ * @param op Operacion.
+ * @param a Primer conjunto.
+ * @param b Segundo conjunto.
+ * @return Conjunto nuevo.
+ */
+static ConjuntoRoaring *combinarConjuntos(Operacion op, const ConjuntoRoaring *a, const ConjuntoRoaring *b) {
+    if (op == OPERACION_INTERSECCION) {
+        return intersecarConjuntos(a, b);
+    }
+    return op == OPERACION_UNION ? unirConjuntos(a, b) : restarConjuntos(a, b);
+}
+
+/**
+ * @brief Mide la memoria y las tres operaciones para un par de conjuntos.
+ *
+ * @param universo Documentos posibles.
+ * @param densidadA Densidad del primer conjunto.
+ * @param densidadB Densidad del segundo conjunto.
+ * @param estado Estado del generador.
+ * @return 1 si todos los resultados coinciden, 0 si no.
+ */
+static int medirPar(int universo, double densidadA, double densidadB, unsigned long long *estado) {
+    long na;
+    long nb;
+    int *a = generarConjunto(universo, densidadA, estado, &na);
+    int *b = generarConjunto(universo, densidadB, estado, &nb);
+    ConjuntoRoaring *ra = crearConjuntoDesdeArreglo(a, na);
+    ConjuntoRoaring *rb = crearConjuntoDesdeArreglo(b, nb);
+    int *destino = reservar((size_t)(na + nb) * sizeof(int));
+    int *extraidos = reservar((size_t)(na + nb) * sizeof(int));
+    int correcto = 1;
+
+    char caso[32];
+    snprintf(caso, sizeof(caso), "%g / %g", densidadA, densidadB);
+    printf("%-14s %9ld %9ld %10.1f %10.1f %6.2f", caso, na, nb, (na + nb) * sizeof(int) / 1024.0,
+           (bytesConjunto(ra) + bytesConjunto(rb)) / 1024.0,
+           (double)(na + nb) * sizeof(int) / (double)(bytesConjunto(ra) + bytesConjunto(rb)));
+
+    long repeticiones = OPERACIONES_POR_MEDICION / (na + nb + 1) + 1;
+    for (Operacion op = OPERACION_INTERSECCION; op <= OPERACION_DIFERENCIA; op++) {
+        long n = 0;
+        double inicio = segundosActuales();
+        for (long r = 0; r < repeticiones; r++) {
+            n = combinarArreglos(op, a, na, b, nb, destino);
+        }
+        double segundosArreglo = (segundosActuales() - inicio) / repeticiones;
+
+        ConjuntoRoaring *resultado = NULL;
+        inicio = segundosActuales();
+        for (long r = 0; r < repeticiones; r++) {
+            liberarConjuntoRoaring(resultado);
+            resultado = combinarConjuntos(op, ra, rb);
+        }
+        double segundosRoaring = (segundosActuales() - inicio) / repeticiones;
+
+        long m = extraerConjunto(resultado, extraidos);
+        if (m != n || m != resultado->cardinalidad || memcmp(destino, extraidos, (size_t)n * sizeof(int)) != 0) {
+            correcto = 0;
+        }
+        printf(" %9.1f %9.1f %6.2f", segundosArreglo * 1e6, segundosRoaring * 1e6, segundosArreglo / segundosRoaring);
+        liberarConjuntoRoaring(resultado);
+    }
+    printf("%s\n", correcto ? "" : "  DISTINTOS");
+
+    free(a);
+    free(b);
+    free(destino);
+    free(extraidos);
+    liberarConjuntoRoaring(ra);
+    liberarConjuntoRoaring(rb);
+    return correcto;
+}
+
+int main(int argc, char *argv[]) {
+    int universo = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (universo <= 0) {
+        fprintf(stderr, "Uso: %s [documentos]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    static const double pares[][2] = {
+        {0.001, 0.001}, {0.01, 0.01}, {0.05, 0.05}, {0.2, 0.2}, {0.5, 0.5}, {0.9, 0.9},
+        {0.001, 0.5}, {0.01, 0.2}, {0.05, 0.5},
+    };
+    unsigned long long estado = 0x9e3779b97f4a7c15ULL;
+    int correcto = 1;
+
+    printf("Universo: %d documentos; tiempos en us por operacion (arreglo, roaring, aceleracion)\n", universo);
+    printf("%-14s %9s %9s %10s %10s %6s %9s %9s %6s %9s %9s %6s %9s %9s %6s\n", "densidades", "docs A", "docs B",
+           "KB arreglo", "KB roaring", "x", "AND arr", "AND roa", "x", "OR arr", "OR roa", "x", "NOT arr", "NOT roa",
+           "x");
+    for (size_t i = 0; i < sizeof(pares) / sizeof(pares[0]); i++) {
+        correcto &= medirPar(universo, pares[i][0], pares[i][1], &estado);
+    }
+    if (!correcto) {
+        fprintf(stderr, "Los resultados Roaring no coinciden con los de los arreglos.\n");
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file bench_tokenizador.c
+ * @brief Mide el rendimiento del tokenizador frente a las lecturas anteriores.
+ *
+ * Genera un texto sintetico en castellano con mayusculas, acentos y signos de
+ * puntuacion, y mide en MB/s tres formas de separarlo en palabras normalizadas
+ * y descartar las stopwords:
+ *
+ * - fscanf("%99s") con tolower y una busqueda lineal de stopwords (la carga original);
+ * - un recorrido con isspace y tolower sobre el texto en memoria (la carga con mmap);
+ * - siguienteToken() con esStopword().
+ *
+ * Compilacion desde la raiz del repositorio:
+ *     make bench/bench_tokenizador
+ *
+ * Uso:
+ *     ./bench/bench_tokenizador [megabytes]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "tokenizador.h"
+
+/**
+ * @brief Generador xorshift64* para que el texto sea reproducible.
+ *
+ * @param estado Estado del generador; se actualiza.
+ * @return Siguiente valor pseudoaleatorio.
+ */
+static unsigned long long siguienteAleatorio(unsigned long long *estado) {
+    *estado ^= *estado >> 12;
+    *estado ^= *estado << 25;
+    *estado ^= *estado >> 27;
+    return *estado * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ * @brief Devuelve el tiempo monotono actual en segundos.
+ *
+ * @return Segundos desde un origen arbitrario.
+ */
+static double segundosActuales() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Stopwords con la busqueda lineal de la version original.
+ *
+ * @param palabra Palabra en minusculas.
+ * @return 1 si es una stopword.
+ */
+static int esStopwordLineal(const char *palabra) {
+    const char *stopwords[] = {"el", "la", "los", "las", "un", "una", "de", "y", "en", "que", NULL};
+    for (int i = 0; stopwords[i]; i++) {
+        if (strcmp(stopwords[i], palabra) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Genera texto con palabras de frecuencia sesgada y algo de puntuacion.
+ *
+ * @param bytes Tamano aproximado del texto.
+ * @param longitud Salida: tamano real.
+ * @return Texto terminado en '\0'.
+ */
+static char *generarTexto(size_t bytes, size_t *longitud) {
+    static const char *const palabras[] = {
+        "el", "la", "de", "que", "y", "en", "los", "las", "un", "una", "Motor", "búsqueda", "índice",
+        "documento", "canción", "árbol", "niño", "año", "información", "RÁPIDO", "pingüino", "estructura",
+        "datos", "grafo", "enlace", "consulta", "PageRank", "memoria", "tokenizador", "normalización",
+        "programación", "algoritmo", "eficiente", "también", "después", "está", "según", "código", "fuente",
+        "hash", "tabla", "lista", "compresión", "velocidad", "rendimiento", "Capítulo", "sección", "página",
+    };
+    static const char *const separadores[] = {" ", " ", " ", " ", " ", ", ", ". ", "\n", "; ", " (", ") ", " ¿", "? "};
+    int numPalabras = (int)(sizeof(palabras) / sizeof(palabras[0]));
+    int numSeparadores = (int)(sizeof(separadores) / sizeof(separadores[0]));
+    char *texto = malloc(bytes + 64);
+    if (!texto) {
+        perror("No se pudo reservar memoria");
+        exit(EXIT_FAILURE);
+    }
+    unsigned long long estado = 0x9e3779b97f4a7c15ULL;
+    size_t n = 0;
+    while (n < bytes) {
+        double u = (siguienteAleatorio(&estado) >> 11) * (1.0 / 9007199254740992.0);
+        const char *palabra = palabras[(int)(numPalabras * u * u)];
+        const char *separador = separadores[siguienteAleatorio(&estado) % numSeparadores];
+        size_t lp = strlen(palabra);
+        size_t ls = strlen(separador);
+        if (n + lp + ls > bytes + 63) {
+            break;
+        }
+        memcpy(texto + n, palabra, lp);
+        n += lp;
+        memcpy(texto + n, separador, ls);
+        n += ls;
+    }
+    texto[n] = '\0';
+    *longitud = n;
+    return texto;
+}
+
+/**
+ * @brief Lectura original: fscanf sobre el archivo, tolower y stopwords lineales.
+ *
+ * @param texto Texto.
+ * @param longitud Longitud del texto.
+ * @param suma Salida: suma de control de las palabras indexadas.
+ * @return Palabras que no son stopwords.
+ */
+static long leerConFscanf(char *texto, size_t longitud, unsigned long *suma) {
+    FILE *archivo = fmemopen(texto, longitud, "r");
+    if (!archivo) {
+        perror("fmemopen");
+        exit(EXIT_FAILURE);
+    }
+    char palabra[100];
+    long palabras = 0;
+    while (fscanf(archivo, "%99s", palabra) == 1) {
+        for (char *c = palabra; *c; c++) {
+            *c = (char)tolower((unsigned char)*c);
+        }
+        if (!esStopwordLineal(palabra)) {
+            palabras++;
+            *suma += (unsigned char)palabra[0];
+        }
+    }
+    fclose(archivo);
+    return palabras;
+}
+
+/**
+ * @brief Lectura con mmap anterior: isspace, tolower y stopwords lineales.
+ *
+ * @param texto Texto.
+ * @param longitud Longitud del texto.
+ * @param suma Salida: suma de control de las palabras indexadas.
+ * @return Palabras que no son stopwords.
+ */
+static long leerConIsspace(const char *texto, size_t longitud, unsigned long *suma) {
+    const char *p = texto;
+    const char *fin = texto + longitud;
+    char palabra[100];
+    long palabras = 0;
+    while (p < fin) {
+        while (p < fin && isspace((unsigned char)*p)) {
+            p++;
+        }
+        const char *inicio = p;
+        while (p < fin && !isspace((unsigned char)*p) && p - inicio < 99) {
+            p++;
+        }
+        size_t largo = (size_t)(p - inicio);
+        if (largo == 0) {
+            continue;
+        }
+        for (size_t i = 0; i < largo; i++) {
+            palabra[i] = (char)tolower((unsigned char)inicio[i]);
+        }
+        palabra[largo] = '\0';
+        if (!esStopwordLineal(palabra)) {
+            palabras++;
+            *suma += (unsigned char)palabra[0];
+        }
+    }
+    return palabras;
+}
+
+/**
+ * @brief Lectura con el tokenizador.
+ *
+ * @param texto Texto.
+ * @param longitud Longitud del texto.
+ * @param suma Salida: suma de control de las palabras indexadas.
+ * @return Palabras que no son stopwords.
+ */
+static long leerConTokenizador(const char *texto, size_t longitud, unsigned long *suma) {
+    Tokenizador t;
+    char palabra[TOKENIZADOR_LARGO_MAXIMO + 1];
+    size_t largo;
+    long palabras = 0;
+    iniciarTokenizador(&t, texto, longitud);
+    while ((largo = siguienteToken(&t, palabra)) > 0) {
+        if (!esStopword(palabra, largo)) {
+            palabras++;
+            *suma += (unsigned char)palabra[0];
+        }
+    }
+    return palabras;
+}
+
+int main(int argc, char *argv[]) {
+    size_t megabytes = argc > 1 ? (size_t)atol(argv[1]) : 64;
+    size_t longitud;
+    char *texto = generarTexto(megabytes << 20, &longitud);
+    printf("Texto sintetico: %.1f MB\n", longitud / 1048576.0);
+    printf("%-28s %10s %10s %12s\n", "lectura", "MB/s", "palabras", "control");
+
+    const char *nombres[] = {"fscanf + tolower + lineal", "isspace + tolower + lineal", "tokenizador"};
+    for (int modo = 0; modo < 3; modo++) {
+        unsigned long suma = 0;
+        long palabras = 0;
+        double inicio = segundosActuales();
+        if (modo == 0) {
+            palabras = leerConFscanf(texto, longitud, &suma);
+        } else if (modo == 1) {
+            palabras = leerConIsspace(texto, longitud, &suma);
+        } else {
+            palabras = leerConTokenizador(texto, longitud, &suma);
+        }
+        double segundos = segundosActuales() - inicio;
+        printf("%-28s %10.1f %10ld %12lu\n", nombres[modo], longitud / 1048576.0 / segundos, palabras, suma);
+    }
+    free(texto);
+    return 0;
+}
@@ -0,0 +1,245 @@
+/**
+ * @file generar_corpus.c
+ * @brief Genera un corpus sintetico de documentos para los benchmarks.
+ *
+ * Escribe DIRECTORIO/dNNNNNNN.txt con palabras inventadas cuya frecuencia sigue
+ * una ley de Zipf (la palabra de rango r aparece con probabilidad proporcional a
+ * 1/r^s) y con tokens "link:N" hacia otros documentos. Los enlaces salientes de
+ * cada documento siguen una ley de potencias (la mayoria tiene pocos, unos pocos
+ * tienen muchos) y los destinos tambien se eligen con Zipf, asi que algunos
+ * documentos reciben la mayor parte de los enlaces. Los nombres tienen el numero
+ * con ceros a la izquierda para que el orden alfabetico coincida con el docID.
+ *
+ * Con la misma semilla el corpus es identico byte a byte.
+ *
+ * Compilacion desde la raiz del repositorio:
+ *     make bench/generar_corpus
+ *
+ * Uso:
+ *     ./bench/generar_corpus DIRECTORIO documentos [palabrasPorDocumento] [vocabulario] [enlacesPorDocumento]
+ *                            [exponenteZipf] [semilla]
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define GRADO_MAXIMO 1000 ///< Enlaces salientes maximos de un documento.
+#define EXPONENTE_GRADO 1.5 ///< Exponente de la cola de la distribucion de enlaces salientes.
+
+/**
+ * @brief Generador xorshift64* para que el corpus sea reproducible.
+ *
+ * @param estado Estado del generador; se actualiza.
+ * @return Siguiente valor pseudoaleatorio.
+ */
+static unsigned long long siguienteAleatorio(unsigned long long *estado) {
+    *estado ^= *estado >> 12;
+    *estado ^= *estado << 25;
+    *estado ^= *estado >> 27;
+    return *estado * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ * @brief Devuelve un numero uniforme en (0, 1).
+ *
+ * @param estado Estado del generador.
+ * @return Valor mayor que 0 y menor que 1.
+ */
+static double uniforme(unsigned long long *estado) {
+    return ((siguienteAleatorio(estado) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Calcula la distribucion acumulada de Zipf sobre n rangos.
+ *
+ * @param n Numero de rangos.
+ * @param s Exponente.
+ * @return Arreglo de n probabilidades acumuladas; la ultima es 1.
+ */
+static double *crearZipf(int n, double s) {
+    double *acumulada = malloc((size_t)n * sizeof(double));
+    if (!acumulada) {
+        perror("No se pudo reservar la distribucion de Zipf");
+        exit(EXIT_FAILURE);
+    }
+    double suma = 0.0;
+    for (int r = 0; r < n; r++) {
+        suma += 1.0 / pow(r + 1, s);
+        acumulada[r] = suma;
+    }
+    for (int r = 0; r < n; r++) {
+        acumulada[r] /= suma;
+    }
+    acumulada[n - 1] = 1.0;
+    return acumulada;
+}
+
+/**
+ * @brief Elige un rango segun una distribucion acumulada.
+ *
+ * @param acumulada Distribucion creada con crearZipf().
+ * @param n Numero de rangos.
+ * @param estado Estado del generador.
+ * @return Rango desde 0.
+ */
+static int muestrearZipf(const double *acumulada, int n, unsigned long long *estado) {
+    double u = uniforme(estado);
+    int bajo = 0;
+    int alto = n - 1;
+    while (bajo < alto) {
+        int medio = bajo + (alto - bajo) / 2;
+        if (acumulada[medio] < u) {
+            bajo = medio + 1;
+        } else {
+            alto = medio;
+        }
+    }
+    return bajo;
+}
+
+/**
+ * @brief Escribe la palabra inventada de un rango.
+ *
+ * Cada rango da una palabra distinta de al menos dos silabas, formada con las
+ * cifras del rango en base 20.
+ *
+ * @param rango Rango de la palabra.
+ * @param palabra Salida; al menos 32 bytes.
+ */
+static void escribirPalabra(int rango, char *palabra) {
+    static const char *const silabas[20] = {"ka", "ze", "vi", "ro", "tu", "ba", "fe", "gi", "jo", "mu",
+                                            "pa", "xe", "ri", "zo", "ku", "la", "ne", "si", "to", "du"};
+    char invertida[32];
+    int largo = 0;
+    unsigned valor = (unsigned)rango + 20;
+    while (valor > 0) {
+        const char *silaba = silabas[valor % 20];
+        invertida[largo++] = silaba[1];
+        invertida[largo++] = silaba[0];
+        valor /= 20;
+    }
+    for (int i = 0; i < largo; i++) {
+        palabra[i] = invertida[largo - 1 - i];
+    }
+    palabra[largo] = '\0';
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr,
+                "Uso: %s DIRECTORIO documentos [palabrasPorDocumento] [vocabulario] [enlacesPorDocumento]"
+                " [exponenteZipf] [semilla]\n",
+                argv[0]);
+        return 1;
+    }
+    const char *directorio = argv[1];
+    int documentos = atoi(argv[2]);
+    int palabrasPorDocumento = argc > 3 ? atoi(argv[3]) : 150;
+    int vocabulario = argc > 4 ? atoi(argv[4]) : 50000;
+    double enlacesPorDocumento = argc > 5 ? atof(argv[5]) : 8.0;
+    double exponente = argc > 6 ? atof(argv[6]) : 1.0;
+    unsigned long long estado = argc > 7 ? strtoull(argv[7], NULL, 10) : 0x9e3779b97f4a7c15ULL;
+    if (documentos <= 0 || palabrasPorDocumento <= 0 || vocabulario <= 0 || enlacesPorDocumento < 0.0) {
+        fprintf(stderr, "Parametros invalidos.\n");
+        return 1;
+    }
+    if (estado == 0) {
+        estado = 1;
+    }
+    if (mkdir(directorio, 0755) != 0 && errno != EEXIST) {
+        perror("No se pudo crear el directorio");
+        return 1;
+    }
+
+    double *zipfPalabras = crearZipf(vocabulario, exponente);
+    double *zipfDestinos = crearZipf(documentos, 1.0);
+    // Permutacion de los destinos, para que los documentos populares no sean siempre los primeros.
+    int *destinos = malloc((size_t)documentos * sizeof(int));
+    char *palabras = malloc((size_t)vocabulario * 32);
+    if (!destinos || !palabras) {
+        perror("No se pudo reservar memoria");
+        return 1;
+    }
+    for (int i = 0; i < documentos; i++) {
+        destinos[i] = i;
+    }
+    for (int i = documentos - 1; i > 0; i--) {
+        int j = (int)(siguienteAleatorio(&estado) % (unsigned long long)(i + 1));
+        int temporal = destinos[i];
+        destinos[i] = destinos[j];
+        destinos[j] = temporal;
+    }
+    for (int r = 0; r < vocabulario; r++) {
+        escribirPalabra(r, palabras + (size_t)r * 32);
+    }
+
+    // Pareto con minimo m y cola EXPONENTE_GRADO: media m * a / (a - 1).
+    double minimoGrado = enlacesPorDocumento * (EXPONENTE_GRADO - 1.0) / EXPONENTE_GRADO;
+    size_t largoRuta = strlen(directorio) + 32;
+    char *ruta = malloc(largoRuta);
+    if (!ruta) {
+        perror("No se pudo reservar memoria");
+        return 1;
+    }
+    unsigned long long bytes = 0;
+    long long enlaces = 0;
+    for (int d = 0; d < documentos; d++) {
+        snprintf(ruta, largoRuta, "%s/d%07d.txt", directorio, d);
+        FILE *archivo = fopen(ruta, "w");
+        if (!archivo) {
+            perror("No se pudo crear un documento");
+            return 1;
+        }
+        int largo = palabrasPorDocumento / 2 + (int)(siguienteAleatorio(&estado) % (unsigned)(palabrasPorDocumento + 1));
+        int grado = (int)(minimoGrado * pow(uniforme(&estado), -1.0 / EXPONENTE_GRADO));
+        if (grado > GRADO_MAXIMO) {
+            grado = GRADO_MAXIMO;
+        }
+        if (documentos == 1) {
+            grado = 0;
+        }
+        int columna = 0;
+        for (int i = 0; i < largo + grado; i++) {
+            // Los enlaces quedan repartidos entre las palabras.
+            int esEnlace = grado > 0 && siguienteAleatorio(&estado) % (unsigned)(largo + grado) < (unsigned)grado;
+            int escritos;
+            if (esEnlace) {
+                int destino = destinos[muestrearZipf(zipfDestinos, documentos, &estado)];
+                if (destino == d) {
+                    destino = (destino + 1) % documentos;
+                }
+                escritos = fprintf(archivo, "%slink:%d", columna ? " " : "", destino);
+                enlaces++;
+            } else {
+                int rango = muestrearZipf(zipfPalabras, vocabulario, &estado);
+                escritos = fprintf(archivo, "%s%s", columna ? " " : "", palabras + (size_t)rango * 32);
+            }
+            columna += escritos;
+            bytes += (unsigned long long)escritos;
+            if (columna > 72) {
+                fputc('\n', archivo);
+                bytes++;
+                columna = 0;
+            }
+        }
+        fputc('\n', archivo);
+        bytes++;
+        if (fclose(archivo) != 0) {
+            perror("No se pudo escribir un documento");
+            return 1;
+        }
+    }
+
+    fprintf(stderr, "Corpus en '%s': %d documentos, %.1f MB, %lld enlaces.\n", directorio, documentos,
+            bytes / (1024.0 * 1024.0), enlaces);
+    free(ruta);
+    free(palabras);
+    free(destinos);
+    free(zipfDestinos);
+    free(zipfPalabras);
+    return 0;
+}
@@ -0,0 +1,287 @@
+/**
+ * @file cache.c
+ * @brief Implementacion de la cache de resultados de consultas.
+ */
+
+#include "cache.h"
+#include "index.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_CUBETAS_INICIALES 256 ///< Cubetas de la tabla hash al guardar la primera entrada.
+#define CACHE_ALINEACION _Alignof(max_align_t) ///< Alineacion del resultado dentro de la entrada.
+
+/**
+ * @struct EntradaCache
+ * @brief Consulta guardada; la clave y el resultado siguen a la cabecera.
+ */
+typedef struct EntradaCache {
+    struct EntradaCache *siguienteCubeta; ///< Siguiente entrada de la misma cubeta.
+    struct EntradaCache *masReciente; ///< Entrada usada justo despues (NULL si es la mas reciente).
+    struct EntradaCache *menosReciente; ///< Entrada usada justo antes (NULL si es la mas antigua).
+    uint64_t hash; ///< Hash de la clave.
+    size_t largoClave; ///< Largo de la clave, sin el '\0'.
+    size_t offsetDatos; ///< Posicion del resultado desde el inicio de la entrada.
+    size_t bytesDatos; ///< Tamano del resultado.
+    size_t bytesEntrada; ///< Bytes que ocupa la entrada completa.
+    char clave[]; ///< Clave terminada en '\0'.
+} EntradaCache;
+
+/**
+ * @struct CacheConsultas
+ * @brief Tabla hash de entradas mas la lista de uso, de la mas reciente a la mas antigua.
+ */
+typedef struct {
+    pthread_mutex_t mutex; ///< Protege todos los campos.
+    EntradaCache **cubetas; ///< Tabla hash encadenada (numCubetas, potencia de dos).
+    size_t numCubetas; ///< Cubetas de la tabla.
+    EntradaCache *masReciente; ///< Cabeza de la lista de uso.
+    EntradaCache *menosReciente; ///< Cola de la lista de uso; la proxima en salir.
+    long generacion; ///< Generacion del indice de las entradas guardadas.
+    EstadisticasCache estadisticas; ///< Contadores.
+} CacheConsultas;
+
+static CacheConsultas cache = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .estadisticas = {.capacidad = CACHE_CONSULTAS_BYTES},
+};
+
+/**
+ * @brief Saca una entrada de la lista de uso.
+ *
+ * @param entrada Entrada.
+ */
+static void desenlazarUso(EntradaCache *entrada) {
+    if (entrada->masReciente) {
+        entrada->masReciente->menosReciente = entrada->menosReciente;
+    } else {
+        cache.masReciente = entrada->menosReciente;
+    }
+    if (entrada->menosReciente) {
+        entrada->menosReciente->masReciente = entrada->masReciente;
+    } else {
+        cache.menosReciente = entrada->masReciente;
+    }
+}
+
+/**
+ * @brief Pone una entrada al frente de la lista de uso.
+ *
+ * @param entrada Entrada que no esta en la lista.
+ */
+static void enlazarUso(EntradaCache *entrada) {
+    entrada->masReciente = NULL;
+    entrada->menosReciente = cache.masReciente;
+    if (cache.masReciente) {
+        cache.masReciente->masReciente = entrada;
+    } else {
+        cache.menosReciente = entrada;
+    }
+    cache.masReciente = entrada;
+}
+
+/**
+ * @brief Devuelve la cubeta en la que esta o estaria una clave.
+ *
+ * @param hash Hash de la clave.
+ * @return Puntero al primer enlace de la cubeta.
+ */
+static EntradaCache **cubetaDe(uint64_t hash) {
+    return &cache.cubetas[hash & (cache.numCubetas - 1)];
+}
+
+/**
+ * @brief Descarta una entrada de la tabla y de la lista de uso.
+ *
+ * @param entrada Entrada.
+ */
+static void descartarEntrada(EntradaCache *entrada) {
+    EntradaCache **enlace = cubetaDe(entrada->hash);
+    while (*enlace != entrada) {
+        enlace = &(*enlace)->siguienteCubeta;
+    }
+    *enlace = entrada->siguienteCubeta;
+    desenlazarUso(entrada);
+    cache.estadisticas.entradas--;
+    cache.estadisticas.bytes -= entrada->bytesEntrada;
+    free(entrada);
+}
+
+/**
+ * @brief Descarta las entradas si la generacion del indice avanzo.
+ *
+ * @param generacion Generacion vista por quien accede.
+ */
+static void revisarGeneracion(long generacion) {
+    if (generacion <= cache.generacion) {
+        return;
+    }
+    cache.estadisticas.invalidadas += cache.estadisticas.entradas;
+    while (cache.menosReciente) {
+        descartarEntrada(cache.menosReciente);
+    }
+    cache.generacion = generacion;
+}
+
+/**
+ * @brief Descarta las entradas mas antiguas hasta que queden a lo sumo tantos bytes.
+ *
+ * @param limite Bytes maximos que pueden quedar.
+ */
+static void liberarHasta(size_t limite) {
+    while (cache.menosReciente && cache.estadisticas.bytes > limite) {
+        descartarEntrada(cache.menosReciente);
+        cache.estadisticas.expulsadas++;
+    }
+}
+
+/**
+ * @brief Duplica las cubetas cuando hay mas entradas que cubetas.
+ */
+static void ampliarCubetas() {
+    size_t numCubetas = cache.numCubetas ? cache.numCubetas * 2 : CACHE_CUBETAS_INICIALES;
+    EntradaCache **cubetas = calloc(numCubetas, sizeof(EntradaCache *));
+    if (!cubetas) {
+        return; // Con cadenas mas largas la cache sigue funcionando.
+    }
+    for (size_t i = 0; i < cache.numCubetas; i++) {
+        EntradaCache *entrada = cache.cubetas[i];
+        while (entrada) {
+            EntradaCache *siguiente = entrada->siguienteCubeta;
+            EntradaCache **cubeta = &cubetas[entrada->hash & (numCubetas - 1)];
+            entrada->siguienteCubeta = *cubeta;
+            *cubeta = entrada;
+            entrada = siguiente;
+        }
+    }
+    free(cache.cubetas);
+    cache.cubetas = cubetas;
+    cache.numCubetas = numCubetas;
+}
+
+/**
+ * @brief Busca una clave en la tabla.
+ *
+ * @param clave Clave.
+ * @param largo Largo de la clave.
+ * @param hash Hash de la clave.
+ * @return Entrada, o NULL si no esta.
+ */
+static EntradaCache *buscarEntrada(const char *clave, size_t largo, uint64_t hash) {
+    if (!cache.numCubetas) {
+        return NULL;
+    }
+    for (EntradaCache *entrada = *cubetaDe(hash); entrada; entrada = entrada->siguienteCubeta) {
+        if (entrada->hash == hash && entrada->largoClave == largo && memcmp(entrada->clave, clave, largo) == 0) {
+            return entrada;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Cambia la capacidad de la cache y descarta lo que no entra.
+ *
+ * @param bytes Capacidad en bytes (0 desactiva la cache).
+ */
+void configurarCacheConsultas(size_t bytes) {
+    pthread_mutex_lock(&cache.mutex);
+    cache.estadisticas.capacidad = bytes;
+    liberarHasta(bytes);
+    pthread_mutex_unlock(&cache.mutex);
+}
+
+/**
+ * @brief Busca el resultado de una consulta.
+ *
+ * @param clave Forma canonica de la consulta.
+ * @param generacion Generacion del indice leida antes de empezar la consulta.
+ * @param bytes Salida: tamano del resultado.
+ * @return Copia del resultado (liberar con free), o NULL si no esta.
+ */
+void *buscarCacheConsultas(const char *clave, long generacion, size_t *bytes) {
+    size_t largo = strlen(clave);
+    uint64_t hash = calcularHash(clave, largo);
+    void *copia = NULL;
+    pthread_mutex_lock(&cache.mutex);
+    if (cache.estadisticas.capacidad > 0) {
+        revisarGeneracion(generacion);
+        EntradaCache *entrada = generacion == cache.generacion ? buscarEntrada(clave, largo, hash) : NULL;
+        if (entrada) {
+            copia = malloc(entrada->bytesDatos ? entrada->bytesDatos : 1);
+        }
+        if (copia) {
+            memcpy(copia, (char *)entrada + entrada->offsetDatos, entrada->bytesDatos);
+            *bytes = entrada->bytesDatos;
+            desenlazarUso(entrada);
+            enlazarUso(entrada);
+            cache.estadisticas.aciertos++;
+        } else {
+            cache.estadisticas.fallos++;
+        }
+    }
+    pthread_mutex_unlock(&cache.mutex);
+    return copia;
+}
+
+/**
+ * @brief Guarda el resultado de una consulta.
+ *
+ * @param clave Forma canonica de la consulta.
+ * @param generacion Generacion del indice leida antes de calcular el resultado.
+ * @param datos Resultado.
+ * @param bytes Tamano del resultado.
+ */
+void guardarCacheConsultas(const char *clave, long generacion, const void *datos, size_t bytes) {
+    size_t largo = strlen(clave);
+    size_t offsetDatos = (sizeof(EntradaCache) + largo + 1 + CACHE_ALINEACION - 1) & ~(CACHE_ALINEACION - 1);
+    size_t bytesEntrada = offsetDatos + bytes;
+    uint64_t hash = calcularHash(clave, largo);
+
+    pthread_mutex_lock(&cache.mutex);
+    revisarGeneracion(generacion);
+    if (generacion != cache.generacion || bytesEntrada > cache.estadisticas.capacidad / CACHE_FRACCION_MAXIMA ||
+        buscarEntrada(clave, largo, hash)) {
+        pthread_mutex_unlock(&cache.mutex);
+        return;
+    }
+    EntradaCache *entrada = malloc(bytesEntrada);
+    if (!entrada) {
+        pthread_mutex_unlock(&cache.mutex);
+        return;
+    }
+    liberarHasta(cache.estadisticas.capacidad - bytesEntrada);
+    if ((size_t)cache.estadisticas.entradas >= cache.numCubetas) {
+        ampliarCubetas();
+    }
+    entrada->hash = hash;
+    entrada->largoClave = largo;
+    entrada->offsetDatos = offsetDatos;
+    entrada->bytesDatos = bytes;
+    entrada->bytesEntrada = bytesEntrada;
+    memcpy(entrada->clave, clave, largo + 1);
+    if (bytes > 0) {
+        memcpy((char *)entrada + offsetDatos, datos, bytes);
+    }
+    EntradaCache **cubeta = cubetaDe(hash);
+    entrada->siguienteCubeta = *cubeta;
+    *cubeta = entrada;
+    enlazarUso(entrada);
+    cache.estadisticas.entradas++;
+    cache.estadisticas.bytes += bytesEntrada;
+    pthread_mutex_unlock(&cache.mutex);
+}
+
+/**
+ * @brief Obtiene los contadores de la cache.
+ *
+ * @param estadisticas Salida.
+ */
+void obtenerEstadisticasCacheConsultas(EstadisticasCache *estadisticas) {
+    pthread_mutex_lock(&cache.mutex);
+    *estadisticas = cache.estadisticas;
+    pthread_mutex_unlock(&cache.mutex);
+}
@@ -0,0 +1,73 @@
+/**
+ * @file cache.h
+ * @brief Cache de resultados de consultas, acotada en bytes y con reemplazo LRU.
+ *
+ * Cada entrada asocia la forma canonica de una consulta con una copia de su
+ * resultado. Las entradas llevan la generacion del indice con la que se
+ * calcularon (ver obtenerGeneracionIndice()); cuando la generacion avanza, la
+ * cache se vacia en el siguiente acceso. Si no hay lugar se descartan las
+ * entradas usadas hace mas tiempo.
+ *
+ * Es segura entre hilos.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+
+#define CACHE_CONSULTAS_BYTES (16u << 20) ///< Capacidad por defecto, en bytes.
+#define CACHE_FRACCION_MAXIMA 16 ///< Un resultado mayor que capacidad / CACHE_FRACCION_MAXIMA no se guarda.
+
+/**
+ * @struct EstadisticasCache
+ * @brief Uso y efectividad de la cache de consultas.
+ */
+typedef struct {
+    long aciertos; ///< Busquedas que encontraron el resultado.
+    long fallos; ///< Busquedas que no lo encontraron.
+    long invalidadas; ///< Entradas descartadas porque cambio la generacion del indice.
+    long expulsadas; ///< Entradas descartadas para hacer lugar.
+    int entradas; ///< Entradas vigentes.
+    size_t bytes; ///< Bytes que ocupan las entradas vigentes.
+    size_t capacidad; ///< Bytes maximos.
+} EstadisticasCache;
+
+/**
+ * @brief Cambia la capacidad de la cache y descarta lo que no entra.
+ *
+ * @param bytes Capacidad en bytes (0 desactiva la cache).
+ */
+void configurarCacheConsultas(size_t bytes);
+
+/**
+ * @brief Busca el resultado de una consulta.
+ *
+ * @param clave Forma canonica de la consulta.
+ * @param generacion Generacion del indice leida antes de empezar la consulta.
+ * @param bytes Salida: tamano del resultado.
+ * @return Copia del resultado (liberar con free), o NULL si no esta.
+ */
+void *buscarCacheConsultas(const char *clave, long generacion, size_t *bytes);
+
+/**
+ * @brief Guarda el resultado de una consulta.
+ *
+ * Se ignora si la generacion ya no es la vigente o si el resultado es demasiado
+ * grande.
+ *
+ * @param clave Forma canonica de la consulta.
+ * @param generacion Generacion del indice leida antes de calcular el resultado.
+ * @param datos Resultado.
+ * @param bytes Tamano del resultado.
+ */
+void guardarCacheConsultas(const char *clave, long generacion, const void *datos, size_t bytes);
+
+/**
+ * @brief Obtiene los contadores de la cache.
+ *
+ * @param estadisticas Salida.
+ */
+void obtenerEstadisticasCacheConsultas(EstadisticasCache *estadisticas);
+
+#endif
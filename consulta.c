@@ -0,0 +1,1600 @@
+/**
+ * @file consulta.c
+ * @brief Implementacion del motor de consultas booleanas.
+ *
+ * Cada clausula se recorre con un cursor: una clausula de una sola palabra usa
+ * directamente el iterador de postings (con sus punteros de salto), y una
+ * clausula OR se materializa como arreglo ordenado de docID y se recorre con
+ * busqueda exponencial. Una frase o cadena NEAR lleva un iterador por palabra:
+ * avanzan por turnos hasta coincidir en un documento, y recien ahi se comparan
+ * las posiciones.
+ *
+ * Si la consulta no tiene frases y alguna palabra es frecuente, se evalua en
+ * cambio de a un conjunto: cada lista aporta su conjunto Roaring y las
+ * clausulas se combinan con interseccion, union y diferencia.
+ */
+
+#include "consulta.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include "cache.h"
+#include "contexto.h"
+#include "diccionario.h"
+#include "graph.h"
+#include "incremental.h"
+#include "ingesta.h"
+#include "instrumentacion.h"
+#include "tokenizador.h"
+
+#define DOC_AGOTADO INT_MAX ///< docID que indica que un cursor no tiene mas documentos.
+#define LARGO_CLAVE_CACHE 512 ///< Bytes maximos de la forma canonica; las consultas mas largas no usan la cache.
+
+static double pesoPageRank = CONSULTA_PESO_PAGERANK; ///< Peso del PageRank en la busqueda por relevancia.
+
+/**
+ * @struct CursorClausula
+ * @brief Recorrido ordenado de los documentos de una clausula.
+ */
+typedef struct {
+    const ClausulaConsulta *clausula; ///< Clausula recorrida.
+    int usaIterador; ///< 1 si recorre una sola lista comprimida, 0 si recorre un arreglo.
+    IteradorPostings it; ///< Iterador de la lista (si usaIterador).
+    int *docs; ///< Union ordenada de las listas (si no usaIterador).
+    int numDocs; ///< Elementos de docs.
+    int pos; ///< Posicion actual en docs.
+    int docID; ///< Documento actual, o DOC_AGOTADO.
+    IteradorPostings *its; ///< Un iterador por palabra de una clausula posicional, o NULL.
+    const UnionPalabra *uniones; ///< Union de cada palabra con la anterior (clausula posicional).
+    const int *distancias; ///< Distancia de cada union (clausula posicional).
+    int masRara; ///< Palabra con menos documentos, que empieza la interseccion.
+    uint32_t *alcanzadas; ///< Posiciones de la ultima palabra que completan la frase hasta ella.
+    uint32_t *candidatas; ///< Posiciones de la palabra que se esta comparando.
+    int capacidadPosiciones; ///< Elementos reservados en alcanzadas y candidatas.
+} CursorClausula;
+
+/**
+ * @struct TerminoRankeado
+ * @brief Estado de una palabra durante la busqueda por relevancia.
+ */
+typedef struct {
+    IteradorPostings it; ///< Iterador de la lista de postings.
+    double idf; ///< Frecuencia inversa de documento de la palabra.
+    double cota; ///< Mayor aporte posible de la palabra al BM25 de un documento.
+    int docID; ///< Documento actual, o DOC_AGOTADO.
+} TerminoRankeado;
+
+/**
+ * @brief Funcion que recibe cada palabra de una consulta que no es stopword.
+ *
+ * @param palabra Palabra normalizada.
+ * @param longitud Longitud de la palabra en bytes.
+ * @param negada 1 si la palabra abre una clausula negada.
+ * @param unionPalabra Forma en que se une a la clausula anterior (si la hay).
+ * @param distancia Distancia de UNION_FRASE y UNION_NEAR, o errores admitidos con EXPANSION_DIFUSA.
+ * @param expansion Palabras del indice que la reemplazan.
+ * @param contexto Datos del llamador.
+ */
+typedef void (*VisitaPalabraConsulta)(const char *palabra, size_t longitud, int negada, UnionPalabra unionPalabra,
+                                      int distancia, ExpansionPalabra expansion, void *contexto);
+
+/**
+ * @brief Reconoce el operador NEAR/k.
+ *
+ * @param texto Fragmento de la consulta.
+ * @param longitud Longitud del fragmento.
+ * @return k, o -1 si el fragmento no es un NEAR.
+ */
+static int leerNear(const char *texto, size_t longitud) {
+    if (longitud < 6 || longitud > 14 || strncmp(texto, "NEAR/", 5) != 0) {
+        return -1;
+    }
+    int distancia = 0;
+    for (size_t i = 5; i < longitud; i++) {
+        if (!isdigit((unsigned char)texto[i])) {
+            return -1;
+        }
+        distancia = distancia * 10 + (texto[i] - '0');
+    }
+    return distancia;
+}
+
+/**
+ * @brief Reconoce el sufijo '*' o '~k' de una palabra de la consulta.
+ *
+ * @param texto Palabra tal como se escribio.
+ * @param longitud Longitud de la palabra; se le descuenta el sufijo.
+ * @param errores Salida: k de '~k', o -1 si se escribio '~' solo.
+ * @return Expansion pedida.
+ */
+static ExpansionPalabra leerExpansion(const char *texto, size_t *longitud, int *errores) {
+    size_t largo = *longitud;
+    if (largo > 1 && texto[largo - 1] == '*') {
+        *longitud = largo - 1;
+        return EXPANSION_PREFIJO;
+    }
+    size_t digitos = 0;
+    while (digitos < largo && digitos < 3 && isdigit((unsigned char)texto[largo - 1 - digitos])) {
+        digitos++;
+    }
+    size_t tilde = largo - 1 - digitos;
+    if (digitos >= largo || tilde == 0 || texto[tilde] != '~') {
+        return EXPANSION_NINGUNA;
+    }
+    *errores = digitos > 0 ? atoi(texto + tilde + 1) : -1;
+    *longitud = tilde;
+    return EXPANSION_DIFUSA;
+}
+
+/**
+ * @brief Cuenta los tokens de un fragmento de la consulta.
+ *
+ * @param texto Fragmento.
+ * @param longitud Longitud del fragmento.
+ * @return Numero de tokens, incluidas las stopwords.
+ */
+static int contarTokens(const char *texto, size_t longitud) {
+    Tokenizador t;
+    char palabra[INGESTA_LARGO_PALABRA + 1];
+    int tokens = 0;
+    iniciarTokenizador(&t, texto, longitud);
+    while (siguienteToken(&t, palabra) > 0) {
+        tokens++;
+    }
+    return tokens;
+}
+
+/**
+ * @brief Separa una consulta en palabras normalizadas y operadores.
+ *
+ * Una palabra con signos, como "e-mail", da varios tokens: el primero recibe el OR
+ * pendiente y los demas se agregan con AND, todos con la misma negacion. Dentro de
+ * una frase, o a la derecha de un NEAR, los tokens siguientes se unen en cambio
+ * con UNION_FRASE y la distancia en tokens desde la palabra anterior, contando
+ * las stopwords. Un sufijo '*' o '~k' se aplica al ultimo token de la palabra,
+ * aunque sea una stopword. Si la palabra a la izquierda de un OR se descarto por
+ * ser stopword, el OR no tiene clausula a la que sumarse y la palabra de la
+ * derecha abre una clausula nueva, en vez de unirse a la anterior. OR no se
+ * combina con palabras negadas ("-a OR b" es un error), porque sumar b a la
+ * clausula de a cambiaria cual palabra se excluye. Informa en stderr los errores
+ * de sintaxis.
+ *
+ * @param consulta Texto de la consulta.
+ * @param visitar Funcion que recibe cada palabra.
+ * @param contexto Datos que se pasan a visitar.
+ * @return 1 si la consulta es valida, 0 si tiene un error de sintaxis.
+ */
+static int recorrerConsulta(const char *consulta, VisitaPalabraConsulta visitar, void *contexto) {
+    int pendienteOr = 0;
+    int pendienteNot = 0;
+    int pendienteNear = -1;
+    int palabras = 0;
+    int clausulaConOr = 0;
+    int clausulaPosicional = 0;
+    int clausulaExpandida = 0;
+    int clausulaNegada = 0;
+    int izquierdaVisitada = 0;
+    int orSinIzquierda = 0;
+    const char *p = consulta;
+
+    while (*p) {
+        while (*p && isspace((unsigned char)*p)) {
+            p++;
+        }
+        const char *inicio = p;
+        while (*p && !isspace((unsigned char)*p)) {
+            p++;
+        }
+        size_t longitud = (size_t)(p - inicio);
+        if (longitud == 0) {
+            break;
+        }
+
+        if (longitud == 3 && strncmp(inicio, "AND", 3) == 0) {
+            continue;
+        }
+        if (longitud == 2 && strncmp(inicio, "OR", 2) == 0) {
+            if (palabras == 0) {
+                fprintf(stderr, "Consulta invalida: OR sin palabra a la izquierda.\n");
+                return 0;
+            }
+            pendienteOr = 1;
+            orSinIzquierda = !izquierdaVisitada;
+            continue;
+        }
+        if (longitud == 3 && strncmp(inicio, "NOT", 3) == 0) {
+            pendienteNot = 1;
+            continue;
+        }
+        int near = leerNear(inicio, longitud);
+        if (near >= 0) {
+            if (palabras == 0) {
+                fprintf(stderr, "Consulta invalida: NEAR sin palabra a la izquierda.\n");
+                return 0;
+            }
+            pendienteNear = near;
+            continue;
+        }
+
+        int negada = pendienteNot;
+        if (*inicio == '-' && longitud > 1) {
+            negada = 1;
+            inicio++;
+            longitud--;
+        }
+        int frase = 0;
+        if (*inicio == '"') {
+            const char *cierre = strchr(inicio + 1, '"');
+            if (!cierre) {
+                fprintf(stderr, "Consulta invalida: comillas sin cerrar.\n");
+                return 0;
+            }
+            frase = 1;
+            inicio++;
+            longitud = (size_t)(cierre - inicio);
+            p = cierre + 1;
+        }
+        int encadenada = frase || pendienteNear >= 0;
+        int errores = 0;
+        ExpansionPalabra expansion = frase ? EXPANSION_NINGUNA : leerExpansion(inicio, &longitud, &errores);
+        if (expansion == EXPANSION_DIFUSA && errores > DICCIONARIO_MAX_ERRORES) {
+            fprintf(stderr, "Consulta invalida: la busqueda difusa admite a lo sumo %d errores.\n",
+                    DICCIONARIO_MAX_ERRORES);
+            return 0;
+        }
+        int ultimoToken = expansion != EXPANSION_NINGUNA ? contarTokens(inicio, longitud) : 0;
+
+        Tokenizador t;
+        char palabra[INGESTA_LARGO_PALABRA + 1];
+        size_t largo;
+        int tokens = 0;
+        int anterior = -1;
+        int visitadas = 0;
+        iniciarTokenizador(&t, inicio, longitud);
+        while ((largo = siguienteToken(&t, palabra)) > 0) {
+            int posicion = tokens++;
+            ExpansionPalabra expansionToken = tokens == ultimoToken ? expansion : EXPANSION_NINGUNA;
+            palabras++;
+            if (expansionToken != EXPANSION_NINGUNA || !esStopword(palabra, largo)) {
+                if (palabras > CONSULTA_MAX_TERMINOS) {
+                    fprintf(stderr, "Consulta invalida: mas de %d palabras.\n", CONSULTA_MAX_TERMINOS);
+                    return 0;
+                }
+                UnionPalabra unionPalabra = UNION_AND;
+                int distancia = 0;
+                if (anterior >= 0 && encadenada) {
+                    unionPalabra = UNION_FRASE;
+                    distancia = posicion - anterior;
+                } else if (anterior < 0 && pendienteNear >= 0) {
+                    unionPalabra = UNION_NEAR;
+                    distancia = pendienteNear;
+                } else if (pendienteOr && !orSinIzquierda) {
+                    unionPalabra = UNION_OR;
+                }
+
+                if (unionPalabra == UNION_OR && (negada || clausulaNegada)) {
+                    fprintf(stderr, "Consulta invalida: no se puede combinar OR con palabras negadas.\n");
+                    return 0;
+                }
+                if ((unionPalabra == UNION_OR && clausulaPosicional) ||
+                    ((unionPalabra == UNION_FRASE || unionPalabra == UNION_NEAR) && clausulaConOr)) {
+                    fprintf(stderr, "Consulta invalida: no se puede combinar OR con frases o NEAR.\n");
+                    return 0;
+                }
+                if ((unionPalabra == UNION_FRASE || unionPalabra == UNION_NEAR) &&
+                    (clausulaExpandida || expansionToken != EXPANSION_NINGUNA)) {
+                    fprintf(stderr, "Consulta invalida: no se puede usar * ni ~ en frases o con NEAR.\n");
+                    return 0;
+                }
+                if ((unionPalabra == UNION_FRASE || unionPalabra == UNION_NEAR) && !indicePosicionalActivado()) {
+                    fprintf(stderr, "Consulta invalida: las frases y NEAR necesitan el indice posicional "
+                                    "(--posiciones).\n");
+                    return 0;
+                }
+                if (unionPalabra == UNION_AND) {
+                    clausulaConOr = 0;
+                    clausulaPosicional = 0;
+                    clausulaExpandida = 0;
+                    clausulaNegada = negada;
+                } else if (unionPalabra == UNION_OR) {
+                    clausulaConOr = 1;
+                } else {
+                    clausulaPosicional = 1;
+                }
+                if (expansionToken == EXPANSION_DIFUSA) {
+                    clausulaExpandida = 1;
+                    distancia = errores >= 0 ? errores : erroresPorDefectoDiccionario(palabra, largo);
+                } else if (expansionToken == EXPANSION_PREFIJO) {
+                    clausulaExpandida = 1;
+                }
+                visitar(palabra, largo, negada, unionPalabra, distancia, expansionToken, contexto);
+                anterior = posicion;
+                pendienteNear = -1;
+                visitadas++;
+            }
+            pendienteOr = 0;
+        }
+        if (tokens > 0) {
+            pendienteNot = 0;
+            pendienteNear = -1;
+            izquierdaVisitada = visitadas > 0;
+        }
+    }
+
+    if (pendienteOr || pendienteNot || pendienteNear >= 0) {
+        fprintf(stderr, "Consulta invalida: operador sin palabra a la derecha.\n");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @struct ExpansionConsulta
+ * @brief Palabras del diccionario que reemplazan a una palabra con '*' o '~'.
+ */
+typedef struct {
+    ListaPostings listas[CONSULTA_MAX_EXPANSIONES]; ///< Listas elegidas, de la mas frecuente a la menos.
+    int numListas; ///< Listas elegidas.
+    int limite; ///< Listas que se pueden elegir.
+} ExpansionConsulta;
+
+/**
+ * @brief Considera una palabra encontrada en el diccionario para la expansion.
+ *
+ * Conserva las que estan en mas documentos, ordenadas de mayor a menor.
+ *
+ * @param palabra Palabra del diccionario.
+ * @param longitud Longitud de la palabra en bytes.
+ * @param contexto ExpansionConsulta.
+ */
+static void considerarExpansion(const char *palabra, size_t longitud, void *contexto) {
+    (void)longitud;
+    ExpansionConsulta *expansion = contexto;
+    ListaPostings lista;
+    if (!buscarPostings(palabra, &lista) || lista.conteoDocs == 0) {
+        return;
+    }
+    int i = expansion->numListas;
+    if (i == expansion->limite) {
+        if (i == 0 || lista.conteoDocs <= expansion->listas[i - 1].conteoDocs) {
+            return;
+        }
+        i--;
+    } else {
+        expansion->numListas++;
+    }
+    while (i > 0 && expansion->listas[i - 1].conteoDocs < lista.conteoDocs) {
+        expansion->listas[i] = expansion->listas[i - 1];
+        i--;
+    }
+    expansion->listas[i] = lista;
+}
+
+/**
+ * @brief Agrega una palabra de la consulta a su clausula y busca su lista de postings.
+ *
+ * Si falta en el indice una palabra de una frase, la clausula queda incompleta:
+ * se descartan sus listas, porque ningun documento puede contener la frase. Una
+ * palabra con expansion agrega en su lugar las listas de las palabras del
+ * diccionario que le corresponden, unidas con OR.
+ *
+ * @param palabra Palabra normalizada.
+ * @param longitud Longitud de la palabra en bytes.
+ * @param negada 1 si la palabra abre una clausula negada.
+ * @param unionPalabra Forma en que se une a la clausula anterior.
+ * @param distancia Distancia de UNION_FRASE y UNION_NEAR, o errores admitidos con EXPANSION_DIFUSA.
+ * @param expansion Palabras del indice que la reemplazan.
+ * @param contexto ConsultaAnalizada en construccion.
+ */
+static void agregarPalabraAnalizada(const char *palabra, size_t longitud, int negada, UnionPalabra unionPalabra,
+                                    int distancia, ExpansionPalabra expansion, void *contexto) {
+    ConsultaAnalizada *analizada = contexto;
+    ClausulaConsulta *clausula;
+    if (unionPalabra != UNION_AND && analizada->numClausulas > 0) {
+        clausula = &analizada->clausulas[analizada->numClausulas - 1];
+    } else {
+        clausula = &analizada->clausulas[analizada->numClausulas++];
+        clausula->primeraLista = analizada->numListas;
+        clausula->numListas = 0;
+        clausula->negada = negada;
+        clausula->frecuencia = 0;
+        clausula->posicional = 0;
+        clausula->incompleta = 0;
+    }
+    if (unionPalabra == UNION_FRASE || unionPalabra == UNION_NEAR) {
+        // Sin la palabra anterior (la primera de una clausula nueva siempre se agrega) ya no hay frase.
+        clausula->posicional = 1;
+        clausula->incompleta |= clausula->numListas == 0;
+    }
+    analizada->palabrasPendientes--;
+    if (clausula->incompleta) {
+        return;
+    }
+    if (expansion != EXPANSION_NINGUNA) {
+        ExpansionConsulta elegidas;
+        elegidas.numListas = 0;
+        elegidas.limite = CONSULTA_MAX_TERMINOS - analizada->numListas - analizada->palabrasPendientes;
+        if (elegidas.limite > CONSULTA_MAX_EXPANSIONES) {
+            elegidas.limite = CONSULTA_MAX_EXPANSIONES;
+        }
+        if (expansion == EXPANSION_PREFIJO) {
+            buscarPrefijoDiccionario(palabra, longitud, considerarExpansion, &elegidas);
+        } else {
+            buscarDifusoDiccionario(palabra, longitud, distancia, considerarExpansion, &elegidas);
+        }
+        for (int i = 0; i < elegidas.numListas; i++) {
+            analizada->listas[analizada->numListas] = elegidas.listas[i];
+            analizada->uniones[analizada->numListas] = i == 0 ? unionPalabra : UNION_OR;
+            analizada->distancias[analizada->numListas] = 0;
+            analizada->numListas++;
+            clausula->numListas++;
+            clausula->frecuencia += elegidas.listas[i].conteoDocs;
+        }
+        return;
+    }
+    ListaPostings *lista = &analizada->listas[analizada->numListas];
+    if (buscarPostings(palabra, lista) && lista->conteoDocs > 0) {
+        analizada->uniones[analizada->numListas] = unionPalabra;
+        analizada->distancias[analizada->numListas] = distancia;
+        analizada->numListas++;
+        clausula->numListas++;
+        if (!clausula->posicional) {
+            clausula->frecuencia += lista->conteoDocs;
+        } else if (lista->conteoDocs < clausula->frecuencia) {
+            clausula->frecuencia = lista->conteoDocs;
+        }
+    } else if (clausula->posicional) {
+        clausula->incompleta = 1;
+        analizada->numListas = clausula->primeraLista;
+        clausula->numListas = 0;
+        clausula->frecuencia = 0;
+    }
+}
+
+/**
+ * @brief Cuenta las palabras de una consulta.
+ *
+ * @param palabra Palabra normalizada.
+ * @param longitud Longitud de la palabra en bytes.
+ * @param negada 1 si la palabra abre una clausula negada.
+ * @param unionPalabra Forma en que se une a la clausula anterior.
+ * @param distancia Distancia de UNION_FRASE y UNION_NEAR, o errores admitidos con EXPANSION_DIFUSA.
+ * @param expansion Palabras del indice que la reemplazan.
+ * @param contexto Contador (int).
+ */
+static void contarPalabraConsulta(const char *palabra, size_t longitud, int negada, UnionPalabra unionPalabra,
+                                  int distancia, ExpansionPalabra expansion, void *contexto) {
+    (void)palabra;
+    (void)longitud;
+    (void)negada;
+    (void)unionPalabra;
+    (void)distancia;
+    (void)expansion;
+    (*(int *)contexto)++;
+}
+
+/**
+ * @brief Separa una consulta en clausulas y busca las listas de postings de cada palabra.
+ *
+ * @param consulta Texto de la consulta.
+ * @param analizada Salida.
+ * @return 1 si la consulta es valida, 0 si tiene un error de sintaxis.
+ */
+int analizarConsulta(const char *consulta, ConsultaAnalizada *analizada) {
+    analizada->numListas = 0;
+    analizada->numClausulas = 0;
+    analizada->palabrasPendientes = 0;
+    if (!recorrerConsulta(consulta, contarPalabraConsulta, &analizada->palabrasPendientes)) {
+        return 0;
+    }
+    return recorrerConsulta(consulta, agregarPalabraAnalizada, analizada);
+}
+
+/**
+ * @struct ClaveConsulta
+ * @brief Forma canonica de una consulta en construccion.
+ */
+typedef struct {
+    char *texto; ///< Clave.
+    size_t capacidad; ///< Bytes disponibles en texto.
+    size_t largo; ///< Bytes escritos, sin el '\0'.
+    int clausulas; ///< Clausulas escritas.
+    int desbordada; ///< 1 si la clave no cupo.
+} ClaveConsulta;
+
+/**
+ * @brief Agrega una palabra a la forma canonica de la consulta.
+ *
+ * Las clausulas se separan con ' ', las palabras de una clausula con '|' y las
+ * clausulas negadas empiezan con '-'. En una frase cada palabra va precedida por
+ * "+distancia+" y en una cadena NEAR por "~distancia~"; como no llevan '|', el
+ * orden de sus palabras se conserva. Una palabra con expansion lleva detras '*'
+ * o '~errores', que el tokenizador nunca deja dentro de una palabra.
+ *
+ * @param palabra Palabra normalizada.
+ * @param longitud Longitud de la palabra en bytes.
+ * @param negada 1 si la palabra abre una clausula negada.
+ * @param unionPalabra Forma en que se une a la clausula anterior.
+ * @param distancia Distancia de UNION_FRASE y UNION_NEAR, o errores admitidos con EXPANSION_DIFUSA.
+ * @param expansion Palabras del indice que la reemplazan.
+ * @param contexto ClaveConsulta en construccion.
+ */
+static void agregarPalabraClave(const char *palabra, size_t longitud, int negada, UnionPalabra unionPalabra,
+                                int distancia, ExpansionPalabra expansion, void *contexto) {
+    ClaveConsulta *clave = contexto;
+    int unir = unionPalabra != UNION_AND && clave->clausulas > 0;
+    char separador[16] = " ";
+    char sufijo[16] = "";
+    if (expansion == EXPANSION_PREFIJO) {
+        sufijo[0] = '*';
+    } else if (expansion == EXPANSION_DIFUSA) {
+        snprintf(sufijo, sizeof(sufijo), "~%d", distancia);
+    }
+    if (unir && unionPalabra == UNION_OR) {
+        separador[0] = '|';
+    } else if (unir) {
+        char marca = unionPalabra == UNION_FRASE ? '+' : '~';
+        snprintf(separador, sizeof(separador), "%c%d%c", marca, distancia, marca);
+    }
+    size_t largoSeparador = strlen(separador);
+    size_t largoSufijo = strlen(sufijo);
+    if (clave->desbordada || clave->largo + largoSeparador + longitud + largoSufijo + 2 > clave->capacidad) {
+        clave->desbordada = 1;
+        return;
+    }
+    memcpy(clave->texto + clave->largo, separador, largoSeparador);
+    clave->largo += largoSeparador;
+    if (!unir) {
+        clave->clausulas++;
+        if (negada) {
+            clave->texto[clave->largo++] = '-';
+        }
+    }
+    memcpy(clave->texto + clave->largo, palabra, longitud);
+    clave->largo += longitud;
+    memcpy(clave->texto + clave->largo, sufijo, largoSufijo);
+    clave->largo += largoSufijo;
+    clave->texto[clave->largo] = '\0';
+}
+
+/**
+ * @brief Compara dos cadenas para qsort.
+ *
+ * @param a Puntero a la primera cadena.
+ * @param b Puntero a la segunda cadena.
+ * @return Negativo, cero o positivo, como strcmp.
+ */
+static int compararCadenas(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/**
+ * @brief Ordena las palabras de cada clausula y las clausulas de una clave.
+ *
+ * El resultado de una consulta no depende del orden de sus clausulas ni del de
+ * las palabras unidas con OR. Si no hay memoria la clave queda como estaba.
+ *
+ * @param texto Clausulas de la clave, cada una precedida por ' '.
+ * @param largo Largo de texto.
+ */
+static void ordenarClave(char *texto, size_t largo) {
+    char *trabajo = malloc(2 * (largo + 1));
+    if (!trabajo) {
+        return;
+    }
+    char *copia = trabajo;
+    char *ordenadas = trabajo + largo + 1;
+    memcpy(copia, texto, largo + 1);
+
+    char *clausulas[CONSULTA_MAX_TERMINOS];
+    int numClausulas = 0;
+    char *escritura = ordenadas;
+    char *p = copia;
+    while (*p == ' ' && numClausulas < CONSULTA_MAX_TERMINOS) {
+        char *clausula = ++p;
+        while (*p && *p != ' ') {
+            p++;
+        }
+        char fin = *p;
+        *p = '\0';
+
+        char *palabras[CONSULTA_MAX_TERMINOS];
+        int numPalabras = 0;
+        int negada = *clausula == '-';
+        char *q = clausula + negada;
+        while (numPalabras < CONSULTA_MAX_TERMINOS) {
+            palabras[numPalabras++] = q;
+            q = strchr(q, '|');
+            if (!q) {
+                break;
+            }
+            *q++ = '\0';
+        }
+        qsort(palabras, numPalabras, sizeof(char *), compararCadenas);
+        clausulas[numClausulas++] = escritura;
+        if (negada) {
+            *escritura++ = '-';
+        }
+        for (int i = 0; i < numPalabras; i++) {
+            size_t n = strlen(palabras[i]);
+            if (i > 0) {
+                *escritura++ = '|';
+            }
+            memcpy(escritura, palabras[i], n);
+            escritura += n;
+        }
+        *escritura++ = '\0';
+        *p = fin;
+    }
+    qsort(clausulas, numClausulas, sizeof(char *), compararCadenas);
+    escritura = texto;
+    for (int i = 0; i < numClausulas; i++) {
+        size_t n = strlen(clausulas[i]);
+        *escritura++ = ' ';
+        memcpy(escritura, clausulas[i], n);
+        escritura += n;
+    }
+    free(trabajo);
+}
+
+/**
+ * @brief Escribe la forma canonica de una consulta, que sirve de clave en la cache.
+ *
+ * Dos consultas con la misma clave tienen el mismo resultado: la clave no depende
+ * de los espacios, las mayusculas, los acentos, las stopwords, "AND" ni del orden
+ * de las clausulas y de las palabras unidas con OR.
+ *
+ * @param consulta Texto de la consulta.
+ * @param prefijo Texto que distingue el tipo de busqueda y sus parametros.
+ * @param clave Salida.
+ * @param capacidad Bytes disponibles en clave.
+ * @return Largo de la clave, 0 si no cupo, o -1 si la consulta tiene un error de sintaxis.
+ */
+static int normalizarConsulta(const char *consulta, const char *prefijo, char *clave, size_t capacidad) {
+    ClaveConsulta canonica = {clave, capacidad, 0, 0, 0};
+    int largoPrefijo = snprintf(clave, capacidad, "%s", prefijo);
+    if (largoPrefijo < 0 || (size_t)largoPrefijo >= capacidad) {
+        canonica.desbordada = 1;
+    } else {
+        canonica.largo = (size_t)largoPrefijo;
+    }
+    if (!recorrerConsulta(consulta, agregarPalabraClave, &canonica)) {
+        return -1;
+    }
+    if (canonica.desbordada) {
+        return 0;
+    }
+    ordenarClave(clave + largoPrefijo, canonica.largo - (size_t)largoPrefijo);
+    return (int)canonica.largo;
+}
+
+/**
+ * @brief Busca con pasos exponenciales la primera posicion de un arreglo ordenado con valor >= objetivo.
+ *
+ * @param docs Arreglo ordenado.
+ * @param num Elementos del arreglo.
+ * @param desde Posicion desde la que buscar.
+ * @param objetivo Valor buscado.
+ * @return Primera posicion con docs[pos] >= objetivo, o num si no hay.
+ */
+static int buscarExponencial(const int *docs, int num, int desde, int objetivo) {
+    if (desde >= num || docs[desde] >= objetivo) {
+        return desde;
+    }
+    int bajo = desde;
+    int paso = 1;
+    while (bajo + paso < num && docs[bajo + paso] < objetivo) {
+        bajo += paso;
+        paso *= 2;
+    }
+    int alto = bajo + paso < num ? bajo + paso : num;
+    while (bajo + 1 < alto) {
+        int medio = bajo + (alto - bajo) / 2;
+        if (docs[medio] < objetivo) {
+            bajo = medio;
+        } else {
+            alto = medio;
+        }
+    }
+    return alto;
+}
+
+/**
+ * @brief Asegura espacio en los buferes de posiciones de un cursor posicional.
+ *
+ * @param c Cursor.
+ * @param cantidad Posiciones que deben caber.
+ * @return 1 si hay espacio, 0 si no hubo memoria.
+ */
+static int reservarPosicionesCursor(CursorClausula *c, int cantidad) {
+    if (cantidad <= c->capacidadPosiciones) {
+        return 1;
+    }
+    uint32_t *alcanzadas = realloc(c->alcanzadas, (size_t)cantidad * sizeof(uint32_t));
+    if (!alcanzadas) {
+        return 0;
+    }
+    c->alcanzadas = alcanzadas;
+    uint32_t *candidatas = realloc(c->candidatas, (size_t)cantidad * sizeof(uint32_t));
+    if (!candidatas) {
+        return 0;
+    }
+    c->candidatas = candidatas;
+    c->capacidadPosiciones = cantidad;
+    return 1;
+}
+
+/**
+ * @brief Comprueba si las palabras de una clausula posicional forman la frase en el documento actual.
+ *
+ * Recorre las palabras en orden y conserva las posiciones de cada una que
+ * completan la frase hasta ella: con UNION_FRASE, p sirve si p - distancia
+ * servia para la anterior; con UNION_NEAR, si alguna posicion de la anterior
+ * esta a lo sumo a distancia de p. Ambos filtros son una mezcla de dos listas
+ * ordenadas, y la comprobacion termina en cuanto no queda ninguna posicion.
+ *
+ * @param c Cursor con todos sus iteradores en el mismo documento.
+ * @return 1 si el documento contiene la frase, 0 si no.
+ */
+static int coincidenPosiciones(CursorClausula *c) {
+    size_t bytes;
+    const unsigned char *datos = posicionesPosting(&c->its[0], &bytes);
+    if (!datos || !reservarPosicionesCursor(c, c->its[0].frecuencia)) {
+        return 0;
+    }
+    decodificarPosiciones(datos, c->its[0].frecuencia, c->alcanzadas);
+    int numAlcanzadas = c->its[0].frecuencia;
+
+    for (int i = 1; i < c->clausula->numListas; i++) {
+        IteradorPostings *it = &c->its[i];
+        datos = posicionesPosting(it, &bytes);
+        if (!datos || !reservarPosicionesCursor(c, it->frecuencia)) {
+            return 0;
+        }
+        decodificarPosiciones(datos, it->frecuencia, c->candidatas);
+        uint64_t distancia = (uint64_t)c->distancias[i];
+        int j = 0;
+        int conservadas = 0;
+        for (int k = 0; k < it->frecuencia && j < numAlcanzadas; k++) {
+            uint64_t p = c->candidatas[k];
+            if (c->uniones[i] == UNION_FRASE) {
+                while (j < numAlcanzadas && c->alcanzadas[j] + distancia < p) {
+                    j++;
+                }
+                if (j < numAlcanzadas && c->alcanzadas[j] + distancia == p) {
+                    c->candidatas[conservadas++] = (uint32_t)p;
+                }
+            } else {
+                while (j < numAlcanzadas && c->alcanzadas[j] + distancia < p) {
+                    j++;
+                }
+                // La misma aparicion no cuenta como dos palabras cercanas.
+                int cerca = j < numAlcanzadas && c->alcanzadas[j] != p && c->alcanzadas[j] <= p + distancia;
+                if (!cerca && j + 1 < numAlcanzadas && c->alcanzadas[j] == p) {
+                    cerca = c->alcanzadas[j + 1] <= p + distancia;
+                }
+                if (cerca) {
+                    c->candidatas[conservadas++] = (uint32_t)p;
+                }
+            }
+        }
+        if (conservadas == 0) {
+            return 0;
+        }
+        uint32_t *temporal = c->alcanzadas;
+        c->alcanzadas = c->candidatas;
+        c->candidatas = temporal;
+        numAlcanzadas = conservadas;
+    }
+    return 1;
+}
+
+/**
+ * @brief Avanza un cursor posicional hasta el primer documento mayor o igual al objetivo que contiene la frase.
+ *
+ * Las palabras se intersecan por turnos, empezando por la mas rara: cada una
+ * salta hasta el documento propuesto y, si lo pasa, propone el suyo, hasta que
+ * todas coinciden. Solo entonces se miran las posiciones.
+ *
+ * @param c Cursor posicional.
+ * @param objetivo Documento objetivo.
+ * @return Documento encontrado, o DOC_AGOTADO.
+ */
+static int avanzarPosicional(CursorClausula *c, int objetivo) {
+    int numListas = c->clausula->numListas;
+    for (;;) {
+        int candidato = objetivo;
+        int iguales = 0;
+        int i = c->masRara;
+        while (iguales < numListas) {
+            if (!avanzarPosting(&c->its[i], candidato)) {
+                return DOC_AGOTADO;
+            }
+            if (c->its[i].docID == candidato) {
+                iguales++;
+            } else {
+                candidato = c->its[i].docID;
+                iguales = 1;
+            }
+            i = i + 1 < numListas ? i + 1 : 0;
+        }
+        if (coincidenPosiciones(c)) {
+            return candidato;
+        }
+        objetivo = candidato + 1;
+    }
+}
+
+/**
+ * @brief Avanza un cursor hasta el primer documento mayor o igual al objetivo.
+ *
+ * @param c Cursor.
+ * @param objetivo Documento objetivo.
+ * @return Documento actual del cursor, o DOC_AGOTADO.
+ */
+static int avanzarCursor(CursorClausula *c, int objetivo) {
+    if (c->docID >= objetivo) {
+        return c->docID;
+    }
+    if (c->its) {
+        c->docID = avanzarPosicional(c, objetivo);
+    } else if (c->usaIterador) {
+        c->docID = avanzarPosting(&c->it, objetivo) ? c->it.docID : DOC_AGOTADO;
+    } else {
+        c->pos = buscarExponencial(c->docs, c->numDocs, c->pos, objetivo);
+        c->docID = c->pos < c->numDocs ? c->docs[c->pos] : DOC_AGOTADO;
+    }
+    return c->docID;
+}
+
+/**
+ * @brief Prepara el cursor de una clausula.
+ *
+ * Una clausula OR se materializa mezclando sus listas en un arreglo ordenado y sin
+ * repetidos; su tamano esta acotado por la suma de las frecuencias de documento.
+ *
+ * @param c Cursor a preparar.
+ * @param analizada Consulta a la que pertenece la clausula.
+ * @param clausula Clausula a recorrer.
+ * @return 1 si se preparo, 0 si no hubo memoria.
+ */
+static int iniciarCursor(CursorClausula *c, const ConsultaAnalizada *analizada, const ClausulaConsulta *clausula) {
+    memset(c, 0, sizeof(*c));
+    c->clausula = clausula;
+    c->docID = -1;
+    const ListaPostings *listas = &analizada->listas[clausula->primeraLista];
+
+    if (clausula->posicional) {
+        c->its = malloc(clausula->numListas * sizeof(IteradorPostings));
+        if (!c->its) {
+            return 0;
+        }
+        c->uniones = &analizada->uniones[clausula->primeraLista];
+        c->distancias = &analizada->distancias[clausula->primeraLista];
+        int frecuenciaMaxima = 1;
+        for (int i = 0; i < clausula->numListas; i++) {
+            iniciarIteradorPostings(&c->its[i], &listas[i]);
+            if (listas[i].conteoDocs < listas[c->masRara].conteoDocs) {
+                c->masRara = i;
+            }
+            if (listas[i].frecuenciaMaxima > frecuenciaMaxima) {
+                frecuenciaMaxima = listas[i].frecuenciaMaxima;
+            }
+        }
+        return reservarPosicionesCursor(c, frecuenciaMaxima);
+    }
+
+    if (clausula->numListas == 1) {
+        c->usaIterador = 1;
+        iniciarIteradorPostings(&c->it, &listas[0]);
+        return 1;
+    }
+
+    c->docs = malloc((clausula->frecuencia ? clausula->frecuencia : 1) * sizeof(int));
+    IteradorPostings its[CONSULTA_MAX_TERMINOS];
+    int actuales[CONSULTA_MAX_TERMINOS];
+    if (!c->docs) {
+        return 0;
+    }
+    for (int i = 0; i < clausula->numListas; i++) {
+        iniciarIteradorPostings(&its[i], &listas[i]);
+        actuales[i] = siguientePosting(&its[i]) ? its[i].docID : DOC_AGOTADO;
+    }
+    for (;;) {
+        int minimo = DOC_AGOTADO;
+        for (int i = 0; i < clausula->numListas; i++) {
+            if (actuales[i] < minimo) {
+                minimo = actuales[i];
+            }
+        }
+        if (minimo == DOC_AGOTADO) {
+            break;
+        }
+        c->docs[c->numDocs++] = minimo;
+        for (int i = 0; i < clausula->numListas; i++) {
+            if (actuales[i] == minimo) {
+                actuales[i] = siguientePosting(&its[i]) ? its[i].docID : DOC_AGOTADO;
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Libera la memoria de un cursor.
+ *
+ * @param c Cursor.
+ */
+static void liberarCursor(CursorClausula *c) {
+    free(c->docs);
+    free(c->its);
+    free(c->alcanzadas);
+    free(c->candidatas);
+}
+
+/**
+ * @brief Compara dos cursores por la frecuencia estimada de su clausula.
+ *
+ * @param a Primer cursor.
+ * @param b Segundo cursor.
+ * @return Negativo si a es mas selectivo que b.
+ */
+static int compararCursores(const void *a, const void *b) {
+    long fa = ((const CursorClausula *)a)->clausula->frecuencia;
+    long fb = ((const CursorClausula *)b)->clausula->frecuencia;
+    return (fa > fb) - (fa < fb);
+}
+
+/**
+ * @brief Indica si conviene evaluar una consulta con conjuntos Roaring.
+ *
+ * Conviene si alguna palabra es frecuente y tiene conjunto. No se puede si hay
+ * frases (necesitan posiciones) o cambios incrementales (el conjunto no los
+ * refleja).
+ *
+ * @param analizada Consulta analizada.
+ * @return 1 si se puede y conviene, 0 si no.
+ */
+static int convieneEvaluarConConjuntos(const ConsultaAnalizada *analizada) {
+    for (int i = 0; i < analizada->numClausulas; i++) {
+        if (analizada->clausulas[i].posicional) {
+            return 0;
+        }
+    }
+    int conConjunto = 0;
+    for (int i = 0; i < analizada->numListas; i++) {
+        if (analizada->listas[i].estados) {
+            return 0;
+        }
+        if (!conConjunto && conjuntoPostings(&analizada->listas[i])) {
+            conConjunto = 1;
+        }
+    }
+    return conConjunto;
+}
+
+/**
+ * @brief Obtiene los docID de una lista como conjunto Roaring.
+ *
+ * Usa el conjunto guardado de la lista si es frecuente; si no, arma uno
+ * temporal recorriendo la lista.
+ *
+ * @param lista Lista de postings.
+ * @param propio Salida: conjunto temporal que el llamador debe liberar, o NULL.
+ * @return Conjunto de la lista.
+ */
+static const ConjuntoRoaring *conjuntoLista(const ListaPostings *lista, ConjuntoRoaring **propio) {
+    *propio = NULL;
+    const ConjuntoRoaring *conjunto = conjuntoPostings(lista);
+    if (conjunto) {
+        return conjunto;
+    }
+    *propio = crearConjuntoRoaring();
+    IteradorPostings it;
+    iniciarIteradorPostings(&it, lista);
+    while (siguientePosting(&it)) {
+        agregarAlFinalConjunto(*propio, it.docID);
+    }
+    ajustarConjunto(*propio);
+    return *propio;
+}
+
+/**
+ * @brief Obtiene los documentos de una clausula OR como conjunto Roaring.
+ *
+ * @param analizada Consulta a la que pertenece la clausula.
+ * @param clausula Clausula con al menos una lista.
+ * @param propio Salida: conjunto que el llamador debe liberar, o NULL si el resultado es de una lista.
+ * @return Union de los conjuntos de las listas de la clausula.
+ */
+static const ConjuntoRoaring *conjuntoClausula(const ConsultaAnalizada *analizada, const ClausulaConsulta *clausula,
+                                               ConjuntoRoaring **propio) {
+    const ListaPostings *listas = &analizada->listas[clausula->primeraLista];
+    const ConjuntoRoaring *conjunto = conjuntoLista(&listas[0], propio);
+    for (int i = 1; i < clausula->numListas; i++) {
+        ConjuntoRoaring *propioLista;
+        const ConjuntoRoaring *otro = conjuntoLista(&listas[i], &propioLista);
+        ConjuntoRoaring *unidos = unirConjuntos(conjunto, otro);
+        liberarConjuntoRoaring(*propio);
+        liberarConjuntoRoaring(propioLista);
+        conjunto = *propio = unidos;
+    }
+    return conjunto;
+}
+
+/**
+ * @brief Evalua una consulta booleana sin frases con operaciones de conjuntos.
+ *
+ * Cada clausula positiva es la union de sus listas; se intersecan de la mas
+ * chica a la mas grande y al resultado se le restan las listas negadas. Las
+ * palabras frecuentes usan el conjunto Roaring de su lista y las demas uno
+ * temporal. Requiere el candado del indice.
+ *
+ * @param analizada Consulta analizada (ver convieneEvaluarConConjuntos()).
+ * @param documentos Salida: arreglo de docID en orden creciente (liberar con free).
+ * @return Numero de documentos encontrados.
+ */
+static int evaluarConsultaConjuntos(const ConsultaAnalizada *analizada, int **documentos) {
+    const ConjuntoRoaring *positivos[CONSULTA_MAX_TERMINOS];
+    ConjuntoRoaring *propios[CONSULTA_MAX_TERMINOS];
+    int numPositivos = 0;
+    for (int i = 0; i < analizada->numClausulas; i++) {
+        const ClausulaConsulta *clausula = &analizada->clausulas[i];
+        if (!clausula->negada && clausula->numListas == 0) {
+            return 0; // Una palabra obligatoria que no esta en el indice: no hay resultados.
+        }
+    }
+    for (int i = 0; i < analizada->numClausulas; i++) {
+        const ClausulaConsulta *clausula = &analizada->clausulas[i];
+        if (clausula->negada) {
+            continue;
+        }
+        // Insercion ordenada por cardinalidad: la interseccion empieza por el mas chico.
+        ConjuntoRoaring *propio;
+        const ConjuntoRoaring *conjunto = conjuntoClausula(analizada, clausula, &propio);
+        int j = numPositivos++;
+        while (j > 0 && positivos[j - 1]->cardinalidad > conjunto->cardinalidad) {
+            positivos[j] = positivos[j - 1];
+            propios[j] = propios[j - 1];
+            j--;
+        }
+        positivos[j] = conjunto;
+        propios[j] = propio;
+    }
+    if (numPositivos == 0) {
+        return 0;
+    }
+
+    const ConjuntoRoaring *resultado = positivos[0];
+    ConjuntoRoaring *propioResultado = NULL;
+    for (int i = 1; i < numPositivos && resultado->cardinalidad > 0; i++) {
+        ConjuntoRoaring *interseccion = intersecarConjuntos(resultado, positivos[i]);
+        liberarConjuntoRoaring(propioResultado);
+        resultado = propioResultado = interseccion;
+    }
+    for (int i = 0; i < analizada->numClausulas && resultado->cardinalidad > 0; i++) {
+        const ClausulaConsulta *clausula = &analizada->clausulas[i];
+        if (!clausula->negada) {
+            continue;
+        }
+        for (int l = 0; l < clausula->numListas && resultado->cardinalidad > 0; l++) {
+            ConjuntoRoaring *propioLista;
+            const ConjuntoRoaring *negado = conjuntoLista(&analizada->listas[clausula->primeraLista + l], &propioLista);
+            ConjuntoRoaring *diferencia = restarConjuntos(resultado, negado);
+            liberarConjuntoRoaring(propioLista);
+            liberarConjuntoRoaring(propioResultado);
+            resultado = propioResultado = diferencia;
+        }
+    }
+
+    int encontrados = (int)resultado->cardinalidad;
+    *documentos = malloc((encontrados > 0 ? encontrados : 1) * sizeof(int));
+    if (*documentos) {
+        extraerConjunto(resultado, *documentos);
+    } else {
+        fprintf(stderr, "No hay memoria para evaluar la consulta.\n");
+        encontrados = 0;
+    }
+    liberarConjuntoRoaring(propioResultado);
+    for (int i = 0; i < numPositivos; i++) {
+        liberarConjuntoRoaring(propios[i]);
+    }
+    INSTRUMENTAR_CONTADOR(CONTADOR_CONSULTAS_CONJUNTOS, 1);
+    return encontrados;
+}
+
+/**
+ * @brief Evalua una consulta booleana. Requiere el candado del indice.
+ *
+ * @param consulta Texto de la consulta.
+ * @param documentos Salida: arreglo de docID en orden creciente (liberar con free).
+ * @return Numero de documentos encontrados, o -1 si la consulta tiene un error de sintaxis.
+ */
+static int evaluarConsulta(const char *consulta, int **documentos) {
+    ConsultaAnalizada analizada;
+    *documentos = NULL;
+    if (!analizarConsulta(consulta, &analizada)) {
+        return -1;
+    }
+    if (convieneEvaluarConConjuntos(&analizada)) {
+        return evaluarConsultaConjuntos(&analizada, documentos);
+    }
+
+    CursorClausula positivos[CONSULTA_MAX_TERMINOS];
+    CursorClausula negativos[CONSULTA_MAX_TERMINOS];
+    int numPositivos = 0;
+    int numNegativos = 0;
+    int resultado = 0;
+
+    for (int i = 0; i < analizada.numClausulas; i++) {
+        const ClausulaConsulta *clausula = &analizada.clausulas[i];
+        if (clausula->negada) {
+            if (clausula->numListas > 0) {
+                if (iniciarCursor(&negativos[numNegativos], &analizada, clausula)) {
+                    numNegativos++;
+                } else {
+                    liberarCursor(&negativos[numNegativos]);
+                }
+            }
+        } else if (clausula->numListas == 0) {
+            goto liberar; // Una palabra obligatoria que no esta en el indice: no hay resultados.
+        } else if (iniciarCursor(&positivos[numPositivos], &analizada, clausula)) {
+            numPositivos++;
+        } else {
+            liberarCursor(&positivos[numPositivos]);
+            fprintf(stderr, "No hay memoria para evaluar la consulta.\n");
+            goto liberar;
+        }
+    }
+    if (numPositivos == 0) {
+        goto liberar;
+    }
+
+    qsort(positivos, numPositivos, sizeof(CursorClausula), compararCursores);
+    int capacidad = (int)(positivos[0].clausula->frecuencia > 0 ? positivos[0].clausula->frecuencia : 1);
+    *documentos = malloc(capacidad * sizeof(int));
+    if (!*documentos) {
+        fprintf(stderr, "No hay memoria para evaluar la consulta.\n");
+        goto liberar;
+    }
+
+    int candidato = avanzarCursor(&positivos[0], 0);
+    while (candidato != DOC_AGOTADO) {
+        int coincide = 1;
+        for (int i = 1; i < numPositivos; i++) {
+            int doc = avanzarCursor(&positivos[i], candidato);
+            if (doc != candidato) {
+                // La clausula mas rara se adelanta al documento propuesto por la otra.
+                candidato = doc == DOC_AGOTADO ? DOC_AGOTADO : avanzarCursor(&positivos[0], doc);
+                coincide = 0;
+                break;
+            }
+        }
+        if (!coincide) {
+            continue;
+        }
+        int excluido = 0;
+        for (int i = 0; i < numNegativos && !excluido; i++) {
+            excluido = avanzarCursor(&negativos[i], candidato) == candidato;
+        }
+        if (!excluido && resultado < capacidad) {
+            (*documentos)[resultado++] = candidato;
+        }
+        candidato = avanzarCursor(&positivos[0], candidato + 1);
+    }
+
+liberar:
+    for (int i = 0; i < numPositivos; i++) {
+        liberarCursor(&positivos[i]);
+    }
+    for (int i = 0; i < numNegativos; i++) {
+        liberarCursor(&negativos[i]);
+    }
+    return resultado;
+}
+
+/**
+ * @brief Evalua una consulta booleana.
+ *
+ * Primero busca el resultado en la cache de consultas. Si no esta, toma el
+ * candado del indice en modo compartido mientras dura la evaluacion, para que
+ * una fusion en segundo plano no libere las listas en uso, y guarda el resultado
+ * con la generacion del indice leida antes de empezar.
+ *
+ * @param consulta Texto de la consulta.
+ * @param documentos Salida: arreglo de docID en orden creciente (liberar con free).
+ * @return Numero de documentos encontrados, o -1 si la consulta tiene un error de sintaxis.
+ */
+int ejecutarConsulta(const char *consulta, int **documentos) {
+    INSTRUMENTAR_INICIO(inicio);
+    long generacion = obtenerGeneracionIndice();
+    char clave[LARGO_CLAVE_CACHE];
+    int largoClave = normalizarConsulta(consulta, "b", clave, sizeof(clave));
+    if (largoClave < 0) {
+        return -1;
+    }
+    size_t bytes;
+    if (largoClave > 0 && (*documentos = buscarCacheConsultas(clave, generacion, &bytes))) {
+        INSTRUMENTAR_LATENCIA(TIEMPO_CONSULTA_BOOLEANA, inicio);
+        return (int)(bytes / sizeof(int));
+    }
+
+    bloquearIndiceLectura();
+    int resultado = evaluarConsulta(consulta, documentos);
+    desbloquearIndice();
+    if (resultado >= 0 && largoClave > 0) {
+        guardarCacheConsultas(clave, generacion, *documentos, (size_t)resultado * sizeof(int));
+    }
+    INSTRUMENTAR_CONTADOR(CONTADOR_CONSULTAS_BOOLEANAS, 1);
+    INSTRUMENTAR_LATENCIA(TIEMPO_CONSULTA_BOOLEANA, inicio);
+    return resultado;
+}
+
+/**
+ * @brief Pregunta al usuario si desea abrir los documentos encontrados y los abre.
+ *
+ * @param docIDs Documentos encontrados.
+ * @param num Numero de documentos.
+ */
+static void preguntarAbrirDocumentos(const int *docIDs, int num) {
+    // Preguntar si desea abrir algun documento
+    char respuesta;
+    printf("¿Desea abrir alguno de estos documentos? (s/n): ");
+    if (scanf(" %c", &respuesta) != 1) {
+        printf("Error al leer la respuesta. Asumiendo 'n'.\n");
+        respuesta = 'n';
+    }
+    if (respuesta == 's' || respuesta == 'S') {
+        for (int i = 0; i < num; i++) {
+            const char *nombre = obtenerNombreDocumento(docIDs[i]);
+            if (nombre) {
+                printf("Abriendo el documento '%s'...\n", nombre);
+                abrirDocumento(nombre);
+            }
+        }
+    } else {
+        printf("No se abriran documentos.\n");
+    }
+}
+
+/**
+ * @brief Busca documentos que cumplen una consulta.
+ *
+ * Muestra los documentos encontrados junto con su PageRank.
+ * Permite al usuario abrir los documentos encontrados.
+ *
+ * @param consulta Consulta a evaluar.
+ */
+void buscarDocumentos(const char *consulta) {
+    int *documentosEncontrados;
+    int conteoDocumentos = ejecutarConsulta(consulta, &documentosEncontrados);
+
+    if (conteoDocumentos < 0) {
+        return;
+    }
+    if (conteoDocumentos == 0) {
+        printf("La consulta '%s' no tiene resultados.\n", consulta);
+        free(documentosEncontrados);
+        return;
+    }
+
+    printf("Resultados para '%s' (%d documentos):\n", consulta, conteoDocumentos);
+    for (int i = 0; i < conteoDocumentos; i++) {
+        const char *nombre = obtenerNombreDocumento(documentosEncontrados[i]);
+        printf(" - Documento: %s (PageRank: %.4f)\n", nombre ? nombre : "?", obtenerPageRank(documentosEncontrados[i]));
+    }
+
+    preguntarAbrirDocumentos(documentosEncontrados, conteoDocumentos);
+    free(documentosEncontrados);
+}
+
+/**
+ * @brief Fija el peso del PageRank en la busqueda por relevancia.
+ *
+ * @param peso Peso del PageRank (0 lo desactiva; los negativos se tratan como 0).
+ */
+void establecerPesoPageRank(double peso) {
+    pesoPageRank = peso > 0.0 ? peso : 0.0;
+}
+
+/**
+ * @brief Obtiene el peso del PageRank en la busqueda por relevancia.
+ *
+ * @return Peso configurado.
+ */
+double obtenerPesoPageRank() {
+    return pesoPageRank;
+}
+
+/**
+ * @brief Calcula el aporte BM25 de una palabra a un documento.
+ *
+ * @param t Palabra.
+ * @param frecuencia Apariciones de la palabra en el documento.
+ * @param normalizacion k1 * (1 - b + b * longitud / longitud promedio) del documento.
+ * @return Aporte de la palabra al puntaje.
+ */
+static double aporteBM25(const TerminoRankeado *t, int frecuencia, double normalizacion) {
+    return t->idf * frecuencia * (BM25_K1 + 1.0) / (frecuencia + normalizacion);
+}
+
+/**
+ * @brief Avanza una palabra hasta el primer documento mayor o igual al objetivo.
+ *
+ * @param t Palabra.
+ * @param objetivo Documento objetivo.
+ * @return Documento actual de la palabra, o DOC_AGOTADO.
+ */
+static int avanzarTermino(TerminoRankeado *t, int objetivo) {
+    if (t->docID < objetivo) {
+        t->docID = avanzarPosting(&t->it, objetivo) ? t->it.docID : DOC_AGOTADO;
+    }
+    return t->docID;
+}
+
+/**
+ * @brief Compara dos palabras por su aporte maximo.
+ *
+ * @param a Primera palabra.
+ * @param b Segunda palabra.
+ * @return Negativo si a aporta menos que b.
+ */
+static int compararTerminosRankeados(const void *a, const void *b) {
+    double ca = ((const TerminoRankeado *)a)->cota;
+    double cb = ((const TerminoRankeado *)b)->cota;
+    return (ca > cb) - (ca < cb);
+}
+
+/**
+ * @brief Evalua una consulta y devuelve los k documentos de mayor puntaje.
+ *
+ * Las palabras se ordenan de menor a mayor aporte maximo. Con el monticulo lleno,
+ * el prefijo de palabras cuya suma de aportes maximos (mas el PageRank maximo) no
+ * supera el umbral deja de proponer candidatos: solo se avanzan con saltos hasta
+ * los documentos que proponen las demas, y se abandonan en cuanto el candidato ya
+ * no puede alcanzar el umbral.
+ *
+ * Requiere el candado del indice.
+ *
+ * @param consulta Texto de la consulta.
+ * @param k Numero maximo de resultados.
+ * @param resultados Salida: arreglo de al menos k elementos, del mejor al peor.
+ * @param contexto PageRank publicado que se usa en toda la consulta (o NULL si no hay).
+ * @param vector Vector personalizado de contexto que reemplaza al PageRank global, o -1 para el global.
+ * @return Numero de resultados, o -1 si la consulta tiene un error de sintaxis.
+ */
+static int evaluarConsultaRankeada(const char *consulta, int k, ResultadoRanking *resultados,
+                                   const ContextoLectura *contexto, int vector) {
+    ConsultaAnalizada analizada;
+    if (!analizarConsulta(consulta, &analizada)) {
+        return -1;
+    }
+
+    TerminoRankeado terminos[CONSULTA_MAX_TERMINOS];
+    double acumuladas[CONSULTA_MAX_TERMINOS];
+    CursorClausula negativos[CONSULTA_MAX_TERMINOS];
+    int numTerminos = 0;
+    int numNegativos = 0;
+    double numDocs = totalDocumentosCargados();
+    double promedio = longitudPromedioDocumentos();
+    if (promedio <= 0.0) {
+        promedio = 1.0;
+    }
+
+    for (int c = 0; c < analizada.numClausulas; c++) {
+        const ClausulaConsulta *clausula = &analizada.clausulas[c];
+        if (clausula->negada) {
+            if (clausula->numListas > 0) {
+                if (iniciarCursor(&negativos[numNegativos], &analizada, clausula)) {
+                    numNegativos++;
+                } else {
+                    liberarCursor(&negativos[numNegativos]);
+                }
+            }
+            continue;
+        }
+        for (int i = 0; i < clausula->numListas; i++) {
+            const ListaPostings *lista = &analizada.listas[clausula->primeraLista + i];
+            TerminoRankeado *t = &terminos[numTerminos++];
+            double df = lista->conteoDocs;
+            iniciarIteradorPostings(&t->it, lista);
+            t->idf = log(1.0 + (numDocs - df + 0.5) / (df + 0.5));
+            // El aporte crece con la frecuencia y es maximo para un documento de longitud 0.
+            t->cota = lista->frecuenciaMaxima > 0 ? aporteBM25(t, lista->frecuenciaMaxima, BM25_K1 * (1.0 - BM25_B))
+                                                  : t->idf * (BM25_K1 + 1.0);
+            t->docID = -1;
+            avanzarTermino(t, 0);
+        }
+    }
+    qsort(terminos, numTerminos, sizeof(TerminoRankeado), compararTerminosRankeados);
+    for (int i = 0; i < numTerminos; i++) {
+        acumuladas[i] = terminos[i].cota + (i > 0 ? acumuladas[i - 1] : 0.0);
+    }
+
+    // El vector personalizado se lee como una columna de su matriz; el global, con paso 1.
+    const double *pageRank = contexto ? contexto->pageRank : NULL;
+    double pageRankMaximo = contexto ? contexto->pageRankMaximo : 0.0;
+    int docsPageRank = contexto ? contexto->numDocs : 0;
+    int paso = 1;
+    if (vector >= 0) {
+        const PageRankPersonalizado *personalizado = contexto->personalizado;
+        pageRank = personalizado->rank + vector;
+        pageRankMaximo = personalizado->maximo[vector];
+        docsPageRank = personalizado->numDocs;
+        paso = personalizado->numVectores;
+    }
+    double peso = pageRankMaximo > 0.0 ? pesoPageRank : 0.0;
+    MonticuloTopK monticulo;
+    iniciarTopK(&monticulo, resultados, k);
+    int primeraEsencial = 0;
+
+    for (;;) {
+        int candidato = DOC_AGOTADO;
+        for (int i = primeraEsencial; i < numTerminos; i++) {
+            if (terminos[i].docID < candidato) {
+                candidato = terminos[i].docID;
+            }
+        }
+        if (candidato == DOC_AGOTADO) {
+            break;
+        }
+
+        double normalizacion =
+            BM25_K1 * (1.0 - BM25_B + BM25_B * obtenerLongitudDocumento(candidato) / promedio);
+        double puntaje = 0.0;
+        for (int i = primeraEsencial; i < numTerminos; i++) {
+            TerminoRankeado *t = &terminos[i];
+            if (t->docID == candidato) {
+                puntaje += aporteBM25(t, t->it.frecuencia, normalizacion);
+                t->docID = siguientePosting(&t->it) ? t->it.docID : DOC_AGOTADO;
+            }
+        }
+        int descartado = 0;
+        for (int i = primeraEsencial - 1; i >= 0 && !descartado; i--) {
+            // primeraEsencial > 0 implica que el monticulo esta lleno.
+            if (puntaje + acumuladas[i] + peso <= umbralTopK(&monticulo)) {
+                descartado = 1;
+            } else if (avanzarTermino(&terminos[i], candidato) == candidato) {
+                puntaje += aporteBM25(&terminos[i], terminos[i].it.frecuencia, normalizacion);
+            }
+        }
+        for (int i = 0; i < numNegativos && !descartado; i++) {
+            descartado = avanzarCursor(&negativos[i], candidato) == candidato;
+        }
+        if (descartado) {
+            continue;
+        }
+
+        // Los documentos agregados despues de la ultima publicacion todavia no tienen PageRank.
+        if (peso > 0.0 && candidato < docsPageRank) {
+            puntaje += peso * pageRank[(size_t)candidato * paso] / pageRankMaximo;
+        }
+        if (ofrecerTopK(&monticulo, candidato, puntaje) && topKLleno(&monticulo)) {
+            double umbral = umbralTopK(&monticulo);
+            while (primeraEsencial < numTerminos && acumuladas[primeraEsencial] + peso <= umbral) {
+                primeraEsencial++;
+            }
+        }
+    }
+
+    for (int i = 0; i < numNegativos; i++) {
+        liberarCursor(&negativos[i]);
+    }
+    return ordenarTopK(&monticulo);
+}
+
+/**
+ * @brief Evalua una consulta y devuelve los k documentos de mayor puntaje.
+ *
+ * Usa el PageRank publicado al empezar, aunque se publique otro mientras tanto.
+ * Los resultados se guardan en la cache de consultas por consulta, k y peso del
+ * PageRank.
+ *
+ * @param consulta Texto de la consulta.
+ * @param k Numero maximo de resultados.
+ * @param resultados Salida: arreglo de al menos k elementos, del mejor al peor.
+ * @return Numero de resultados, o -1 si la consulta tiene un error de sintaxis.
+ */
+int ejecutarConsultaRankeada(const char *consulta, int k, ResultadoRanking *resultados) {
+    return ejecutarConsultaPersonalizada(consulta, k, NULL, resultados);
+}
+
+/**
+ * @brief Evalua una consulta por relevancia con un PageRank personalizado.
+ *
+ * Usa los vectores publicados al empezar, aunque se publiquen otros mientras
+ * tanto. La personalizacion forma parte de la clave de la cache.
+ *
+ * @param consulta Texto de la consulta.
+ * @param k Numero maximo de resultados.
+ * @param personalizacion Nombre del vector personalizado, o NULL para el PageRank global.
+ * @param resultados Salida: arreglo de al menos k elementos, del mejor al peor.
+ * @return Numero de resultados, -1 si la consulta tiene un error de sintaxis o
+ *         CONSULTA_PERSONALIZACION_DESCONOCIDA si no hay un vector con ese nombre.
+ */
+int ejecutarConsultaPersonalizada(const char *consulta, int k, const char *personalizacion,
+                                  ResultadoRanking *resultados) {
+    INSTRUMENTAR_INICIO(inicio);
+    long generacion = obtenerGeneracionIndice();
+    char prefijo[64 + CONTEXTO_LARGO_PERSONALIZACION];
+    char clave[LARGO_CLAVE_CACHE];
+    snprintf(prefijo, sizeof(prefijo), "r%d:%.17g:%s:", k, pesoPageRank, personalizacion ? personalizacion : "");
+    int largoClave = normalizarConsulta(consulta, prefijo, clave, sizeof(clave));
+    if (largoClave < 0) {
+        return -1;
+    }
+    size_t bytes;
+    ResultadoRanking *guardados = largoClave > 0 ? buscarCacheConsultas(clave, generacion, &bytes) : NULL;
+    if (guardados) {
+        memcpy(resultados, guardados, bytes);
+        free(guardados);
+        INSTRUMENTAR_LATENCIA(TIEMPO_CONSULTA_RANKEADA, inicio);
+        return (int)(bytes / sizeof(ResultadoRanking));
+    }
+
+    const ContextoLectura *contexto = entrarLectura();
+    int vector = -1;
+    if (personalizacion) {
+        vector = buscarPersonalizacion(contexto ? contexto->personalizado : NULL, personalizacion);
+        if (vector < 0) {
+            salirLectura();
+            return CONSULTA_PERSONALIZACION_DESCONOCIDA;
+        }
+    }
+    bloquearIndiceLectura();
+    int resultado = evaluarConsultaRankeada(consulta, k, resultados, contexto, vector);
+    desbloquearIndice();
+    salirLectura();
+    if (resultado >= 0 && largoClave > 0) {
+        guardarCacheConsultas(clave, generacion, resultados, (size_t)resultado * sizeof(ResultadoRanking));
+    }
+    INSTRUMENTAR_CONTADOR(CONTADOR_CONSULTAS_RANKEADAS, 1);
+    INSTRUMENTAR_LATENCIA(TIEMPO_CONSULTA_RANKEADA, inicio);
+    return resultado;
+}
+
+/**
+ * @brief Muestra los documentos mas relevantes para una consulta.
+ *
+ * @param consulta Consulta a evaluar.
+ * @param k Numero maximo de resultados.
+ * @param personalizacion Nombre del vector personalizado, o NULL para el PageRank global.
+ */
+void buscarDocumentosRankeados(const char *consulta, int k, const char *personalizacion) {
+    ResultadoRanking *resultados = malloc((k > 0 ? k : 1) * sizeof(ResultadoRanking));
+    int *docIDs = malloc((k > 0 ? k : 1) * sizeof(int));
+    if (!resultados || !docIDs) {
+        fprintf(stderr, "No hay memoria para evaluar la consulta.\n");
+        free(resultados);
+        free(docIDs);
+        return;
+    }
+
+    // Se muestra el PageRank con el que se calcularon los puntajes: el del vector elegido.
+    const ContextoLectura *contexto = entrarLectura();
+    int num = ejecutarConsultaPersonalizada(consulta, k, personalizacion, resultados);
+    int vector = personalizacion ? buscarPersonalizacion(contexto ? contexto->personalizado : NULL, personalizacion)
+                                 : -1;
+    if (num == CONSULTA_PERSONALIZACION_DESCONOCIDA) {
+        printf("No hay una personalizacion llamada '%s'.\n", personalizacion);
+    } else if (num == 0) {
+        printf("La consulta '%s' no tiene resultados.\n", consulta);
+    } else if (num > 0) {
+        printf("Los %d documentos mas relevantes para '%s':\n", num, consulta);
+        for (int i = 0; i < num; i++) {
+            const char *nombre = obtenerNombreDocumento(resultados[i].docID);
+            printf(" %2d. %s (puntaje: %.4f, PageRank: %.4f)\n", i + 1, nombre ? nombre : "?",
+                   resultados[i].puntaje, pageRankContexto(contexto, vector, resultados[i].docID));
+            docIDs[i] = resultados[i].docID;
+        }
+    }
+    salirLectura();
+    if (num > 0) {
+        preguntarAbrirDocumentos(docIDs, num);
+    }
+    free(resultados);
+    free(docIDs);
+}
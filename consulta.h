@@ -0,0 +1,187 @@
+/**
+ * @file consulta.h
+ * @brief Motor de consultas booleanas sobre el indice invertido.
+ *
+ * Una consulta es una lista de palabras que deben aparecer todas (AND implicito).
+ * "a OR b" acepta cualquiera de las dos, y "NOT a" o "-a" excluye los documentos
+ * que contienen a; OR no se puede combinar con palabras negadas. Los operadores
+ * se escriben en mayusculas; "AND" es opcional. Las palabras se normalizan igual
+ * que al indexar, y si una stopword queda a la izquierda de un OR, la palabra de
+ * la derecha forma su propia clausula.
+ *
+ * Con el indice posicional hay ademas frases y proximidad: una frase entre
+ * comillas, como "a b c", exige las palabras seguidas y en ese orden, y
+ * "a NEAR/k b" exige que b este a lo sumo k posiciones antes o despues de a. Las stopwords no se indexan pero ocupan su
+ * posicion, asi que dentro de una frase cuentan como un hueco. NEAR se puede
+ * encadenar ("a NEAR/3 b NEAR/5 c" mide cada palabra desde la anterior), las
+ * frases y NEAR se pueden negar, y no se pueden mezclar con OR.
+ *
+ * Una palabra terminada en '*' busca todas las que empiezan asi ("busq*"), y una
+ * terminada en '~' o '~k' las que estan a distancia de Levenshtein k o menos
+ * ("busqeda~1"; sin k la distancia depende del largo, ver
+ * erroresPorDefectoDiccionario()). Las palabras encontradas en el diccionario
+ * ordenado se agregan a la clausula como alternativas unidas con OR, hasta
+ * CONSULTA_MAX_EXPANSIONES, prefiriendo las que estan en mas documentos. No se
+ * pueden usar dentro de frases ni con NEAR.
+ *
+ * La busqueda por relevancia usa las mismas consultas, pero trata todas las
+ * palabras no negadas como alternativas (tambien las de frases y NEAR) y ordena
+ * los documentos por BM25 mas una fraccion configurable del PageRank normalizado,
+ * el global o uno personalizado por tema (ver personalizacion.h).
+ */
+
+#ifndef CONSULTA_H
+#define CONSULTA_H
+
+#include "index.h"
+#include "ranking.h"
+
+#define CONSULTA_MAX_TERMINOS 64 ///< Numero maximo de palabras en una consulta.
+#define CONSULTA_MAX_EXPANSIONES 16 ///< Palabras que agrega como mucho un prefijo o una busqueda difusa.
+#define CONSULTA_TOP_K 10 ///< Resultados que muestra la busqueda por relevancia.
+#define CONSULTA_PESO_PAGERANK 1.0 ///< Peso por defecto del PageRank en el puntaje.
+#define CONSULTA_PERSONALIZACION_DESCONOCIDA -2 ///< Resultado de una consulta con una personalizacion inexistente.
+#define BM25_K1 1.2 ///< Saturacion de la frecuencia en BM25.
+#define BM25_B 0.75 ///< Normalizacion por longitud de documento en BM25.
+
+/**
+ * @brief Forma en que una palabra de la consulta se une a la anterior.
+ */
+typedef enum {
+    UNION_AND, ///< Abre una clausula nueva.
+    UNION_OR, ///< Es una alternativa mas de la clausula anterior.
+    UNION_FRASE, ///< Sigue a la palabra anterior de la clausula exactamente "distancia" posiciones despues.
+    UNION_NEAR, ///< Esta a lo sumo "distancia" posiciones antes o despues de la palabra anterior.
+} UnionPalabra;
+
+/**
+ * @brief Palabras del indice que reemplazan a una palabra de la consulta.
+ */
+typedef enum {
+    EXPANSION_NINGUNA, ///< Solo la palabra escrita.
+    EXPANSION_PREFIJO, ///< Las que empiezan con la palabra ("pal*").
+    EXPANSION_DIFUSA, ///< Las que estan a distancia de Levenshtein acotada ("pal~k").
+} ExpansionPalabra;
+
+/**
+ * @struct ClausulaConsulta
+ * @brief Grupo de palabras unidas por OR, o frase o cadena NEAR, dentro de una consulta.
+ */
+typedef struct {
+    int primeraLista; ///< Posicion de la primera lista del grupo en ConsultaAnalizada::listas.
+    int numListas; ///< Palabras del grupo que estan en el indice.
+    int negada; ///< 1 si los documentos del grupo se excluyen (NOT).
+    long frecuencia; ///< Cota del tamano del grupo: suma de las frecuencias de documento (minimo si es posicional).
+    int posicional; ///< 1 si es una frase o una cadena NEAR.
+    int incompleta; ///< 1 si falta en el indice una palabra de la frase; el grupo no tiene documentos.
+} ClausulaConsulta;
+
+/**
+ * @struct ConsultaAnalizada
+ * @brief Consulta separada en clausulas, lista para evaluarse.
+ */
+typedef struct {
+    ListaPostings listas[CONSULTA_MAX_TERMINOS]; ///< Listas de postings de las palabras encontradas.
+    UnionPalabra uniones[CONSULTA_MAX_TERMINOS]; ///< Union de cada lista con la anterior de su clausula.
+    int distancias[CONSULTA_MAX_TERMINOS]; ///< Distancia de UNION_FRASE y UNION_NEAR.
+    int numListas; ///< Numero de listas.
+    ClausulaConsulta clausulas[CONSULTA_MAX_TERMINOS]; ///< Clausulas de la consulta.
+    int numClausulas; ///< Numero de clausulas.
+    int palabrasPendientes; ///< Palabras que faltan agregar; las expansiones les dejan lugar en listas.
+} ConsultaAnalizada;
+
+/**
+ * @brief Separa una consulta en clausulas y busca las listas de postings de cada palabra.
+ *
+ * Las stopwords se descartan porque nunca se indexan. Las listas solo son
+ * validas mientras el llamador tenga el candado del indice (bloquearIndiceLectura()).
+ *
+ * @param consulta Texto de la consulta.
+ * @param analizada Salida.
+ * @return 1 si la consulta es valida, 0 si tiene un error de sintaxis.
+ */
+int analizarConsulta(const char *consulta, ConsultaAnalizada *analizada);
+
+/**
+ * @brief Evalua una consulta booleana.
+ *
+ * Las clausulas positivas se ordenan por frecuencia de documento; la mas rara
+ * propone candidatos y las demas se avanzan con saltos hasta cada candidato.
+ * Una frase se recorre igual: primero se intersecan los documentos de sus
+ * palabras y solo en los comunes se decodifican y cruzan las posiciones.
+ * Sin frases, si alguna palabra es frecuente (ver conjuntoPostings()), las
+ * clausulas se combinan como conjuntos Roaring.
+ *
+ * @param consulta Texto de la consulta.
+ * @param documentos Salida: arreglo de docID en orden creciente (liberar con free).
+ * @return Numero de documentos encontrados, o -1 si la consulta tiene un error de sintaxis.
+ */
+int ejecutarConsulta(const char *consulta, int **documentos);
+
+/**
+ * @brief Busca documentos que cumplen una consulta.
+ *
+ * Imprime los documentos encontrados, junto con sus valores de PageRank, y ofrece
+ * abrirlos.
+ *
+ * @param consulta Consulta a evaluar.
+ */
+void buscarDocumentos(const char *consulta);
+
+/**
+ * @brief Fija el peso del PageRank en la busqueda por relevancia.
+ *
+ * El puntaje de un documento es su BM25 mas peso * PageRank / PageRank maximo.
+ *
+ * @param peso Peso del PageRank (0 lo desactiva).
+ */
+void establecerPesoPageRank(double peso);
+
+/**
+ * @brief Obtiene el peso del PageRank en la busqueda por relevancia.
+ *
+ * @return Peso configurado.
+ */
+double obtenerPesoPageRank();
+
+/**
+ * @brief Evalua una consulta y devuelve los k documentos de mayor puntaje.
+ *
+ * Usa MaxScore: las palabras se ordenan por su puntaje maximo posible y, una vez
+ * que hay k resultados, las que no alcanzan por si solas el umbral solo se
+ * consultan para completar el puntaje de candidatos de las demas.
+ *
+ * @param consulta Texto de la consulta.
+ * @param k Numero maximo de resultados.
+ * @param resultados Salida: arreglo de al menos k elementos, del mejor al peor.
+ * @return Numero de resultados, o -1 si la consulta tiene un error de sintaxis.
+ */
+int ejecutarConsultaRankeada(const char *consulta, int k, ResultadoRanking *resultados);
+
+/**
+ * @brief Evalua una consulta por relevancia con un PageRank personalizado.
+ *
+ * Igual que ejecutarConsultaRankeada(), pero el PageRank del puntaje es el vector
+ * personalizado con ese nombre (ver personalizacion.h), normalizado por su propio
+ * maximo.
+ *
+ * @param consulta Texto de la consulta.
+ * @param k Numero maximo de resultados.
+ * @param personalizacion Nombre del vector personalizado, o NULL para el PageRank global.
+ * @param resultados Salida: arreglo de al menos k elementos, del mejor al peor.
+ * @return Numero de resultados, -1 si la consulta tiene un error de sintaxis o
+ *         CONSULTA_PERSONALIZACION_DESCONOCIDA si no hay un vector con ese nombre.
+ */
+int ejecutarConsultaPersonalizada(const char *consulta, int k, const char *personalizacion,
+                                  ResultadoRanking *resultados);
+
+/**
+ * @brief Muestra los documentos mas relevantes para una consulta.
+ *
+ * @param consulta Consulta a evaluar.
+ * @param k Numero maximo de resultados.
+ * @param personalizacion Nombre del vector personalizado, o NULL para el PageRank global.
+ */
+void buscarDocumentosRankeados(const char *consulta, int k, const char *personalizacion);
+
+#endif
@@ -0,0 +1,262 @@
+/**
+ * @file contexto.c
+ * @brief Implementacion de la publicacion de contextos y la reclamacion por epocas.
+ */
+
+#include "contexto.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @struct RanuraLector
+ * @brief Epoca anunciada por un hilo lector.
+ *
+ * Las ranuras forman una lista que solo crece; la de un hilo que termina queda
+ * libre para el proximo hilo que lea.
+ */
+typedef struct RanuraLector {
+    _Atomic unsigned long epoca; ///< Epoca de la lectura en curso, o 0 si el hilo no esta leyendo.
+    int libre; ///< 1 si ningun hilo usa la ranura. Protegido por mutexRanuras.
+    struct RanuraLector *siguiente; ///< Ranura siguiente de la lista.
+} RanuraLector;
+
+static ContextoLectura *_Atomic contextoVigente = NULL;
+static _Atomic unsigned long epocaGlobal = 1;
+static RanuraLector *_Atomic ranuras = NULL;
+static pthread_mutex_t mutexRanuras = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t mutexPublicacion = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t claveRanura;
+static pthread_once_t claveCreada = PTHREAD_ONCE_INIT;
+static long generaciones = 0;
+
+static _Thread_local RanuraLector *ranuraPropia = NULL;
+static _Thread_local int profundidad = 0;
+static _Thread_local const ContextoLectura *contextoPropio = NULL;
+
+/**
+ * @brief Devuelve la ranura de un hilo que termino.
+ *
+ * @param ranura Ranura del hilo.
+ */
+static void liberarRanura(void *ranura) {
+    pthread_mutex_lock(&mutexRanuras);
+    atomic_store(&((RanuraLector *)ranura)->epoca, 0);
+    ((RanuraLector *)ranura)->libre = 1;
+    pthread_mutex_unlock(&mutexRanuras);
+}
+
+/**
+ * @brief Crea la clave que libera la ranura de cada hilo al terminar.
+ */
+static void crearClaveRanura() {
+    pthread_key_create(&claveRanura, liberarRanura);
+}
+
+/**
+ * @brief Asigna una ranura al hilo actual, reutilizando una libre si la hay.
+ */
+static void registrarLector() {
+    pthread_once(&claveCreada, crearClaveRanura);
+    pthread_mutex_lock(&mutexRanuras);
+    RanuraLector *ranura = atomic_load(&ranuras);
+    while (ranura && !ranura->libre) {
+        ranura = ranura->siguiente;
+    }
+    if (!ranura) {
+        ranura = malloc(sizeof(RanuraLector));
+        if (!ranura) {
+            perror("No se pudo registrar un lector");
+            exit(EXIT_FAILURE);
+        }
+        atomic_init(&ranura->epoca, 0);
+        ranura->siguiente = atomic_load(&ranuras);
+        atomic_store(&ranuras, ranura);
+    }
+    ranura->libre = 0;
+    pthread_mutex_unlock(&mutexRanuras);
+    pthread_setspecific(claveRanura, ranura);
+    ranuraPropia = ranura;
+}
+
+/**
+ * @brief Reserva un contexto sin publicar para un numero de documentos.
+ *
+ * @param numDocs Documentos del vector de PageRank.
+ * @return Contexto con los valores sin inicializar.
+ */
+ContextoLectura *crearContextoLectura(int numDocs) {
+    if (numDocs < 0) {
+        numDocs = 0;
+    }
+    ContextoLectura *contexto = malloc(sizeof(ContextoLectura) + (size_t)numDocs * sizeof(double));
+    if (!contexto) {
+        perror("No se pudo reservar memoria para el contexto de lectura");
+        exit(EXIT_FAILURE);
+    }
+    contexto->generacion = 0;
+    contexto->numDocs = numDocs;
+    contexto->pageRankMaximo = 0.0;
+    contexto->iteraciones = 0;
+    contexto->residuo = 0.0;
+    contexto->personalizado = NULL;
+    return contexto;
+}
+
+/**
+ * @brief Reserva un conjunto de vectores personalizados sin publicar.
+ *
+ * @param numDocs Documentos de cada vector.
+ * @param numVectores Vectores del conjunto (como maximo CONTEXTO_MAX_PERSONALIZACIONES).
+ * @return Conjunto con los nombres vacios y los valores sin inicializar.
+ */
+PageRankPersonalizado *crearPageRankPersonalizado(int numDocs, int numVectores) {
+    if (numDocs < 0) {
+        numDocs = 0;
+    }
+    if (numVectores < 0) {
+        numVectores = 0;
+    }
+    if (numVectores > CONTEXTO_MAX_PERSONALIZACIONES) {
+        numVectores = CONTEXTO_MAX_PERSONALIZACIONES;
+    }
+    PageRankPersonalizado *personalizado =
+        malloc(sizeof(PageRankPersonalizado) + (size_t)numDocs * numVectores * sizeof(double));
+    if (!personalizado) {
+        perror("No se pudo reservar memoria para el PageRank personalizado");
+        exit(EXIT_FAILURE);
+    }
+    memset(personalizado, 0, sizeof(PageRankPersonalizado));
+    personalizado->numDocs = numDocs;
+    personalizado->numVectores = numVectores;
+    return personalizado;
+}
+
+/**
+ * @brief Busca un vector personalizado por nombre.
+ *
+ * @param personalizado Conjunto (puede ser NULL).
+ * @param nombre Nombre del vector.
+ * @return Posicion del vector en el conjunto, o -1 si no esta.
+ */
+int buscarPersonalizacion(const PageRankPersonalizado *personalizado, const char *nombre) {
+    if (!personalizado || !nombre) {
+        return -1;
+    }
+    for (int v = 0; v < personalizado->numVectores; v++) {
+        if (strcmp(personalizado->nombres[v], nombre) == 0) {
+            return v;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Obtiene el PageRank de un documento en el vector global o en uno personalizado.
+ *
+ * @param contexto Contexto leido (puede ser NULL).
+ * @param vector Posicion del vector personalizado, o -1 para el global.
+ * @param docID Documento.
+ * @return Valor del documento, o 0 si el vector no lo incluye.
+ */
+double pageRankContexto(const ContextoLectura *contexto, int vector, int docID) {
+    if (!contexto || docID < 0) {
+        return 0.0;
+    }
+    if (vector < 0) {
+        return docID < contexto->numDocs ? contexto->pageRank[docID] : 0.0;
+    }
+    const PageRankPersonalizado *personalizado = contexto->personalizado;
+    if (!personalizado || vector >= personalizado->numVectores || docID >= personalizado->numDocs) {
+        return 0.0;
+    }
+    return personalizado->rank[(size_t)docID * personalizado->numVectores + vector];
+}
+
+/**
+ * @brief Publica un contexto con mutexPublicacion tomado y libera el anterior.
+ *
+ * Espera a que terminen las lecturas que empezaron antes y suelta el candado. Los
+ * vectores personalizados del anterior se liberan si el nuevo no los comparte.
+ *
+ * @param contexto Contexto a publicar, con su conjunto personalizado ya asignado.
+ */
+static void publicarConCandado(ContextoLectura *contexto) {
+    contexto->generacion = ++generaciones;
+    ContextoLectura *anterior = atomic_exchange(&contextoVigente, contexto);
+    // Un lector que obtuvo el contexto anterior anuncio antes una epoca menor que esta.
+    unsigned long epoca = atomic_fetch_add(&epocaGlobal, 1) + 1;
+    for (RanuraLector *ranura = atomic_load(&ranuras); ranura; ranura = ranura->siguiente) {
+        unsigned long vista;
+        while ((vista = atomic_load(&ranura->epoca)) != 0 && vista < epoca) {
+            sched_yield();
+        }
+    }
+    pthread_mutex_unlock(&mutexPublicacion);
+    if (anterior && anterior->personalizado != contexto->personalizado) {
+        free((void *)anterior->personalizado);
+    }
+    free(anterior);
+}
+
+/**
+ * @brief Publica un contexto y libera el anterior cuando ya nadie lo lee.
+ *
+ * @param contexto Contexto creado con crearContextoLectura(); pasa a ser del modulo.
+ */
+void publicarContextoLectura(ContextoLectura *contexto) {
+    pthread_mutex_lock(&mutexPublicacion);
+    ContextoLectura *vigente = atomic_load(&contextoVigente);
+    contexto->personalizado = vigente ? vigente->personalizado : NULL;
+    publicarConCandado(contexto);
+}
+
+/**
+ * @brief Publica un conjunto de vectores personalizados.
+ *
+ * @param personalizado Conjunto creado con crearPageRankPersonalizado(), o NULL para quitarlos.
+ */
+void publicarPageRankPersonalizado(PageRankPersonalizado *personalizado) {
+    pthread_mutex_lock(&mutexPublicacion);
+    ContextoLectura *vigente = atomic_load(&contextoVigente);
+    ContextoLectura *contexto = crearContextoLectura(vigente ? vigente->numDocs : 0);
+    if (vigente) {
+        contexto->pageRankMaximo = vigente->pageRankMaximo;
+        contexto->iteraciones = vigente->iteraciones;
+        contexto->residuo = vigente->residuo;
+        memcpy(contexto->pageRank, vigente->pageRank, (size_t)vigente->numDocs * sizeof(double));
+    }
+    contexto->personalizado = personalizado;
+    publicarConCandado(contexto);
+}
+
+/**
+ * @brief Empieza una lectura del contexto vigente.
+ *
+ * @return Contexto vigente, o NULL si todavia no se publico ninguno.
+ */
+const ContextoLectura *entrarLectura() {
+    if (profundidad++ > 0) {
+        return contextoPropio;
+    }
+    if (!ranuraPropia) {
+        registrarLector();
+    }
+    atomic_store(&ranuraPropia->epoca, atomic_load(&epocaGlobal));
+    contextoPropio = atomic_load(&contextoVigente);
+    return contextoPropio;
+}
+
+/**
+ * @brief Termina una lectura empezada con entrarLectura().
+ */
+void salirLectura() {
+    if (--profundidad > 0) {
+        return;
+    }
+    contextoPropio = NULL;
+    atomic_store_explicit(&ranuraPropia->epoca, 0, memory_order_release);
+}
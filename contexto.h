@@ -0,0 +1,140 @@
+/**
+ * @file contexto.h
+ * @brief Estado de solo lectura de las consultas, publicado por versiones.
+ *
+ * Quien recalcula el PageRank trabaja sobre los arreglos del grafo y, al
+ * terminar, publica un ContextoLectura nuevo e inmutable con un intercambio
+ * atomico de puntero. Las consultas leen el contexto vigente sin candados ni
+ * esperas, asi que nunca ven un vector a medio actualizar.
+ *
+ * El contexto reemplazado se libera con reclamacion por epocas: cada lector
+ * anuncia la epoca en la que empezo a leer, y quien publica espera a que ningun
+ * lector siga en una epoca anterior al reemplazo. Solo espera quien publica.
+ *
+ * El indice y la tabla de documentos no forman parte del contexto: se protegen
+ * con el candado del indice (ver bloquearIndiceLectura()).
+ */
+
+#ifndef CONTEXTO_H
+#define CONTEXTO_H
+
+#define CONTEXTO_MAX_PERSONALIZACIONES 64 ///< Vectores de PageRank personalizado que admite un contexto.
+#define CONTEXTO_LARGO_PERSONALIZACION 32 ///< Bytes del nombre de una personalizacion, con el '\0'.
+
+/**
+ * @struct PageRankPersonalizado
+ * @brief Conjunto publicado de vectores de PageRank personalizado.
+ *
+ * Se reserva en un solo bloque con crearPageRankPersonalizado(). Los contextos
+ * consecutivos comparten el mismo conjunto hasta que se publica otro, y se
+ * libera junto con el ultimo contexto que lo usa.
+ */
+typedef struct {
+    int numDocs; ///< Documentos de cada vector.
+    int numVectores; ///< Vectores del conjunto.
+    int iteraciones; ///< Iteraciones del calculo que produjo los vectores.
+    double residuo; ///< Mayor diferencia L1 de la ultima iteracion entre todos los vectores.
+    char nombres[CONTEXTO_MAX_PERSONALIZACIONES][CONTEXTO_LARGO_PERSONALIZACION]; ///< Nombre de cada vector.
+    double maximo[CONTEXTO_MAX_PERSONALIZACIONES]; ///< Mayor valor de cada vector.
+    double rank[]; ///< Matriz documentos x vectores: rank[docID * numVectores + v].
+} PageRankPersonalizado;
+
+/**
+ * @struct ContextoLectura
+ * @brief Version publicada del PageRank.
+ *
+ * Se reserva en un solo bloque con crearContextoLectura() y no se modifica
+ * despues de publicarla.
+ */
+typedef struct {
+    long generacion; ///< Numero de la publicacion, desde 1; lo asigna publicarContextoLectura().
+    int numDocs; ///< Documentos con PageRank.
+    double pageRankMaximo; ///< Mayor valor del vector (0 si no hay documentos).
+    int iteraciones; ///< Iteraciones del calculo que produjo el vector.
+    double residuo; ///< Residuo del calculo que produjo el vector.
+    const PageRankPersonalizado *personalizado; ///< Vectores personalizados vigentes, o NULL si no hay.
+    double pageRank[]; ///< PageRank de cada documento.
+} ContextoLectura;
+
+/**
+ * @brief Reserva un contexto sin publicar para un numero de documentos.
+ *
+ * Termina el programa si no hay memoria.
+ *
+ * @param numDocs Documentos del vector de PageRank.
+ * @return Contexto con los valores sin inicializar.
+ */
+ContextoLectura *crearContextoLectura(int numDocs);
+
+/**
+ * @brief Publica un contexto y libera el anterior cuando ya nadie lo lee.
+ *
+ * Los lectores que entren despues de la llamada ven el contexto nuevo. La funcion
+ * vuelve cuando terminaron todas las lecturas que empezaron antes. No debe
+ * llamarse desde dentro de una lectura. El contexto nuevo conserva los vectores
+ * personalizados del anterior.
+ *
+ * @param contexto Contexto creado con crearContextoLectura(); pasa a ser del modulo.
+ */
+void publicarContextoLectura(ContextoLectura *contexto);
+
+/**
+ * @brief Reserva un conjunto de vectores personalizados sin publicar.
+ *
+ * Termina el programa si no hay memoria.
+ *
+ * @param numDocs Documentos de cada vector.
+ * @param numVectores Vectores del conjunto (como maximo CONTEXTO_MAX_PERSONALIZACIONES).
+ * @return Conjunto con los nombres vacios y los valores sin inicializar.
+ */
+PageRankPersonalizado *crearPageRankPersonalizado(int numDocs, int numVectores);
+
+/**
+ * @brief Publica un conjunto de vectores personalizados.
+ *
+ * Publica una copia del contexto vigente con el conjunto nuevo, que reemplaza al
+ * anterior; el anterior se libera cuando ya nadie lo lee. Las mismas reglas que
+ * publicarContextoLectura().
+ *
+ * @param personalizado Conjunto creado con crearPageRankPersonalizado(), o NULL para
+ *                      quitarlos; pasa a ser del modulo.
+ */
+void publicarPageRankPersonalizado(PageRankPersonalizado *personalizado);
+
+/**
+ * @brief Busca un vector personalizado por nombre.
+ *
+ * @param personalizado Conjunto (puede ser NULL).
+ * @param nombre Nombre del vector.
+ * @return Posicion del vector en el conjunto, o -1 si no esta.
+ */
+int buscarPersonalizacion(const PageRankPersonalizado *personalizado, const char *nombre);
+
+/**
+ * @brief Obtiene el PageRank de un documento en el vector global o en uno personalizado.
+ *
+ * Es el valor con el que las consultas por relevancia calculan el puntaje.
+ *
+ * @param contexto Contexto leido con entrarLectura() (puede ser NULL).
+ * @param vector Posicion del vector personalizado (ver buscarPersonalizacion()), o -1 para el global.
+ * @param docID Documento.
+ * @return Valor del documento, o 0 si el vector no lo incluye.
+ */
+double pageRankContexto(const ContextoLectura *contexto, int vector, int docID);
+
+/**
+ * @brief Empieza una lectura del contexto vigente.
+ *
+ * Las lecturas se pueden anidar; todas las del mismo hilo devuelven el contexto
+ * que obtuvo la mas externa. Cada llamada debe terminar con salirLectura().
+ *
+ * @return Contexto vigente, o NULL si todavia no se publico ninguno.
+ */
+const ContextoLectura *entrarLectura();
+
+/**
+ * @brief Termina una lectura empezada con entrarLectura().
+ */
+void salirLectura();
+
+#endif
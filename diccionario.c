@@ -0,0 +1,488 @@
+/**
+ * @file diccionario.c
+ * @brief Implementacion del diccionario ordenado con codificacion de prefijos.
+ */
+
+#include "diccionario.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "incremental.h"
+#include "index.h"
+#include "instrumentacion.h"
+#include "snapshot.h"
+#include "tokenizador.h"
+
+#define DICCIONARIO_LARGO_MAXIMO TOKENIZADOR_LARGO_MAXIMO ///< Bytes maximos de una palabra del diccionario.
+
+_Static_assert(DICCIONARIO_LARGO_MAXIMO < 256, "Los largos del diccionario se guardan en un byte");
+
+/**
+ * @struct PalabraDiccionario
+ * @brief Palabra del indice durante el armado del diccionario.
+ */
+typedef struct {
+    const char *palabra; ///< Palabra (apunta al indice, a la instantanea o a un segmento delta).
+    size_t longitud; ///< Longitud de la palabra en bytes.
+} PalabraDiccionario;
+
+/**
+ * @struct RecoleccionDiccionario
+ * @brief Palabras juntadas de todas las fuentes, todavia sin ordenar.
+ */
+typedef struct {
+    PalabraDiccionario *palabras; ///< Palabras, con repeticiones.
+    int numPalabras; ///< Palabras juntadas.
+    int capacidad; ///< Capacidad reservada.
+    size_t bytes; ///< Cota de los bytes codificados: cada palabra completa mas dos largos.
+} RecoleccionDiccionario;
+
+/**
+ * @struct DiccionarioOrdenado
+ * @brief Palabras ordenadas por bytes, en bloques con codificacion de prefijos.
+ *
+ * La primera palabra de cada bloque se guarda como un byte de largo y sus bytes;
+ * las demas como un byte con los bytes compartidos con la anterior, un byte con
+ * los que siguen y esos bytes.
+ */
+typedef struct {
+    unsigned char *datos; ///< Bloques codificados, uno detras de otro.
+    size_t bytes; ///< Bytes usados en datos.
+    size_t *bloques; ///< Inicio de cada bloque en datos.
+    int numBloques; ///< Numero de bloques.
+    int numPalabras; ///< Palabras distintas.
+    long vocabulario; ///< Version de las palabras del indice con la que se armo, o 0 si nunca se armo.
+    long construcciones; ///< Veces que se armo.
+} DiccionarioOrdenado;
+
+/**
+ * @struct CursorDiccionario
+ * @brief Posicion de lectura dentro del diccionario.
+ */
+typedef struct {
+    int indice; ///< Palabra actual, o numPalabras si se agoto.
+    const unsigned char *siguiente; ///< Proximo byte a decodificar.
+    char palabra[DICCIONARIO_LARGO_MAXIMO + 1]; ///< Palabra actual, terminada en '\0'.
+    size_t longitud; ///< Longitud de la palabra actual.
+} CursorDiccionario;
+
+static pthread_mutex_t candadoDiccionario = PTHREAD_MUTEX_INITIALIZER;
+static DiccionarioOrdenado diccionario;
+
+/**
+ * @brief Agrega una palabra a la recoleccion.
+ *
+ * @param palabra Palabra.
+ * @param longitud Longitud de la palabra en bytes.
+ * @param contexto RecoleccionDiccionario.
+ */
+static void recolectarPalabra(const char *palabra, size_t longitud, void *contexto) {
+    RecoleccionDiccionario *recoleccion = contexto;
+    if (longitud == 0 || longitud > DICCIONARIO_LARGO_MAXIMO) {
+        return;
+    }
+    if (recoleccion->numPalabras == recoleccion->capacidad) {
+        int capacidad = recoleccion->capacidad ? recoleccion->capacidad * 2 : 1024;
+        PalabraDiccionario *palabras = realloc(recoleccion->palabras, capacidad * sizeof(PalabraDiccionario));
+        if (!palabras) {
+            perror("No se pudo reservar el diccionario ordenado");
+            exit(EXIT_FAILURE);
+        }
+        recoleccion->palabras = palabras;
+        recoleccion->capacidad = capacidad;
+    }
+    recoleccion->palabras[recoleccion->numPalabras].palabra = palabra;
+    recoleccion->palabras[recoleccion->numPalabras].longitud = longitud;
+    recoleccion->numPalabras++;
+    recoleccion->bytes += longitud + 2;
+}
+
+/**
+ * @brief Agrega a la recoleccion la palabra de una lista de postings.
+ *
+ * @param lista Lista de postings.
+ * @param contexto RecoleccionDiccionario.
+ */
+static void recolectarLista(const ListaPostings *lista, void *contexto) {
+    recolectarPalabra(lista->palabra, lista->longitud, contexto);
+}
+
+/**
+ * @brief Compara dos cadenas de bytes sin signo, como memcmp con desempate por largo.
+ *
+ * @param a Primera cadena.
+ * @param largoA Largo de a.
+ * @param b Segunda cadena.
+ * @param largoB Largo de b.
+ * @return Negativo, cero o positivo segun a sea menor, igual o mayor que b.
+ */
+static int compararBytes(const char *a, size_t largoA, const char *b, size_t largoB) {
+    int comparacion = memcmp(a, b, largoA < largoB ? largoA : largoB);
+    if (comparacion != 0) {
+        return comparacion;
+    }
+    return (largoA > largoB) - (largoA < largoB);
+}
+
+/**
+ * @brief Compara dos palabras para qsort.
+ *
+ * @param a Puntero a la primera PalabraDiccionario.
+ * @param b Puntero a la segunda PalabraDiccionario.
+ * @return Negativo, cero o positivo segun el orden por bytes.
+ */
+static int compararPalabras(const void *a, const void *b) {
+    const PalabraDiccionario *x = a;
+    const PalabraDiccionario *y = b;
+    return compararBytes(x->palabra, x->longitud, y->palabra, y->longitud);
+}
+
+/**
+ * @brief Arma el diccionario con las palabras actuales del indice.
+ *
+ * Junta las palabras del indice en memoria, de la instantanea y de los segmentos
+ * delta, las ordena, descarta las repetidas y las codifica por bloques.
+ */
+static void construirDiccionario() {
+    INSTRUMENTAR_INICIO(inicio);
+    RecoleccionDiccionario recoleccion;
+    memset(&recoleccion, 0, sizeof(recoleccion));
+    recorrerIndice(recolectarLista, &recoleccion);
+    recorrerSnapshot(recolectarLista, &recoleccion);
+    recorrerPalabrasIncremental(recolectarPalabra, &recoleccion);
+    qsort(recoleccion.palabras, recoleccion.numPalabras, sizeof(PalabraDiccionario), compararPalabras);
+
+    free(diccionario.datos);
+    free(diccionario.bloques);
+    int maxBloques = (recoleccion.numPalabras + DICCIONARIO_PALABRAS_POR_BLOQUE - 1) / DICCIONARIO_PALABRAS_POR_BLOQUE;
+    diccionario.datos = malloc(recoleccion.bytes ? recoleccion.bytes : 1);
+    diccionario.bloques = malloc((maxBloques ? maxBloques : 1) * sizeof(size_t));
+    if (!diccionario.datos || !diccionario.bloques) {
+        perror("No se pudo reservar el diccionario ordenado");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t bytes = 0;
+    int numPalabras = 0;
+    const PalabraDiccionario *anterior = NULL;
+    for (int i = 0; i < recoleccion.numPalabras; i++) {
+        const PalabraDiccionario *actual = &recoleccion.palabras[i];
+        if (anterior && compararPalabras(anterior, actual) == 0) {
+            continue;
+        }
+        size_t comun = 0;
+        if (numPalabras % DICCIONARIO_PALABRAS_POR_BLOQUE == 0) {
+            diccionario.bloques[numPalabras / DICCIONARIO_PALABRAS_POR_BLOQUE] = bytes;
+        } else {
+            while (comun < anterior->longitud && comun < actual->longitud &&
+                   anterior->palabra[comun] == actual->palabra[comun]) {
+                comun++;
+            }
+            diccionario.datos[bytes++] = (unsigned char)comun;
+        }
+        diccionario.datos[bytes++] = (unsigned char)(actual->longitud - comun);
+        memcpy(diccionario.datos + bytes, actual->palabra + comun, actual->longitud - comun);
+        bytes += actual->longitud - comun;
+        numPalabras++;
+        anterior = actual;
+    }
+    diccionario.bytes = bytes;
+    diccionario.numPalabras = numPalabras;
+    diccionario.numBloques = (numPalabras + DICCIONARIO_PALABRAS_POR_BLOQUE - 1) / DICCIONARIO_PALABRAS_POR_BLOQUE;
+    diccionario.construcciones++;
+    free(recoleccion.palabras);
+    INSTRUMENTAR_FIN(TIEMPO_DICCIONARIO, inicio);
+}
+
+/**
+ * @brief Vuelve a armar el diccionario si las palabras del indice cambiaron desde la ultima vez.
+ *
+ * Se llama con candadoDiccionario tomado.
+ */
+static void actualizarDiccionario() {
+    // La version se lee antes de armarlo, como hace la cache de consultas con la generacion.
+    long vocabulario = obtenerVocabularioIndice();
+    if (diccionario.vocabulario != vocabulario) {
+        construirDiccionario();
+        diccionario.vocabulario = vocabulario;
+    }
+}
+
+/**
+ * @brief Ubica el cursor en la primera palabra de un bloque.
+ *
+ * @param c Cursor.
+ * @param bloque Bloque.
+ */
+static void leerInicioBloque(CursorDiccionario *c, int bloque) {
+    const unsigned char *p = diccionario.datos + diccionario.bloques[bloque];
+    c->indice = bloque * DICCIONARIO_PALABRAS_POR_BLOQUE;
+    c->longitud = *p++;
+    memcpy(c->palabra, p, c->longitud);
+    c->palabra[c->longitud] = '\0';
+    c->siguiente = p + c->longitud;
+}
+
+/**
+ * @brief Avanza el cursor a la palabra siguiente.
+ *
+ * @param c Cursor en una palabra.
+ * @return 1 si quedo en una palabra, 0 si el diccionario se agoto.
+ */
+static int siguientePalabraCursor(CursorDiccionario *c) {
+    if (c->indice + 1 >= diccionario.numPalabras) {
+        c->indice = diccionario.numPalabras;
+        return 0;
+    }
+    if ((c->indice + 1) % DICCIONARIO_PALABRAS_POR_BLOQUE == 0) {
+        leerInicioBloque(c, (c->indice + 1) / DICCIONARIO_PALABRAS_POR_BLOQUE);
+        return 1;
+    }
+    const unsigned char *p = c->siguiente;
+    size_t comun = p[0];
+    size_t resto = p[1];
+    memcpy(c->palabra + comun, p + 2, resto);
+    c->longitud = comun + resto;
+    c->palabra[c->longitud] = '\0';
+    c->siguiente = p + 2 + resto;
+    c->indice++;
+    return 1;
+}
+
+/**
+ * @brief Ubica el cursor en la primera palabra mayor o igual a una clave.
+ *
+ * Busca por biseccion el ultimo bloque que empieza con una palabra menor o igual
+ * a la clave y avanza dentro de el.
+ *
+ * @param c Cursor.
+ * @param clave Clave.
+ * @param largo Largo de la clave en bytes.
+ * @return 1 si quedo en una palabra, 0 si todas son menores que la clave.
+ */
+static int posicionarCursor(CursorDiccionario *c, const char *clave, size_t largo) {
+    if (diccionario.numPalabras == 0) {
+        c->indice = 0;
+        return 0;
+    }
+    int bajo = 0;
+    int alto = diccionario.numBloques - 1;
+    while (bajo < alto) {
+        int medio = bajo + (alto - bajo + 1) / 2;
+        const unsigned char *inicio = diccionario.datos + diccionario.bloques[medio];
+        if (compararBytes((const char *)inicio + 1, inicio[0], clave, largo) <= 0) {
+            bajo = medio;
+        } else {
+            alto = medio - 1;
+        }
+    }
+    leerInicioBloque(c, bajo);
+    while (compararBytes(c->palabra, c->longitud, clave, largo) < 0) {
+        if (!siguientePalabraCursor(c)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Recorre en orden las palabras del indice que empiezan con un prefijo.
+ *
+ * @param prefijo Prefijo (no necesita terminar en '\0').
+ * @param longitud Longitud del prefijo en bytes.
+ * @param visitar Funcion llamada con cada palabra.
+ * @param contexto Puntero que se pasa sin cambios a visitar.
+ * @return Numero de palabras encontradas.
+ */
+int buscarPrefijoDiccionario(const char *prefijo, size_t longitud, VisitaPalabraDiccionario visitar, void *contexto) {
+    pthread_mutex_lock(&candadoDiccionario);
+    actualizarDiccionario();
+    CursorDiccionario c;
+    int encontradas = 0;
+    int hay = posicionarCursor(&c, prefijo, longitud);
+    while (hay && c.longitud >= longitud && memcmp(c.palabra, prefijo, longitud) == 0) {
+        visitar(c.palabra, c.longitud, contexto);
+        encontradas++;
+        hay = siguientePalabraCursor(&c);
+    }
+    pthread_mutex_unlock(&candadoDiccionario);
+    return encontradas;
+}
+
+/**
+ * @brief Devuelve cuantos bytes ocupa un caracter UTF-8 segun su primer byte.
+ *
+ * @param byte Primer byte.
+ * @return Entre 1 y 4; un byte de continuacion suelto cuenta como un caracter.
+ */
+static int largoCaracter(unsigned char byte) {
+    return byte < 0xC0 ? 1 : byte < 0xE0 ? 2 : byte < 0xF0 ? 3 : 4;
+}
+
+/**
+ * @brief Junta los bytes de un caracter en un entero, para compararlo de una vez.
+ *
+ * @param bytes Bytes del caracter.
+ * @param largo Entre 1 y 4.
+ * @return Valor que solo coincide con el de los mismos bytes.
+ */
+static uint32_t empaquetarCaracter(const char *bytes, size_t largo) {
+    uint32_t valor = 0;
+    for (size_t i = 0; i < largo; i++) {
+        valor = valor << 8 | (unsigned char)bytes[i];
+    }
+    return valor;
+}
+
+/**
+ * @brief Recorre en orden las palabras del indice a distancia de Levenshtein acotada de una palabra.
+ *
+ * filas[d] es la fila de la matriz de distancias entre los primeros d bytes de
+ * la palabra del diccionario y cada prefijo de la buscada. Las filas del
+ * prefijo que la palabra comparte con la anterior se reutilizan. En medio de un
+ * caracter de varios bytes la fila se copia y se calcula al completarlo. Si el
+ * minimo de una fila supera el limite, ninguna palabra con ese prefijo sirve y
+ * el cursor salta a la primera palabra mayor que todas ellas.
+ *
+ * @param palabra Palabra buscada (no necesita terminar en '\0').
+ * @param longitud Longitud de la palabra en bytes.
+ * @param errores Distancia maxima, entre 0 y DICCIONARIO_MAX_ERRORES.
+ * @param visitar Funcion llamada con cada palabra.
+ * @param contexto Puntero que se pasa sin cambios a visitar.
+ * @return Numero de palabras encontradas.
+ */
+int buscarDifusoDiccionario(const char *palabra, size_t longitud, int errores, VisitaPalabraDiccionario visitar,
+                            void *contexto) {
+    if (longitud > DICCIONARIO_LARGO_MAXIMO || errores < 0) {
+        return 0;
+    }
+    if (errores > DICCIONARIO_MAX_ERRORES) {
+        errores = DICCIONARIO_MAX_ERRORES;
+    }
+    uint32_t patron[DICCIONARIO_LARGO_MAXIMO];
+    size_t m = 0;
+    for (size_t i = 0; i < longitud;) {
+        size_t largo = (size_t)largoCaracter((unsigned char)palabra[i]);
+        if (i + largo > longitud) {
+            largo = longitud - i;
+        }
+        patron[m++] = empaquetarCaracter(palabra + i, largo);
+        i += largo;
+    }
+
+    // Las distancias no superan DICCIONARIO_LARGO_MAXIMO, asi que caben en un byte.
+    unsigned char filas[DICCIONARIO_LARGO_MAXIMO + 1][DICCIONARIO_LARGO_MAXIMO + 1];
+    unsigned char restantes[DICCIONARIO_LARGO_MAXIMO + 1]; // Bytes que faltan del caracter empezado.
+    unsigned char inicioCaracter[DICCIONARIO_LARGO_MAXIMO + 1]; // Byte donde empieza el ultimo caracter.
+    char camino[DICCIONARIO_LARGO_MAXIMO]; // Prefijo al que corresponden las filas calculadas.
+    for (size_t j = 0; j <= m; j++) {
+        filas[0][j] = (unsigned char)j;
+    }
+    restantes[0] = 0;
+    inicioCaracter[0] = 0;
+    size_t validas = 0;
+
+    pthread_mutex_lock(&candadoDiccionario);
+    actualizarDiccionario();
+    CursorDiccionario c;
+    int encontradas = 0;
+    int hay = posicionarCursor(&c, "", 0);
+    while (hay) {
+        size_t d = 0;
+        while (d < validas && d < c.longitud && camino[d] == c.palabra[d]) {
+            d++;
+        }
+        int podada = 0;
+        while (d < c.longitud) {
+            camino[d] = c.palabra[d];
+            if (restantes[d] == 0) {
+                inicioCaracter[d + 1] = (unsigned char)d;
+                restantes[d + 1] = (unsigned char)(largoCaracter((unsigned char)c.palabra[d]) - 1);
+            } else {
+                inicioCaracter[d + 1] = inicioCaracter[d];
+                restantes[d + 1] = restantes[d] - 1;
+            }
+            const unsigned char *previa = filas[d];
+            unsigned char *fila = filas[++d];
+            if (restantes[d] > 0) {
+                memcpy(fila, previa, m + 1);
+                continue;
+            }
+            uint32_t caracter = empaquetarCaracter(c.palabra + inicioCaracter[d], d - inicioCaracter[d]);
+            fila[0] = previa[0] + 1;
+            unsigned char minimo = fila[0];
+            for (size_t j = 1; j <= m; j++) {
+                unsigned char valor = previa[j - 1] + (patron[j - 1] != caracter);
+                if (previa[j] + 1 < valor) {
+                    valor = previa[j] + 1;
+                }
+                if (fila[j - 1] + 1 < valor) {
+                    valor = fila[j - 1] + 1;
+                }
+                fila[j] = valor;
+                if (valor < minimo) {
+                    minimo = valor;
+                }
+            }
+            if (minimo > errores) {
+                podada = 1;
+                break;
+            }
+        }
+        validas = d;
+
+        if (!podada) {
+            if (filas[c.longitud][m] <= errores) {
+                visitar(c.palabra, c.longitud, contexto);
+                encontradas++;
+            }
+            hay = siguientePalabraCursor(&c);
+            continue;
+        }
+        // La primera palabra mayor que todas las que empiezan con camino[0..d).
+        char sucesor[DICCIONARIO_LARGO_MAXIMO];
+        size_t largo = d;
+        memcpy(sucesor, camino, largo);
+        while (largo > 0 && (unsigned char)sucesor[largo - 1] == 0xFF) {
+            largo--;
+        }
+        if (largo == 0) {
+            break;
+        }
+        sucesor[largo - 1]++;
+        hay = posicionarCursor(&c, sucesor, largo);
+    }
+    pthread_mutex_unlock(&candadoDiccionario);
+    return encontradas;
+}
+
+/**
+ * @brief Elige la distancia de una busqueda difusa segun el largo de la palabra.
+ *
+ * @param palabra Palabra.
+ * @param longitud Longitud de la palabra en bytes.
+ * @return Distancia maxima.
+ */
+int erroresPorDefectoDiccionario(const char *palabra, size_t longitud) {
+    size_t caracteres = 0;
+    for (size_t i = 0; i < longitud; i++) {
+        caracteres += ((unsigned char)palabra[i] & 0xC0) != 0x80;
+    }
+    return caracteres <= 2 ? 0 : caracteres <= 5 ? 1 : 2;
+}
+
+/**
+ * @brief Obtiene el tamano del diccionario, armandolo si hace falta.
+ *
+ * @param estadisticas Salida.
+ */
+void obtenerEstadisticasDiccionario(EstadisticasDiccionario *estadisticas) {
+    pthread_mutex_lock(&candadoDiccionario);
+    actualizarDiccionario();
+    estadisticas->palabras = diccionario.numPalabras;
+    estadisticas->bytes = diccionario.bytes + (size_t)diccionario.numBloques * sizeof(size_t);
+    estadisticas->construcciones = diccionario.construcciones;
+    pthread_mutex_unlock(&candadoDiccionario);
+}
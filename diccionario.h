@@ -0,0 +1,104 @@
+/**
+ * @file diccionario.h
+ * @brief Diccionario ordenado de las palabras del indice, para prefijos y busqueda difusa.
+ *
+ * La tabla hash del indice solo encuentra palabras exactas. Este diccionario
+ * guarda todas las palabras ordenadas por bytes y con codificacion de prefijos
+ * (front coding): en cada bloque de DICCIONARIO_PALABRAS_POR_BLOQUE palabras la
+ * primera va completa y las demas solo guardan cuantos bytes comparten con la
+ * anterior y el resto. Una busqueda binaria sobre la primera palabra de cada
+ * bloque ubica cualquier palabra.
+ *
+ * Con eso se responden dos preguntas en un tiempo que depende de las respuestas
+ * y no del vocabulario: las palabras que empiezan con un prefijo (un rango
+ * contiguo) y las que estan a distancia de Levenshtein acotada de una palabra.
+ * La busqueda difusa recorre el orden como si fuera un trie, con una fila de la
+ * matriz de distancias por byte del prefijo comun, y cuando ningun valor de la
+ * fila queda dentro del limite salta con la busqueda binaria todas las palabras
+ * que comparten ese prefijo. La distancia se mide en caracteres UTF-8, asi que
+ * "nino" esta a distancia 1 de "niño".
+ *
+ * El diccionario se arma con las palabras del indice en memoria, de la
+ * instantanea y de los segmentos delta la primera vez que se usa, y se vuelve a
+ * armar cuando cambia el conjunto de palabras (ver obtenerVocabularioIndice());
+ * recalcular el PageRank o las frecuencias no lo vuelve a armar.
+ * Es seguro entre hilos; quien lo usa debe tener el candado del indice tomado
+ * (ver bloquearIndiceLectura()).
+ */
+
+#ifndef DICCIONARIO_H
+#define DICCIONARIO_H
+
+#include <stddef.h>
+
+#define DICCIONARIO_PALABRAS_POR_BLOQUE 16 ///< Palabras por bloque; la primera de cada uno va completa.
+#define DICCIONARIO_MAX_ERRORES 2 ///< Mayor distancia de Levenshtein que admite la busqueda difusa.
+
+/**
+ * @struct EstadisticasDiccionario
+ * @brief Tamano del diccionario ordenado.
+ */
+typedef struct {
+    int palabras; ///< Palabras distintas.
+    size_t bytes; ///< Bytes de las palabras codificadas y de los inicios de bloque.
+    long construcciones; ///< Veces que se armo desde el arranque.
+} EstadisticasDiccionario;
+
+/**
+ * @brief Funcion que recibe cada palabra encontrada en el diccionario.
+ *
+ * La palabra solo es valida durante la llamada. No debe usar el diccionario.
+ *
+ * @param palabra Palabra, terminada en '\0'.
+ * @param longitud Longitud de la palabra en bytes.
+ * @param contexto Datos del llamador.
+ */
+typedef void (*VisitaPalabraDiccionario)(const char *palabra, size_t longitud, void *contexto);
+
+/**
+ * @brief Recorre en orden las palabras del indice que empiezan con un prefijo.
+ *
+ * @param prefijo Prefijo (no necesita terminar en '\0').
+ * @param longitud Longitud del prefijo en bytes.
+ * @param visitar Funcion llamada con cada palabra.
+ * @param contexto Puntero que se pasa sin cambios a visitar.
+ * @return Numero de palabras encontradas.
+ */
+int buscarPrefijoDiccionario(const char *prefijo, size_t longitud, VisitaPalabraDiccionario visitar, void *contexto);
+
+/**
+ * @brief Recorre en orden las palabras del indice a distancia de Levenshtein acotada de una palabra.
+ *
+ * Cuenta como un error cada insercion, borrado o cambio de un caracter.
+ *
+ * @param palabra Palabra buscada (no necesita terminar en '\0').
+ * @param longitud Longitud de la palabra en bytes.
+ * @param errores Distancia maxima, entre 0 y DICCIONARIO_MAX_ERRORES.
+ * @param visitar Funcion llamada con cada palabra.
+ * @param contexto Puntero que se pasa sin cambios a visitar.
+ * @return Numero de palabras encontradas.
+ */
+int buscarDifusoDiccionario(const char *palabra, size_t longitud, int errores, VisitaPalabraDiccionario visitar,
+                            void *contexto);
+
+/**
+ * @brief Elige la distancia de una busqueda difusa segun el largo de la palabra.
+ *
+ * 0 errores hasta 2 caracteres, 1 hasta 5 y 2 desde 6.
+ *
+ * @param palabra Palabra.
+ * @param longitud Longitud de la palabra en bytes.
+ * @return Distancia maxima.
+ */
+int erroresPorDefectoDiccionario(const char *palabra, size_t longitud);
+
+/**
+ * @brief Obtiene el tamano del diccionario, armandolo si hace falta.
+ *
+ * Quien la llama debe tener el candado del indice tomado.
+ *
+ * @param estadisticas Salida.
+ */
+void obtenerEstadisticasDiccionario(EstadisticasDiccionario *estadisticas);
+
+#endif
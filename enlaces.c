@@ -0,0 +1,568 @@
+/**
+ * @file enlaces.c
+ * @brief Implementacion de la carga masiva de enlaces.
+ *
+ * Durante la carga cada enlace numerico se anota como un par de 64 bits (docID
+ * del origen, docID del destino) y cada enlace por nombre como el origen mas el
+ * nombre. Al terminar, ambos se convierten en claves
+ * origen << bits | destino, donde bits alcanza para el mayor docID, que un radix
+ * sort LSD ordena en pocas pasadas; los repetidos quedan contiguos y el arreglo
+ * CSR sale de recorrer las claves una vez.
+ *
+ * Los nombres se resuelven con una tabla hash de la clave normalizada de cada
+ * documento, que se completa a medida que aparecen documentos nuevos. Solo la
+ * usa el hilo que carga o sincroniza.
+ *
+ * Una sincronizacion tambien resuelve en dos etapas: los enlaces de cada archivo
+ * se aplazan hasta que todos los archivos nuevos tienen docID, asi que un archivo
+ * puede enlazar a otro que se agrega despues en la misma sincronizacion.
+ */
+
+#include "enlaces.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "graph.h"
+#include "index.h"
+#include "instrumentacion.h"
+#include "tokenizador.h"
+
+/**
+ * @struct EnlacePorNombre
+ * @brief Enlace por nombre anotado durante la carga.
+ */
+typedef struct {
+    int origen; ///< docID del documento que enlaza.
+    size_t offset; ///< Posicion del nombre en nombresPendientes.
+} EnlacePorNombre;
+
+/**
+ * @struct RanuraNombre
+ * @brief Ranura de la tabla de nombres de documento.
+ */
+typedef struct {
+    uint64_t hash; ///< Hash de la clave.
+    size_t offset; ///< Posicion de la clave en textoNombres.
+    int documento; ///< docID + 1, o 0 si la ranura esta vacia.
+} RanuraNombre;
+
+static uint64_t *pares; ///< Enlaces numericos de la carga: origen << 32 | destino.
+static size_t numPares; ///< Pares anotados.
+static size_t capacidadPares; ///< Capacidad reservada de pares.
+static EnlacePorNombre *enlacesPorNombre; ///< Enlaces por nombre de la carga.
+static size_t numEnlacesPorNombre; ///< Enlaces por nombre anotados.
+static size_t capacidadEnlacesPorNombre; ///< Capacidad reservada de enlacesPorNombre.
+static char *nombresPendientes; ///< Nombres de los enlaces de la carga, terminados en '\0'.
+static size_t bytesNombresPendientes; ///< Bytes usados en nombresPendientes.
+static size_t capacidadNombresPendientes; ///< Bytes reservados en nombresPendientes.
+
+static RanuraNombre *ranurasNombres; ///< Tabla hash de claves de nombre a docID.
+static size_t capacidadRanurasNombres; ///< Numero de ranuras (potencia de dos).
+static int numNombres; ///< Claves en la tabla.
+static char *textoNombres; ///< Claves de la tabla, terminadas en '\0'.
+static size_t bytesTextoNombres; ///< Bytes usados en textoNombres.
+static size_t capacidadTextoNombres; ///< Bytes reservados en textoNombres.
+static int docsConNombre; ///< Documentos ya revisados para la tabla de nombres.
+
+static DocumentoParcial *aplazados; ///< Enlaces aplazados de la sincronizacion en curso (solo los enlaces).
+static int *origenesAplazados; ///< docID de cada documento de aplazados.
+static int numAplazados; ///< Documentos con enlaces aplazados.
+static int capacidadAplazados; ///< Capacidad reservada de aplazados y origenesAplazados.
+
+static EstadisticasEnlaces estadisticasEnlaces; ///< Enlaces leidos y descartados desde la ultima carga.
+
+/**
+ * @brief Reserva o amplia un arreglo, terminando el programa si no hay memoria.
+ *
+ * @param bloque Arreglo actual (puede ser NULL).
+ * @param bytes Nuevo tamano en bytes.
+ * @return Arreglo ampliado.
+ */
+static void *ampliarEnlaces(void *bloque, size_t bytes) {
+    void *nuevo = realloc(bloque, bytes ? bytes : 1);
+    if (!nuevo) {
+        perror("No se pudo reservar memoria para los enlaces");
+        exit(EXIT_FAILURE);
+    }
+    return nuevo;
+}
+
+/**
+ * @brief Quita la extension ".txt" de un nombre, si la tiene.
+ *
+ * @param nombre Nombre.
+ * @param longitud Longitud del nombre.
+ * @return Longitud sin la extension.
+ */
+static size_t sinExtension(const char *nombre, size_t longitud) {
+    if (longitud > 4 && memcmp(nombre + longitud - 4, ".txt", 4) == 0) {
+        return longitud - 4;
+    }
+    return longitud;
+}
+
+/**
+ * @brief Calcula la clave con la que se enlaza un documento por su nombre.
+ *
+ * Pasa "link:" mas el nombre del archivo por el tokenizador, de modo que la
+ * clave se normaliza igual que los tokens de los documentos.
+ *
+ * @param ruta Nombre del documento (ruta del archivo).
+ * @param clave Salida: clave sin ".txt", de al menos TOKENIZADOR_LARGO_MAXIMO + 1 bytes.
+ * @return Longitud de la clave, o 0 si el nombre no cabe en un token de enlace.
+ */
+static size_t claveNombreArchivo(const char *ruta, char *clave) {
+    const char *barra = strrchr(ruta, '/');
+    const char *nombre = barra ? barra + 1 : ruta;
+    size_t longitud = strlen(nombre);
+    char texto[2 * TOKENIZADOR_LARGO_MAXIMO];
+    if (longitud == 0 || longitud + 5 > sizeof(texto)) {
+        return 0;
+    }
+    memcpy(texto, "link:", 5);
+    memcpy(texto + 5, nombre, longitud);
+
+    Tokenizador t;
+    char palabra[TOKENIZADOR_LARGO_MAXIMO + 1];
+    iniciarTokenizador(&t, texto, longitud + 5);
+    size_t largo = siguienteToken(&t, palabra);
+    // Un nombre con espacios u otros separadores no se puede escribir en un solo token.
+    if (largo <= 5 || memcmp(palabra, "link:", 5) != 0 || t.actual != t.fin) {
+        return 0;
+    }
+    largo = sinExtension(palabra + 5, largo - 5);
+    memcpy(clave, palabra + 5, largo);
+    clave[largo] = '\0';
+    return largo;
+}
+
+/**
+ * @brief Duplica la tabla de nombres.
+ */
+static void redimensionarNombres() {
+    size_t capacidad = capacidadRanurasNombres ? capacidadRanurasNombres * 2 : 1024;
+    RanuraNombre *ranuras = calloc(capacidad, sizeof(RanuraNombre));
+    if (!ranuras) {
+        perror("No se pudo reservar memoria para los enlaces");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t r = 0; r < capacidadRanurasNombres; r++) {
+        if (ranurasNombres[r].documento) {
+            size_t i = (size_t)ranurasNombres[r].hash & (capacidad - 1);
+            while (ranuras[i].documento) {
+                i = (i + 1) & (capacidad - 1);
+            }
+            ranuras[i] = ranurasNombres[r];
+        }
+    }
+    free(ranurasNombres);
+    ranurasNombres = ranuras;
+    capacidadRanurasNombres = capacidad;
+}
+
+/**
+ * @brief Busca la ranura de una clave en la tabla de nombres.
+ *
+ * @param clave Clave.
+ * @param longitud Longitud de la clave.
+ * @param hash Hash de la clave.
+ * @return Ranura con la clave, o la ranura vacia donde iria.
+ */
+static RanuraNombre *buscarRanuraNombre(const char *clave, size_t longitud, uint64_t hash) {
+    size_t mascara = capacidadRanurasNombres - 1;
+    size_t i = (size_t)hash & mascara;
+    while (ranurasNombres[i].documento) {
+        const char *guardada = textoNombres + ranurasNombres[i].offset;
+        if (ranurasNombres[i].hash == hash && strncmp(guardada, clave, longitud) == 0 && guardada[longitud] == '\0') {
+            break;
+        }
+        i = (i + 1) & mascara;
+    }
+    return &ranurasNombres[i];
+}
+
+/**
+ * @brief Agrega a la tabla de nombres los documentos cargados desde la ultima vez.
+ *
+ * Si dos archivos tienen la misma clave (por ejemplo, "A.txt" y "a.txt"), el
+ * nombre enlaza al de menor docID.
+ */
+static void registrarNombresNuevos() {
+    int total = totalDocumentosCargados();
+    char clave[TOKENIZADOR_LARGO_MAXIMO + 1];
+    for (; docsConNombre < total; docsConNombre++) {
+        const char *nombre = obtenerNombreDocumento(docsConNombre);
+        size_t longitud = nombre ? claveNombreArchivo(nombre, clave) : 0;
+        if (longitud == 0) {
+            continue;
+        }
+        if ((size_t)(numNombres + 1) * 10 > capacidadRanurasNombres * 7) {
+            redimensionarNombres();
+        }
+        uint64_t hash = calcularHash(clave, longitud);
+        RanuraNombre *ranura = buscarRanuraNombre(clave, longitud, hash);
+        if (ranura->documento) {
+            continue;
+        }
+        if (bytesTextoNombres + longitud + 1 > capacidadTextoNombres) {
+            capacidadTextoNombres = capacidadTextoNombres ? capacidadTextoNombres * 2 : 16384;
+            while (capacidadTextoNombres < bytesTextoNombres + longitud + 1) {
+                capacidadTextoNombres *= 2;
+            }
+            textoNombres = ampliarEnlaces(textoNombres, capacidadTextoNombres);
+        }
+        memcpy(textoNombres + bytesTextoNombres, clave, longitud + 1);
+        ranura->hash = hash;
+        ranura->offset = bytesTextoNombres;
+        ranura->documento = docsConNombre + 1;
+        bytesTextoNombres += longitud + 1;
+        numNombres++;
+    }
+}
+
+/**
+ * @brief Busca el documento que corresponde a un nombre de enlace.
+ *
+ * @param nombre Nombre normalizado, sin el prefijo "link:" (con o sin ".txt").
+ * @return docID del documento, o -1 si ninguno tiene ese nombre.
+ */
+int buscarDocumentoPorNombreEnlace(const char *nombre) {
+    registrarNombresNuevos();
+    if (numNombres == 0) {
+        return -1;
+    }
+    size_t longitud = sinExtension(nombre, strlen(nombre));
+    RanuraNombre *ranura = buscarRanuraNombre(nombre, longitud, calcularHash(nombre, longitud));
+    return ranura->documento - 1;
+}
+
+/**
+ * @brief Vacia la tabla de nombres.
+ */
+static void vaciarNombres() {
+    if (ranurasNombres) {
+        memset(ranurasNombres, 0, capacidadRanurasNombres * sizeof(RanuraNombre));
+    }
+    numNombres = 0;
+    bytesTextoNombres = 0;
+    docsConNombre = 0;
+}
+
+/**
+ * @brief Empieza una carga de enlaces y pone en cero las estadisticasEnlaces.
+ *
+ * La tabla de nombres se vacia, porque la carga vuelve a asignar los docID.
+ */
+void iniciarCargaEnlaces() {
+    numPares = 0;
+    numEnlacesPorNombre = 0;
+    bytesNombresPendientes = 0;
+    vaciarNombres();
+    memset(&estadisticasEnlaces, 0, sizeof(estadisticasEnlaces));
+}
+
+/**
+ * @brief Anota los enlaces de un documento de la carga.
+ *
+ * Los destinos numericos se validan al terminar, cuando se conoce el total de
+ * documentos.
+ *
+ * @param origen docID del documento.
+ * @param parcial Documento parcial con sus enlaces.
+ */
+void recolectarEnlaces(int origen, const DocumentoParcial *parcial) {
+    if (numPares + parcial->numEnlaces > capacidadPares) {
+        capacidadPares = capacidadPares ? capacidadPares * 2 : 4096;
+        while (capacidadPares < numPares + parcial->numEnlaces) {
+            capacidadPares *= 2;
+        }
+        pares = ampliarEnlaces(pares, capacidadPares * sizeof(uint64_t));
+    }
+    for (int e = 0; e < parcial->numEnlaces; e++) {
+        pares[numPares++] = (uint64_t)origen << 32 | (uint32_t)parcial->enlaces[e];
+    }
+
+    if (parcial->numNombresEnlaces) {
+        if (numEnlacesPorNombre + parcial->numNombresEnlaces > capacidadEnlacesPorNombre) {
+            capacidadEnlacesPorNombre = capacidadEnlacesPorNombre ? capacidadEnlacesPorNombre * 2 : 1024;
+            while (capacidadEnlacesPorNombre < numEnlacesPorNombre + parcial->numNombresEnlaces) {
+                capacidadEnlacesPorNombre *= 2;
+            }
+            enlacesPorNombre = ampliarEnlaces(enlacesPorNombre, capacidadEnlacesPorNombre * sizeof(EnlacePorNombre));
+        }
+        if (bytesNombresPendientes + parcial->bytesNombresEnlaces > capacidadNombresPendientes) {
+            capacidadNombresPendientes = capacidadNombresPendientes ? capacidadNombresPendientes * 2 : 16384;
+            while (capacidadNombresPendientes < bytesNombresPendientes + parcial->bytesNombresEnlaces) {
+                capacidadNombresPendientes *= 2;
+            }
+            nombresPendientes = ampliarEnlaces(nombresPendientes, capacidadNombresPendientes);
+        }
+        const char *nombre = parcial->nombresEnlaces;
+        for (int e = 0; e < parcial->numNombresEnlaces; e++) {
+            size_t largo = strlen(nombre) + 1;
+            memcpy(nombresPendientes + bytesNombresPendientes, nombre, largo);
+            enlacesPorNombre[numEnlacesPorNombre].origen = origen;
+            enlacesPorNombre[numEnlacesPorNombre].offset = bytesNombresPendientes;
+            numEnlacesPorNombre++;
+            bytesNombresPendientes += largo;
+            nombre += largo;
+        }
+    }
+    estadisticasEnlaces.leidos += parcial->numEnlaces + parcial->numNombresEnlaces;
+    estadisticasEnlaces.porNombre += parcial->numNombresEnlaces;
+}
+
+/**
+ * @brief Ordena claves de 64 bits con un radix sort LSD.
+ *
+ * Cada pasada ordena ENLACES_BITS_DIGITO bits, de forma estable; las pasadas en
+ * las que todas las claves tienen el mismo digito se saltean.
+ *
+ * @param claves Claves a ordenar.
+ * @param auxiliar Arreglo de trabajo del mismo tamano.
+ * @param n Numero de claves.
+ * @param bits Bits significativos de las claves.
+ * @return El arreglo (claves o auxiliar) que quedo ordenado.
+ */
+static uint64_t *ordenarClaves(uint64_t *claves, uint64_t *auxiliar, size_t n, int bits) {
+    size_t numCubetas = (size_t)1 << ENLACES_BITS_DIGITO;
+    uint64_t mascara = numCubetas - 1;
+    size_t *cubetas = ampliarEnlaces(NULL, numCubetas * sizeof(size_t));
+    for (int desplazamiento = 0; desplazamiento < bits && n > 1; desplazamiento += ENLACES_BITS_DIGITO) {
+        memset(cubetas, 0, numCubetas * sizeof(size_t));
+        for (size_t i = 0; i < n; i++) {
+            cubetas[(claves[i] >> desplazamiento) & mascara]++;
+        }
+        if (cubetas[(claves[0] >> desplazamiento) & mascara] == n) {
+            continue;
+        }
+        size_t suma = 0;
+        for (size_t c = 0; c < numCubetas; c++) {
+            size_t cantidad = cubetas[c];
+            cubetas[c] = suma;
+            suma += cantidad;
+        }
+        for (size_t i = 0; i < n; i++) {
+            auxiliar[cubetas[(claves[i] >> desplazamiento) & mascara]++] = claves[i];
+        }
+        uint64_t *intercambio = claves;
+        claves = auxiliar;
+        auxiliar = intercambio;
+    }
+    free(cubetas);
+    return claves;
+}
+
+/**
+ * @brief Termina de medir una etapa de la carga de enlaces.
+ *
+ * @param tiempo Etapa, para la instrumentacion.
+ * @param inicio Reloj al empezar la etapa (ver relojInstrumentacion()).
+ * @return Duracion de la etapa en nanosegundos.
+ */
+static uint64_t terminarEtapa(Tiempo tiempo, uint64_t inicio) {
+    uint64_t nanosegundos = relojInstrumentacion() - inicio;
+#ifdef MOTOR_INSTRUMENTACION
+    registrarTiempo(tiempo, nanosegundos);
+#else
+    (void)tiempo;
+#endif
+    return nanosegundos;
+}
+
+/**
+ * @brief Valida, ordena y deduplica los enlaces anotados y los instala en el grafo.
+ *
+ * @param numDocs Documentos cargados; los destinos numericos deben ser menores.
+ * @return Numero de enlaces instalados.
+ */
+size_t terminarCargaEnlaces(int numDocs) {
+    asegurarDocumentosGrafo(numDocs);
+    int bits = 1;
+    while (bits < 31 && ((int64_t)1 << bits) < numDocs) {
+        bits++;
+    }
+
+    // Validar: cada enlace se convierte en una clave origen << bits | destino
+    uint64_t inicioValidar = relojInstrumentacion();
+    size_t total = numPares + numEnlacesPorNombre;
+    uint64_t *claves = ampliarEnlaces(NULL, total * sizeof(uint64_t));
+    size_t numClaves = 0;
+    for (size_t p = 0; p < numPares; p++) {
+        uint64_t origen = pares[p] >> 32;
+        int destino = (int)(uint32_t)pares[p];
+        if (destino < 0 || destino >= numDocs) {
+            estadisticasEnlaces.fueraDeRango++;
+            continue;
+        }
+        claves[numClaves++] = origen << bits | (uint64_t)destino;
+    }
+    for (size_t e = 0; e < numEnlacesPorNombre; e++) {
+        int destino = buscarDocumentoPorNombreEnlace(nombresPendientes + enlacesPorNombre[e].offset);
+        if (destino < 0) {
+            estadisticasEnlaces.nombresDesconocidos++;
+            continue;
+        }
+        claves[numClaves++] = (uint64_t)enlacesPorNombre[e].origen << bits | (uint64_t)destino;
+    }
+    free(pares);
+    free(enlacesPorNombre);
+    free(nombresPendientes);
+    pares = NULL;
+    enlacesPorNombre = NULL;
+    nombresPendientes = NULL;
+    numPares = capacidadPares = 0;
+    numEnlacesPorNombre = capacidadEnlacesPorNombre = 0;
+    bytesNombresPendientes = capacidadNombresPendientes = 0;
+    estadisticasEnlaces.nanosValidar = terminarEtapa(TIEMPO_ENLACES_VALIDAR, inicioValidar);
+
+    // Ordenar y quitar repetidos, que quedan contiguos
+    uint64_t inicioOrdenar = relojInstrumentacion();
+    uint64_t *auxiliar = ampliarEnlaces(NULL, numClaves * sizeof(uint64_t));
+    uint64_t *ordenadas = ordenarClaves(claves, auxiliar, numClaves, 2 * bits);
+    size_t unicas = 0;
+    for (size_t i = 0; i < numClaves; i++) {
+        if (unicas == 0 || ordenadas[i] != ordenadas[unicas - 1]) {
+            ordenadas[unicas++] = ordenadas[i];
+        }
+    }
+    estadisticasEnlaces.repetidos += (long)(numClaves - unicas);
+    estadisticasEnlaces.agregados += (long)unicas;
+    estadisticasEnlaces.nanosOrdenar = terminarEtapa(TIEMPO_ENLACES_ORDENAR, inicioOrdenar);
+
+    // Armar el CSR en una pasada; establecerEnlaces() lo transpone a CSC
+    uint64_t inicioArmar = relojInstrumentacion();
+    size_t *inicioSalida = calloc((size_t)numDocs + 1, sizeof(size_t));
+    int *destinosSalida = ampliarEnlaces(NULL, unicas * sizeof(int));
+    if (!inicioSalida) {
+        perror("No se pudo reservar memoria para los enlaces");
+        exit(EXIT_FAILURE);
+    }
+    uint64_t mascara = ((uint64_t)1 << bits) - 1;
+    for (size_t i = 0; i < unicas; i++) {
+        inicioSalida[(ordenadas[i] >> bits) + 1]++;
+        destinosSalida[i] = (int)(ordenadas[i] & mascara);
+    }
+    for (int u = 0; u < numDocs; u++) {
+        inicioSalida[u + 1] += inicioSalida[u];
+    }
+    free(claves);
+    free(auxiliar);
+    establecerEnlaces(inicioSalida, destinosSalida, unicas);
+    estadisticasEnlaces.nanosArmar = terminarEtapa(TIEMPO_ENLACES_ARMAR, inicioArmar);
+    return unicas;
+}
+
+/**
+ * @brief Compara dos docID para ordenarlos con qsort.
+ *
+ * @param a Puntero al primer docID.
+ * @param b Puntero al segundo docID.
+ * @return Negativo, cero o positivo segun el orden.
+ */
+static int compararDestinos(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Reemplaza los enlaces salientes de un documento ya cargado.
+ *
+ * @param origen docID del documento.
+ * @param parcial Documento parcial con sus enlaces.
+ */
+void actualizarEnlacesDocumento(int origen, const DocumentoParcial *parcial) {
+    int numDocs = totalDocumentosCargados();
+    int *destinos = ampliarEnlaces(NULL, (size_t)(parcial->numEnlaces + parcial->numNombresEnlaces) * sizeof(int));
+    int numDestinos = 0;
+    for (int e = 0; e < parcial->numEnlaces; e++) {
+        if (parcial->enlaces[e] < 0 || parcial->enlaces[e] >= numDocs) {
+            estadisticasEnlaces.fueraDeRango++;
+        } else {
+            destinos[numDestinos++] = parcial->enlaces[e];
+        }
+    }
+    const char *nombre = parcial->nombresEnlaces;
+    for (int e = 0; e < parcial->numNombresEnlaces; e++) {
+        int destino = buscarDocumentoPorNombreEnlace(nombre);
+        if (destino < 0) {
+            estadisticasEnlaces.nombresDesconocidos++;
+        } else {
+            destinos[numDestinos++] = destino;
+        }
+        nombre += strlen(nombre) + 1;
+    }
+    estadisticasEnlaces.leidos += parcial->numEnlaces + parcial->numNombresEnlaces;
+    estadisticasEnlaces.porNombre += parcial->numNombresEnlaces;
+
+    if (numDestinos > 1) {
+        qsort(destinos, numDestinos, sizeof(int), compararDestinos);
+    }
+    int unicos = 0;
+    for (int i = 0; i < numDestinos; i++) {
+        if (unicos == 0 || destinos[i] != destinos[unicos - 1]) {
+            destinos[unicos++] = destinos[i];
+        }
+    }
+    estadisticasEnlaces.repetidos += numDestinos - unicos;
+    estadisticasEnlaces.agregados += unicos;
+    reemplazarEnlacesSalientes(origen, destinos, unicos);
+    free(destinos);
+}
+
+/**
+ * @brief Aplaza el reemplazo de los enlaces salientes de un documento sincronizado.
+ *
+ * Los arreglos de enlaces pasan del documento parcial a la lista de aplazados,
+ * sin copiarlos; el resto del documento parcial no cambia.
+ *
+ * @param origen docID del documento.
+ * @param parcial Documento parcial con sus enlaces; queda sin ellos.
+ */
+void aplazarEnlacesDocumento(int origen, DocumentoParcial *parcial) {
+    if (numAplazados == capacidadAplazados) {
+        capacidadAplazados = capacidadAplazados ? capacidadAplazados * 2 : 64;
+        aplazados = ampliarEnlaces(aplazados, capacidadAplazados * sizeof(DocumentoParcial));
+        origenesAplazados = ampliarEnlaces(origenesAplazados, capacidadAplazados * sizeof(int));
+    }
+    DocumentoParcial *enlaces = &aplazados[numAplazados];
+    memset(enlaces, 0, sizeof(*enlaces));
+    enlaces->enlaces = parcial->enlaces;
+    enlaces->numEnlaces = parcial->numEnlaces;
+    enlaces->nombresEnlaces = parcial->nombresEnlaces;
+    enlaces->numNombresEnlaces = parcial->numNombresEnlaces;
+    origenesAplazados[numAplazados++] = origen;
+    parcial->enlaces = NULL;
+    parcial->numEnlaces = 0;
+    parcial->capacidadEnlaces = 0;
+    parcial->nombresEnlaces = NULL;
+    parcial->bytesNombresEnlaces = 0;
+    parcial->capacidadNombresEnlaces = 0;
+    parcial->numNombresEnlaces = 0;
+}
+
+/**
+ * @brief Reemplaza los enlaces salientes de los documentos aplazados, en el orden en que se aplazaron.
+ */
+void instalarEnlacesAplazados() {
+    for (int i = 0; i < numAplazados; i++) {
+        actualizarEnlacesDocumento(origenesAplazados[i], &aplazados[i]);
+        liberarDocumentoParcial(&aplazados[i]);
+    }
+    free(aplazados);
+    free(origenesAplazados);
+    aplazados = NULL;
+    origenesAplazados = NULL;
+    numAplazados = 0;
+    capacidadAplazados = 0;
+}
+
+/**
+ * @brief Obtiene las estadisticas de los enlaces.
+ *
+ * @param estadisticas Salida.
+ */
+void obtenerEstadisticasEnlaces(EstadisticasEnlaces *estadisticas) {
+    *estadisticas = estadisticasEnlaces;
+}
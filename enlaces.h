@@ -0,0 +1,118 @@
+/**
+ * @file enlaces.h
+ * @brief Carga masiva de los enlaces entre documentos, con validacion y sin repetidos.
+ *
+ * Un documento enlaza a otro con un token "link:N" o "link:nombre". N es el
+ * docID del destino, igual en la carga y en la sincronizacion incremental: los
+ * archivos que no se pudieron leer no reciben docID, asi que corren los de los
+ * archivos siguientes, y los archivos nuevos reciben los docID siguientes al
+ * ultimo. El nombre, que no depende de ese orden, es el del archivo sin
+ * directorio, con o sin ".txt", normalizado como cualquier palabra (minusculas y
+ * sin acentos).
+ *
+ * Durante la carga los enlaces de cada documento solo se anotan como pares
+ * (origen, destino). Al terminar se resuelven los nombres, se descartan los
+ * destinos que no existen, se ordenan los pares con radix sort, se quitan los
+ * repetidos y se arman de una vez los arreglos CSR/CSC del grafo, sin pasar por
+ * las listas de adyacencia. La duracion de cada etapa queda en las estadisticas
+ * y, con la instrumentacion activada, tambien en su informe.
+ */
+
+#ifndef ENLACES_H
+#define ENLACES_H
+
+#include <stdint.h>
+#include "ingesta.h"
+
+#define ENLACES_BITS_DIGITO 11 ///< Bits que ordena cada pasada del radix sort de los pares.
+
+/**
+ * @struct EstadisticasEnlaces
+ * @brief Enlaces leidos y descartados desde la ultima carga.
+ *
+ * Incluye los de las sincronizaciones posteriores a la carga.
+ */
+typedef struct {
+    long leidos; ///< Tokens de enlace leidos de los documentos.
+    long porNombre; ///< De ellos, los que nombran un archivo en vez de un numero.
+    long fueraDeRango; ///< Descartados porque el numero no corresponde a ningun documento.
+    long nombresDesconocidos; ///< Descartados porque ningun documento tiene ese nombre.
+    long repetidos; ///< Descartados por repetir un enlace del mismo documento.
+    long agregados; ///< Enlaces agregados al grafo (los de un documento sincronizado reemplazan a los anteriores).
+    uint64_t nanosValidar; ///< Duracion de la resolucion y validacion de la carga.
+    uint64_t nanosOrdenar; ///< Duracion del radix sort y la eliminacion de repetidos de la carga.
+    uint64_t nanosArmar; ///< Duracion del armado de los arreglos CSR/CSC de la carga.
+} EstadisticasEnlaces;
+
+/**
+ * @brief Empieza una carga de enlaces y pone en cero las estadisticas.
+ */
+void iniciarCargaEnlaces();
+
+/**
+ * @brief Anota los enlaces de un documento de la carga.
+ *
+ * @param origen docID del documento.
+ * @param parcial Documento parcial con sus enlaces.
+ */
+void recolectarEnlaces(int origen, const DocumentoParcial *parcial);
+
+/**
+ * @brief Valida, ordena y deduplica los enlaces anotados y los instala en el grafo.
+ *
+ * Reemplaza todos los enlaces del grafo y libera los pares anotados.
+ *
+ * @param numDocs Documentos cargados; los destinos numericos deben ser menores.
+ * @return Numero de enlaces instalados.
+ */
+size_t terminarCargaEnlaces(int numDocs);
+
+/**
+ * @brief Reemplaza los enlaces salientes de un documento ya cargado.
+ *
+ * Aplica la misma validacion y eliminacion de
+ * repetidos que la carga y suma los descartes a las estadisticas.
+ *
+ * @param origen docID del documento.
+ * @param parcial Documento parcial con sus enlaces.
+ */
+void actualizarEnlacesDocumento(int origen, const DocumentoParcial *parcial);
+
+/**
+ * @brief Aplaza el reemplazo de los enlaces salientes de un documento sincronizado.
+ *
+ * Los enlaces se resuelven recien con instalarEnlacesAplazados(), cuando ya se
+ * registraron todos los archivos de la sincronizacion; asi "link:N" y
+ * "link:nombre" pueden apuntar a un archivo que se agrega despues en la misma
+ * sincronizacion, como en la carga.
+ *
+ * @param origen docID del documento.
+ * @param parcial Documento parcial con sus enlaces; sus arreglos de enlaces pasan
+ *                a la lista de aplazados y quedan vacios.
+ */
+void aplazarEnlacesDocumento(int origen, DocumentoParcial *parcial);
+
+/**
+ * @brief Reemplaza los enlaces salientes de los documentos aplazados con aplazarEnlacesDocumento().
+ *
+ * Aplica la validacion de actualizarEnlacesDocumento() a cada uno, con todos los
+ * docID ya asignados, y vacia la lista.
+ */
+void instalarEnlacesAplazados();
+
+/**
+ * @brief Busca el documento que corresponde a un nombre de enlace.
+ *
+ * @param nombre Nombre normalizado, sin el prefijo "link:" (con o sin ".txt").
+ * @return docID del documento, o -1 si ninguno tiene ese nombre.
+ */
+int buscarDocumentoPorNombreEnlace(const char *nombre);
+
+/**
+ * @brief Obtiene las estadisticas de los enlaces.
+ *
+ * @param estadisticas Salida.
+ */
+void obtenerEstadisticasEnlaces(EstadisticasEnlaces *estadisticas);
+
+#endif
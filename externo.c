@@ -0,0 +1,751 @@
+/**
+ * @file externo.c
+ * @brief Implementacion de la construccion del indice en memoria externa.
+ *
+ * Despues de cada documento se compara la memoria del indice en memoria con el
+ * limite; al alcanzarlo sus palabras se ordenan y se escriben a una corrida, y el
+ * indice se reemplaza por uno vacio. Cada palabra de una corrida lleva sus listas
+ * tal como estaban en memoria (postings, saltos, posiciones y saltos de
+ * posiciones), asi que la fusion puede recorrerlas con un IteradorPostings comun
+ * o, si la palabra esta en una sola corrida, pasarlas intactas a la instantanea.
+ *
+ * Todas las corridas se escriben una tras otra en un mismo archivo temporal, asi
+ * que la carga usa un descriptor y un bufer de escritura sin importar cuantas
+ * corridas haya. La fusion lee cada corrida con pread() y un bufer propio de
+ * EXTERNO_BUFER_CORRIDA; si las corridas no caben en la mitad del limite de
+ * memoria, pasadas intermedias las mezclan de a grupos en un segundo archivo
+ * hasta que caben.
+ */
+
+#include "externo.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "arena.h"
+#include "index.h"
+#include "ingesta.h"
+#include "instrumentacion.h"
+#include "snapshot.h"
+
+/**
+ * @struct CabeceraTerminoCorrida
+ * @brief Cabecera de cada palabra de una corrida.
+ *
+ * La siguen, en este orden: los saltos, los saltos de posiciones (uno por salto,
+ * solo con el indice posicional), los postings, las posiciones y los bytes de la
+ * palabra, sin el '\0'. El orden deja cada arreglo alineado al leerlo de una vez.
+ */
+typedef struct {
+    uint32_t longitud; ///< Longitud de la palabra.
+    uint32_t conteoDocs; ///< Documentos de la lista.
+    uint32_t frecuenciaMaxima; ///< Mayor frecuencia de la palabra en un documento.
+    uint32_t numSaltos; ///< Punteros de salto.
+    uint64_t bytesPostings; ///< Bytes de postings comprimidos.
+    uint64_t bytesPosiciones; ///< Bytes de posiciones codificadas.
+} CabeceraTerminoCorrida;
+
+/**
+ * @struct Corrida
+ * @brief Tramo del archivo de corridas que ocupa una corrida.
+ */
+typedef struct {
+    uint64_t inicio; ///< Offset del primer byte de la corrida.
+    uint64_t fin; ///< Offset siguiente al ultimo byte de la corrida.
+} Corrida;
+
+/**
+ * @struct LectorCorrida
+ * @brief Lectura de una corrida durante la fusion, con su palabra actual.
+ */
+typedef struct {
+    int descriptor; ///< Descriptor del archivo de corridas.
+    uint64_t posicion; ///< Offset del siguiente byte a leer del archivo.
+    uint64_t fin; ///< Offset del final de la corrida.
+    unsigned char *bufer; ///< Bufer de lectura de EXTERNO_BUFER_CORRIDA bytes.
+    size_t usados; ///< Bytes del bufer ya entregados.
+    size_t llenos; ///< Bytes validos en el bufer.
+    CabeceraTerminoCorrida cabecera; ///< Cabecera de la palabra actual.
+    unsigned char *datos; ///< Listas y palabra (terminada en '\0') de la palabra actual.
+    size_t capacidad; ///< Bytes reservados en datos.
+    const char *palabra; ///< Palabra actual, dentro de datos.
+} LectorCorrida;
+
+/**
+ * @struct ArchivoCorridas
+ * @brief Archivo temporal, ya borrado del directorio, donde se escriben corridas seguidas.
+ */
+typedef struct {
+    FILE *archivo; ///< Archivo abierto, o NULL si todavia no se creo.
+    char *bufer; ///< Bufer de escritura de EXTERNO_BUFER_CORRIDA bytes.
+} ArchivoCorridas;
+
+/**
+ * @struct TerminoVolcado
+ * @brief Palabra del indice en memoria que se escribe en una corrida.
+ */
+typedef struct {
+    uint64_t clave; ///< Primeros 8 bytes de la palabra en orden big-endian, para ordenar sin leerla.
+    const char *palabra; ///< Palabra.
+    const unsigned char *postings; ///< Postings comprimidos.
+    const SaltoPosting *saltos; ///< Punteros de salto.
+    const unsigned char *posiciones; ///< Posiciones, o NULL.
+    const uint32_t *saltosPosiciones; ///< Saltos de posiciones, o NULL.
+    CabeceraTerminoCorrida cabecera; ///< Cabecera que se escribe.
+} TerminoVolcado;
+
+/**
+ * @struct ListaVolcado
+ * @brief Palabras recolectadas del indice en memoria para una corrida.
+ */
+typedef struct {
+    TerminoVolcado *terminos; ///< Palabras.
+    size_t num; ///< Palabras recolectadas.
+} ListaVolcado;
+
+static Corrida *corridas = NULL; ///< Corridas de la ultima carga, en orden de docID.
+static int numCorridas = 0; ///< Corridas escritas.
+static int capacidadCorridas = 0; ///< Capacidad reservada de corridas.
+static ArchivoCorridas archivos[2]; ///< Archivo con las corridas vigentes y el de la pasada siguiente.
+static int archivoActual = 0; ///< Posicion en archivos del que tiene las corridas vigentes.
+static LectorCorrida *lectores = NULL; ///< Corridas que se mezclan en la fusion en curso.
+static size_t limiteMemoria = 0; ///< Bytes del indice en memoria a partir de los cuales se vuelca.
+static const char *rutaCorridas = NULL; ///< Ruta junto a la que se crean las corridas.
+static EstadisticasExterno estadisticas; ///< Resumen de la ultima construccion.
+
+/**
+ * @brief Reserva o amplia un arreglo, terminando el programa si no hay memoria.
+ *
+ * @param bloque Arreglo actual (puede ser NULL).
+ * @param bytes Nuevo tamano en bytes.
+ * @return Arreglo ampliado.
+ */
+static void *ampliar(void *bloque, size_t bytes) {
+    void *nuevo = realloc(bloque, bytes);
+    if (!nuevo) {
+        perror("No se pudo reservar memoria durante la carga externa");
+        exit(EXIT_FAILURE);
+    }
+    return nuevo;
+}
+
+/**
+ * @brief Cierra los archivos de corridas y libera sus bufers.
+ */
+static void cerrarCorridas() {
+    for (int a = 0; a < 2; a++) {
+        if (archivos[a].archivo) {
+            fclose(archivos[a].archivo);
+        }
+        free(archivos[a].bufer);
+        archivos[a].archivo = NULL;
+        archivos[a].bufer = NULL;
+    }
+    archivoActual = 0;
+    free(corridas);
+    corridas = NULL;
+    numCorridas = 0;
+    capacidadCorridas = 0;
+}
+
+/**
+ * @brief Crea un archivo de corridas vacio, terminando el programa si no se puede.
+ *
+ * @param archivo Archivo a crear.
+ * @param base Ruta a cuyo lado se crea.
+ * @param numero Numero que distingue el archivo del otro de la misma base.
+ */
+static void crearArchivoCorridas(ArchivoCorridas *archivo, const char *base, int numero) {
+    size_t largo = strlen(base) + 32;
+    char *ruta = ampliar(NULL, largo);
+    snprintf(ruta, largo, "%s.corridas.%d", base, numero);
+    archivo->archivo = fopen(ruta, "w+b");
+    if (!archivo->archivo) {
+        perror("No se pudo crear el archivo de corridas del indice");
+        exit(EXIT_FAILURE);
+    }
+    // Borrado enseguida: sigue abierto para la fusion y no queda en disco si el proceso termina.
+    remove(ruta);
+    free(ruta);
+    archivo->bufer = ampliar(NULL, EXTERNO_BUFER_CORRIDA);
+    setvbuf(archivo->archivo, archivo->bufer, _IOFBF, EXTERNO_BUFER_CORRIDA);
+}
+
+/**
+ * @brief Agrega una corrida a una lista de corridas.
+ *
+ * @param lista Lista de corridas; se amplia si hace falta.
+ * @param num Corridas de la lista; se incrementa.
+ * @param capacidad Capacidad reservada de la lista; se actualiza.
+ * @param inicio Offset del primer byte de la corrida.
+ * @param fin Offset siguiente al ultimo byte de la corrida.
+ */
+static void agregarCorrida(Corrida **lista, int *num, int *capacidad, uint64_t inicio, uint64_t fin) {
+    if (*num == *capacidad) {
+        *capacidad = *capacidad ? *capacidad * 2 : 16;
+        *lista = ampliar(*lista, *capacidad * sizeof(Corrida));
+    }
+    (*lista)[*num].inicio = inicio;
+    (*lista)[*num].fin = fin;
+    (*num)++;
+}
+
+/**
+ * @brief Agrega una palabra del indice en memoria a la lista de volcado (usada con recorrerIndice()).
+ *
+ * @param lista Lista de postings visitada.
+ * @param contexto Puntero a ListaVolcado, con lugar para todas las palabras.
+ */
+static void recolectarVolcado(const ListaPostings *lista, void *contexto) {
+    ListaVolcado *volcado = contexto;
+    TerminoVolcado *termino = &volcado->terminos[volcado->num++];
+    termino->clave = 0;
+    for (size_t i = 0; i < 8; i++) {
+        termino->clave = (termino->clave << 8) | (i < lista->longitud ? (unsigned char)lista->palabra[i] : 0);
+    }
+    termino->palabra = lista->palabra;
+    termino->postings = lista->datos;
+    termino->saltos = lista->saltos;
+    termino->posiciones = lista->posiciones;
+    termino->saltosPosiciones = lista->saltosPosiciones;
+    termino->cabecera.longitud = (uint32_t)lista->longitud;
+    termino->cabecera.conteoDocs = (uint32_t)lista->conteoDocs;
+    termino->cabecera.frecuenciaMaxima = (uint32_t)lista->frecuenciaMaxima;
+    termino->cabecera.numSaltos = (uint32_t)lista->numSaltos;
+    termino->cabecera.bytesPostings = lista->bytes;
+    termino->cabecera.bytesPosiciones = lista->posiciones ? lista->bytesPosiciones : 0;
+}
+
+/**
+ * @brief Compara dos palabras de volcado por bytes para ordenarlas con qsort.
+ *
+ * La clave decide casi siempre; solo las palabras con los mismos 8 primeros
+ * bytes se comparan completas.
+ *
+ * @param a Primera palabra.
+ * @param b Segunda palabra.
+ * @return Negativo, cero o positivo como strcmp entre ambas.
+ */
+static int compararVolcado(const void *a, const void *b) {
+    const TerminoVolcado *x = a;
+    const TerminoVolcado *y = b;
+    if (x->clave != y->clave) {
+        return x->clave < y->clave ? -1 : 1;
+    }
+    return strcmp(x->palabra, y->palabra);
+}
+
+/**
+ * @brief Escribe bytes en una corrida, terminando el programa si falla.
+ *
+ * @param archivo Corrida.
+ * @param datos Bytes a escribir (puede ser NULL si bytes es 0).
+ * @param bytes Numero de bytes.
+ */
+static void escribirCorrida(FILE *archivo, const void *datos, size_t bytes) {
+    if (bytes > 0 && fwrite(datos, 1, bytes, archivo) != bytes) {
+        perror("No se pudo escribir una corrida del indice");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Escribe una palabra con sus listas en una corrida.
+ *
+ * @param archivo Archivo de corridas.
+ * @param termino Palabra a escribir.
+ */
+static void escribirTerminoCorrida(FILE *archivo, const TerminoVolcado *termino) {
+    escribirCorrida(archivo, &termino->cabecera, sizeof(CabeceraTerminoCorrida));
+    escribirCorrida(archivo, termino->saltos, termino->cabecera.numSaltos * sizeof(SaltoPosting));
+    for (uint32_t b = 0; indicePosicionalActivado() && b < termino->cabecera.numSaltos; b++) {
+        uint32_t salto = termino->saltosPosiciones ? termino->saltosPosiciones[b] : 0;
+        escribirCorrida(archivo, &salto, sizeof(salto));
+    }
+    escribirCorrida(archivo, termino->postings, termino->cabecera.bytesPostings);
+    escribirCorrida(archivo, termino->posiciones, termino->cabecera.bytesPosiciones);
+    escribirCorrida(archivo, termino->palabra, termino->cabecera.longitud);
+}
+
+/**
+ * @brief Termina de escribir una corrida.
+ *
+ * @param archivo Archivo de corridas.
+ * @return Offset siguiente al ultimo byte escrito.
+ */
+static uint64_t cerrarTramoCorrida(FILE *archivo) {
+    off_t fin = ftello(archivo);
+    if (fflush(archivo) != 0 || fin < 0) {
+        perror("No se pudo escribir una corrida del indice");
+        exit(EXIT_FAILURE);
+    }
+    return (uint64_t)fin;
+}
+
+/**
+ * @brief Escribe el indice en memoria como una corrida nueva y lo vacia.
+ *
+ * @param memoria Memoria del indice en memoria al momento de volcarlo.
+ */
+static void volcarCorrida(size_t memoria) {
+    int numTerminos = totalPalabrasIndexadas();
+    if (numTerminos == 0) {
+        return;
+    }
+    INSTRUMENTAR_INICIO(inicio);
+    ListaVolcado volcado = {ampliar(NULL, (size_t)numTerminos * sizeof(TerminoVolcado)), 0};
+    recorrerIndice(recolectarVolcado, &volcado);
+    qsort(volcado.terminos, volcado.num, sizeof(TerminoVolcado), compararVolcado);
+
+    if (!archivos[archivoActual].archivo) {
+        crearArchivoCorridas(&archivos[archivoActual], rutaCorridas, archivoActual);
+    }
+    FILE *archivo = archivos[archivoActual].archivo;
+    off_t inicioCorrida = ftello(archivo);
+    for (size_t t = 0; t < volcado.num; t++) {
+        escribirTerminoCorrida(archivo, &volcado.terminos[t]);
+    }
+    uint64_t finCorrida = cerrarTramoCorrida(archivo);
+    free(volcado.terminos);
+
+    agregarCorrida(&corridas, &numCorridas, &capacidadCorridas, (uint64_t)inicioCorrida, finCorrida);
+    estadisticas.corridas = numCorridas;
+    estadisticas.bytesCorridas += finCorrida - (uint64_t)inicioCorrida;
+    if (memoria > estadisticas.memoriaMaxima) {
+        estadisticas.memoriaMaxima = memoria;
+    }
+
+    vaciarIndice();
+    INSTRUMENTAR_FIN(TIEMPO_VOLCAR_CORRIDA, inicio);
+}
+
+/**
+ * @brief Vuelca el indice en memoria si llego al limite (se llama despues de cada documento).
+ *
+ * Cuenta tambien el arreglo que hace falta para ordenar las palabras al volcarlas
+ * y el bufer de escritura del archivo de corridas.
+ *
+ * @param contexto Sin uso.
+ */
+static void revisarMemoria(void *contexto) {
+    (void)contexto;
+    size_t memoria = memoriaIndiceEnMemoria() + (size_t)totalPalabrasIndexadas() * sizeof(TerminoVolcado) +
+                     EXTERNO_BUFER_CORRIDA;
+    if (memoria >= limiteMemoria) {
+        volcarCorrida(memoria);
+    }
+}
+
+/**
+ * @brief Carga los documentos de un directorio volcando el indice a disco por corridas.
+ *
+ * @param directorio Directorio de documentos.
+ * @param hilos Numero de hilos de lectura.
+ * @param memoriaMaxima Bytes que puede ocupar el indice en memoria antes de volcarlo.
+ * @param rutaTemporal Ruta a cuyo lado se crean las corridas.
+ * @return Numero de corridas escritas.
+ */
+int cargarArchivosEnCorridas(const char *directorio, int hilos, size_t memoriaMaxima, const char *rutaTemporal) {
+    cerrarCorridas();
+    memset(&estadisticas, 0, sizeof(estadisticas));
+    limiteMemoria = memoriaMaxima < EXTERNO_MEMORIA_MINIMA ? EXTERNO_MEMORIA_MINIMA : memoriaMaxima;
+    rutaCorridas = rutaTemporal;
+    cargarArchivosConAviso(directorio, hilos, revisarMemoria, NULL);
+    volcarCorrida(memoriaIndiceEnMemoria());
+    rutaCorridas = NULL;
+    return numCorridas;
+}
+
+/**
+ * @brief Lee bytes de una corrida a traves del bufer de su lector.
+ *
+ * @param lector Lector de la corrida.
+ * @param destino Donde se copian los bytes.
+ * @param bytes Numero de bytes.
+ * @return 1 si se leyeron todos, 0 si la corrida termino antes, -1 si fallo la lectura.
+ */
+static int leerBytesCorrida(LectorCorrida *lector, void *destino, size_t bytes) {
+    unsigned char *salida = destino;
+    while (bytes > 0) {
+        if (lector->usados == lector->llenos) {
+            uint64_t quedan = lector->fin - lector->posicion;
+            size_t pedidos = quedan < EXTERNO_BUFER_CORRIDA ? (size_t)quedan : EXTERNO_BUFER_CORRIDA;
+            if (pedidos == 0) {
+                return 0;
+            }
+            ssize_t leidos = pread(lector->descriptor, lector->bufer, pedidos, (off_t)lector->posicion);
+            if (leidos <= 0) {
+                return -1;
+            }
+            lector->posicion += (uint64_t)leidos;
+            lector->llenos = (size_t)leidos;
+            lector->usados = 0;
+        }
+        size_t copiados = lector->llenos - lector->usados < bytes ? lector->llenos - lector->usados : bytes;
+        memcpy(salida, lector->bufer + lector->usados, copiados);
+        lector->usados += copiados;
+        salida += copiados;
+        bytes -= copiados;
+    }
+    return 1;
+}
+
+/**
+ * @brief Lee la siguiente palabra de una corrida.
+ *
+ * @param lector Lector de la corrida.
+ * @return 1 si se leyo una palabra, 0 al final de la corrida, -1 si fallo la lectura.
+ */
+static int leerTerminoCorrida(LectorCorrida *lector) {
+    CabeceraTerminoCorrida *c = &lector->cabecera;
+    if (lector->usados == lector->llenos && lector->posicion == lector->fin) {
+        return 0;
+    }
+    if (leerBytesCorrida(lector, c, sizeof(CabeceraTerminoCorrida)) <= 0) {
+        return -1;
+    }
+    size_t saltos = c->numSaltos * (sizeof(SaltoPosting) + (indicePosicionalActivado() ? sizeof(uint32_t) : 0));
+    size_t bytes = saltos + c->bytesPostings + c->bytesPosiciones + c->longitud;
+    if (bytes + 1 > lector->capacidad) {
+        lector->capacidad = bytes + 1 > 2 * lector->capacidad ? bytes + 1 : 2 * lector->capacidad;
+        lector->datos = ampliar(lector->datos, lector->capacidad);
+    }
+    if (leerBytesCorrida(lector, lector->datos, bytes) <= 0) {
+        return -1;
+    }
+    lector->datos[bytes] = '\0';
+    lector->palabra = (const char *)lector->datos + bytes - c->longitud;
+    return 1;
+}
+
+/**
+ * @brief Arma una vista de la lista de la palabra actual de una corrida.
+ *
+ * @param lector Lector de la corrida, con una palabra leida.
+ * @param lista Salida.
+ */
+static void vistaCorrida(const LectorCorrida *lector, ListaPostings *lista) {
+    const CabeceraTerminoCorrida *c = &lector->cabecera;
+    const unsigned char *p = lector->datos;
+    memset(lista, 0, sizeof(*lista));
+    lista->saltos = (const SaltoPosting *)p;
+    lista->numSaltos = (int)c->numSaltos;
+    p += c->numSaltos * sizeof(SaltoPosting);
+    if (indicePosicionalActivado()) {
+        lista->saltosPosiciones = (const uint32_t *)p;
+        p += c->numSaltos * sizeof(uint32_t);
+    }
+    lista->datos = p;
+    lista->bytes = c->bytesPostings;
+    p += c->bytesPostings;
+    lista->posiciones = c->bytesPosiciones ? p : NULL;
+    lista->bytesPosiciones = c->bytesPosiciones;
+    p += c->bytesPosiciones;
+    lista->palabra = (const char *)p;
+    lista->longitud = c->longitud;
+    lista->conteoDocs = (int)c->conteoDocs;
+    lista->frecuenciaMaxima = (int)c->frecuenciaMaxima;
+}
+
+/**
+ * @brief Concatena en un nodo nuevo las listas de una palabra presente en varias corridas.
+ *
+ * @param arena Arena donde se crea el nodo.
+ * @param iguales Lectores de las corridas con la palabra, en orden de docID.
+ * @param n Numero de corridas.
+ * @return Nodo con la lista completa; sus postings se liberan con liberarNodoIndice().
+ */
+static NodoIndice *combinarListas(Arena *arena, const int *iguales, int n) {
+    ListaPostings lista;
+    vistaCorrida(&lectores[iguales[0]], &lista);
+    NodoIndice *nodo = crearNodoIndice(arena, lista.palabra, lista.longitud);
+    for (int i = 0; i < n; i++) {
+        vistaCorrida(&lectores[iguales[i]], &lista);
+        IteradorPostings it;
+        iniciarIteradorPostings(&it, &lista);
+        while (siguientePosting(&it)) {
+            size_t bytes = 0;
+            const unsigned char *posiciones = lista.posiciones ? posicionesPosting(&it, &bytes) : NULL;
+            agregarPostingNodo(nodo, it.docID, it.frecuencia, posiciones, bytes);
+        }
+    }
+    return nodo;
+}
+
+/**
+ * @brief Indica si la palabra actual de una corrida va antes que la de otra.
+ *
+ * A igual palabra va primero la corrida anterior, que tiene los docID menores.
+ *
+ * @param a Indice del lector de la primera corrida.
+ * @param b Indice del lector de la segunda corrida.
+ * @return 1 si a va antes que b.
+ */
+static int corridaMenor(int a, int b) {
+    int orden = strcmp(lectores[a].palabra, lectores[b].palabra);
+    return orden < 0 || (orden == 0 && a < b);
+}
+
+/**
+ * @brief Restablece el orden del monticulo bajando un elemento.
+ *
+ * @param monticulo Indices de corridas, con la menor palabra en la raiz.
+ * @param n Elementos del monticulo.
+ * @param i Posicion del elemento que puede estar fuera de lugar.
+ */
+static void hundirCorrida(int *monticulo, int n, int i) {
+    for (;;) {
+        int menor = i;
+        int izquierdo = 2 * i + 1;
+        int derecho = izquierdo + 1;
+        if (izquierdo < n && corridaMenor(monticulo[izquierdo], monticulo[menor])) {
+            menor = izquierdo;
+        }
+        if (derecho < n && corridaMenor(monticulo[derecho], monticulo[menor])) {
+            menor = derecho;
+        }
+        if (menor == i) {
+            return;
+        }
+        int temporal = monticulo[i];
+        monticulo[i] = monticulo[menor];
+        monticulo[menor] = temporal;
+        i = menor;
+    }
+}
+
+/**
+ * @brief Agrega una corrida al monticulo.
+ *
+ * @param monticulo Indices de corridas.
+ * @param n Elementos del monticulo; se incrementa.
+ * @param corrida Corrida a agregar, con una palabra leida.
+ */
+static void subirCorrida(int *monticulo, int *n, int corrida) {
+    int i = (*n)++;
+    monticulo[i] = corrida;
+    while (i > 0 && corridaMenor(monticulo[i], monticulo[(i - 1) / 2])) {
+        int padre = (i - 1) / 2;
+        monticulo[i] = monticulo[padre];
+        monticulo[padre] = corrida;
+        i = padre;
+    }
+}
+
+/**
+ * @brief Saca del monticulo la corrida con la menor palabra.
+ *
+ * @param monticulo Indices de corridas.
+ * @param n Elementos del monticulo (al menos uno); se decrementa.
+ * @return Corrida extraida.
+ */
+static int sacarCorrida(int *monticulo, int *n) {
+    int raiz = monticulo[0];
+    monticulo[0] = monticulo[--(*n)];
+    hundirCorrida(monticulo, *n, 0);
+    return raiz;
+}
+
+/**
+ * @brief Calcula cuantas corridas se mezclan a la vez.
+ *
+ * Los bufers de lectura de las corridas que se mezclan juntas ocupan a lo sumo la
+ * mitad del limite de memoria; el resto queda para las listas de la palabra en curso.
+ *
+ * @return Corridas por mezcla, al menos 2.
+ */
+static int viasFusion() {
+    size_t vias = limiteMemoria / 2 / EXTERNO_BUFER_CORRIDA;
+    return vias < 2 ? 2 : vias > INT_MAX ? INT_MAX : (int)vias;
+}
+
+/**
+ * @brief Mezcla un grupo de corridas en la instantanea o en una corrida nueva.
+ *
+ * Un monticulo ordena las corridas por su palabra actual. Las que comparten la
+ * menor palabra salen juntas y en orden de corrida, se combinan y avanzan.
+ *
+ * @param grupo Corridas a mezclar, consecutivas y en orden de docID.
+ * @param n Numero de corridas, a lo sumo los lectores reservados.
+ * @param descriptor Descriptor del archivo de corridas del que se leen.
+ * @param escritor Instantanea donde se escribe la mezcla, o NULL para escribirla en destino.
+ * @param destino Archivo de corridas donde se escribe la mezcla cuando escritor es NULL.
+ * @return 1 si se mezclaron, 0 si fallo la lectura o la escritura.
+ */
+static int mezclarCorridas(const Corrida *grupo, int n, int descriptor, EscritorTerminosSnapshot *escritor,
+                           FILE *destino) {
+    int *monticulo = ampliar(NULL, (size_t)(n ? n : 1) * sizeof(int));
+    int *iguales = ampliar(NULL, (size_t)(n ? n : 1) * sizeof(int));
+    int enMonticulo = 0;
+    int correcto = 1;
+    for (int c = 0; c < n && correcto; c++) {
+        LectorCorrida *lector = &lectores[c];
+        lector->descriptor = descriptor;
+        lector->posicion = grupo[c].inicio;
+        lector->fin = grupo[c].fin;
+        lector->usados = 0;
+        lector->llenos = 0;
+        int leido = leerTerminoCorrida(lector);
+        if (leido > 0) {
+            subirCorrida(monticulo, &enMonticulo, c);
+        }
+        correcto = leido >= 0;
+    }
+
+    Arena arena;
+    iniciarArena(&arena, ARENA_TAMANO_BLOQUE);
+    while (enMonticulo > 0 && correcto) {
+        int numIguales = 0;
+        iguales[numIguales++] = sacarCorrida(monticulo, &enMonticulo);
+        while (enMonticulo > 0 && strcmp(lectores[monticulo[0]].palabra, lectores[iguales[0]].palabra) == 0) {
+            iguales[numIguales++] = sacarCorrida(monticulo, &enMonticulo);
+        }
+
+        ListaPostings lista;
+        NodoIndice *nodo = NULL;
+        if (numIguales == 1) {
+            vistaCorrida(&lectores[iguales[0]], &lista);
+        } else {
+            nodo = combinarListas(&arena, iguales, numIguales);
+            memset(&lista, 0, sizeof(lista));
+            lista.palabra = nodo->palabra;
+            lista.longitud = nodo->longitud;
+            lista.datos = nodo->postings;
+            lista.bytes = nodo->bytesPostings;
+            lista.conteoDocs = nodo->conteoDocs;
+            lista.saltos = nodo->saltos;
+            lista.numSaltos = nodo->numSaltos;
+            lista.frecuenciaMaxima = nodo->frecuenciaMaxima;
+            lista.posiciones = nodo->posiciones;
+            lista.bytesPosiciones = nodo->bytesPosiciones;
+            lista.saltosPosiciones = nodo->saltosPosiciones;
+            estadisticas.palabrasCombinadas++;
+        }
+        if (escritor) {
+            correcto = agregarTerminoSnapshot(escritor, &lista);
+            estadisticas.palabras++;
+        } else {
+            TerminoVolcado termino;
+            ListaVolcado volcado = {&termino, 0};
+            recolectarVolcado(&lista, &volcado);
+            escribirTerminoCorrida(destino, &termino);
+        }
+        if (nodo) {
+            liberarNodoIndice(nodo);
+            reiniciarArena(&arena);
+        }
+
+        for (int i = 0; i < numIguales && correcto; i++) {
+            int leido = leerTerminoCorrida(&lectores[iguales[i]]);
+            if (leido > 0) {
+                subirCorrida(monticulo, &enMonticulo, iguales[i]);
+            }
+            correcto = leido >= 0;
+        }
+    }
+    liberarArena(&arena);
+    free(monticulo);
+    free(iguales);
+    return correcto;
+}
+
+/**
+ * @brief Mezcla las corridas vigentes de a grupos en el otro archivo de corridas.
+ *
+ * Cada grupo son corridas consecutivas, asi que las corridas nuevas siguen en
+ * orden de docID. Al terminar, el archivo leido queda vacio para la pasada siguiente.
+ *
+ * @param vias Corridas por grupo.
+ * @param ruta Ruta a cuyo lado se crea el otro archivo, si todavia no existe.
+ * @return 1 si se mezclaron, 0 si fallo la lectura.
+ */
+static int pasadaIntermedia(int vias, const char *ruta) {
+    ArchivoCorridas *destino = &archivos[1 - archivoActual];
+    if (!destino->archivo) {
+        crearArchivoCorridas(destino, ruta, 1 - archivoActual);
+    }
+    FILE *origen = archivos[archivoActual].archivo;
+    Corrida *nuevas = NULL;
+    int numNuevas = 0;
+    int capacidadNuevas = 0;
+    int correcto = 1;
+    for (int c = 0; c < numCorridas && correcto; c += vias) {
+        int n = numCorridas - c < vias ? numCorridas - c : vias;
+        off_t inicioCorrida = ftello(destino->archivo);
+        correcto = mezclarCorridas(&corridas[c], n, fileno(origen), NULL, destino->archivo);
+        uint64_t finCorrida = cerrarTramoCorrida(destino->archivo);
+        agregarCorrida(&nuevas, &numNuevas, &capacidadNuevas, (uint64_t)inicioCorrida, finCorrida);
+    }
+    if (ftruncate(fileno(origen), 0) != 0 || fseeko(origen, 0, SEEK_SET) != 0) {
+        perror("No se pudo vaciar el archivo de corridas del indice");
+        exit(EXIT_FAILURE);
+    }
+    free(corridas);
+    corridas = nuevas;
+    numCorridas = numNuevas;
+    capacidadCorridas = capacidadNuevas;
+    archivoActual = 1 - archivoActual;
+    estadisticas.pasadas++;
+    return correcto;
+}
+
+/**
+ * @brief Fusiona las corridas de la ultima carga en una instantanea.
+ *
+ * Mientras haya mas corridas que las que se mezclan a la vez (ver viasFusion())
+ * hace pasadas intermedias; la ultima mezcla escribe la instantanea.
+ *
+ * @param ruta Ruta de la instantanea.
+ * @param firmaCorpus Firma del directorio indexado.
+ * @return 1 si la instantanea se escribio, 0 en caso de error.
+ */
+int fusionarCorridas(const char *ruta, uint64_t firmaCorpus) {
+    INSTRUMENTAR_INICIO(inicio);
+    EscritorTerminosSnapshot *escritor = iniciarSnapshotPorTerminos(ruta);
+    if (!escritor) {
+        cerrarCorridas();
+        return 0;
+    }
+    int vias = viasFusion();
+    int numLectores = numCorridas < vias ? numCorridas : vias;
+    lectores = ampliar(NULL, (size_t)(numLectores ? numLectores : 1) * sizeof(LectorCorrida));
+    memset(lectores, 0, (size_t)(numLectores ? numLectores : 1) * sizeof(LectorCorrida));
+    for (int l = 0; l < numLectores; l++) {
+        lectores[l].bufer = ampliar(NULL, EXTERNO_BUFER_CORRIDA);
+    }
+
+    int correcto = 1;
+    while (numCorridas > vias && correcto) {
+        correcto = pasadaIntermedia(vias, ruta);
+    }
+    if (correcto) {
+        int descriptor = archivos[archivoActual].archivo ? fileno(archivos[archivoActual].archivo) : -1;
+        correcto = mezclarCorridas(corridas, numCorridas, descriptor, escritor, NULL);
+    }
+    for (int l = 0; l < numLectores; l++) {
+        free(lectores[l].bufer);
+        free(lectores[l].datos);
+    }
+    free(lectores);
+    lectores = NULL;
+    cerrarCorridas();
+
+    if (correcto) {
+        correcto = terminarSnapshotPorTerminos(escritor, firmaCorpus);
+    } else {
+        fprintf(stderr, "No se pudieron fusionar las corridas del indice.\n");
+        cancelarSnapshotPorTerminos(escritor);
+    }
+    INSTRUMENTAR_FIN(TIEMPO_FUSIONAR_CORRIDAS, inicio);
+    return correcto;
+}
+
+/**
+ * @brief Obtiene el resumen de la ultima construccion en memoria externa.
+ *
+ * @param salida Salida.
+ */
+void obtenerEstadisticasExterno(EstadisticasExterno *salida) {
+    *salida = estadisticas;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file externo.h
+ * @brief Construccion del indice en memoria externa, para corpus que no entran en memoria.
+ *
+ * Variante de cargarArchivosEnIndiceYGrafo() al estilo SPIMI: los documentos se
+ * leen con los mismos hilos y se agregan al indice en memoria, pero cuando este
+ * llega al limite de memoria fijado se vuelca a disco como una corrida (sus
+ * palabras ordenadas, cada una con su lista de postings comprimida) y se vacia.
+ * Al terminar, fusionarCorridas() mezcla las corridas en orden de palabra y
+ * escribe directamente la instantanea final (ver snapshot.h), que despues se
+ * abre con abrirSnapshot() como cualquier otra.
+ *
+ * Como los documentos se agregan en orden de docID, cada corrida cubre un rango
+ * de documentos posterior al de la anterior: la fusion de una palabra solo
+ * concatena sus listas, y una palabra que aparece en una sola corrida se copia
+ * sin decodificarla.
+ *
+ * El limite cubre el indice en memoria durante la carga. La tabla de documentos
+ * y el grafo se arman en memoria como siempre (crecen con los documentos y los
+ * enlaces, no con las palabras), y la fusion guarda en memoria la lista de una
+ * palabra a la vez, 8 bytes por palabra para la tabla hash final y un bufer de
+ * EXTERNO_BUFER_CORRIDA por corrida que mezcla. Las corridas comparten un archivo,
+ * asi que no hace falta un descriptor por corrida; si sus bufers no caben en la
+ * mitad del limite, la fusion las mezcla por grupos en pasadas intermedias.
+ */
+
+#ifndef EXTERNO_H
+#define EXTERNO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define EXTERNO_MEMORIA_MINIMA (4 * 1024 * 1024) ///< Limite minimo del indice en memoria; los menores se elevan.
+#define EXTERNO_BUFER_CORRIDA (256 * 1024) ///< Bytes del bufer de lectura y escritura de cada corrida.
+#define EXTERNO_RUTA_SIN_SNAPSHOT "indice.externo.snap" ///< Instantanea de paso cuando no se guarda ninguna.
+
+/**
+ * @struct EstadisticasExterno
+ * @brief Resumen de la ultima construccion en memoria externa.
+ */
+typedef struct {
+    int corridas; ///< Corridas volcadas a disco.
+    uint64_t bytesCorridas; ///< Bytes escritos en las corridas.
+    size_t memoriaMaxima; ///< Mayor memoria del indice en memoria al volcar una corrida.
+    int palabras; ///< Palabras distintas de la instantanea final.
+    int palabrasCombinadas; ///< Listas armadas con las de varias corridas, contando las pasadas intermedias.
+    int pasadas; ///< Pasadas intermedias de la fusion.
+} EstadisticasExterno;
+
+/**
+ * @brief Carga los documentos de un directorio volcando el indice a disco por corridas.
+ *
+ * Asigna los docID y arma la tabla de documentos y el grafo igual que
+ * cargarArchivosEnIndiceYGrafo(). Al terminar, el indice en memoria queda vacio
+ * y los postings estan en las corridas, que hay que pasar a una instantanea con
+ * fusionarCorridas() (despues de calcular el PageRank, que la instantanea guarda).
+ *
+ * Las corridas son archivos temporales junto a rutaTemporal, borrados apenas se
+ * crean: no dejan restos aunque el proceso termine a la mitad. Si no se puede
+ * escribir una corrida el programa termina, como cuando falta memoria.
+ *
+ * @param directorio Directorio de documentos.
+ * @param hilos Numero de hilos de lectura.
+ * @param memoriaMaxima Bytes que puede ocupar el indice en memoria antes de volcarlo
+ *                      (al menos EXTERNO_MEMORIA_MINIMA).
+ * @param rutaTemporal Ruta a cuyo lado se crean las corridas (por ejemplo, la de la instantanea).
+ * @return Numero de corridas escritas.
+ */
+int cargarArchivosEnCorridas(const char *directorio, int hilos, size_t memoriaMaxima, const char *rutaTemporal);
+
+/**
+ * @brief Fusiona las corridas de la ultima carga en una instantanea.
+ *
+ * Hace una mezcla de k vias por palabra y escribe cada lista completa con
+ * agregarTerminoSnapshot(); la tabla de documentos, el grafo y el PageRank se
+ * toman del estado actual. k sale del limite de memoria de la carga; con mas
+ * corridas, antes se mezclan de a k en corridas mas largas. Las corridas se
+ * cierran en cualquier caso.
+ *
+ * @param ruta Ruta de la instantanea.
+ * @param firmaCorpus Firma del directorio indexado (ver calcularFirmaCorpus()).
+ * @return 1 si la instantanea se escribio, 0 en caso de error.
+ */
+int fusionarCorridas(const char *ruta, uint64_t firmaCorpus);
+
+/**
+ * @brief Obtiene el resumen de la ultima construccion en memoria externa.
+ *
+ * @param estadisticas Salida.
+ */
+void obtenerEstadisticasExterno(EstadisticasExterno *estadisticas);
+
+#endif
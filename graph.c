@@ -7,11 +7,75 @@
  */
 
 #include "graph.h"
+#include "contexto.h"
+#include "index.h"
+#include "instrumentacion.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include <pthread.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 Grafo grafo; ///< Estructura global que representa el grafo.
+int hilosPageRank = 1; ///< Numero de hilos usados por calcularPageRank().
+
+/**
+ * @struct TrabajoPageRank
+ * @brief Estado compartido por los hilos durante un calculo de PageRank.
+ *
+ * Los arreglos de PageRank y de contribuciones tienen doble bufer: en cada
+ * iteracion se lee uno y se escribe el otro. Las sumas parciales de cada hilo
+ * tambien se alternan por paridad de iteracion, de modo que basta una barrera
+ * por iteracion.
+ */
+typedef struct {
+    int numHilos; ///< Hilos que participan.
+    int numDocs; ///< Documentos del grafo.
+    double amortiguamiento; ///< Factor de amortiguamiento.
+    double tolerancia; ///< Diferencia L1 de parada.
+    int maxIteraciones; ///< Tope de iteraciones.
+    const size_t *inicio; ///< CSC: inicio de los enlaces entrantes.
+    const int *origenes; ///< CSC: origenes de los enlaces entrantes.
+    const double *inverso; ///< Inverso del grado de salida.
+    double *rank[2]; ///< PageRank de la iteracion par e impar.
+    double *contribucion[2]; ///< Contribuciones de la iteracion par e impar.
+    double *masaParcial[2]; ///< Masa sin enlaces acumulada por cada hilo.
+    double *residuoParcial[2]; ///< Diferencia L1 acumulada por cada hilo.
+    int *limites; ///< Primer documento de cada hilo (numHilos + 1 entradas).
+    pthread_barrier_t barrera; ///< Barrera de fin de iteracion.
+    pthread_mutex_t mutexArranque; ///< Protege el campo arranque.
+    pthread_cond_t condArranque; ///< Avisa a los hilos cuando arranque cambia.
+    int arranque; ///< 0 mientras se crean los hilos, 1 para empezar, -1 para abortar.
+    int iteraciones; ///< Iteraciones realizadas (escrita por el hilo 0).
+    double residuoInicial; ///< Residuo de la primera iteracion (escrito por el hilo 0).
+    double residuo; ///< Residuo final (escrito por el hilo 0).
+} TrabajoPageRank;
+
+/**
+ * @struct HiloPageRank
+ * @brief Argumento de cada hilo de PageRank.
+ */
+typedef struct {
+    TrabajoPageRank *trabajo; ///< Estado compartido.
+    int id; ///< Indice del hilo, determina su bloque de documentos.
+} HiloPageRank;
+
+/**
+ * @brief Libera los arreglos CSR/CSC, salvo que pertenezcan a una instantanea.
+ */
+static void liberarArreglosCongelados() {
+    if (!grafo.arreglosExternos) {
+        free(grafo.inicioSalida);
+        free(grafo.destinosSalida);
+        free(grafo.inicioEntrada);
+        free(grafo.origenesEntrada);
+        free(grafo.inversoGradoSalida);
+    }
+    grafo.arreglosExternos = 0;
+}
 
 /**
  * @brief Inicializa el grafo con un numero especifico de documentos.
@@ -21,108 +85,1518 @@ Grafo grafo; ///< Estructura global que representa el grafo.
  * @param numDocs Numero de documentos que formaran parte del grafo.
  */
 void inicializarGrafo(int numDocs) {
-    grafo.numDocs = numDocs;
-    for (int i = 0; i < numDocs; i++) {
+    free(grafo.adyacencia);
+    free(grafo.pageRank);
+    free(grafo.topPageRank);
+    free(grafo.salidaReemplazada);
+    free(grafo.residuo);
+    liberarArreglosCongelados();
+    // Las listas pendientes viven en la arena: basta con vaciarla.
+    Arena arenaEnlaces = grafo.arenaEnlaces;
+    reiniciarArena(&arenaEnlaces);
+    memset(&grafo, 0, sizeof(grafo));
+    grafo.arenaEnlaces = arenaEnlaces;
+    asegurarDocumentosGrafo(numDocs);
+}
+
+/**
+ * @brief Garantiza que el grafo tenga al menos el numero de documentos indicado.
+ *
+ * Duplica la capacidad reservada cuando hace falta, de modo que agregar documentos
+ * uno a uno cuesta tiempo constante amortizado.
+ *
+ * @param numDocs Numero minimo de documentos que debe tener el grafo.
+ */
+void asegurarDocumentosGrafo(int numDocs) {
+    if (numDocs > grafo.capacidad) {
+        int capacidad = grafo.capacidad ? grafo.capacidad : 64;
+        while (capacidad < numDocs) {
+            capacidad *= 2;
+        }
+        NodoGrafo **adyacencia = realloc(grafo.adyacencia, capacidad * sizeof(NodoGrafo *));
+        double *pageRank = realloc(grafo.pageRank, capacidad * sizeof(double));
+        if (!adyacencia || !pageRank) {
+            perror("No se pudo ampliar el grafo");
+            exit(EXIT_FAILURE);
+        }
+        grafo.adyacencia = adyacencia;
+        grafo.pageRank = pageRank;
+        grafo.capacidad = capacidad;
+        if (grafo.residuo) {
+            double *residuo = realloc(grafo.residuo, capacidad * sizeof(double));
+            if (!residuo) {
+                perror("No se pudo ampliar el grafo");
+                exit(EXIT_FAILURE);
+            }
+            grafo.residuo = residuo;
+        }
+    }
+    for (int i = grafo.numDocs; i < numDocs; i++) {
         grafo.adyacencia[i] = NULL;
         grafo.pageRank[i] = 0.0;
     }
+    if (numDocs > grafo.numDocs) {
+        if (grafo.residuoValido) {
+            // El teletransporte se reparte entre mas documentos: baja para todos los anteriores.
+            // Los nuevos tienen PageRank 0 y ningun enlace entrante, asi que su residuo es el
+            // teletransporte completo.
+            double d = grafo.amortiguamientoResiduo;
+            double masa = (1.0 - d) + d * grafo.masaSinEnlacesResiduo;
+            double nuevaBase = masa / numDocs;
+            grafo.residuoUniforme += nuevaBase - masa / grafo.numDocs;
+            for (int i = grafo.numDocs; i < numDocs; i++) {
+                grafo.residuo[i] = nuevaBase - grafo.residuoUniforme;
+            }
+        }
+        grafo.numDocs = numDocs;
+        grafo.modificado = 1;
+        grafo.tamanoTopPageRank = 0; // Los documentos nuevos pueden entrar al ranking
+    }
+}
+
+/**
+ * @brief Indica si los enlaces congelados de un documento siguen vigentes.
+ *
+ * @param u Documento.
+ * @return 1 si el documento esta en los arreglos CSR y sus enlaces no se reemplazaron.
+ */
+static int usaEnlacesCongelados(int u) {
+    return u < grafo.docsCongelados && !(grafo.salidaReemplazada && grafo.salidaReemplazada[u]);
+}
+
+/**
+ * @brief Cuenta los enlaces salientes vigentes de un documento, congelados y pendientes.
+ *
+ * @param u Documento.
+ * @return Grado de salida.
+ */
+static size_t gradoSalidaActual(int u) {
+    size_t grado = 0;
+    if (usaEnlacesCongelados(u)) {
+        grado = grafo.inicioSalida[u + 1] - grafo.inicioSalida[u];
+    }
+    for (NodoGrafo *nodo = grafo.adyacencia[u]; nodo; nodo = nodo->siguiente) {
+        grado++;
+    }
+    return grado;
+}
+
+/**
+ * @brief Reparte una cantidad de PageRank de un documento entre sus enlaces salientes.
+ *
+ * Suma d * cantidad / grado al residuo de cada destino. Si el documento no tiene
+ * enlaces, la cantidad cuenta como masa sin enlaces y se reparte entre todos los
+ * documentos a traves del residuo uniforme.
+ *
+ * @param u Documento de origen.
+ * @param cantidad PageRank a repartir (negativa para retirar un aporte).
+ * @param umbral Residuo a partir del cual un destino se agrega a la cola.
+ * @param cola Cola de documentos por empujar (NULL si no se usa).
+ * @param finCola Posicion de escritura de la cola.
+ * @param enCola Marca de los documentos que ya estan en la cola.
+ */
+static void repartirResiduo(int u, double cantidad, double umbral, int *cola, size_t *finCola, char *enCola) {
+    double d = grafo.amortiguamientoResiduo;
+    size_t grado = gradoSalidaActual(u);
+    if (grado == 0) {
+        grafo.masaSinEnlacesResiduo += cantidad;
+        grafo.residuoUniforme += d * cantidad / grafo.numDocs;
+        return;
+    }
+    double aporte = d * cantidad / (double)grado;
+    size_t e = 0;
+    size_t fin = 0;
+    if (usaEnlacesCongelados(u)) {
+        e = grafo.inicioSalida[u];
+        fin = grafo.inicioSalida[u + 1];
+    }
+    NodoGrafo *nodo = grafo.adyacencia[u];
+    while (e < fin || nodo) {
+        int v;
+        if (e < fin) {
+            v = grafo.destinosSalida[e++];
+        } else {
+            v = nodo->docID;
+            nodo = nodo->siguiente;
+        }
+        grafo.residuo[v] += aporte;
+        if (cola && !enCola[v] && fabs(grafo.residuo[v]) >= umbral) {
+            enCola[v] = 1;
+            cola[(*finCola)++ % grafo.numDocs] = v;
+        }
+    }
 }
 
 /**
  * @brief Agrega un enlace dirigido en el grafo entre dos documentos.
  *
  * Crea un enlace del documento de origen al documento de destino en la lista de adyacencia.
+ * Los identificadores negativos se descartan.
  *
  * @param origen Identificador del documento de origen.
  * @param destino Identificador del documento de destino.
  */
 void agregarEnlace(int origen, int destino) {
-    NodoGrafo *nuevo = malloc(sizeof(NodoGrafo));
+    if (origen < 0 || destino < 0) {
+        fprintf(stderr, "Enlace invalido %d -> %d descartado.\n", origen, destino);
+        return;
+    }
+    asegurarDocumentosGrafo((origen > destino ? origen : destino) + 1);
+    // Con el residuo vigente, el aporte del origen se retira y se vuelve a repartir con el nuevo grado.
+    if (grafo.residuoValido) {
+        repartirResiduo(origen, -grafo.pageRank[origen], 0.0, NULL, NULL, NULL);
+    }
+    NodoGrafo *nuevo = reservarArena(&grafo.arenaEnlaces, sizeof(NodoGrafo));
     nuevo->docID = destino;
     nuevo->siguiente = grafo.adyacencia[origen];
     grafo.adyacencia[origen] = nuevo;
+    grafo.modificado = 1;
+    if (grafo.residuoValido) {
+        repartirResiduo(origen, grafo.pageRank[origen], 0.0, NULL, NULL, NULL);
+    }
+}
+
+/**
+ * @brief Reserva un arreglo o termina el programa si no hay memoria.
+ *
+ * @param bytes Tamano del bloque en bytes.
+ * @return Bloque reservado.
+ */
+static void *reservarGrafo(size_t bytes) {
+    void *bloque = malloc(bytes ? bytes : 1);
+    if (!bloque) {
+        perror("No se pudo reservar memoria para el grafo");
+        exit(EXIT_FAILURE);
+    }
+    return bloque;
+}
+
+/**
+ * @brief Reemplaza todos los enlaces salientes de un documento.
+ *
+ * Descarta los enlaces pendientes del documento (su memoria se recupera al
+ * congelar) y marca los congelados para que el siguiente congelamiento los omita.
+ *
+ * @param origen Documento cuyos enlaces se reemplazan.
+ * @param destinos Nuevos destinos (pueden repetirse).
+ * @param numDestinos Numero de destinos (0 deja al documento sin enlaces).
+ */
+void reemplazarEnlacesSalientes(int origen, const int *destinos, int numDestinos) {
+    if (origen < 0) {
+        return;
+    }
+    int maximo = origen;
+    for (int i = 0; i < numDestinos; i++) {
+        if (destinos[i] > maximo) {
+            maximo = destinos[i];
+        }
+    }
+    asegurarDocumentosGrafo(maximo + 1);
+    int residuoValido = grafo.residuoValido;
+    if (residuoValido) {
+        repartirResiduo(origen, -grafo.pageRank[origen], 0.0, NULL, NULL, NULL);
+    }
+    grafo.adyacencia[origen] = NULL;
+
+    if (origen < grafo.docsCongelados) {
+        if (!grafo.salidaReemplazada) {
+            grafo.salidaReemplazada = calloc(grafo.docsCongelados, 1);
+            if (!grafo.salidaReemplazada) {
+                perror("No se pudo reservar memoria para el grafo");
+                exit(EXIT_FAILURE);
+            }
+        }
+        grafo.salidaReemplazada[origen] = 1;
+    }
+    // El residuo se corrige una sola vez con los enlaces definitivos, no enlace por enlace.
+    grafo.residuoValido = 0;
+    for (int i = 0; i < numDestinos; i++) {
+        agregarEnlace(origen, destinos[i]);
+    }
+    grafo.modificado = 1;
+    grafo.residuoValido = residuoValido;
+    if (residuoValido) {
+        repartirResiduo(origen, grafo.pageRank[origen], 0.0, NULL, NULL, NULL);
+    }
+}
+
+/**
+ * @brief Registra que el vector de PageRank cambio.
+ *
+ * Descarta el ranking en cache y publica una copia del vector, con su maximo, en
+ * un contexto de lectura nuevo; las consultas en curso siguen con el anterior.
+ * Despues avanza la generacion del indice, porque los puntajes guardados de las
+ * consultas ya no valen.
+ */
+static void pageRankActualizado() {
+    grafo.tamanoTopPageRank = 0;
+    ContextoLectura *contexto = crearContextoLectura(grafo.numDocs);
+    for (int i = 0; i < grafo.numDocs; i++) {
+        contexto->pageRank[i] = grafo.pageRank[i];
+        if (grafo.pageRank[i] > contexto->pageRankMaximo) {
+            contexto->pageRankMaximo = grafo.pageRank[i];
+        }
+    }
+    contexto->iteraciones = grafo.iteracionesPageRank;
+    contexto->residuo = grafo.residuoPageRank;
+    publicarContextoLectura(contexto);
+    avanzarGeneracionIndice();
+}
+
+/**
+ * @brief Adopta arreglos CSR/CSC externos y un vector de PageRank ya calculado.
+ *
+ * @param numDocs Numero de documentos.
+ * @param numEnlaces Numero de enlaces.
+ * @param inicioSalida CSR: inicio de los enlaces salientes (numDocs + 1 entradas).
+ * @param destinosSalida CSR: destinos de los enlaces salientes.
+ * @param inicioEntrada CSC: inicio de los enlaces entrantes (numDocs + 1 entradas).
+ * @param origenesEntrada CSC: origenes de los enlaces entrantes.
+ * @param inversoGradoSalida Inverso del grado de salida de cada documento.
+ * @param pageRank PageRank de cada documento.
+ * @param iteraciones Iteraciones del calculo que produjo el PageRank.
+ * @param residuo Residuo del calculo que produjo el PageRank.
+ */
+void usarGrafoExterno(int numDocs, size_t numEnlaces, const size_t *inicioSalida, const int *destinosSalida,
+                      const size_t *inicioEntrada, const int *origenesEntrada, const double *inversoGradoSalida,
+                      const double *pageRank, int iteraciones, double residuo) {
+    inicializarGrafo(numDocs);
+    grafo.inicioSalida = (size_t *)inicioSalida;
+    grafo.destinosSalida = (int *)destinosSalida;
+    grafo.inicioEntrada = (size_t *)inicioEntrada;
+    grafo.origenesEntrada = (int *)origenesEntrada;
+    grafo.inversoGradoSalida = (double *)inversoGradoSalida;
+    grafo.arreglosExternos = 1;
+    grafo.numEnlaces = numEnlaces;
+    grafo.docsCongelados = numDocs;
+    grafo.modificado = 0;
+    memcpy(grafo.pageRank, pageRank, numDocs * sizeof(double));
+    grafo.iteracionesPageRank = iteraciones;
+    grafo.residuoPageRank = residuo;
+    // La instantanea no guarda el residuo inicial; el de un calculo desde el uniforme ronda 1.
+    if (iteraciones > 0 && residuo > 0.0 && residuo < 1.0) {
+        grafo.contraccionPageRank = pow(residuo, 1.0 / iteraciones);
+    }
+    pageRankActualizado();
+}
+
+/**
+ * @brief Devuelve el grafo global, congelado, para lectura.
+ *
+ * @return Puntero al grafo.
+ */
+const Grafo *obtenerGrafo() {
+    if (grafo.modificado) {
+        congelarGrafo();
+    }
+    return &grafo;
+}
+
+/**
+ * @brief Instala un arreglo CSR nuevo y arma a partir de el el arreglo CSC.
+ *
+ * Los origenes de cada destino quedan ordenados de menor a mayor. Los arreglos
+ * pasan a ser del grafo, que deja de tener enlaces pendientes.
+ *
+ * @param inicioSalida CSR: inicio de los enlaces salientes (numDocs + 1 entradas).
+ * @param destinosSalida CSR: destinos de los enlaces salientes.
+ * @param numEnlaces Numero de enlaces.
+ */
+static void instalarEnlacesCongelados(size_t *inicioSalida, int *destinosSalida, size_t numEnlaces) {
+    int n = grafo.numDocs;
+
+    // Transponer a CSC contando los enlaces entrantes de cada destino
+    size_t *inicioEntrada = calloc(n + 1, sizeof(size_t));
+    int *origenesEntrada = reservarGrafo(numEnlaces * sizeof(int));
+    double *inversoGradoSalida = reservarGrafo((n ? n : 1) * sizeof(double));
+    if (!inicioEntrada) {
+        perror("No se pudo reservar memoria para el grafo");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t e = 0; e < numEnlaces; e++) {
+        inicioEntrada[destinosSalida[e] + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+        inicioEntrada[v + 1] += inicioEntrada[v];
+    }
+    size_t *cursor = reservarGrafo((n ? n : 1) * sizeof(size_t));
+    memcpy(cursor, inicioEntrada, n * sizeof(size_t));
+    for (int u = 0; u < n; u++) {
+        size_t grado = inicioSalida[u + 1] - inicioSalida[u];
+        inversoGradoSalida[u] = grado ? 1.0 / (double)grado : 0.0;
+        for (size_t e = inicioSalida[u]; e < inicioSalida[u + 1]; e++) {
+            origenesEntrada[cursor[destinosSalida[e]]++] = u;
+        }
+    }
+    free(cursor);
+
+    liberarArreglosCongelados();
+    grafo.inicioSalida = inicioSalida;
+    grafo.destinosSalida = destinosSalida;
+    grafo.inicioEntrada = inicioEntrada;
+    grafo.origenesEntrada = origenesEntrada;
+    grafo.inversoGradoSalida = inversoGradoSalida;
+    grafo.numEnlaces = numEnlaces;
+    grafo.docsCongelados = n;
+    grafo.modificado = 0;
+    free(grafo.salidaReemplazada);
+    grafo.salidaReemplazada = NULL;
+}
+
+/**
+ * @brief Traslada los enlaces pendientes a los arreglos CSR y CSC.
+ *
+ * Combina los enlaces ya congelados (salvo los de documentos cuyos enlaces se
+ * reemplazaron) con los de las listas de adyacencia en un nuevo arreglo CSR,
+ * vacia la arena de las listas y construye a partir de el el arreglo CSC, en el que
+ * los origenes de cada destino quedan ordenados de menor a mayor.
+ */
+void congelarGrafo() {
+    int n = grafo.numDocs;
+    size_t *inicioSalida = reservarGrafo((n + 1) * sizeof(size_t));
+
+    // Grado de salida: enlaces congelados mas enlaces pendientes
+    for (int u = 0; u < n; u++) {
+        size_t grado = 0;
+        if (u < grafo.docsCongelados && !(grafo.salidaReemplazada && grafo.salidaReemplazada[u])) {
+            grado = grafo.inicioSalida[u + 1] - grafo.inicioSalida[u];
+        }
+        for (NodoGrafo *nodo = grafo.adyacencia[u]; nodo; nodo = nodo->siguiente) {
+            grado++;
+        }
+        inicioSalida[u + 1] = grado;
+    }
+    inicioSalida[0] = 0;
+    for (int u = 0; u < n; u++) {
+        inicioSalida[u + 1] += inicioSalida[u];
+    }
+    size_t numEnlaces = inicioSalida[n];
+
+    int *destinosSalida = reservarGrafo(numEnlaces * sizeof(int));
+    for (int u = 0; u < n; u++) {
+        size_t k = inicioSalida[u];
+        if (u < grafo.docsCongelados && !(grafo.salidaReemplazada && grafo.salidaReemplazada[u])) {
+            for (size_t e = grafo.inicioSalida[u]; e < grafo.inicioSalida[u + 1]; e++) {
+                destinosSalida[k++] = grafo.destinosSalida[e];
+            }
+        }
+        for (NodoGrafo *nodo = grafo.adyacencia[u]; nodo; nodo = nodo->siguiente) {
+            destinosSalida[k++] = nodo->docID;
+        }
+        grafo.adyacencia[u] = NULL;
+    }
+    reiniciarArena(&grafo.arenaEnlaces);
+
+    instalarEnlacesCongelados(inicioSalida, destinosSalida, numEnlaces);
+}
+
+/**
+ * @brief Reemplaza todos los enlaces del grafo por un arreglo CSR ya armado.
+ *
+ * Descarta los enlaces pendientes y congelados. El residuo del PageRank deja de
+ * valer, porque cambian los enlaces de todos los documentos.
+ *
+ * @param inicioSalida CSR: inicio de los enlaces salientes (numDocs + 1 entradas).
+ * @param destinosSalida CSR: destinos de los enlaces salientes.
+ * @param numEnlaces Numero de enlaces.
+ */
+void establecerEnlaces(size_t *inicioSalida, int *destinosSalida, size_t numEnlaces) {
+    for (int u = 0; u < grafo.numDocs; u++) {
+        grafo.adyacencia[u] = NULL;
+    }
+    reiniciarArena(&grafo.arenaEnlaces);
+    grafo.residuoValido = 0;
+    instalarEnlacesCongelados(inicioSalida, destinosSalida, numEnlaces);
+}
+
+/**
+ * @brief Configura cuantos hilos usa calcularPageRank().
+ *
+ * @param hilos Numero de hilos (se acota entre 1 y PAGERANK_MAX_HILOS).
+ */
+void establecerHilosPageRank(int hilos) {
+    if (hilos < 1) {
+        hilos = 1;
+    }
+    if (hilos > PAGERANK_MAX_HILOS) {
+        hilos = PAGERANK_MAX_HILOS;
+    }
+    hilosPageRank = hilos;
+}
+
+/**
+ * @brief Devuelve el numero de hilos configurado para PageRank.
+ *
+ * @return Numero de hilos.
+ */
+int obtenerHilosPageRank() {
+    return hilosPageRank;
+}
+
+/**
+ * @brief Reparte los documentos en bloques contiguos de costo parecido.
+ *
+ * El costo de un bloque es su numero de documentos mas su numero de enlaces
+ * entrantes, de modo que los documentos muy enlazados no sobrecargan un hilo.
+ *
+ * @param trabajo Estado del calculo; se llenan sus limites.
+ */
+static void repartirDocumentos(TrabajoPageRank *trabajo) {
+    int n = trabajo->numDocs;
+    double costoTotal = (double)n + (double)trabajo->inicio[n];
+    trabajo->limites[0] = 0;
+    for (int t = 1; t < trabajo->numHilos; t++) {
+        double objetivo = costoTotal * t / trabajo->numHilos;
+        int bajo = trabajo->limites[t - 1];
+        int alto = n;
+        while (bajo < alto) {
+            int medio = bajo + (alto - bajo) / 2;
+            if ((double)medio + (double)trabajo->inicio[medio] < objetivo) {
+                bajo = medio + 1;
+            } else {
+                alto = medio;
+            }
+        }
+        trabajo->limites[t] = bajo;
+    }
+    trabajo->limites[trabajo->numHilos] = n;
+}
+
+/**
+ * @brief Cuerpo de cada hilo de PageRank.
+ *
+ * En una sola pasada por su bloque, el hilo suma las contribuciones entrantes de
+ * cada documento, aplica amortiguamiento y teletransporte, acumula la diferencia
+ * L1 y deja lista la contribucion del documento para la siguiente iteracion. Tras
+ * la barrera, todos los hilos suman las parciales en el mismo orden y llegan a la
+ * misma decision de parada sin necesidad de operaciones atomicas.
+ *
+ * @param argumento Puntero a un HiloPageRank.
+ * @return NULL.
+ */
+static void *ejecutarHiloPageRank(void *argumento) {
+    HiloPageRank *hilo = argumento;
+    TrabajoPageRank *trabajo = hilo->trabajo;
+
+    if (hilo->id != 0) {
+        pthread_mutex_lock(&trabajo->mutexArranque);
+        while (trabajo->arranque == 0) {
+            pthread_cond_wait(&trabajo->condArranque, &trabajo->mutexArranque);
+        }
+        int abortar = trabajo->arranque < 0;
+        pthread_mutex_unlock(&trabajo->mutexArranque);
+        if (abortar) {
+            return NULL;
+        }
+    }
+
+    int n = trabajo->numDocs;
+    int desde = trabajo->limites[hilo->id];
+    int hasta = trabajo->limites[hilo->id + 1];
+    double d = trabajo->amortiguamiento;
+    const size_t *inicio = trabajo->inicio;
+    const int *origenes = trabajo->origenes;
+    const double *inverso = trabajo->inverso;
+    double masaSinEnlaces = 0.0;
+
+    for (int t = 0; t < trabajo->numHilos; t++) {
+        masaSinEnlaces += trabajo->masaParcial[0][t];
+    }
+
+    INSTRUMENTAR_INICIO(relojInicio);
+    int iter = 0;
+    double residuo = 0.0;
+    while (iter < trabajo->maxIteraciones) {
+        int par = iter & 1;
+        const double *rank = trabajo->rank[par];
+        const double *contribucion = trabajo->contribucion[par];
+        double *nuevoRank = trabajo->rank[!par];
+        double *nuevaContribucion = trabajo->contribucion[!par];
+        double base = (1.0 - d) / n + d * masaSinEnlaces / n;
+        double masaLocal = 0.0;
+        double residuoLocal = 0.0;
+
+        for (int v = desde; v < hasta; v++) {
+            double suma = 0.0;
+            for (size_t e = inicio[v]; e < inicio[v + 1]; e++) {
+                suma += contribucion[origenes[e]];
+            }
+            double valor = base + d * suma;
+            residuoLocal += fabs(valor - rank[v]);
+            nuevoRank[v] = valor;
+            nuevaContribucion[v] = valor * inverso[v];
+            if (inverso[v] == 0.0) {
+                masaLocal += valor;
+            }
+        }
+        trabajo->masaParcial[!par][hilo->id] = masaLocal;
+        trabajo->residuoParcial[par][hilo->id] = residuoLocal;
+
+        if (trabajo->numHilos > 1) {
+            pthread_barrier_wait(&trabajo->barrera);
+        }
+
+        masaSinEnlaces = 0.0;
+        residuo = 0.0;
+        for (int t = 0; t < trabajo->numHilos; t++) {
+            masaSinEnlaces += trabajo->masaParcial[!par][t];
+            residuo += trabajo->residuoParcial[par][t];
+        }
+        iter++;
+        if (hilo->id == 0) {
+            INSTRUMENTAR_ITERACION_PAGERANK(iter, residuo, relojInicio);
+            if (iter == 1) {
+                trabajo->residuoInicial = residuo;
+            }
+        }
+        if (residuo < trabajo->tolerancia) {
+            break;
+        }
+    }
+
+    if (hilo->id == 0) {
+        trabajo->iteraciones = iter;
+        trabajo->residuo = residuo;
+    }
+    return NULL;
 }
 
 /**
  * @brief Calcula el PageRank de cada documento en el grafo.
  *
- * Utiliza el metodo iterativo de PageRank con un factor de amortiguamiento y un numero fijo de iteraciones.
+ * Cada hilo se encarga de un bloque contiguo de documentos y, en cada iteracion,
+ * recorre secuencialmente sus enlaces entrantes en el arreglo CSC sumando las
+ * contribuciones (PageRank dividido por grado de salida) de los origenes. La masa
+ * de los documentos sin enlaces se reparte de forma uniforme junto con el termino
+ * de teletransporte. Cada documento es escrito por un solo hilo, por lo que no se
+ * necesitan operaciones atomicas.
  *
  * @param dampingFactor Factor de amortiguamiento utilizado en el calculo.
- * @param iteraciones Numero de iteraciones para refinar los valores de PageRank.
+ * @param maxIteraciones Numero maximo de iteraciones.
+ * @param tolerancia Diferencia L1 bajo la cual se detiene el calculo.
+ * @param desdeAnterior 1 para partir del vector de PageRank anterior, 0 para partir del uniforme.
+ * @return Numero de iteraciones realizadas.
  */
-void calcularPageRank(double dampingFactor, int iteraciones) {
-    // Inicializar PageRank uniforme
-    for (int i = 0; i < grafo.numDocs; i++) {
-        grafo.pageRank[i] = 1.0 / grafo.numDocs;
+static int resolverPageRank(double dampingFactor, int maxIteraciones, double tolerancia, int desdeAnterior) {
+    if (grafo.modificado) {
+        congelarGrafo();
+    }
+    int n = grafo.numDocs;
+    grafo.iteracionesPageRank = 0;
+    grafo.residuoPageRank = 0.0;
+    grafo.empujesPageRank = 0;
+    grafo.residuoValido = 0;
+    if (n == 0) {
+        return 0;
+    }
+    INSTRUMENTAR_INICIO(relojInicio);
+
+    TrabajoPageRank trabajo;
+    memset(&trabajo, 0, sizeof(trabajo));
+    trabajo.numHilos = hilosPageRank < n ? hilosPageRank : n;
+    trabajo.numDocs = n;
+    trabajo.amortiguamiento = dampingFactor;
+    trabajo.tolerancia = tolerancia;
+    trabajo.maxIteraciones = maxIteraciones;
+    trabajo.inicio = grafo.inicioEntrada;
+    trabajo.origenes = grafo.origenesEntrada;
+    trabajo.inverso = grafo.inversoGradoSalida;
+
+    int T = trabajo.numHilos;
+    double *otroRank = malloc(n * sizeof(double));
+    double *contribuciones = malloc(2 * (size_t)n * sizeof(double));
+    double *parciales = calloc(4 * (size_t)T, sizeof(double));
+    int *limites = malloc((T + 1) * sizeof(int));
+    HiloPageRank *hilos = malloc(T * sizeof(HiloPageRank));
+    pthread_t *ids = malloc(T * sizeof(pthread_t));
+    if (!otroRank || !contribuciones || !parciales || !limites || !hilos || !ids) {
+        perror("No se pudo reservar memoria para PageRank");
+        free(otroRank);
+        free(contribuciones);
+        free(parciales);
+        free(limites);
+        free(hilos);
+        free(ids);
+        return 0;
+    }
+    trabajo.rank[0] = grafo.pageRank;
+    trabajo.rank[1] = otroRank;
+    trabajo.contribucion[0] = contribuciones;
+    trabajo.contribucion[1] = contribuciones + n;
+    trabajo.masaParcial[0] = parciales;
+    trabajo.masaParcial[1] = parciales + T;
+    trabajo.residuoParcial[0] = parciales + 2 * T;
+    trabajo.residuoParcial[1] = parciales + 3 * T;
+    trabajo.limites = limites;
+    repartirDocumentos(&trabajo);
+
+    // Inicializar PageRank uniforme, o desde el vector anterior si se pidio y es utilizable
+    double suma = 0.0;
+    if (desdeAnterior) {
+        for (int i = 0; i < n; i++) {
+            // Todo PageRank calculado es positivo: un 0 indica un documento nuevo.
+            if (grafo.pageRank[i] <= 0.0) {
+                grafo.pageRank[i] = 1.0 / n;
+            }
+            suma += grafo.pageRank[i];
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        grafo.pageRank[i] = suma > 0.0 ? grafo.pageRank[i] / suma : 1.0 / n;
+        contribuciones[i] = grafo.pageRank[i] * grafo.inversoGradoSalida[i];
+    }
+    for (int t = 0; t < T; t++) {
+        for (int i = limites[t]; i < limites[t + 1]; i++) {
+            if (grafo.inversoGradoSalida[i] == 0.0) {
+                trabajo.masaParcial[0][t] += grafo.pageRank[i];
+            }
+        }
+    }
+
+    for (int t = 0; t < T; t++) {
+        hilos[t].trabajo = &trabajo;
+        hilos[t].id = t;
+    }
+    pthread_mutex_init(&trabajo.mutexArranque, NULL);
+    pthread_cond_init(&trabajo.condArranque, NULL);
+    if (T > 1) {
+        pthread_barrier_init(&trabajo.barrera, NULL, T);
+    }
+    int lanzados = 1;
+    while (lanzados < T && pthread_create(&ids[lanzados], NULL, ejecutarHiloPageRank, &hilos[lanzados]) == 0) {
+        lanzados++;
+    }
+
+    // Sin todos los hilos la barrera nunca se completaria: se aborta y se calcula en serie.
+    pthread_mutex_lock(&trabajo.mutexArranque);
+    trabajo.arranque = lanzados == T ? 1 : -1;
+    pthread_cond_broadcast(&trabajo.condArranque);
+    pthread_mutex_unlock(&trabajo.mutexArranque);
+
+    if (lanzados == T) {
+        ejecutarHiloPageRank(&hilos[0]);
+    }
+    for (int t = 1; t < lanzados; t++) {
+        pthread_join(ids[t], NULL);
+    }
+    if (T > 1) {
+        pthread_barrier_destroy(&trabajo.barrera);
     }
+    pthread_cond_destroy(&trabajo.condArranque);
+    pthread_mutex_destroy(&trabajo.mutexArranque);
 
-    // Iteraciones de refinamiento
-    for (int iter = 0; iter < iteraciones; iter++) {
-        double nuevoPageRank[MAX_DOCS] = {0};
-        for (int i = 0; i < grafo.numDocs; i++) {
-            NodoGrafo *nodo = grafo.adyacencia[i];
-            while (nodo) {
-                int destino = nodo->docID;
-                nuevoPageRank[destino] += grafo.pageRank[i];
-                nodo = nodo->siguiente;
+    if (lanzados < T) {
+        fprintf(stderr, "No se pudieron crear los hilos de PageRank; se usara un solo hilo.\n");
+        free(otroRank);
+        free(contribuciones);
+        free(parciales);
+        free(limites);
+        free(hilos);
+        free(ids);
+        int hilosConfigurados = hilosPageRank;
+        hilosPageRank = 1;
+        int iteraciones = resolverPageRank(dampingFactor, maxIteraciones, tolerancia, desdeAnterior);
+        hilosPageRank = hilosConfigurados;
+        return iteraciones;
+    }
+
+    if (trabajo.iteraciones & 1) {
+        memcpy(grafo.pageRank, otroRank, n * sizeof(double));
+    }
+    free(otroRank);
+    free(contribuciones);
+    free(parciales);
+    free(limites);
+    free(hilos);
+    free(ids);
+
+    grafo.iteracionesPageRank = trabajo.iteraciones;
+    grafo.residuoPageRank = trabajo.residuo;
+    if (trabajo.iteraciones > 1 && trabajo.residuoInicial > 0.0 && trabajo.residuo > 0.0) {
+        grafo.contraccionPageRank = pow(trabajo.residuo / trabajo.residuoInicial, 1.0 / (trabajo.iteraciones - 1));
+    }
+    grafo.empujesPageRank = 0;
+    grafo.residuoValido = 0;
+    pageRankActualizado();
+    INSTRUMENTAR_CONTADOR(CONTADOR_ITERACIONES_PAGERANK, trabajo.iteraciones);
+    INSTRUMENTAR_FIN(TIEMPO_PAGERANK, relojInicio);
+    return trabajo.iteraciones;
+}
+
+/**
+ * @brief Calcula el PageRank de cada documento en el grafo.
+ *
+ * Parte del vector uniforme 1/n.
+ *
+ * @param dampingFactor Factor de amortiguamiento utilizado en el calculo.
+ * @param maxIteraciones Numero maximo de iteraciones.
+ * @param tolerancia Diferencia L1 bajo la cual se detiene el calculo.
+ * @return Numero de iteraciones realizadas.
+ */
+int calcularPageRank(double dampingFactor, int maxIteraciones, double tolerancia) {
+    return resolverPageRank(dampingFactor, maxIteraciones, tolerancia, 0);
+}
+
+/**
+ * @struct TrabajoLote
+ * @brief Estado compartido por los hilos durante una iteracion del PageRank por lotes.
+ *
+ * Las matrices tienen una fila por documento y una columna por vector. Las
+ * contribuciones tienen doble bufer porque los hilos leen las de cualquier
+ * documento; el PageRank de cada fila solo lo lee y escribe el hilo de su bloque.
+ */
+typedef struct {
+    int numVectores; ///< Vectores del lote (columnas de las matrices).
+    double amortiguamiento; ///< Factor de amortiguamiento.
+    const size_t *inicio; ///< CSC: inicio de los enlaces entrantes.
+    const int *origenes; ///< CSC: origenes de los enlaces entrantes.
+    const double *inverso; ///< Inverso del grado de salida.
+    const double *teletransporte; ///< Matriz de teletransporte, sin normalizar.
+    const double *base; ///< Por vector: (1 - d + d * masa sin enlaces) / suma de su teletransporte.
+    double *rank; ///< Matriz de PageRank.
+    const double *contribucion; ///< Contribuciones de la iteracion anterior.
+    double *nuevaContribucion; ///< Contribuciones de esta iteracion.
+} TrabajoLote;
+
+/**
+ * @struct HiloLote
+ * @brief Bloque de documentos de un hilo del PageRank por lotes y sus sumas parciales.
+ */
+typedef struct {
+    const TrabajoLote *trabajo; ///< Estado compartido.
+    int desde; ///< Primer documento del bloque.
+    int hasta; ///< Documento siguiente al ultimo del bloque.
+    double masa[PAGERANK_MAX_LOTE]; ///< PageRank de los documentos sin enlaces del bloque, por vector.
+    double residuo[PAGERANK_MAX_LOTE]; ///< Diferencia L1 del bloque, por vector.
+} HiloLote;
+
+/**
+ * @brief Suma, de un grupo de ancho columnas, las filas de contribuciones de los origenes de un documento.
+ *
+ * Con ancho constante en cada llamada el compilador despliega los bucles sobre
+ * las columnas y deja los acumuladores en registros: cada enlace lee su fila
+ * una vez y la suma entera, sin otra bifurcacion que la del propio enlace.
+ * Mientras tanto precarga la fila del enlace PAGERANK_LOTE_ADELANTO posiciones
+ * mas adelante, aunque sea de otro documento del bloque.
+ *
+ * @param contribucion Matriz de contribuciones, desplazada a la primera columna del grupo.
+ * @param origenes Origenes de los enlaces entrantes.
+ * @param desde Primer enlace.
+ * @param hasta Enlace siguiente al ultimo.
+ * @param limite Enlace siguiente al ultimo del bloque, hasta donde se precarga.
+ * @param numVectores Columnas de la matriz.
+ * @param ancho Columnas del grupo: 1 o un numero par hasta 16.
+ * @param suma Salida: suma de cada columna del grupo.
+ */
+static inline __attribute__((always_inline)) void sumarGrupoContribucion(const double *contribucion,
+                                                                         const int *origenes, size_t desde,
+                                                                         size_t hasta, size_t limite,
+                                                                         int numVectores, int ancho, double *suma) {
+#if defined(__SSE2__)
+    if (ancho >= 2) {
+        __m128d acumulado[8];
+        for (int k = 0; k < ancho / 2; k++) {
+            acumulado[k] = _mm_setzero_pd();
+        }
+        for (size_t e = desde; e < hasta; e++) {
+            if (e + PAGERANK_LOTE_ADELANTO < limite) {
+                const double *siguiente = contribucion + (size_t)origenes[e + PAGERANK_LOTE_ADELANTO] * numVectores;
+                for (int k = 0; k < ancho; k += 8) {
+                    _mm_prefetch((const char *)(siguiente + k), _MM_HINT_T0);
+                }
+            }
+            const double *fila = contribucion + (size_t)origenes[e] * numVectores;
+            for (int k = 0; k < ancho / 2; k++) {
+                acumulado[k] = _mm_add_pd(acumulado[k], _mm_loadu_pd(fila + 2 * k));
             }
         }
+        for (int k = 0; k < ancho / 2; k++) {
+            _mm_storeu_pd(suma + 2 * k, acumulado[k]);
+        }
+        return;
+    }
+#endif
+    for (int k = 0; k < ancho; k++) {
+        double total = 0.0;
+        for (size_t e = desde; e < hasta; e++) {
+            total += contribucion[(size_t)origenes[e] * numVectores + k];
+        }
+        suma[k] = total;
+    }
+}
+
+/**
+ * @brief Recorre el bloque de un hilo del PageRank por lotes con numVectores columnas.
+ *
+ * Con numVectores constante en cada llamada, el compilador despliega los bucles
+ * sobre las columnas y deja en registros las sumas, los residuos y las masas.
+ * Hasta 16 columnas se suman en una sola pasada por los enlaces; los lotes mas
+ * anchos se recorren de a 16 columnas. La masa de los documentos sin enlaces se
+ * decide una vez por documento, no por columna.
+ *
+ * @param hilo Bloque del hilo; recibe la masa y el residuo de cada vector.
+ * @param numVectores Columnas de las matrices.
+ */
+static inline __attribute__((always_inline)) void recorrerBloqueLote(HiloLote *hilo, int numVectores) {
+    const TrabajoLote *trabajo = hilo->trabajo;
+    double d = trabajo->amortiguamiento;
+    double base[PAGERANK_MAX_LOTE];
+    double masa[PAGERANK_MAX_LOTE];
+    double residuo[PAGERANK_MAX_LOTE];
+    double suma[PAGERANK_MAX_LOTE];
+    for (int b = 0; b < numVectores; b++) {
+        base[b] = trabajo->base[b];
+        masa[b] = 0.0;
+        residuo[b] = 0.0;
+    }
 
-        for (int i = 0; i < grafo.numDocs; i++) {
-            grafo.pageRank[i] = dampingFactor * nuevoPageRank[i] + (1 - dampingFactor) / grafo.numDocs;
+    size_t limite = trabajo->inicio[hilo->hasta];
+    for (int v = hilo->desde; v < hilo->hasta; v++) {
+        size_t desde = trabajo->inicio[v];
+        size_t hasta = trabajo->inicio[v + 1];
+        int b = 0;
+        for (; b + 16 <= numVectores; b += 16) {
+            sumarGrupoContribucion(trabajo->contribucion + b, trabajo->origenes, desde, hasta, limite, numVectores,
+                                   16, suma + b);
+        }
+        int pares = (numVectores - b) & ~1;
+        if (pares) {
+            sumarGrupoContribucion(trabajo->contribucion + b, trabajo->origenes, desde, hasta, limite, numVectores,
+                                   pares, suma + b);
+            b += pares;
+        }
+        if (b < numVectores) {
+            sumarGrupoContribucion(trabajo->contribucion + b, trabajo->origenes, desde, hasta, limite, numVectores,
+                                   1, suma + b);
+        }
+
+        const double *teletransporte = trabajo->teletransporte + (size_t)v * numVectores;
+        double *rank = trabajo->rank + (size_t)v * numVectores;
+        double *nuevaContribucion = trabajo->nuevaContribucion + (size_t)v * numVectores;
+        double inverso = trabajo->inverso[v];
+        for (int c = 0; c < numVectores; c++) {
+            double valor = base[c] * teletransporte[c] + d * suma[c];
+            residuo[c] += fabs(valor - rank[c]);
+            rank[c] = valor;
+            nuevaContribucion[c] = valor * inverso;
+        }
+        if (inverso == 0.0) {
+            for (int c = 0; c < numVectores; c++) {
+                masa[c] += rank[c];
+            }
         }
     }
+    for (int b = 0; b < numVectores; b++) {
+        hilo->masa[b] = masa[b];
+        hilo->residuo[b] = residuo[b];
+    }
 }
 
 /**
- * @brief Obtiene el PageRank de un documento especifico.
+ * @brief Cuerpo de cada hilo del PageRank por lotes: una iteracion sobre su bloque.
  *
- * @param docID Identificador del documento.
- * @return Valor del PageRank del documento.
+ * Los anchos de lote habituales tienen su propia copia de recorrerBloqueLote().
+ *
+ * @param argumento Puntero a un HiloLote.
+ * @return NULL.
  */
-double obtenerPageRank(int docID) {
-    return grafo.pageRank[docID];
+static void *ejecutarHiloLote(void *argumento) {
+    HiloLote *hilo = argumento;
+    switch (hilo->trabajo->numVectores) {
+    case 1:
+        recorrerBloqueLote(hilo, 1);
+        break;
+    case 2:
+        recorrerBloqueLote(hilo, 2);
+        break;
+    case 4:
+        recorrerBloqueLote(hilo, 4);
+        break;
+    case 8:
+        recorrerBloqueLote(hilo, 8);
+        break;
+    case 16:
+        recorrerBloqueLote(hilo, 16);
+        break;
+    default:
+        recorrerBloqueLote(hilo, hilo->trabajo->numVectores);
+        break;
+    }
+    return NULL;
 }
 
 /**
- * @brief Muestra los documentos con los mayores valores de PageRank.
+ * @brief Calcula varios PageRank personalizados en un mismo recorrido del grafo.
  *
- * Ordena los documentos por PageRank y muestra los n primeros.
+ * Es el calculo de calcularPageRank() con un vector de teletransporte por
+ * columna: el PageRank de v en el vector b es d * (contribuciones entrantes) +
+ * (1 - d + d * masa sin enlaces) * t[v][b], de modo que tanto el salto aleatorio
+ * como la masa de los documentos sin enlaces vuelven a los documentos del tema.
  *
- * @param n Numero de documentos a mostrar.
+ * Las matrices se guardan por documento, asi que cada enlace entrante lee una
+ * sola fila contigua y actualiza los numVectores valores a la vez (con SSE2, de
+ * a dos): el costo de recorrer el arreglo CSC se paga una vez por lote y no una
+ * vez por vector. Las contribuciones se alinean a 64 bytes para que una fila de
+ * hasta 8 vectores ocupe una sola linea de cache. Aun asi cada enlace trae una
+ * fila de 8 * numVectores bytes desde una posicion al azar, de modo que el
+ * costo por vector baja bastante menos que numVectores veces: con un hilo, en
+ * bench_pagerank, entre 1.3 y 1.5 veces con lotes de 4 a 16. Los documentos se
+ * reparten entre los hilos de
+ * establecerHilosPageRank() como en el calculo global; cada iteracion lanza los
+ * hilos y los espera.
+ *
+ * @param teletransporte Matriz numDocs x numVectores, por documento: el peso de v en
+ *                       el vector b esta en teletransporte[v * numVectores + b]. Cada
+ *                       columna se normaliza para que sume 1.
+ * @param numVectores Vectores del lote (entre 1 y PAGERANK_MAX_LOTE).
+ * @param dampingFactor Factor de amortiguamiento.
+ * @param maxIteraciones Numero maximo de iteraciones.
+ * @param tolerancia Diferencia L1 bajo la cual se detiene, para todos los vectores.
+ * @param rank Salida: matriz numDocs x numVectores con el mismo orden que teletransporte.
+ * @param residuo Salida: mayor diferencia L1 de la ultima iteracion (puede ser NULL).
+ * @return Iteraciones realizadas, o -1 si los argumentos no son validos (numVectores
+ *         fuera de rango, pesos negativos o una columna sin peso).
  */
-void mostrarTopPageRank(int n) {
-    struct {
-        double pageRank;
-        int docID;
-    } documentos[MAX_DOCS];
+int calcularPageRankPorLotes(const double *teletransporte, int numVectores, double dampingFactor, int maxIteraciones,
+                             double tolerancia, double *rank, double *residuo) {
+    if (residuo) {
+        *residuo = 0.0;
+    }
+    if (numVectores < 1 || numVectores > PAGERANK_MAX_LOTE) {
+        return -1;
+    }
+    if (grafo.modificado) {
+        congelarGrafo();
+    }
+    int n = grafo.numDocs;
+    int B = numVectores;
+    double sumaTeletransporte[PAGERANK_MAX_LOTE] = {0.0};
+    for (size_t i = 0; i < (size_t)n * B; i++) {
+        if (teletransporte[i] < 0.0) {
+            return -1;
+        }
+        sumaTeletransporte[i % B] += teletransporte[i];
+    }
+    for (int b = 0; b < B; b++) {
+        if (!(sumaTeletransporte[b] > 0.0)) {
+            return -1;
+        }
+    }
+    INSTRUMENTAR_INICIO(relojInicio);
 
-    // Copiar valores en un arreglo temporal
-    for (int i = 0; i < grafo.numDocs; i++) {
-        documentos[i].pageRank = grafo.pageRank[i];
-        documentos[i].docID = i;
+    int T = hilosPageRank < n ? hilosPageRank : n;
+    double *contribuciones = aligned_alloc(64, (2 * (size_t)n * B * sizeof(double) + 63) & ~(size_t)63);
+    int *limites = malloc((T + 1) * sizeof(int));
+    HiloLote *hilos = malloc(T * sizeof(HiloLote));
+    pthread_t *ids = malloc(T * sizeof(pthread_t));
+    if (!contribuciones || !limites || !hilos || !ids) {
+        perror("No se pudo reservar memoria para PageRank");
+        exit(EXIT_FAILURE);
     }
+    // Mismo reparto por costo que el calculo global.
+    TrabajoPageRank reparto;
+    memset(&reparto, 0, sizeof(reparto));
+    reparto.numHilos = T;
+    reparto.numDocs = n;
+    reparto.inicio = grafo.inicioEntrada;
+    reparto.limites = limites;
+    repartirDocumentos(&reparto);
 
-    // Ordenar los documentos por PageRank (ordenamiento burbuja)
-    for (int i = 0; i < grafo.numDocs - 1; i++) {
-        for (int j = 0; j < grafo.numDocs - i - 1; j++) {
-            if (documentos[j].pageRank < documentos[j + 1].pageRank) {
-                // Intercambiar
-                double tempPageRank = documentos[j].pageRank;
-                int tempDocID = documentos[j].docID;
-                documentos[j].pageRank = documentos[j + 1].pageRank;
-                documentos[j].docID = documentos[j + 1].docID;
-                documentos[j + 1].pageRank = tempPageRank;
-                documentos[j + 1].docID = tempDocID;
+    // El vector inicial es el propio teletransporte, que para un tema esta mas cerca del resultado que el uniforme.
+    double base[PAGERANK_MAX_LOTE];
+    double masa[PAGERANK_MAX_LOTE] = {0.0};
+    for (int v = 0; v < n; v++) {
+        for (int b = 0; b < B; b++) {
+            size_t i = (size_t)v * B + b;
+            rank[i] = teletransporte[i] / sumaTeletransporte[b];
+            contribuciones[i] = rank[i] * grafo.inversoGradoSalida[v];
+            if (grafo.inversoGradoSalida[v] == 0.0) {
+                masa[b] += rank[i];
             }
         }
     }
 
-    // Mostrar los top `n` documentos
+    TrabajoLote trabajo;
+    trabajo.numVectores = B;
+    trabajo.amortiguamiento = dampingFactor;
+    trabajo.inicio = grafo.inicioEntrada;
+    trabajo.origenes = grafo.origenesEntrada;
+    trabajo.inverso = grafo.inversoGradoSalida;
+    trabajo.teletransporte = teletransporte;
+    trabajo.base = base;
+    trabajo.rank = rank;
+    for (int t = 0; t < T; t++) {
+        hilos[t].trabajo = &trabajo;
+        hilos[t].desde = limites[t];
+        hilos[t].hasta = limites[t + 1];
+    }
+
+    int iter = 0;
+    double mayorResiduo = 0.0;
+    while (iter < maxIteraciones) {
+        int par = iter & 1;
+        trabajo.contribucion = contribuciones + (size_t)par * n * B;
+        trabajo.nuevaContribucion = contribuciones + (size_t)!par * n * B;
+        for (int b = 0; b < B; b++) {
+            base[b] = ((1.0 - dampingFactor) + dampingFactor * masa[b]) / sumaTeletransporte[b];
+        }
+        // Si un hilo no se puede crear, su bloque lo procesa el hilo que llama.
+        int creados[PAGERANK_MAX_HILOS];
+        for (int t = 1; t < T; t++) {
+            creados[t] = pthread_create(&ids[t], NULL, ejecutarHiloLote, &hilos[t]) == 0;
+        }
+        ejecutarHiloLote(&hilos[0]);
+        for (int t = 1; t < T; t++) {
+            if (creados[t]) {
+                pthread_join(ids[t], NULL);
+            } else {
+                ejecutarHiloLote(&hilos[t]);
+            }
+        }
+
+        mayorResiduo = 0.0;
+        for (int b = 0; b < B; b++) {
+            double residuoVector = 0.0;
+            masa[b] = 0.0;
+            for (int t = 0; t < T; t++) {
+                masa[b] += hilos[t].masa[b];
+                residuoVector += hilos[t].residuo[b];
+            }
+            if (residuoVector > mayorResiduo) {
+                mayorResiduo = residuoVector;
+            }
+        }
+        iter++;
+        if (mayorResiduo < tolerancia) {
+            break;
+        }
+    }
+
+    free(contribuciones);
+    free(limites);
+    free(hilos);
+    free(ids);
+    if (residuo) {
+        *residuo = mayorResiduo;
+    }
+    INSTRUMENTAR_FIN(TIEMPO_PAGERANK_LOTE, relojInicio);
+    return iter;
+}
+
+/**
+ * @brief Calcula el residuo T(x) - x de todos los documentos.
+ *
+ * Recorre el arreglo CSC como una iteracion de PageRank, sin modificar el vector.
+ *
+ * @param d Factor de amortiguamiento.
+ * @return 1 si se pudo reservar el residuo, 0 si no.
+ */
+static int calcularResiduo(double d) {
+    if (grafo.modificado) {
+        congelarGrafo();
+    }
+    int n = grafo.numDocs;
+    if (!grafo.residuo) {
+        grafo.residuo = malloc((grafo.capacidad ? grafo.capacidad : 1) * sizeof(double));
+        if (!grafo.residuo) {
+            perror("No se pudo reservar memoria para PageRank");
+            return 0;
+        }
+    }
+    double masa = 0.0;
+    for (int u = 0; u < n; u++) {
+        if (grafo.inversoGradoSalida[u] == 0.0) {
+            masa += grafo.pageRank[u];
+        }
+    }
+    double base = ((1.0 - d) + d * masa) / n;
+    for (int v = 0; v < n; v++) {
+        double suma = 0.0;
+        for (size_t e = grafo.inicioEntrada[v]; e < grafo.inicioEntrada[v + 1]; e++) {
+            int u = grafo.origenesEntrada[e];
+            suma += grafo.pageRank[u] * grafo.inversoGradoSalida[u];
+        }
+        grafo.residuo[v] = base + d * suma - grafo.pageRank[v];
+    }
+    grafo.residuoUniforme = 0.0;
+    grafo.masaSinEnlacesResiduo = masa;
+    grafo.amortiguamientoResiduo = d;
+    grafo.residuoValido = 1;
+    return 1;
+}
+
+/**
+ * @brief Incorpora el residuo uniforme al vector escalandolo.
+ *
+ * Con r = r' + g, el vector x cumple (I - dP) x = ((1 - d) / n - g) - r', de modo
+ * que c x, con c = 1 / (1 - g n / (1 - d)), deja el residuo en c r' sin parte
+ * uniforme. Cuesta una pasada por los documentos pero no por los enlaces.
+ */
+static void absorberResiduoUniforme() {
+    int n = grafo.numDocs;
+    double c = 1.0 / (1.0 - grafo.residuoUniforme * n / (1.0 - grafo.amortiguamientoResiduo));
+    for (int i = 0; i < n; i++) {
+        grafo.pageRank[i] *= c;
+        grafo.residuo[i] *= c;
+    }
+    grafo.masaSinEnlacesResiduo *= c;
+    grafo.residuoUniforme = 0.0;
+}
+
+/**
+ * @brief Calcula cuanto trabajo de empuje cuesta lo mismo que el calculo completo desde el vector actual.
+ *
+ * El calculo completo parte con una diferencia igual al residuo y la reduce en
+ * cada iteracion en el factor medido en el ultimo calculo (d si no lo hubo),
+ * recorriendo en orden todos los enlaces. Un enlace empujado cuesta
+ * PAGERANK_COSTO_EMPUJE veces mas por sus accesos aleatorios.
+ *
+ * @param residuo Residuo L1 actual.
+ * @param tolerancia Residuo L1 admitido.
+ * @return Presupuesto en unidades de trabajo del empuje (1 + grado por empuje).
+ */
+static double presupuestoEmpuje(double residuo, double tolerancia) {
+    double d = grafo.amortiguamientoResiduo;
+    double contraccion = grafo.contraccionPageRank;
+    if (!(contraccion > 0.01 && contraccion < d)) {
+        contraccion = contraccion > 0.0 && contraccion <= 0.01 ? 0.01 : d;
+    }
+    double iteraciones = residuo > tolerancia ? ceil(log(residuo / tolerancia) / -log(contraccion)) : 1.0;
+    return iteraciones * ((double)grafo.numEnlaces + grafo.numDocs) / PAGERANK_COSTO_EMPUJE;
+}
+
+/**
+ * @brief Estima el trabajo de empujar el residuo desde los documentos que superan el umbral.
+ *
+ * Recorre en anchura, salto a salto, los documentos alcanzables desde las
+ * semillas. En cada salto la masa del residuo se multiplica por d y se reparte
+ * entre los documentos nuevos de la frontera; mientras a cada uno le toca al
+ * menos el umbral habra que empujarlos, y cada empuje cuesta 1 + su grado de
+ * salida. Sin localidad la frontera se multiplica por el grado en cada salto y
+ * el recorrido se corta en cuanto el salto siguiente no entra en el
+ * presupuesto. Cuando deja de crecer (hasta PAGERANK_CRECIMIENTO_ESTABLE por
+ * salto), los saltos restantes se proyectan con ese crecimiento sin recorrerlos.
+ *
+ * @param semillas Documentos cuyo residuo supera el umbral.
+ * @param numSemillas Numero de semillas.
+ * @param umbral Residuo por documento a partir del cual se empuja.
+ * @param presupuesto Trabajo por encima del cual no conviene empujar.
+ * @return Trabajo estimado; mayor que presupuesto si no conviene empujar.
+ */
+static double estimarTrabajoEmpuje(const int *semillas, size_t numSemillas, double umbral, double presupuesto) {
+    int n = grafo.numDocs;
+    double d = grafo.amortiguamientoResiduo;
+    int *orden = malloc(n * sizeof(int));
+    char *visitado = calloc(n, 1);
+    if (!orden || !visitado) {
+        perror("No se pudo reservar memoria para PageRank");
+        free(orden);
+        free(visitado);
+        return HUGE_VAL;
+    }
+
+    double masa = 0.0;
+    double trabajo = 0.0;
+    size_t total = 0;
+    for (size_t i = 0; i < numSemillas; i++) {
+        int u = semillas[i];
+        visitado[u] = 1;
+        orden[total++] = u;
+        masa += fabs(grafo.residuo[u]);
+        trabajo += 1.0 + (double)gradoSalidaActual(u);
+    }
+    size_t inicioFrontera = 0;
+    double trabajoFrontera = trabajo;
+    double crecimiento = 0.0; // Desconocido hasta el primer salto.
+    while (trabajo <= presupuesto && total > inicioFrontera) {
+        double frontera = (double)(total - inicioFrontera);
+        double costoMedio = trabajoFrontera / frontera;
+        double restantes = (double)(n - total);
+        masa *= d;
+        if (crecimiento > 0.0 && crecimiento <= PAGERANK_CRECIMIENTO_ESTABLE) {
+            for (double m = masa; trabajo <= presupuesto && restantes >= 1.0; m *= d) {
+                frontera = fmin(frontera * fmax(crecimiento, 1.0), restantes);
+                if (m / frontera < umbral) {
+                    break;
+                }
+                trabajo += frontera * costoMedio;
+                restantes -= frontera;
+            }
+            break;
+        }
+        // El salto siguiente no puede tener mas documentos que los enlaces de la frontera.
+        double siguiente = fmin(frontera * (crecimiento > 0.0 ? crecimiento : costoMedio - 1.0), restantes);
+        if (siguiente >= 1.0 && masa / siguiente >= umbral && trabajo + siguiente * costoMedio > presupuesto) {
+            trabajo += siguiente * costoMedio;
+            break;
+        }
+
+        size_t finFrontera = total;
+        trabajoFrontera = 0.0;
+        for (size_t i = inicioFrontera; i < finFrontera; i++) {
+            int u = orden[i];
+            size_t e = 0;
+            size_t fin = 0;
+            if (usaEnlacesCongelados(u)) {
+                e = grafo.inicioSalida[u];
+                fin = grafo.inicioSalida[u + 1];
+            }
+            NodoGrafo *nodo = grafo.adyacencia[u];
+            while (e < fin || nodo) {
+                int v;
+                if (e < fin) {
+                    v = grafo.destinosSalida[e++];
+                } else {
+                    v = nodo->docID;
+                    nodo = nodo->siguiente;
+                }
+                if (!visitado[v]) {
+                    visitado[v] = 1;
+                    orden[total++] = v;
+                    trabajoFrontera += 1.0 + (double)gradoSalidaActual(v);
+                }
+            }
+        }
+        inicioFrontera = finFrontera;
+        if (total == finFrontera || masa / (double)(total - finFrontera) < umbral) {
+            break; // A los documentos nuevos ya no les llega residuo suficiente para empujarlos.
+        }
+        crecimiento = (double)(total - finFrontera) / frontera;
+        trabajo += trabajoFrontera;
+    }
+    free(orden);
+    free(visitado);
+    return trabajo;
+}
+
+/**
+ * @brief Empuja el residuo de los documentos hasta dejarlo bajo la tolerancia.
+ *
+ * Cada documento cuyo residuo supera tolerancia / (2n) lo suma a su PageRank y
+ * reparte d veces esa cantidad entre sus enlaces salientes; la parte uniforme se
+ * absorbe con absorberResiduoUniforme() cuando supera tolerancia / 2. No
+ * empuja nada si estimarTrabajoEmpuje() anticipa que el costo supera el de
+ * presupuestoEmpuje(), y se detiene si lo supera de todos modos.
+ *
+ * @param tolerancia Residuo L1 admitido.
+ * @return 1 si el residuo quedo bajo la tolerancia, 0 si no convenia empujar o se agoto el presupuesto.
+ */
+static int empujarResiduo(double tolerancia) {
+    int n = grafo.numDocs;
+    double umbral = tolerancia / (2.0 * n);
+    double presupuesto = HUGE_VAL; // Se fija con el residuo de la primera pasada.
+    double trabajo = 0.0;
+    int *cola = malloc(n * sizeof(int));
+    char *enCola = calloc(n, 1);
+    if (!cola || !enCola) {
+        perror("No se pudo reservar memoria para PageRank");
+        free(cola);
+        free(enCola);
+        return 0;
+    }
+
+    int completo = 1;
+    int estimado = 0;
+    for (;;) {
+        if (fabs(grafo.residuoUniforme) * n >= tolerancia / 2.0) {
+            absorberResiduoUniforme();
+            trabajo += n;
+        }
+        size_t principio = 0;
+        size_t fin = 0;
+        double residuoTotal = fabs(grafo.residuoUniforme) * n;
+        for (int u = 0; u < n; u++) {
+            residuoTotal += fabs(grafo.residuo[u]);
+            if (fabs(grafo.residuo[u]) >= umbral) {
+                enCola[u] = 1;
+                cola[fin++] = u;
+            }
+        }
+        trabajo += n;
+        if (fin == 0) {
+            break;
+        }
+        if (!estimado) {
+            estimado = 1;
+            presupuesto = presupuestoEmpuje(residuoTotal, tolerancia);
+            if (estimarTrabajoEmpuje(cola, fin, umbral, presupuesto) > presupuesto) {
+                completo = 0;
+                break;
+            }
+        }
+        // Cada documento esta en la cola a lo sumo una vez, asi que basta un anillo de n entradas.
+        while (principio < fin) {
+            int u = cola[principio++ % n];
+            enCola[u] = 0;
+            double cantidad = grafo.residuo[u];
+            grafo.residuo[u] = 0.0;
+            grafo.pageRank[u] += cantidad;
+            repartirResiduo(u, cantidad, umbral, cola, &fin, enCola);
+            grafo.empujesPageRank++;
+            trabajo += 1.0 + (double)gradoSalidaActual(u);
+            if (trabajo > presupuesto) {
+                completo = 0;
+                break;
+            }
+        }
+        if (!completo) {
+            break;
+        }
+    }
+
+    double residuo = fabs(grafo.residuoUniforme) * n;
+    for (int u = 0; u < n; u++) {
+        residuo += fabs(grafo.residuo[u]);
+    }
+    grafo.residuoPageRank = residuo;
+    free(cola);
+    free(enCola);
+    return completo;
+}
+
+/**
+ * @brief Actualiza el PageRank despues de cambios en los enlaces.
+ *
+ * @param dampingFactor Factor de amortiguamiento.
+ * @param maxIteraciones Numero maximo de iteraciones del calculo completo.
+ * @param tolerancia Residuo L1 admitido.
+ * @return Iteraciones del calculo completo, o 0 si bastaron los empujes.
+ */
+int actualizarPageRank(double dampingFactor, int maxIteraciones, double tolerancia) {
+    if (grafo.numDocs == 0) {
+        return 0;
+    }
+    INSTRUMENTAR_INICIO(relojInicio);
+    if (grafo.residuoValido && grafo.amortiguamientoResiduo != dampingFactor) {
+        grafo.residuoValido = 0;
+    }
+    grafo.empujesPageRank = 0;
+    if ((grafo.residuoValido || calcularResiduo(dampingFactor)) && empujarResiduo(tolerancia)) {
+        grafo.iteracionesPageRank = 0;
+        pageRankActualizado();
+        INSTRUMENTAR_FIN(TIEMPO_PAGERANK_INCREMENTAL, relojInicio);
+        return 0;
+    }
+    long empujes = grafo.empujesPageRank;
+    int iteraciones = resolverPageRank(dampingFactor, maxIteraciones, tolerancia, 1);
+    grafo.empujesPageRank = empujes;
+    INSTRUMENTAR_FIN(TIEMPO_PAGERANK_INCREMENTAL, relojInicio);
+    return iteraciones;
+}
+
+/**
+ * @brief Devuelve el numero de iteraciones del ultimo calculo de PageRank.
+ *
+ * @return Iteraciones realizadas.
+ */
+int obtenerIteracionesPageRank() {
+    return grafo.iteracionesPageRank;
+}
+
+/**
+ * @brief Devuelve los empujes de la ultima actualizacion incremental del PageRank.
+ *
+ * @return Empujes realizados (0 si el ultimo calculo fue completo).
+ */
+long obtenerEmpujesPageRank() {
+    return grafo.empujesPageRank;
+}
+
+/**
+ * @brief Obtiene el uso de memoria de la arena de enlaces pendientes.
+ *
+ * @param estadisticas Salida.
+ */
+void obtenerEstadisticasMemoriaGrafo(EstadisticasArena *estadisticas) {
+    memset(estadisticas, 0, sizeof(*estadisticas));
+    acumularEstadisticasArena(&grafo.arenaEnlaces, estadisticas);
+}
+
+/**
+ * @brief Devuelve la diferencia L1 de la ultima iteracion de PageRank.
+ *
+ * @return Residuo del ultimo calculo.
+ */
+double obtenerResiduoPageRank() {
+    return grafo.residuoPageRank;
+}
+
+/**
+ * @brief Obtiene el PageRank publicado de un documento especifico.
+ *
+ * @param docID Identificador del documento.
+ * @return Valor del PageRank del documento, o 0 si todavia no tiene.
+ */
+double obtenerPageRank(int docID) {
+    const ContextoLectura *contexto = entrarLectura();
+    double valor = contexto && docID >= 0 && docID < contexto->numDocs ? contexto->pageRank[docID] : 0.0;
+    salirLectura();
+    return valor;
+}
+
+/**
+ * @brief Obtiene el mayor valor de PageRank publicado.
+ *
+ * @return PageRank maximo, o 0 si no hay documentos.
+ */
+double obtenerPageRankMaximo() {
+    const ContextoLectura *contexto = entrarLectura();
+    double maximo = contexto ? contexto->pageRankMaximo : 0.0;
+    salirLectura();
+    return maximo;
+}
+
+/**
+ * @brief Obtiene los k documentos con mayor PageRank.
+ *
+ * Si el ranking en cache es mas corto que k, se recalcula con seleccionarTopK()
+ * para al menos PAGERANK_TOP_MINIMO documentos.
+ *
+ * @param k Numero de documentos pedidos.
+ * @param salida Arreglo de al menos k elementos; queda ordenado del mejor al peor.
+ * @return Numero de documentos devueltos (el menor entre k y el total).
+ */
+int obtenerTopPageRank(int k, ResultadoRanking *salida) {
+    if (k > grafo.numDocs) {
+        k = grafo.numDocs;
+    }
+    if (k <= 0) {
+        return 0;
+    }
+    if (k > grafo.tamanoTopPageRank) {
+        int tamano = k > PAGERANK_TOP_MINIMO ? k : PAGERANK_TOP_MINIMO;
+        if (tamano > grafo.numDocs) {
+            tamano = grafo.numDocs;
+        }
+        ResultadoRanking *top = realloc(grafo.topPageRank, tamano * sizeof(ResultadoRanking));
+        if (!top) {
+            perror("No se pudo reservar memoria para el ranking");
+            return 0;
+        }
+        grafo.topPageRank = top;
+        grafo.tamanoTopPageRank = seleccionarTopK(grafo.pageRank, grafo.numDocs, tamano, top);
+    }
+    memcpy(salida, grafo.topPageRank, k * sizeof(ResultadoRanking));
+    return k;
+}
+
+/**
+ * @brief Muestra los documentos con los mayores valores de PageRank.
+ *
+ * @param n Numero de documentos a mostrar.
+ */
+void mostrarTopPageRank(int n) {
+    ResultadoRanking *top = malloc((n > 0 ? n : 1) * sizeof(ResultadoRanking));
+    if (!top) {
+        perror("No se pudo reservar memoria para el ranking");
+        return;
+    }
+    int num = obtenerTopPageRank(n, top);
+
     printf("\n--- Top %d Documentos por PageRank ---\n", n);
-    for (int i = 0; i < n && i < grafo.numDocs; i++) {
-        printf("Documento %d: PageRank = %.4f\n", documentos[i].docID, documentos[i].pageRank);
+    for (int i = 0; i < num; i++) {
+        printf("Documento %d: PageRank = %.4f\n", top[i].docID, top[i].puntaje);
     }
     printf("------------------------------------\n");
+    free(top);
 }
@@ -9,14 +9,29 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
-#define MAX_DOCS 100 ///< Numero maximo de documentos que puede manejar el grafo.
+#include <stddef.h>
+#include "arena.h"
+#include "ranking.h"
+
+#define PAGERANK_AMORTIGUAMIENTO 0.85 ///< Factor de amortiguamiento por defecto.
+#define PAGERANK_MAX_ITERACIONES 100 ///< Tope de iteraciones del calculo de PageRank.
+#define PAGERANK_TOLERANCIA 1e-10 ///< Diferencia L1 entre iteraciones bajo la cual se considera convergido.
+#define PAGERANK_MAX_HILOS 256 ///< Numero maximo de hilos para el calculo de PageRank.
+#define PAGERANK_TOP_MINIMO 64 ///< Documentos que guarda como minimo el ranking en cache.
+#define PAGERANK_TOLERANCIA_INCREMENTAL 1e-8 ///< Residuo L1 que admite la actualizacion incremental.
+#define PAGERANK_COSTO_EMPUJE 8 ///< Costo de un enlace empujado (acceso aleatorio) frente a uno recorrido en orden.
+#define PAGERANK_CRECIMIENTO_ESTABLE 1.1 ///< Crecimiento de la frontera del empuje que se proyecta sin recorrerla.
+#define PAGERANK_MAX_LOTE 64 ///< Vectores de teletransporte que resuelve a la vez calcularPageRankPorLotes().
+#define PAGERANK_LOTE_ADELANTO 16 ///< Enlaces de anticipacion con que calcularPageRankPorLotes() precarga las filas.
 
 /**
  * @struct NodoGrafo
  * @brief Representa un nodo en la lista de adyacencia del grafo.
  *
  * Cada nodo almacena el identificador de un documento al que se apunta y un puntero
- * al siguiente nodo en la lista de adyacencia.
+ * al siguiente nodo en la lista de adyacencia. Solo se usa para los enlaces agregados
+ * desde el ultimo congelamiento; congelarGrafo() los traslada al formato CSR. Los
+ * nodos se reservan en la arena del grafo, que se vacia al congelar.
  */
 typedef struct NodoGrafo {
     int docID; ///< Identificador del documento.
@@ -28,11 +43,43 @@ typedef struct NodoGrafo {
  * @brief Estructura que representa el grafo de documentos.
  *
  * Incluye las listas de adyacencia, los valores de PageRank y el numero de documentos.
+ * Los arreglos se reservan en el heap y crecen a medida que aparecen documentos.
+ *
+ * Solo lo modifica el hilo que carga, sincroniza o recalcula. Cada vez que cambia
+ * el PageRank se publica una copia en un contexto de lectura (ver contexto.h),
+ * que es lo que leen las consultas concurrentes.
+ *
+ * Los enlaces congelados se guardan dos veces en formato de filas comprimidas:
+ * por origen (CSR, enlaces salientes) y por destino (CSC, enlaces entrantes). El
+ * calculo de PageRank recorre la version por destino de forma secuencial.
  */
 typedef struct {
-    NodoGrafo *adyacencia[MAX_DOCS]; ///< Listas de adyacencia para cada documento.
-    double pageRank[MAX_DOCS]; ///< Valores de PageRank para cada documento.
+    NodoGrafo **adyacencia; ///< Enlaces salientes agregados desde el ultimo congelamiento.
+    double *pageRank; ///< Valores de PageRank para cada documento; las consultas leen la copia publicada.
     int numDocs; ///< Numero total de documentos en el grafo.
+    int capacidad; ///< Numero de documentos para los que hay espacio reservado.
+    int docsCongelados; ///< Numero de documentos cubiertos por los arreglos CSR/CSC.
+    size_t numEnlaces; ///< Numero de enlaces en los arreglos CSR/CSC.
+    size_t *inicioSalida; ///< CSR: inicio de los enlaces salientes de cada documento (docsCongelados + 1).
+    int *destinosSalida; ///< CSR: destinos de los enlaces salientes.
+    size_t *inicioEntrada; ///< CSC: inicio de los enlaces entrantes de cada documento (docsCongelados + 1).
+    int *origenesEntrada; ///< CSC: origenes de los enlaces entrantes, en orden creciente.
+    double *inversoGradoSalida; ///< 1 / grado de salida de cada documento, 0 si no tiene enlaces.
+    unsigned char *salidaReemplazada; ///< 1 por documento congelado cuyos enlaces salientes se reemplazaron, o NULL.
+    int modificado; ///< 1 si hay enlaces o documentos posteriores al ultimo congelamiento.
+    int arreglosExternos; ///< 1 si los arreglos CSR/CSC pertenecen a una instantanea y no se liberan.
+    int iteracionesPageRank; ///< Iteraciones realizadas en el ultimo calculo de PageRank.
+    double residuoPageRank; ///< Diferencia L1 de la ultima iteracion de PageRank.
+    ResultadoRanking *topPageRank; ///< Documentos de mayor PageRank, del mejor al peor.
+    int tamanoTopPageRank; ///< Entradas validas de topPageRank (0 si hay que recalcularlo).
+    double *residuo; ///< Residuo T(x) - x de cada documento, sin la parte uniforme (capacidad entradas).
+    double residuoUniforme; ///< Parte del residuo comun a todos los documentos.
+    double masaSinEnlacesResiduo; ///< PageRank de los documentos sin enlaces salientes, segun el residuo.
+    double amortiguamientoResiduo; ///< Factor de amortiguamiento con el que se calculo el residuo.
+    int residuoValido; ///< 1 si el residuo corresponde al PageRank y a los enlaces actuales.
+    long empujesPageRank; ///< Empujes de la ultima actualizacion incremental (0 tras un calculo completo).
+    double contraccionPageRank; ///< Factor en que se redujo la diferencia por iteracion en el ultimo calculo, o 0.
+    Arena arenaEnlaces; ///< Nodos de las listas de adyacencia.
 } Grafo;
 
 /**
@@ -42,30 +89,237 @@ typedef struct {
  */
 void inicializarGrafo(int numDocs);
 
+/**
+ * @brief Garantiza que el grafo tenga al menos el numero de documentos indicado.
+ *
+ * Los documentos nuevos se agregan sin enlaces y con PageRank 0.
+ *
+ * @param numDocs Numero minimo de documentos que debe tener el grafo.
+ */
+void asegurarDocumentosGrafo(int numDocs);
+
 /**
  * @brief Agrega un enlace dirigido entre dos documentos en el grafo.
  *
+ * Si alguno de los documentos aun no existe, el grafo crece para incluirlo.
+ *
  * @param origen Identificador del documento de origen.
  * @param destino Identificador del documento de destino.
  */
 void agregarEnlace(int origen, int destino);
 
+/**
+ * @brief Reemplaza todos los enlaces salientes de un documento.
+ *
+ * Los enlaces anteriores dejan de contar en el siguiente congelamiento.
+ *
+ * @param origen Documento cuyos enlaces se reemplazan.
+ * @param destinos Nuevos destinos (pueden repetirse).
+ * @param numDestinos Numero de destinos (0 deja al documento sin enlaces).
+ */
+void reemplazarEnlacesSalientes(int origen, const int *destinos, int numDestinos);
+
+/**
+ * @brief Adopta arreglos CSR/CSC externos y un vector de PageRank ya calculado.
+ *
+ * Los arreglos CSR/CSC se usan sin copiarlos (por ejemplo, desde una instantanea
+ * proyectada con mmap) y nunca se modifican ni liberan; el PageRank se copia para
+ * poder recalcularlo.
+ *
+ * @param numDocs Numero de documentos.
+ * @param numEnlaces Numero de enlaces.
+ * @param inicioSalida CSR: inicio de los enlaces salientes (numDocs + 1 entradas).
+ * @param destinosSalida CSR: destinos de los enlaces salientes.
+ * @param inicioEntrada CSC: inicio de los enlaces entrantes (numDocs + 1 entradas).
+ * @param origenesEntrada CSC: origenes de los enlaces entrantes.
+ * @param inversoGradoSalida Inverso del grado de salida de cada documento.
+ * @param pageRank PageRank de cada documento.
+ * @param iteraciones Iteraciones del calculo que produjo el PageRank.
+ * @param residuo Residuo del calculo que produjo el PageRank.
+ */
+void usarGrafoExterno(int numDocs, size_t numEnlaces, const size_t *inicioSalida, const int *destinosSalida,
+                      const size_t *inicioEntrada, const int *origenesEntrada, const double *inversoGradoSalida,
+                      const double *pageRank, int iteraciones, double residuo);
+
+/**
+ * @brief Devuelve el grafo global, congelado, para lectura.
+ *
+ * @return Puntero al grafo.
+ */
+const Grafo *obtenerGrafo();
+
+/**
+ * @brief Traslada los enlaces pendientes a los arreglos CSR y CSC.
+ *
+ * Se llama automaticamente desde calcularPageRank() cuando el grafo fue modificado.
+ */
+void congelarGrafo();
+
+/**
+ * @brief Reemplaza todos los enlaces del grafo por un arreglo CSR ya armado.
+ *
+ * Es el camino de la carga masiva (ver enlaces.h): los destinos deben existir
+ * (menores que numDocs) y venir ordenados dentro de cada documento. Arma el
+ * arreglo CSC en una pasada y descarta los enlaces anteriores, pendientes o
+ * congelados. Los arreglos pasan a ser del grafo.
+ *
+ * @param inicioSalida CSR: inicio de los enlaces salientes (numDocs + 1 entradas).
+ * @param destinosSalida CSR: destinos de los enlaces salientes.
+ * @param numEnlaces Numero de enlaces.
+ */
+void establecerEnlaces(size_t *inicioSalida, int *destinosSalida, size_t numEnlaces);
+
 /**
  * @brief Calcula el PageRank de cada documento en el grafo.
  *
+ * Normaliza cada contribucion por el grado de salida del origen y reparte la masa
+ * de los documentos sin enlaces salientes entre todos los documentos. Itera hasta
+ * que la diferencia L1 entre dos iteraciones sea menor que la tolerancia o se
+ * alcance el maximo de iteraciones. Usa los hilos configurados con
+ * establecerHilosPageRank().
+ *
  * @param dampingFactor Factor de amortiguamiento utilizado en el calculo.
- * @param iteraciones Numero de iteraciones para refinar los valores de PageRank.
+ * @param maxIteraciones Numero maximo de iteraciones.
+ * @param tolerancia Diferencia L1 bajo la cual se detiene el calculo.
+ * @return Numero de iteraciones realizadas.
+ */
+int calcularPageRank(double dampingFactor, int maxIteraciones, double tolerancia);
+
+/**
+ * @brief Calcula varios PageRank personalizados en un mismo recorrido del grafo.
+ *
+ * Cada columna tiene su propio vector de teletransporte: el salto aleatorio y la
+ * masa de los documentos sin enlaces vuelven a los documentos de esa columna y no
+ * a todos por igual. Con un teletransporte uniforme el resultado es el de
+ * calcularPageRank(). Las matrices se guardan por documento para que cada enlace
+ * entrante actualice todas las columnas con una sola lectura contigua; usa los
+ * hilos configurados con establecerHilosPageRank(). Las lecturas al azar de esas
+ * filas limitan la ganancia: por vector, un lote de 4 a 16 cuesta entre 1.3 y
+ * 1.5 veces menos que uno de 1, no numVectores veces menos.
+ *
+ * @param teletransporte Matriz numDocs x numVectores: el peso del documento v en la
+ *                       columna b esta en teletransporte[v * numVectores + b]. Cada
+ *                       columna se normaliza para que sume 1.
+ * @param numVectores Columnas del lote (entre 1 y PAGERANK_MAX_LOTE).
+ * @param dampingFactor Factor de amortiguamiento.
+ * @param maxIteraciones Numero maximo de iteraciones.
+ * @param tolerancia Diferencia L1 bajo la cual se detiene, para todas las columnas.
+ * @param rank Salida: matriz numDocs x numVectores con el mismo orden que teletransporte.
+ * @param residuo Salida: mayor diferencia L1 de la ultima iteracion (puede ser NULL).
+ * @return Iteraciones realizadas, o -1 si numVectores esta fuera de rango, hay un peso
+ *         negativo o una columna no tiene peso.
+ */
+int calcularPageRankPorLotes(const double *teletransporte, int numVectores, double dampingFactor, int maxIteraciones,
+                             double tolerancia, double *rank, double *residuo);
+
+/**
+ * @brief Actualiza el PageRank despues de cambios en los enlaces.
+ *
+ * Mantiene el residuo r = T(x) - x de cada documento, donde T es una iteracion
+ * de PageRank. Cada enlace agregado o reemplazado corrige en el momento el
+ * residuo de los destinos del documento que cambio; los cambios de la masa sin
+ * enlaces y del teletransporte van a un termino uniforme. Luego se empuja el
+ * residuo de cada documento que supera tolerancia / (2n) a sus enlaces
+ * salientes (forward push), sin congelar el grafo, lo que solo toca la zona
+ * afectada. La primera llamada, o la siguiente a un calculo completo, calcula
+ * el residuo recorriendo todos los enlaces.
+ *
+ * Al terminar, el error L1 del vector es a lo sumo tolerancia / (1 - dampingFactor).
+ * El empuje solo conviene si queda local. Antes de empujar se compara su costo
+ * estimado, recorriendo en anchura la zona que alcanzaria el residuo, con el del
+ * calculo completo partiendo del vector actual: las iteraciones que necesita
+ * segun el residuo y la convergencia del ultimo calculo, cada una un recorrido
+ * en orden de los enlaces, mientras que cada enlace empujado cuesta
+ * PAGERANK_COSTO_EMPUJE veces mas. Si los enlaces no tienen localidad, la zona
+ * crece hasta abarcar el grafo y se pasa directamente al calculo completo; lo
+ * mismo si el empuje agota ese presupuesto a pesar de la estimacion.
+ *
+ * @param dampingFactor Factor de amortiguamiento.
+ * @param maxIteraciones Numero maximo de iteraciones del calculo completo.
+ * @param tolerancia Residuo L1 admitido.
+ * @return Iteraciones del calculo completo, o 0 si bastaron los empujes.
+ */
+int actualizarPageRank(double dampingFactor, int maxIteraciones, double tolerancia);
+
+/**
+ * @brief Configura cuantos hilos usa calcularPageRank().
+ *
+ * Los documentos se reparten en bloques contiguos con una cantidad parecida de
+ * enlaces entrantes. Con la misma cantidad de hilos el resultado es identico entre
+ * ejecuciones; entre cantidades distintas difiere solo por redondeo.
+ *
+ * @param hilos Numero de hilos (se acota entre 1 y PAGERANK_MAX_HILOS).
+ */
+void establecerHilosPageRank(int hilos);
+
+/**
+ * @brief Devuelve el numero de hilos configurado para PageRank.
+ *
+ * @return Numero de hilos.
+ */
+int obtenerHilosPageRank();
+
+/**
+ * @brief Devuelve el numero de iteraciones del ultimo calculo de PageRank.
+ *
+ * @return Iteraciones realizadas.
+ */
+int obtenerIteracionesPageRank();
+
+/**
+ * @brief Devuelve los empujes de la ultima actualizacion incremental del PageRank.
+ *
+ * @return Empujes realizados (0 si el ultimo calculo fue completo).
+ */
+long obtenerEmpujesPageRank();
+
+/**
+ * @brief Obtiene el uso de memoria de la arena de enlaces pendientes.
+ *
+ * @param estadisticas Salida.
  */
-void calcularPageRank(double dampingFactor, int iteraciones);
+void obtenerEstadisticasMemoriaGrafo(EstadisticasArena *estadisticas);
 
 /**
- * @brief Obtiene el PageRank de un documento especifico.
+ * @brief Devuelve la diferencia L1 de la ultima iteracion de PageRank.
+ *
+ * @return Residuo del ultimo calculo.
+ */
+double obtenerResiduoPageRank();
+
+/**
+ * @brief Obtiene el PageRank publicado de un documento especifico.
+ *
+ * Lee el contexto de lectura vigente, sin candados. Para usar el mismo vector en
+ * varias lecturas, el llamador debe envolverlas en entrarLectura() y salirLectura().
  *
  * @param docID Identificador del documento.
- * @return Valor del PageRank del documento.
+ * @return Valor del PageRank del documento, o 0 si todavia no tiene.
  */
 double obtenerPageRank(int docID);
 
+/**
+ * @brief Obtiene el mayor valor de PageRank publicado.
+ *
+ * Se actualiza cada vez que se calcula, se actualiza o se carga el PageRank.
+ *
+ * @return PageRank maximo, o 0 si no hay documentos.
+ */
+double obtenerPageRankMaximo();
+
+/**
+ * @brief Obtiene los k documentos con mayor PageRank.
+ *
+ * El ranking se calcula con seleccion parcial la primera vez que se pide despues
+ * de cada calculo o carga del PageRank y se guarda; mientras no cambie el
+ * PageRank, las siguientes consultas de hasta ese tamano cuestan O(k).
+ *
+ * @param k Numero de documentos pedidos.
+ * @param salida Arreglo de al menos k elementos; queda ordenado del mejor al peor.
+ * @return Numero de documentos devueltos (el menor entre k y el total).
+ */
+int obtenerTopPageRank(int k, ResultadoRanking *salida);
+
 /**
  * @brief Muestra los documentos con los mayores valores de PageRank.
  *
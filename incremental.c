@@ -0,0 +1,933 @@
+/**
+ * @file incremental.c
+ * @brief Implementacion de los segmentos delta, las lapidas y la fusion en segundo plano.
+ */
+
+#define _GNU_SOURCE
+#include "incremental.h"
+#include "enlaces.h"
+#include "graph.h"
+#include "ingesta.h"
+#include "snapshot.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define DELTA_FUSION (SEGMENTO_FUSION - 1) ///< Posicion del delta congelado en segmentos y en ListaPostings::deltas.
+#define DELTA_ACTIVO (SEGMENTO_DELTA - 1) ///< Posicion del delta que recibe los cambios.
+
+/**
+ * @struct TerminoDelta
+ * @brief Palabra de un segmento delta con sus postings ordenados por docID.
+ */
+typedef struct {
+    char *palabra; ///< Palabra (terminada en '\0').
+    size_t longitud; ///< Longitud de la palabra en bytes.
+    uint64_t hash; ///< Hash de la palabra.
+    PostingSimple *postings; ///< Postings en orden creciente de docID.
+    int numPostings; ///< Numero de postings.
+    int capacidadPostings; ///< Capacidad reservada de postings.
+    int frecuenciaMaxima; ///< Mayor frecuencia registrada; no baja al quitar postings.
+    int fusionado; ///< 1 si la fusion ya lo combino con una palabra del principal.
+    unsigned char *posiciones; ///< Posiciones codificadas; cada posting guarda su offset (solo se agrega).
+    size_t bytesPosiciones; ///< Bytes usados en posiciones.
+    size_t capacidadPosiciones; ///< Bytes reservados en posiciones.
+} TerminoDelta;
+
+/**
+ * @struct SegmentoDelta
+ * @brief Indice en memoria de los documentos cambiados desde la ultima fusion.
+ */
+typedef struct {
+    TerminoDelta **ranuras; ///< Tabla hash de direccionamiento abierto.
+    size_t capacidad; ///< Numero de ranuras (potencia de dos).
+    int numTerminos; ///< Palabras distintas.
+    long numPostings; ///< Postings de todas las palabras.
+    int *documentos; ///< Documentos indexados en el segmento.
+    int numDocumentos; ///< Numero de documentos.
+    int capacidadDocumentos; ///< Capacidad reservada de documentos.
+    Arena arena; ///< Palabras del segmento (TerminoDelta y sus cadenas).
+} SegmentoDelta;
+
+/**
+ * @struct ArchivoConocido
+ * @brief Archivo del corpus con los datos que se usan para detectar cambios.
+ */
+typedef struct {
+    char *ruta; ///< Ruta del archivo, igual al nombre del documento.
+    uint64_t hash; ///< Hash de la ruta.
+    int docID; ///< Documento asociado.
+    long long tamano; ///< Tamano en bytes la ultima vez que se indexo.
+    long long modificacion; ///< Fecha de modificacion en nanosegundos.
+    int eliminado; ///< 1 si el archivo se borro.
+    int visto; ///< 1 si aparecio en la sincronizacion en curso.
+} ArchivoConocido;
+
+/**
+ * @struct TrabajoFusion
+ * @brief Datos que usa el hilo de fusion para armar el indice nuevo.
+ */
+typedef struct {
+    SegmentoDelta *delta; ///< Delta congelado.
+    unsigned char *estados; ///< Copia de los estados al congelar el delta.
+    int numEstados; ///< Entradas de estados.
+    Arena arena; ///< Nodos del indice nuevo, que pasa al indice al instalarlo.
+    NodoIndice **nodos; ///< Palabras del indice nuevo.
+    int numNodos; ///< Numero de palabras.
+    int capacidadNodos; ///< Capacidad reservada de nodos.
+} TrabajoFusion;
+
+// Con consultas concurrentes el candado da preferencia a la fusion, para que no espere indefinidamente.
+#ifdef PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP
+static pthread_rwlock_t candadoIndice = PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP;
+#else
+static pthread_rwlock_t candadoIndice = PTHREAD_RWLOCK_INITIALIZER;
+#endif
+static SegmentoDelta *segmentos[SEGMENTOS_DELTA];
+static unsigned char *estadoDocumentos = NULL;
+static int numEstados = 0;
+static int capacidadEstados = 0;
+static int lapidas = 0;
+static int fusionesRealizadas = 0;
+static int fusionEnCurso = 0;
+static int hiloPorUnir = 0;
+static pthread_t hiloFusion;
+
+static char *directorioCorpus = NULL;
+static ArchivoConocido **archivos = NULL;
+static size_t capacidadArchivos = 0;
+static int numArchivos = 0;
+
+/**
+ * @brief Reserva memoria o termina el programa si no hay.
+ *
+ * @param bloque Bloque actual (o NULL).
+ * @param bytes Tamano pedido.
+ * @return Bloque de al menos bytes bytes.
+ */
+static void *ampliar(void *bloque, size_t bytes) {
+    void *nuevo = realloc(bloque, bytes ? bytes : 1);
+    if (!nuevo) {
+        perror("No se pudo reservar memoria para los cambios incrementales");
+        exit(EXIT_FAILURE);
+    }
+    return nuevo;
+}
+
+/**
+ * @brief Toma el candado del indice en modo exclusivo.
+ */
+void bloquearIndice() {
+    pthread_rwlock_wrlock(&candadoIndice);
+}
+
+/**
+ * @brief Toma el candado del indice en modo compartido.
+ */
+void bloquearIndiceLectura() {
+    pthread_rwlock_rdlock(&candadoIndice);
+}
+
+/**
+ * @brief Libera el candado del indice, tomado en cualquiera de los dos modos.
+ */
+void desbloquearIndice() {
+    pthread_rwlock_unlock(&candadoIndice);
+}
+
+/**
+ * @brief Crea un segmento delta vacio.
+ *
+ * @return Segmento nuevo.
+ */
+static SegmentoDelta *crearSegmentoDelta() {
+    SegmentoDelta *segmento = ampliar(NULL, sizeof(SegmentoDelta));
+    memset(segmento, 0, sizeof(*segmento));
+    segmento->capacidad = 1024;
+    segmento->ranuras = calloc(segmento->capacidad, sizeof(TerminoDelta *));
+    if (!segmento->ranuras) {
+        perror("No se pudo reservar el segmento delta");
+        exit(EXIT_FAILURE);
+    }
+    return segmento;
+}
+
+/**
+ * @brief Libera un segmento delta y sus palabras.
+ *
+ * @param segmento Segmento a liberar (puede ser NULL).
+ */
+static void liberarSegmentoDelta(SegmentoDelta *segmento) {
+    if (!segmento) {
+        return;
+    }
+    for (size_t i = 0; i < segmento->capacidad; i++) {
+        if (segmento->ranuras[i]) {
+            free(segmento->ranuras[i]->postings);
+            free(segmento->ranuras[i]->posiciones);
+        }
+    }
+    liberarArena(&segmento->arena);
+    free(segmento->ranuras);
+    free(segmento->documentos);
+    free(segmento);
+}
+
+/**
+ * @brief Busca la ranura de una palabra en un segmento delta.
+ *
+ * @param segmento Segmento.
+ * @param palabra Palabra.
+ * @param longitud Longitud de la palabra.
+ * @param hash Hash de la palabra.
+ * @return Ranura de la palabra, o la ranura vacia donde deberia insertarse.
+ */
+static TerminoDelta **buscarRanuraDelta(const SegmentoDelta *segmento, const char *palabra, size_t longitud,
+                                        uint64_t hash) {
+    size_t i = (size_t)hash & (segmento->capacidad - 1);
+    while (segmento->ranuras[i]) {
+        const TerminoDelta *termino = segmento->ranuras[i];
+        if (termino->hash == hash && termino->longitud == longitud && memcmp(termino->palabra, palabra, longitud) == 0) {
+            break;
+        }
+        i = (i + 1) & (segmento->capacidad - 1);
+    }
+    return &segmento->ranuras[i];
+}
+
+/**
+ * @brief Duplica las ranuras de un segmento delta.
+ *
+ * @param segmento Segmento.
+ */
+static void redimensionarSegmentoDelta(SegmentoDelta *segmento) {
+    size_t capacidad = segmento->capacidad * 2;
+    TerminoDelta **ranuras = calloc(capacidad, sizeof(TerminoDelta *));
+    if (!ranuras) {
+        perror("No se pudo ampliar el segmento delta");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < segmento->capacidad; i++) {
+        TerminoDelta *termino = segmento->ranuras[i];
+        if (termino) {
+            size_t j = (size_t)termino->hash & (capacidad - 1);
+            while (ranuras[j]) {
+                j = (j + 1) & (capacidad - 1);
+            }
+            ranuras[j] = termino;
+        }
+    }
+    free(segmento->ranuras);
+    segmento->ranuras = ranuras;
+    segmento->capacidad = capacidad;
+}
+
+/**
+ * @brief Agrega un posting a un segmento delta, manteniendo el orden por docID.
+ *
+ * @param segmento Segmento.
+ * @param palabra Palabra.
+ * @param longitud Longitud de la palabra.
+ * @param hash Hash de la palabra.
+ * @param docID Documento (no debe estar ya en la lista de la palabra).
+ * @param frecuencia Apariciones de la palabra en el documento.
+ * @param posiciones Posiciones de las apariciones, o NULL sin indice posicional.
+ */
+static void agregarPostingDelta(SegmentoDelta *segmento, const char *palabra, size_t longitud, uint64_t hash,
+                                int docID, int frecuencia, const uint32_t *posiciones) {
+    if ((size_t)(segmento->numTerminos + 1) * 10 > segmento->capacidad * 7) {
+        redimensionarSegmentoDelta(segmento);
+    }
+    TerminoDelta **ranura = buscarRanuraDelta(segmento, palabra, longitud, hash);
+    TerminoDelta *termino = *ranura;
+    if (!termino) {
+        termino = reservarArena(&segmento->arena, sizeof(TerminoDelta));
+        memset(termino, 0, sizeof(*termino));
+        termino->palabra = copiarCadenaArena(&segmento->arena, palabra, longitud);
+        termino->longitud = longitud;
+        termino->hash = hash;
+        *ranura = termino;
+        segmento->numTerminos++;
+        avanzarVocabularioIndice();
+    }
+    if (termino->numPostings == termino->capacidadPostings) {
+        termino->capacidadPostings = termino->capacidadPostings ? termino->capacidadPostings * 2 : 4;
+        termino->postings = ampliar(termino->postings, termino->capacidadPostings * sizeof(PostingSimple));
+    }
+
+    // Lo habitual es agregar al final; un documento viejo que cambia se intercala.
+    int pos = termino->numPostings;
+    while (pos > 0 && termino->postings[pos - 1].docID > docID) {
+        pos--;
+    }
+    memmove(&termino->postings[pos + 1], &termino->postings[pos],
+            (termino->numPostings - pos) * sizeof(PostingSimple));
+    termino->postings[pos].docID = docID;
+    termino->postings[pos].frecuencia = frecuencia;
+    termino->postings[pos].offsetPosiciones = 0;
+    if (posiciones) {
+        // Las posiciones de un posting quitado quedan como basura hasta la fusion.
+        if (termino->bytesPosiciones + 5 * (size_t)frecuencia > termino->capacidadPosiciones) {
+            size_t capacidad = termino->capacidadPosiciones ? termino->capacidadPosiciones * 2 : 64;
+            while (capacidad < termino->bytesPosiciones + 5 * (size_t)frecuencia) {
+                capacidad *= 2;
+            }
+            termino->posiciones = ampliar(termino->posiciones, capacidad);
+            termino->capacidadPosiciones = capacidad;
+        }
+        termino->postings[pos].offsetPosiciones = (uint32_t)termino->bytesPosiciones;
+        termino->bytesPosiciones +=
+            codificarPosiciones(posiciones, frecuencia, termino->posiciones + termino->bytesPosiciones);
+    }
+    termino->numPostings++;
+    if (frecuencia > termino->frecuenciaMaxima) {
+        termino->frecuenciaMaxima = frecuencia;
+    }
+    segmento->numPostings++;
+}
+
+/**
+ * @brief Quita de un segmento delta todos los postings de un documento.
+ *
+ * Recorre todas las palabras del segmento, que es pequeno comparado con el principal.
+ *
+ * @param segmento Segmento.
+ * @param docID Documento.
+ */
+static void quitarDocumentoDelta(SegmentoDelta *segmento, int docID) {
+    for (size_t i = 0; i < segmento->capacidad; i++) {
+        TerminoDelta *termino = segmento->ranuras[i];
+        if (!termino) {
+            continue;
+        }
+        int bajo = 0;
+        int alto = termino->numPostings;
+        while (bajo < alto) {
+            int medio = bajo + (alto - bajo) / 2;
+            if (termino->postings[medio].docID < docID) {
+                bajo = medio + 1;
+            } else {
+                alto = medio;
+            }
+        }
+        if (bajo < termino->numPostings && termino->postings[bajo].docID == docID) {
+            memmove(&termino->postings[bajo], &termino->postings[bajo + 1],
+                    (termino->numPostings - bajo - 1) * sizeof(PostingSimple));
+            termino->numPostings--;
+            segmento->numPostings--;
+        }
+    }
+}
+
+/**
+ * @brief Obtiene el segmento vigente de un documento.
+ *
+ * @param docID Documento.
+ * @return Segmento vigente, o DOCUMENTO_ELIMINADO.
+ */
+static int estadoDocumento(int docID) {
+    return docID < numEstados ? estadoDocumentos[docID] : SEGMENTO_PRINCIPAL;
+}
+
+/**
+ * @brief Fija el segmento vigente de un documento.
+ *
+ * @param docID Documento.
+ * @param estado Segmento vigente, o DOCUMENTO_ELIMINADO.
+ */
+static void fijarEstadoDocumento(int docID, int estado) {
+    if (docID >= capacidadEstados) {
+        int capacidad = capacidadEstados ? capacidadEstados : 1024;
+        while (capacidad <= docID) {
+            capacidad *= 2;
+        }
+        estadoDocumentos = ampliar(estadoDocumentos, capacidad);
+        memset(estadoDocumentos + capacidadEstados, SEGMENTO_PRINCIPAL, capacidad - capacidadEstados);
+        capacidadEstados = capacidad;
+    }
+    if (docID >= numEstados) {
+        numEstados = docID + 1;
+    }
+    estadoDocumentos[docID] = (unsigned char)estado;
+}
+
+/**
+ * @brief Invalida la version vigente de un documento.
+ *
+ * Sus postings en el delta activo se quitan; los del principal o del delta
+ * congelado quedan como basura hasta la proxima fusion y se cuentan como lapidas.
+ *
+ * @param docID Documento.
+ */
+static void invalidarDocumento(int docID) {
+    int anterior = estadoDocumento(docID);
+    if (anterior == SEGMENTO_DELTA) {
+        quitarDocumentoDelta(segmentos[DELTA_ACTIVO], docID);
+    } else if (anterior == SEGMENTO_PRINCIPAL || anterior == SEGMENTO_FUSION) {
+        lapidas++;
+    }
+}
+
+/**
+ * @brief Indexa un documento en el delta activo. Requiere el candado del indice.
+ *
+ * @param docID Documento.
+ * @param parcial Indice parcial del documento.
+ * @param nuevo 1 si el documento no tiene version anterior.
+ */
+static void indexarEnDelta(int docID, const DocumentoParcial *parcial, int nuevo) {
+    if (!segmentos[DELTA_ACTIVO]) {
+        segmentos[DELTA_ACTIVO] = crearSegmentoDelta();
+    }
+    SegmentoDelta *delta = segmentos[DELTA_ACTIVO];
+    int enDelta = estadoDocumento(docID) == SEGMENTO_DELTA;
+    if (!nuevo) {
+        invalidarDocumento(docID);
+    }
+
+    long longitud = 0;
+    for (int t = 0; t < parcial->numTerminos; t++) {
+        const TerminoParcial *termino = &parcial->terminos[t];
+        agregarPostingDelta(delta, parcial->texto + termino->offset, termino->longitud, termino->hash, docID,
+                            termino->frecuencia,
+                            parcial->posiciones ? parcial->posiciones + termino->primeraPosicion : NULL);
+        longitud += termino->frecuencia;
+    }
+    if (!enDelta) {
+        if (delta->numDocumentos == delta->capacidadDocumentos) {
+            delta->capacidadDocumentos = delta->capacidadDocumentos ? delta->capacidadDocumentos * 2 : 64;
+            delta->documentos = ampliar(delta->documentos, delta->capacidadDocumentos * sizeof(int));
+        }
+        delta->documentos[delta->numDocumentos++] = docID;
+    }
+    fijarEstadoDocumento(docID, SEGMENTO_DELTA);
+    establecerLongitudDocumento(docID, (int)longitud);
+}
+
+/**
+ * @brief Agrega a una lista de postings los postings de los segmentos delta.
+ *
+ * @param palabra Palabra buscada.
+ * @param longitud Longitud de la palabra.
+ * @param hash Hash de la palabra.
+ * @param lista Lista con los datos del indice principal; se completa.
+ * @return 1 si la palabra esta en algun segmento delta, 0 si no.
+ */
+int completarListaIncremental(const char *palabra, size_t longitud, uint64_t hash, ListaPostings *lista) {
+    if (!estadoDocumentos) {
+        return 0;
+    }
+    int encontrada = 0;
+    lista->estados = estadoDocumentos;
+    lista->numEstados = numEstados;
+    for (int d = 0; d < SEGMENTOS_DELTA; d++) {
+        const TerminoDelta *termino = segmentos[d] ? *buscarRanuraDelta(segmentos[d], palabra, longitud, hash) : NULL;
+        if (!termino || termino->numPostings == 0) {
+            continue;
+        }
+        lista->deltas[d] = termino->postings;
+        lista->numDeltas[d] = termino->numPostings;
+        lista->posicionesDeltas[d] = termino->posiciones;
+        // Cuenta tambien los postings invalidados: es una cota, igual que frecuenciaMaxima.
+        lista->conteoDocs += termino->numPostings;
+        if (termino->frecuenciaMaxima > lista->frecuenciaMaxima) {
+            lista->frecuenciaMaxima = termino->frecuenciaMaxima;
+        }
+        if (!lista->palabra) {
+            lista->palabra = termino->palabra;
+            lista->longitud = termino->longitud;
+        }
+        encontrada = 1;
+    }
+    return encontrada;
+}
+
+/**
+ * @brief Recorre las palabras de los segmentos delta.
+ *
+ * @param visitar Funcion llamada con cada palabra y su longitud.
+ * @param contexto Puntero que se pasa sin cambios a visitar.
+ */
+void recorrerPalabrasIncremental(void (*visitar)(const char *palabra, size_t longitud, void *contexto),
+                                 void *contexto) {
+    for (int d = 0; d < SEGMENTOS_DELTA; d++) {
+        for (size_t i = 0; segmentos[d] && i < segmentos[d]->capacidad; i++) {
+            const TerminoDelta *termino = segmentos[d]->ranuras[i];
+            if (termino) {
+                visitar(termino->palabra, termino->longitud, contexto);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Lee el tamano y la fecha de modificacion de un archivo.
+ *
+ * @param ruta Ruta del archivo.
+ * @param tamano Salida: tamano en bytes.
+ * @param modificacion Salida: fecha de modificacion en nanosegundos.
+ * @return 1 si se pudo leer, 0 si el archivo no existe.
+ */
+static int leerMarcaArchivo(const char *ruta, long long *tamano, long long *modificacion) {
+    struct stat info;
+    if (stat(ruta, &info) != 0) {
+        return 0;
+    }
+    *tamano = (long long)info.st_size;
+    *modificacion = (long long)info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+    return 1;
+}
+
+/**
+ * @brief Busca un archivo conocido por su ruta.
+ *
+ * @param ruta Ruta del archivo.
+ * @return Entrada del archivo, o NULL si nunca se indexo.
+ */
+static ArchivoConocido *buscarArchivo(const char *ruta) {
+    if (!archivos) {
+        return NULL;
+    }
+    uint64_t hash = calcularHash(ruta, strlen(ruta));
+    size_t i = (size_t)hash & (capacidadArchivos - 1);
+    while (archivos[i]) {
+        if (archivos[i]->hash == hash && strcmp(archivos[i]->ruta, ruta) == 0) {
+            return archivos[i];
+        }
+        i = (i + 1) & (capacidadArchivos - 1);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Registra un archivo nuevo asociado a un documento.
+ *
+ * @param ruta Ruta del archivo.
+ * @param docID Documento.
+ * @return Entrada creada.
+ */
+static ArchivoConocido *registrarArchivo(const char *ruta, int docID) {
+    if ((size_t)(numArchivos + 1) * 10 > capacidadArchivos * 7) {
+        size_t capacidad = capacidadArchivos ? capacidadArchivos * 2 : 1024;
+        ArchivoConocido **tabla = calloc(capacidad, sizeof(ArchivoConocido *));
+        if (!tabla) {
+            perror("No se pudo ampliar la tabla de archivos");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < capacidadArchivos; i++) {
+            if (archivos[i]) {
+                size_t j = (size_t)archivos[i]->hash & (capacidad - 1);
+                while (tabla[j]) {
+                    j = (j + 1) & (capacidad - 1);
+                }
+                tabla[j] = archivos[i];
+            }
+        }
+        free(archivos);
+        archivos = tabla;
+        capacidadArchivos = capacidad;
+    }
+
+    ArchivoConocido *archivo = ampliar(NULL, sizeof(ArchivoConocido));
+    memset(archivo, 0, sizeof(*archivo));
+    archivo->ruta = ampliar(NULL, strlen(ruta) + 1);
+    strcpy(archivo->ruta, ruta);
+    archivo->hash = calcularHash(ruta, strlen(ruta));
+    archivo->docID = docID;
+    leerMarcaArchivo(ruta, &archivo->tamano, &archivo->modificacion);
+
+    size_t i = (size_t)archivo->hash & (capacidadArchivos - 1);
+    while (archivos[i]) {
+        i = (i + 1) & (capacidadArchivos - 1);
+    }
+    archivos[i] = archivo;
+    numArchivos++;
+    return archivo;
+}
+
+/**
+ * @brief Registra el estado inicial de los archivos del corpus.
+ *
+ * @param directorio Directorio de documentos.
+ */
+void iniciarIncremental(const char *directorio) {
+    free(directorioCorpus);
+    directorioCorpus = ampliar(NULL, strlen(directorio) + 1);
+    strcpy(directorioCorpus, directorio);
+    int total = totalDocumentosCargados();
+    for (int d = 0; d < total; d++) {
+        const char *nombre = obtenerNombreDocumento(d);
+        if (nombre && !buscarArchivo(nombre)) {
+            registrarArchivo(nombre, d);
+        }
+    }
+}
+
+/**
+ * @brief Congela el delta activo y lo fusiona si supera los umbrales.
+ */
+static void fusionarSiHaceFalta() {
+    bloquearIndice();
+    int hace = (segmentos[DELTA_ACTIVO] && segmentos[DELTA_ACTIVO]->numPostings >= INCREMENTAL_MAX_POSTINGS) ||
+               lapidas >= INCREMENTAL_MAX_LAPIDAS;
+    desbloquearIndice();
+    if (hace) {
+        fusionarIndice();
+    }
+}
+
+/**
+ * @brief Indexa un archivo nuevo o vuelve a indexar uno modificado, con sus enlaces ahora o despues.
+ *
+ * @param ruta Ruta del archivo, con el mismo formato que los nombres de documento.
+ * @param aplazarEnlaces 1 para dejar los enlaces para instalarEnlacesAplazados(), 0 para instalarlos ya.
+ * @return docID del documento, o -1 si el archivo no se pudo leer.
+ */
+static int indexarArchivo(const char *ruta, int aplazarEnlaces) {
+    long long tamano = 0;
+    long long modificacion = 0;
+    // La marca se toma antes de leer: si el archivo cambia durante la lectura, se relee la proxima vez.
+    leerMarcaArchivo(ruta, &tamano, &modificacion);
+
+    DocumentoParcial parcial;
+    memset(&parcial, 0, sizeof(parcial));
+    procesarArchivo(ruta, &parcial);
+    if (parcial.error) {
+        errno = parcial.error;
+        perror("No se pudo abrir el archivo");
+        liberarDocumentoParcial(&parcial);
+        return -1;
+    }
+
+    ArchivoConocido *archivo = buscarArchivo(ruta);
+    bloquearIndice();
+    int docID = archivo ? archivo->docID : totalDocumentosCargados();
+    if (!archivo) {
+        agregarDocumento(docID, ruta);
+    }
+    indexarEnDelta(docID, &parcial, archivo == NULL || archivo->eliminado);
+    desbloquearIndice();
+
+    if (!archivo) {
+        archivo = registrarArchivo(ruta, docID);
+    }
+    archivo->tamano = tamano;
+    archivo->modificacion = modificacion;
+    archivo->eliminado = 0;
+    archivo->visto = 1;
+
+    asegurarDocumentosGrafo(docID + 1);
+    if (aplazarEnlaces) {
+        aplazarEnlacesDocumento(docID, &parcial);
+    } else {
+        actualizarEnlacesDocumento(docID, &parcial);
+    }
+    liberarDocumentoParcial(&parcial);
+    fusionarSiHaceFalta();
+    return docID;
+}
+
+/**
+ * @brief Indexa un archivo nuevo o vuelve a indexar uno modificado.
+ *
+ * @param ruta Ruta del archivo, con el mismo formato que los nombres de documento.
+ * @return docID del documento, o -1 si el archivo no se pudo leer.
+ */
+int actualizarArchivo(const char *ruta) {
+    return indexarArchivo(ruta, 0);
+}
+
+/**
+ * @brief Elimina un documento del indice y sus enlaces salientes del grafo.
+ *
+ * @param ruta Ruta del archivo.
+ * @return 1 si el documento existia, 0 si no.
+ */
+int eliminarArchivo(const char *ruta) {
+    ArchivoConocido *archivo = buscarArchivo(ruta);
+    if (!archivo || archivo->eliminado) {
+        return 0;
+    }
+    bloquearIndice();
+    invalidarDocumento(archivo->docID);
+    fijarEstadoDocumento(archivo->docID, DOCUMENTO_ELIMINADO);
+    establecerLongitudDocumento(archivo->docID, 0);
+    desbloquearIndice();
+    archivo->eliminado = 1;
+
+    reemplazarEnlacesSalientes(archivo->docID, NULL, 0);
+    fusionarSiHaceFalta();
+    return 1;
+}
+
+/**
+ * @brief Aplica al indice los cambios del directorio desde la ultima sincronizacion.
+ *
+ * Primero indexa los archivos nuevos y modificados, y despues, con todos los
+ * docID asignados, instala sus enlaces, como terminarCargaEnlaces() en la carga.
+ *
+ * @param resumen Salida: cambios aplicados (puede ser NULL).
+ * @return Numero de archivos cambiados, o -1 si el directorio no se pudo leer.
+ */
+int sincronizarDocumentos(ResumenSincronizacion *resumen) {
+    ResumenSincronizacion cambios = {0, 0, 0};
+    if (resumen) {
+        *resumen = cambios;
+    }
+    if (!directorioCorpus) {
+        return -1;
+    }
+    int numRutas;
+    char **rutas = listarArchivos(directorioCorpus, &numRutas);
+    if (!rutas) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < capacidadArchivos; i++) {
+        if (archivos[i]) {
+            archivos[i]->visto = 0;
+        }
+    }
+    for (int r = 0; r < numRutas; r++) {
+        long long tamano;
+        long long modificacion;
+        ArchivoConocido *archivo = buscarArchivo(rutas[r]);
+        if (!leerMarcaArchivo(rutas[r], &tamano, &modificacion)) {
+            // Se borro despues de listar el directorio; lo detecta la proxima sincronizacion.
+            if (archivo) {
+                archivo->visto = 1;
+            }
+            continue;
+        }
+        if (archivo && !archivo->eliminado) {
+            archivo->visto = 1;
+            if (archivo->tamano == tamano && archivo->modificacion == modificacion) {
+                continue;
+            }
+            if (indexarArchivo(rutas[r], 1) >= 0) {
+                cambios.actualizados++;
+            }
+        } else if (indexarArchivo(rutas[r], 1) >= 0) {
+            cambios.agregados++;
+        }
+    }
+    instalarEnlacesAplazados();
+    for (size_t i = 0; i < capacidadArchivos; i++) {
+        if (archivos[i] && !archivos[i]->visto && !archivos[i]->eliminado) {
+            cambios.eliminados += eliminarArchivo(archivos[i]->ruta);
+        }
+    }
+    for (int r = 0; r < numRutas; r++) {
+        free(rutas[r]);
+    }
+    free(rutas);
+
+    if (resumen) {
+        *resumen = cambios;
+    }
+    int total = cambios.agregados + cambios.actualizados + cambios.eliminados;
+    if (total > 0) {
+        actualizarPageRank(PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES, PAGERANK_TOLERANCIA_INCREMENTAL);
+    }
+    return total;
+}
+
+/**
+ * @brief Agrega un nodo al indice que arma la fusion, o lo libera si quedo vacio.
+ *
+ * @param trabajo Fusion en curso.
+ * @param nodo Nodo terminado.
+ */
+static void agregarNodoFusion(TrabajoFusion *trabajo, NodoIndice *nodo) {
+    if (nodo->conteoDocs == 0) {
+        liberarNodoIndice(nodo);
+        return;
+    }
+    if (trabajo->numNodos == trabajo->capacidadNodos) {
+        trabajo->capacidadNodos = trabajo->capacidadNodos ? trabajo->capacidadNodos * 2 : 1024;
+        trabajo->nodos = ampliar(trabajo->nodos, trabajo->capacidadNodos * sizeof(NodoIndice *));
+    }
+    trabajo->nodos[trabajo->numNodos++] = nodo;
+}
+
+/**
+ * @brief Copia un posting de un segmento delta, con sus posiciones, a un nodo nuevo.
+ *
+ * @param nodo Nodo de destino.
+ * @param termino Palabra del segmento delta.
+ * @param posting Posting de la palabra.
+ */
+static void agregarPostingDeltaNodo(NodoIndice *nodo, const TerminoDelta *termino, const PostingSimple *posting) {
+    if (!termino->posiciones) {
+        agregarPostingNodo(nodo, posting->docID, posting->frecuencia, NULL, 0);
+        return;
+    }
+    const unsigned char *posiciones = termino->posiciones + posting->offsetPosiciones;
+    agregarPostingNodo(nodo, posting->docID, posting->frecuencia, posiciones,
+                       largoPosiciones(posiciones, posting->frecuencia));
+}
+
+/**
+ * @brief Combina la lista de una palabra del principal con la del delta congelado.
+ *
+ * Conserva los postings del principal de documentos que siguen vigentes en el
+ * principal y los del delta de documentos vigentes en el delta, segun los
+ * estados copiados al congelar.
+ *
+ * @param lista Lista de la palabra en el principal.
+ * @param contexto TrabajoFusion.
+ */
+static void fusionarLista(const ListaPostings *lista, void *contexto) {
+    TrabajoFusion *trabajo = contexto;
+    TerminoDelta *termino = *buscarRanuraDelta(trabajo->delta, lista->palabra, lista->longitud,
+                                               calcularHash(lista->palabra, lista->longitud));
+    NodoIndice *nodo = crearNodoIndice(&trabajo->arena, lista->palabra, lista->longitud);
+    IteradorPostings it;
+    iniciarIteradorPostings(&it, lista);
+    int hay = siguientePosting(&it);
+    int j = 0;
+    int numDelta = termino ? termino->numPostings : 0;
+    while (hay || j < numDelta) {
+        if (hay && (j >= numDelta || it.docID < termino->postings[j].docID)) {
+            int estado = it.docID < trabajo->numEstados ? trabajo->estados[it.docID] : SEGMENTO_PRINCIPAL;
+            if (estado == SEGMENTO_PRINCIPAL) {
+                size_t bytes = 0;
+                const unsigned char *posiciones = posicionesPosting(&it, &bytes);
+                agregarPostingNodo(nodo, it.docID, it.frecuencia, posiciones, bytes);
+            }
+            hay = siguientePosting(&it);
+        } else {
+            // Con el mismo docID en ambos, el del principal esta invalidado y se descarta en la vuelta siguiente.
+            const PostingSimple *posting = &termino->postings[j++];
+            if (trabajo->estados[posting->docID] == SEGMENTO_FUSION) {
+                agregarPostingDeltaNodo(nodo, termino, posting);
+            }
+        }
+    }
+    if (termino) {
+        termino->fusionado = 1;
+    }
+    agregarNodoFusion(trabajo, nodo);
+}
+
+/**
+ * @brief Cuerpo del hilo de fusion.
+ *
+ * Arma el indice nuevo sin el candado, porque el principal y el delta congelado
+ * no cambian, y lo instala con el candado tomado.
+ *
+ * @param argumento TrabajoFusion, que se libera al terminar.
+ * @return NULL.
+ */
+static void *ejecutarFusion(void *argumento) {
+    TrabajoFusion *trabajo = argumento;
+    recorrerIndice(fusionarLista, trabajo);
+    recorrerSnapshot(fusionarLista, trabajo);
+    for (size_t i = 0; i < trabajo->delta->capacidad; i++) {
+        TerminoDelta *termino = trabajo->delta->ranuras[i];
+        if (!termino || termino->fusionado) {
+            continue;
+        }
+        NodoIndice *nodo = crearNodoIndice(&trabajo->arena, termino->palabra, termino->longitud);
+        for (int p = 0; p < termino->numPostings; p++) {
+            if (trabajo->estados[termino->postings[p].docID] == SEGMENTO_FUSION) {
+                agregarPostingDeltaNodo(nodo, termino, &termino->postings[p]);
+            }
+        }
+        agregarNodoFusion(trabajo, nodo);
+    }
+
+    bloquearIndice();
+    reemplazarIndice(trabajo->nodos, trabajo->numNodos, &trabajo->arena);
+    descartarDiccionarioSnapshot();
+    for (int i = 0; i < trabajo->delta->numDocumentos; i++) {
+        int docID = trabajo->delta->documentos[i];
+        if (estadoDocumento(docID) == SEGMENTO_FUSION) {
+            estadoDocumentos[docID] = SEGMENTO_PRINCIPAL;
+        }
+    }
+    segmentos[DELTA_FUSION] = NULL;
+    fusionEnCurso = 0;
+    fusionesRealizadas++;
+    desbloquearIndice();
+
+    liberarSegmentoDelta(trabajo->delta);
+    free(trabajo->estados);
+    free(trabajo->nodos);
+    free(trabajo);
+    return NULL;
+}
+
+/**
+ * @brief Congela el delta activo y lo fusiona con el principal en segundo plano.
+ */
+void fusionarIndice() {
+    bloquearIndice();
+    int vacio = (!segmentos[DELTA_ACTIVO] || segmentos[DELTA_ACTIVO]->numDocumentos == 0) && lapidas == 0;
+    int ocupado = fusionEnCurso;
+    desbloquearIndice();
+    if (vacio || ocupado) {
+        return;
+    }
+    esperarFusionIndice();
+
+    TrabajoFusion *trabajo = ampliar(NULL, sizeof(TrabajoFusion));
+    memset(trabajo, 0, sizeof(*trabajo));
+    bloquearIndice();
+    if (!segmentos[DELTA_ACTIVO]) {
+        segmentos[DELTA_ACTIVO] = crearSegmentoDelta();
+    }
+    SegmentoDelta *congelado = segmentos[DELTA_ACTIVO];
+    segmentos[DELTA_FUSION] = congelado;
+    segmentos[DELTA_ACTIVO] = crearSegmentoDelta();
+    for (int i = 0; i < congelado->numDocumentos; i++) {
+        int docID = congelado->documentos[i];
+        if (estadoDocumento(docID) == SEGMENTO_DELTA) {
+            estadoDocumentos[docID] = SEGMENTO_FUSION;
+        }
+    }
+    trabajo->delta = congelado;
+    trabajo->numEstados = numEstados;
+    trabajo->estados = ampliar(NULL, numEstados);
+    memcpy(trabajo->estados, estadoDocumentos, numEstados);
+    lapidas = 0;
+    fusionEnCurso = 1;
+    desbloquearIndice();
+
+    if (pthread_create(&hiloFusion, NULL, ejecutarFusion, trabajo) != 0) {
+        fprintf(stderr, "No se pudo crear el hilo de fusion; se fusionara en el hilo principal.\n");
+        ejecutarFusion(trabajo);
+    } else {
+        hiloPorUnir = 1;
+    }
+}
+
+/**
+ * @brief Espera a que termine la fusion en curso, si la hay.
+ */
+void esperarFusionIndice() {
+    if (hiloPorUnir) {
+        pthread_join(hiloFusion, NULL);
+        hiloPorUnir = 0;
+    }
+}
+
+/**
+ * @brief Obtiene el estado de los segmentos incrementales.
+ *
+ * @param estadisticas Salida.
+ */
+void obtenerEstadisticasIncremental(EstadisticasIncremental *estadisticas) {
+    bloquearIndice();
+    const SegmentoDelta *activo = segmentos[DELTA_ACTIVO];
+    const SegmentoDelta *fusion = segmentos[DELTA_FUSION];
+    estadisticas->postingsDelta = activo ? activo->numPostings : 0;
+    estadisticas->terminosDelta = activo ? activo->numTerminos : 0;
+    estadisticas->postingsFusion = fusion ? fusion->numPostings : 0;
+    estadisticas->lapidas = lapidas;
+    estadisticas->fusiones = fusionesRealizadas;
+    desbloquearIndice();
+}
@@ -0,0 +1,157 @@
+/**
+ * @file incremental.h
+ * @brief Altas, cambios y bajas de documentos sin recargar todo el corpus.
+ *
+ * Los documentos nuevos o modificados se indexan en un segmento delta en
+ * memoria, con listas de postings sin comprimir. Cada documento tiene un estado
+ * que indica en que segmento esta su version vigente; los postings de los demas
+ * segmentos se ignoran al leer, asi que un cambio o un borrado (lapida) no
+ * reescribe el indice principal.
+ *
+ * Cuando el delta crece demasiado, o hay muchas lapidas, se congela y un hilo en
+ * segundo plano lo fusiona con el principal en un indice nuevo, que reemplaza al
+ * anterior bajo el candado del indice. Mientras tanto las consultas siguen
+ * combinando el principal, el delta congelado y un delta nuevo.
+ */
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "index.h"
+
+#define INCREMENTAL_MAX_POSTINGS 65536 ///< Postings en el delta que disparan una fusion.
+#define INCREMENTAL_MAX_LAPIDAS 1024 ///< Documentos invalidados en el principal que disparan una fusion.
+
+/**
+ * @struct ResumenSincronizacion
+ * @brief Cambios aplicados por sincronizarDocumentos().
+ */
+typedef struct {
+    int agregados; ///< Archivos nuevos.
+    int actualizados; ///< Archivos modificados.
+    int eliminados; ///< Archivos borrados.
+} ResumenSincronizacion;
+
+/**
+ * @struct EstadisticasIncremental
+ * @brief Estado de los segmentos incrementales.
+ */
+typedef struct {
+    long postingsDelta; ///< Postings del delta activo.
+    int terminosDelta; ///< Palabras distintas del delta activo.
+    long postingsFusion; ///< Postings del delta que se esta fusionando (0 si no hay fusion).
+    int lapidas; ///< Documentos del principal invalidados desde la ultima fusion.
+    int fusiones; ///< Fusiones terminadas.
+} EstadisticasIncremental;
+
+/**
+ * @brief Toma el candado del indice en modo exclusivo.
+ *
+ * Lo deben tener quienes modifican el indice: la sincronizacion y la fusion en
+ * segundo plano, que reemplaza el indice principal y libera el delta fusionado.
+ */
+void bloquearIndice();
+
+/**
+ * @brief Toma el candado del indice en modo compartido.
+ *
+ * Lo deben tener quienes leen listas de postings. Varias consultas pueden
+ * tenerlo a la vez; solo esperan a quien tenga el modo exclusivo.
+ */
+void bloquearIndiceLectura();
+
+/**
+ * @brief Libera el candado del indice, tomado en cualquiera de los dos modos.
+ */
+void desbloquearIndice();
+
+/**
+ * @brief Registra el estado inicial de los archivos del corpus.
+ *
+ * Guarda el tamano y la fecha de modificacion de cada documento cargado, que
+ * sincronizarDocumentos() compara para detectar cambios.
+ *
+ * @param directorio Directorio de documentos.
+ */
+void iniciarIncremental(const char *directorio);
+
+/**
+ * @brief Indexa un archivo nuevo o vuelve a indexar uno modificado.
+ *
+ * Un archivo nuevo recibe el siguiente docID libre. Sus enlaces reemplazan a los
+ * anteriores; el PageRank no se recalcula.
+ *
+ * @param ruta Ruta del archivo, con el mismo formato que los nombres de documento.
+ * @return docID del documento, o -1 si el archivo no se pudo leer.
+ */
+int actualizarArchivo(const char *ruta);
+
+/**
+ * @brief Elimina un documento del indice y sus enlaces salientes del grafo.
+ *
+ * El docID queda reservado y el documento deja de aparecer en las consultas.
+ *
+ * @param ruta Ruta del archivo.
+ * @return 1 si el documento existia, 0 si no.
+ */
+int eliminarArchivo(const char *ruta);
+
+/**
+ * @brief Aplica al indice los cambios del directorio desde la ultima sincronizacion.
+ *
+ * Compara el tamano y la fecha de modificacion de cada archivo con los
+ * registrados y solo vuelve a leer los que cambiaron. Los enlaces de los
+ * archivos leidos se instalan al final, asi que pueden apuntar a un archivo que
+ * recibe su docID mas adelante en la misma sincronizacion. Si hubo cambios,
+ * actualiza el PageRank con actualizarPageRank() y PAGERANK_TOLERANCIA_INCREMENTAL.
+ *
+ * @param resumen Salida: cambios aplicados (puede ser NULL).
+ * @return Numero de archivos cambiados, o -1 si el directorio no se pudo leer.
+ */
+int sincronizarDocumentos(ResumenSincronizacion *resumen);
+
+/**
+ * @brief Agrega a una lista de postings los postings de los segmentos delta.
+ *
+ * La llama buscarPostings() con el candado del indice tomado.
+ *
+ * @param palabra Palabra buscada.
+ * @param longitud Longitud de la palabra.
+ * @param hash Hash de la palabra.
+ * @param lista Lista con los datos del indice principal; se completa.
+ * @return 1 si la palabra esta en algun segmento delta, 0 si no.
+ */
+int completarListaIncremental(const char *palabra, size_t longitud, uint64_t hash, ListaPostings *lista);
+
+/**
+ * @brief Recorre las palabras de los segmentos delta.
+ *
+ * Una palabra que esta en los dos segmentos se visita dos veces. Quien la llama
+ * debe tener el candado del indice tomado.
+ *
+ * @param visitar Funcion llamada con cada palabra y su longitud.
+ * @param contexto Puntero que se pasa sin cambios a visitar.
+ */
+void recorrerPalabrasIncremental(void (*visitar)(const char *palabra, size_t longitud, void *contexto),
+                                 void *contexto);
+
+/**
+ * @brief Congela el delta activo y lo fusiona con el principal en segundo plano.
+ *
+ * No hace nada si no hay cambios o si ya hay una fusion en curso.
+ */
+void fusionarIndice();
+
+/**
+ * @brief Espera a que termine la fusion en curso, si la hay.
+ */
+void esperarFusionIndice();
+
+/**
+ * @brief Obtiene el estado de los segmentos incrementales.
+ *
+ * @param estadisticas Salida.
+ */
+void obtenerEstadisticasIncremental(EstadisticasIncremental *estadisticas);
+
+#endif
@@ -10,87 +10,737 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <ctype.h>
-#include "graph.h"
+#include <limits.h>
+#include <stdatomic.h>
+#include "snapshot.h"
+#include "incremental.h"
+#include "instrumentacion.h"
 
-#define HASH_SIZE 100 ///< Tamaño de la tabla hash utilizada para el indice invertido.
+#define HASH_CAPACIDAD_INICIAL 1024 ///< Capacidad inicial de la tabla hash (potencia de dos).
+#define HASH_CARGA_MAXIMA_NUM 7 ///< Numerador del factor de carga maximo (7/10).
+#define HASH_CARGA_MAXIMA_DEN 10 ///< Denominador del factor de carga maximo (7/10).
 
-NodoIndice *tablaHash[HASH_SIZE]; ///< Tabla hash para almacenar las palabras y sus documentos asociados.
-char nombresArchivos[MAX_DOCS][256]; ///< Almacena los nombres de los documentos cargados.
+EntradaIndice *tablaHash = NULL; ///< Tabla hash de direccionamiento abierto con las palabras indexadas.
+size_t capacidadTablaHash = 0; ///< Numero de ranuras de la tabla hash (siempre potencia de dos).
+Documento *documentos = NULL; ///< Tabla de documentos indexada por docID.
+int capacidadDocumentos = 0; ///< Entradas reservadas en la tabla de documentos.
+char *almacenNombres = NULL; ///< Almacen contiguo de nombres de documentos terminados en '\0'.
+size_t bytesNombres = 0; ///< Bytes usados en el almacen de nombres.
+size_t capacidadNombres = 0; ///< Bytes reservados en el almacen de nombres.
+int documentosExternos = 0; ///< 1 si la tabla y el almacen de nombres pertenecen a una instantanea.
 int totalDocs = 0; ///< Contador del total de documentos cargados.
+uint64_t longitudTotalDocs = 0; ///< Suma de las longitudes de todos los documentos.
 int palabrasIndexadas = 0; ///< Contador del total de palabras indexadas.
+NodoIndice **terminosPendientes = NULL; ///< Palabras tocadas por el documento en curso.
+int numTerminosPendientes = 0; ///< Numero de palabras tocadas por el documento en curso.
+int capacidadTerminosPendientes = 0; ///< Capacidad reservada de terminosPendientes.
+Arena arenaIndice; ///< Nodos y palabras del indice en memoria.
+static _Atomic long generacionIndice = 1; ///< Aumenta con cada cambio visible para las consultas.
+static _Atomic long vocabularioIndice = 1; ///< Aumenta cuando se agregan, quitan o fusionan palabras.
+static int indicePosicional = 0; ///< 1 si los postings guardan las posiciones de la palabra.
+static _Atomic size_t bytesListas = 0; ///< Bytes reservados por los bufers de todas las listas de postings vivas.
+static _Atomic size_t bytesConjuntos = 0; ///< Bytes de los conjuntos Roaring vivos de las listas frecuentes.
+static _Atomic int numConjuntos = 0; ///< Conjuntos Roaring vivos de las listas frecuentes.
 
 /**
  * @brief Inicializa el indice invertido.
  *
- * Establece todas las posiciones de la tabla hash en NULL.
+ * Libera las palabras anteriores, si las hay, reserva la tabla hash con su
+ * capacidad inicial y marca todas las ranuras como vacias.
  */
 void inicializarIndice() {
-    for (int i = 0; i < HASH_SIZE; i++) {
-        tablaHash[i] = NULL;
+    for (size_t i = 0; i < capacidadTablaHash; i++) {
+        liberarNodoIndice(tablaHash[i].nodo);
     }
+    reiniciarArena(&arenaIndice);
+    numTerminosPendientes = 0;
+    free(tablaHash);
+    capacidadTablaHash = HASH_CAPACIDAD_INICIAL;
+    tablaHash = calloc(capacidadTablaHash, sizeof(EntradaIndice));
+    if (!tablaHash) {
+        perror("No se pudo reservar la tabla hash");
+        exit(EXIT_FAILURE);
+    }
+    palabrasIndexadas = 0;
+    avanzarVocabularioIndice();
+    avanzarGeneracionIndice();
+}
+
+/**
+ * @brief Vacia el indice en memoria conservando la capacidad de la tabla hash.
+ *
+ * Libera las listas de postings y los nodos, pero deja la tabla y un bloque de
+ * la arena, para que volver a llenarlo no repita las ampliaciones.
+ */
+void vaciarIndice() {
+    for (size_t i = 0; i < capacidadTablaHash; i++) {
+        liberarNodoIndice(tablaHash[i].nodo);
+    }
+    reiniciarArena(&arenaIndice);
+    memset(tablaHash, 0, capacidadTablaHash * sizeof(EntradaIndice));
+    numTerminosPendientes = 0;
+    palabrasIndexadas = 0;
+    avanzarVocabularioIndice();
+    avanzarGeneracionIndice();
+}
+
+/**
+ * @brief Activa o desactiva el indice posicional.
+ *
+ * @param activar 1 para guardar las posiciones, 0 para no guardarlas.
+ */
+void activarIndicePosicional(int activar) {
+    indicePosicional = activar != 0;
+}
+
+/**
+ * @brief Indica si el indice guarda posiciones.
+ *
+ * @return 1 si el indice posicional esta activado, 0 si no.
+ */
+int indicePosicionalActivado() {
+    return indicePosicional;
+}
+
+/**
+ * @brief Mezcla los bits de un valor de 64 bits.
+ *
+ * Finalizador de MurmurHash3: cada bit de entrada afecta a todos los bits de salida.
+ *
+ * @param x Valor a mezclar.
+ * @return Valor mezclado.
+ */
+static uint64_t mezclar64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
 }
 
 /**
- * @brief Calcula el hash de una palabra.
+ * @brief Calcula el hash de 64 bits de una palabra.
  *
- * Utiliza una funcion de hash basada en multiplicacion por 31 para obtener
- * una posicion en la tabla hash.
+ * Procesa la palabra en bloques de 8 bytes y mezcla cada bloque con
+ * multiplicaciones y rotaciones, por lo que palabras parecidas quedan bien
+ * repartidas en la tabla.
  *
  * @param palabra Palabra a la cual calcular el hash.
- * @return Posicion en la tabla hash.
+ * @param longitud Longitud de la palabra en bytes.
+ * @return Hash de 64 bits de la palabra.
+ */
+uint64_t calcularHash(const char *palabra, size_t longitud) {
+    uint64_t hash = 0x9e3779b97f4a7c15ULL ^ (longitud * 0xc2b2ae3d27d4eb4fULL);
+    while (longitud >= 8) {
+        uint64_t bloque;
+        memcpy(&bloque, palabra, 8);
+        hash ^= mezclar64(bloque);
+        hash = ((hash << 27) | (hash >> 37)) * 0x9e3779b97f4a7c15ULL + 0x52dce729ULL;
+        palabra += 8;
+        longitud -= 8;
+    }
+    uint64_t resto = 0;
+    memcpy(&resto, palabra, longitud);
+    hash ^= mezclar64(resto ^ 0x27d4eb2f165667c5ULL);
+    return mezclar64(hash);
+}
+
+/**
+ * @brief Busca la ranura de una palabra en la tabla hash.
+ *
+ * Recorre la tabla con sondeo lineal a partir del hash. Las ranuras cuyo hash
+ * no coincide se descartan sin comparar las cadenas.
+ *
+ * @param palabra Palabra a buscar.
+ * @param longitud Longitud de la palabra en bytes.
+ * @param hash Hash de la palabra.
+ * @return Ranura que contiene la palabra, o la ranura vacia donde deberia insertarse.
+ */
+static EntradaIndice *buscarRanura(const char *palabra, size_t longitud, uint64_t hash) {
+    size_t mascara = capacidadTablaHash - 1;
+    size_t i = (size_t)hash & mascara;
+    while (tablaHash[i].nodo) {
+        if (tablaHash[i].hash == hash && tablaHash[i].nodo->longitud == longitud &&
+            memcmp(tablaHash[i].nodo->palabra, palabra, longitud) == 0) {
+            break;
+        }
+        i = (i + 1) & mascara;
+    }
+    INSTRUMENTAR_CONTADOR(CONTADOR_BUSQUEDAS_HASH, 1);
+    INSTRUMENTAR_CONTADOR(CONTADOR_SONDEOS_HASH, ((i - (size_t)hash) & mascara) + 1);
+    INSTRUMENTAR_HISTOGRAMA(HISTOGRAMA_SONDEOS_HASH, ((i - (size_t)hash) & mascara) + 1);
+    return &tablaHash[i];
+}
+
+/**
+ * @brief Duplica la capacidad de la tabla hash y reubica todas las entradas.
+ *
+ * Los hashes almacenados se reutilizan, por lo que no se recalcula ninguno.
+ */
+static void redimensionarTablaHash() {
+    size_t capacidadAnterior = capacidadTablaHash;
+    EntradaIndice *anterior = tablaHash;
+
+    capacidadTablaHash *= 2;
+    tablaHash = calloc(capacidadTablaHash, sizeof(EntradaIndice));
+    if (!tablaHash) {
+        perror("No se pudo redimensionar la tabla hash");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t mascara = capacidadTablaHash - 1;
+    for (size_t j = 0; j < capacidadAnterior; j++) {
+        if (anterior[j].nodo) {
+            size_t i = (size_t)anterior[j].hash & mascara;
+            while (tablaHash[i].nodo) {
+                i = (i + 1) & mascara;
+            }
+            tablaHash[i] = anterior[j];
+        }
+    }
+    free(anterior);
+}
+
+/**
+ * @brief Busca la lista de postings de una palabra.
+ *
+ * Consulta primero el indice en memoria y luego la instantanea cargada, si la hay.
+ * Los postings del documento en curso, aun sin finalizar, no se incluyen.
+ *
+ * @param palabra Palabra a buscar.
+ * @param lista Salida: vista de la lista de postings.
+ * @return 1 si la palabra esta indexada, 0 en caso contrario.
+ */
+int buscarPostings(const char *palabra, ListaPostings *lista) {
+    size_t longitud = strlen(palabra);
+    uint64_t hash = calcularHash(palabra, longitud);
+    NodoIndice *nodo = buscarRanura(palabra, longitud, hash)->nodo;
+    int encontrada = 1;
+    memset(lista, 0, sizeof(*lista));
+    if (nodo) {
+        lista->palabra = nodo->palabra;
+        lista->longitud = nodo->longitud;
+        lista->datos = nodo->postings;
+        lista->bytes = nodo->bytesPostings;
+        lista->conteoDocs = nodo->conteoDocs;
+        lista->saltos = nodo->saltos;
+        lista->numSaltos = nodo->numSaltos;
+        lista->frecuenciaMaxima = nodo->frecuenciaMaxima;
+        lista->posiciones = nodo->posiciones;
+        lista->bytesPosiciones = nodo->bytesPosiciones;
+        lista->saltosPosiciones = nodo->saltosPosiciones;
+        lista->conjunto = &nodo->conjunto;
+    } else {
+        encontrada = buscarPostingsSnapshot(palabra, longitud, hash, lista);
+    }
+    return completarListaIncremental(palabra, longitud, hash, lista) || encontrada;
+}
+
+/**
+ * @brief Recorre todas las palabras del indice en memoria.
+ *
+ * @param visitar Funcion llamada con la lista de postings de cada palabra.
+ * @param contexto Puntero que se pasa sin cambios a visitar.
+ */
+void recorrerIndice(void (*visitar)(const ListaPostings *lista, void *contexto), void *contexto) {
+    for (size_t i = 0; i < capacidadTablaHash; i++) {
+        NodoIndice *nodo = tablaHash[i].nodo;
+        if (nodo) {
+            ListaPostings lista;
+            memset(&lista, 0, sizeof(lista));
+            lista.palabra = nodo->palabra;
+            lista.longitud = nodo->longitud;
+            lista.datos = nodo->postings;
+            lista.bytes = nodo->bytesPostings;
+            lista.conteoDocs = nodo->conteoDocs;
+            lista.saltos = nodo->saltos;
+            lista.numSaltos = nodo->numSaltos;
+            lista.frecuenciaMaxima = nodo->frecuenciaMaxima;
+            lista.posiciones = nodo->posiciones;
+            lista.bytesPosiciones = nodo->bytesPosiciones;
+            lista.saltosPosiciones = nodo->saltosPosiciones;
+            lista.conjunto = &nodo->conjunto;
+            visitar(&lista, contexto);
+        }
+    }
+}
+
+/**
+ * @brief Escribe un entero sin signo en formato varint al final de los postings de un nodo.
+ *
+ * Cada byte guarda 7 bits del valor; el bit alto indica que sigue otro byte.
+ * El bufer crece al doble cuando no queda espacio.
+ *
+ * @param nodo Nodo cuyos postings se extienden.
+ * @param valor Valor a codificar.
+ */
+static void escribirVarint(NodoIndice *nodo, uint32_t valor) {
+    if (nodo->bytesPostings + 5 > nodo->capacidadPostings) {
+        size_t capacidad = nodo->capacidadPostings ? nodo->capacidadPostings * 2 : 8;
+        unsigned char *nuevo = realloc(nodo->postings, capacidad);
+        if (!nuevo) {
+            perror("No se pudo ampliar la lista de postings");
+            exit(EXIT_FAILURE);
+        }
+        bytesListas += capacidad - nodo->capacidadPostings;
+        nodo->postings = nuevo;
+        nodo->capacidadPostings = capacidad;
+    }
+    while (valor >= 0x80) {
+        nodo->postings[nodo->bytesPostings++] = (unsigned char)(valor | 0x80);
+        valor >>= 7;
+    }
+    nodo->postings[nodo->bytesPostings++] = (unsigned char)valor;
+}
+
+/**
+ * @brief Lee un entero en formato varint.
+ *
+ * @param p Puntero a la posicion de lectura; se avanza tras los bytes consumidos.
+ * @return Valor decodificado.
+ */
+static uint32_t leerVarint(const unsigned char **p) {
+    const unsigned char *q = *p;
+    uint32_t valor = *q & 0x7f;
+    int desplazamiento = 7;
+    while (*q++ & 0x80) {
+        valor |= (uint32_t)(*q & 0x7f) << desplazamiento;
+        desplazamiento += 7;
+    }
+    *p = q;
+    return valor;
+}
+
+/**
+ * @brief Codifica las posiciones de un posting.
+ *
+ * La primera posicion se guarda tal cual y las siguientes como diferencia con
+ * la anterior, cada una en varint.
+ *
+ * @param posiciones Posiciones en orden creciente.
+ * @param cantidad Numero de posiciones.
+ * @param destino Bufer de al menos 5 * cantidad bytes.
+ * @return Bytes escritos.
+ */
+size_t codificarPosiciones(const uint32_t *posiciones, int cantidad, unsigned char *destino) {
+    unsigned char *p = destino;
+    uint32_t anterior = 0;
+    for (int i = 0; i < cantidad; i++) {
+        uint32_t valor = posiciones[i] - anterior;
+        anterior = posiciones[i];
+        while (valor >= 0x80) {
+            *p++ = (unsigned char)(valor | 0x80);
+            valor >>= 7;
+        }
+        *p++ = (unsigned char)valor;
+    }
+    return (size_t)(p - destino);
+}
+
+/**
+ * @brief Calcula cuantos bytes ocupan las posiciones codificadas de un posting.
+ *
+ * Basta contar los bytes que terminan un varint, sin decodificarlos. Mientras
+ * falten al menos 8 posiciones, los 8 bytes siguientes son todos de este posting
+ * y se cuentan de una vez con popcount sobre sus bits altos.
+ *
+ * @param datos Posiciones codificadas.
+ * @param cantidad Numero de posiciones (la frecuencia del posting).
+ * @return Bytes que ocupan.
+ */
+size_t largoPosiciones(const unsigned char *datos, int cantidad) {
+    const unsigned char *p = datos;
+    while (cantidad >= 8) {
+        uint64_t palabra;
+        memcpy(&palabra, p, sizeof(palabra));
+        cantidad -= __builtin_popcountll(~palabra & 0x8080808080808080ULL);
+        p += sizeof(palabra);
+    }
+    while (cantidad > 0) {
+        if (!(*p++ & 0x80)) {
+            cantidad--;
+        }
+    }
+    return (size_t)(p - datos);
+}
+
+/**
+ * @brief Decodifica las posiciones de un posting.
+ *
+ * @param datos Posiciones codificadas.
+ * @param cantidad Numero de posiciones (la frecuencia del posting).
+ * @param destino Salida: cantidad posiciones en orden creciente.
+ */
+void decodificarPosiciones(const unsigned char *datos, int cantidad, uint32_t *destino) {
+    uint32_t posicion = 0;
+    for (int i = 0; i < cantidad; i++) {
+        posicion += leerVarint(&datos);
+        destino[i] = posicion;
+    }
+}
+
+/**
+ * @brief Asegura espacio para bytes mas en el bufer de posiciones de un nodo.
+ *
+ * @param nodo Nodo.
+ * @param bytes Bytes que se van a agregar.
+ */
+static void reservarPosiciones(NodoIndice *nodo, size_t bytes) {
+    if (nodo->bytesPosiciones + bytes <= nodo->capacidadPosiciones) {
+        return;
+    }
+    size_t capacidad = nodo->capacidadPosiciones ? nodo->capacidadPosiciones * 2 : 16;
+    while (capacidad < nodo->bytesPosiciones + bytes) {
+        capacidad *= 2;
+    }
+    unsigned char *nuevo = realloc(nodo->posiciones, capacidad);
+    if (!nuevo) {
+        perror("No se pudo ampliar las posiciones");
+        exit(EXIT_FAILURE);
+    }
+    bytesListas += capacidad - nodo->capacidadPosiciones;
+    nodo->posiciones = nuevo;
+    nodo->capacidadPosiciones = capacidad;
+}
+
+/**
+ * @brief Calcula los bytes reservados para los punteros de salto de un nodo.
+ *
+ * @param nodo Nodo.
+ * @return Bytes de saltos y, si los hay, de saltos de posiciones.
+ */
+static size_t bytesSaltos(const NodoIndice *nodo) {
+    size_t porSalto = sizeof(SaltoPosting) + (nodo->saltosPosiciones ? sizeof(uint32_t) : 0);
+    return (size_t)nodo->capacidadSaltos * porSalto;
+}
+
+/**
+ * @brief Agrega un posting al final de la lista comprimida de un nodo.
+ *
+ * Registra un puntero de salto cada POSTINGS_POR_BLOQUE postings. Las posiciones
+ * se copian antes de registrarlo, para que el salto de posiciones apunte despues
+ * de las del ultimo posting del bloque.
+ *
+ * @param nodo Nodo de destino.
+ * @param docID Documento, mayor que el ultimo de la lista.
+ * @param frecuencia Apariciones de la palabra en el documento.
+ * @param posiciones Posiciones ya codificadas, o NULL si no hay que copiar ninguna.
+ * @param bytesPosiciones Bytes de posiciones.
+ */
+void agregarPostingNodo(NodoIndice *nodo, int docID, int frecuencia, const unsigned char *posiciones,
+                        size_t bytesPosiciones) {
+    if (atomic_load_explicit(&nodo->conjunto, memory_order_relaxed)) {
+        descartarConjuntoPostings(&nodo->conjunto);
+    }
+    if (posiciones) {
+        reservarPosiciones(nodo, bytesPosiciones);
+        memcpy(nodo->posiciones + nodo->bytesPosiciones, posiciones, bytesPosiciones);
+        nodo->bytesPosiciones += bytesPosiciones;
+    }
+    size_t bytesAntes = nodo->bytesPostings;
+    escribirVarint(nodo, (uint32_t)(docID - nodo->ultimoDocID));
+    escribirVarint(nodo, (uint32_t)frecuencia);
+    INSTRUMENTAR_CONTADOR(CONTADOR_POSTINGS_CODIFICADOS, 1);
+    INSTRUMENTAR_CONTADOR(CONTADOR_BYTES_POSTINGS, nodo->bytesPostings - bytesAntes);
+    if (frecuencia > nodo->frecuenciaMaxima) {
+        nodo->frecuenciaMaxima = frecuencia;
+    }
+    nodo->ultimoDocID = docID;
+    nodo->conteoDocs++;
+
+    if (nodo->conteoDocs % POSTINGS_POR_BLOQUE == 0) {
+        if (nodo->numSaltos == nodo->capacidadSaltos) {
+            size_t bytesAntes = bytesSaltos(nodo);
+            nodo->capacidadSaltos = nodo->capacidadSaltos ? nodo->capacidadSaltos * 2 : 4;
+            nodo->saltos = realloc(nodo->saltos, nodo->capacidadSaltos * sizeof(SaltoPosting));
+            if (!nodo->saltos) {
+                perror("No se pudo ampliar los punteros de salto");
+                exit(EXIT_FAILURE);
+            }
+            if (nodo->posiciones) {
+                nodo->saltosPosiciones = realloc(nodo->saltosPosiciones, nodo->capacidadSaltos * sizeof(uint32_t));
+                if (!nodo->saltosPosiciones) {
+                    perror("No se pudo ampliar los punteros de salto");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            bytesListas += bytesSaltos(nodo) - bytesAntes;
+        }
+        nodo->saltos[nodo->numSaltos].ultimoDocID = nodo->ultimoDocID;
+        nodo->saltos[nodo->numSaltos].offset = (uint32_t)nodo->bytesPostings;
+        if (nodo->posiciones) {
+            nodo->saltosPosiciones[nodo->numSaltos] = (uint32_t)nodo->bytesPosiciones;
+        }
+        nodo->numSaltos++;
+    }
+}
+
+/**
+ * @brief Codifica el posting pendiente de un nodo en su lista comprimida.
+ *
+ * @param nodo Nodo con un documento pendiente.
+ */
+static void codificarPendiente(NodoIndice *nodo) {
+    // Las posiciones del documento en curso ya se escribieron al agregarlo.
+    agregarPostingNodo(nodo, nodo->docPendiente, nodo->frecuenciaPendiente, NULL, 0);
+    if (nodo->docPendiente < capacidadDocumentos && !documentosExternos) {
+        documentos[nodo->docPendiente].longitud += (uint32_t)nodo->frecuenciaPendiente;
+        longitudTotalDocs += (uint64_t)nodo->frecuenciaPendiente;
+    }
+    nodo->docPendiente = -1;
+    nodo->frecuenciaPendiente = 0;
+}
+
+/**
+ * @brief Crea un nodo de indice vacio para una palabra.
+ *
+ * La palabra se copia justo despues del nodo, en la misma reserva, para que
+ * comparar la palabra al buscar en la tabla no toque otra linea de cache lejana.
+ *
+ * @param arena Arena donde se reserva el nodo.
+ * @param palabra Palabra (no necesita terminar en '\0').
+ * @param longitud Longitud de la palabra en bytes.
+ * @return Nodo nuevo; termina el programa si no hay memoria.
+ */
+NodoIndice *crearNodoIndice(Arena *arena, const char *palabra, size_t longitud) {
+    NodoIndice *nodo = reservarArena(arena, sizeof(NodoIndice) + longitud + 1);
+    memset(nodo, 0, sizeof(NodoIndice));
+    nodo->palabra = (char *)(nodo + 1);
+    memcpy(nodo->palabra, palabra, longitud);
+    nodo->palabra[longitud] = '\0';
+    nodo->longitud = longitud;
+    nodo->ultimoDocID = -1;
+    nodo->docPendiente = -1;
+    return nodo;
+}
+
+/**
+ * @brief Libera los postings de un nodo de indice.
+ *
+ * @param nodo Nodo cuyos postings se liberan (puede ser NULL).
+ */
+void liberarNodoIndice(NodoIndice *nodo) {
+    if (nodo) {
+        bytesListas -= nodo->capacidadPostings + nodo->capacidadPosiciones + bytesSaltos(nodo);
+        descartarConjuntoPostings(&nodo->conjunto);
+        free(nodo->postings);
+        free(nodo->saltos);
+        free(nodo->posiciones);
+        free(nodo->saltosPosiciones);
+        nodo->postings = NULL;
+        nodo->saltos = NULL;
+        nodo->posiciones = NULL;
+        nodo->saltosPosiciones = NULL;
+        nodo->capacidadPostings = 0;
+        nodo->capacidadPosiciones = 0;
+        nodo->capacidadSaltos = 0;
+    }
+}
+
+/**
+ * @brief Reemplaza el indice en memoria por un conjunto de nodos ya armados.
+ *
+ * La tabla nueva se dimensiona para quedar bajo el factor de carga maximo sin
+ * redimensionar durante la insercion.
+ *
+ * @param nodos Nodos del nuevo indice, con palabras distintas.
+ * @param numNodos Numero de nodos.
+ * @param arena Arena de los nodos; el indice se queda con sus bloques y la deja vacia.
  */
-int calcularHash(const char *palabra) {
-    unsigned long hash = 0;
-    while (*palabra) {
-        hash = (hash * 31) + *palabra++;
+void reemplazarIndice(NodoIndice **nodos, int numNodos, Arena *arena) {
+    size_t capacidad = HASH_CAPACIDAD_INICIAL;
+    while ((size_t)numNodos * HASH_CARGA_MAXIMA_DEN > capacidad * HASH_CARGA_MAXIMA_NUM) {
+        capacidad *= 2;
+    }
+    EntradaIndice *tabla = calloc(capacidad, sizeof(EntradaIndice));
+    if (!tabla) {
+        perror("No se pudo reservar la tabla hash");
+        exit(EXIT_FAILURE);
+    }
+    for (int n = 0; n < numNodos; n++) {
+        uint64_t hash = calcularHash(nodos[n]->palabra, nodos[n]->longitud);
+        size_t i = (size_t)hash & (capacidad - 1);
+        while (tabla[i].nodo) {
+            i = (i + 1) & (capacidad - 1);
+        }
+        tabla[i].hash = hash;
+        tabla[i].nodo = nodos[n];
     }
-    return hash % HASH_SIZE;
+
+    for (size_t i = 0; i < capacidadTablaHash; i++) {
+        liberarNodoIndice(tablaHash[i].nodo);
+    }
+    liberarArena(&arenaIndice);
+    long reservasAcumuladas = arenaIndice.reservasAcumuladas;
+    size_t bytesAcumulados = arenaIndice.bytesAcumulados;
+    arenaIndice = *arena;
+    arenaIndice.reservasAcumuladas += reservasAcumuladas;
+    arenaIndice.bytesAcumulados += bytesAcumulados;
+    iniciarArena(arena, arena->tamanoBloque);
+    free(tablaHash);
+    tablaHash = tabla;
+    capacidadTablaHash = capacidad;
+    palabrasIndexadas = numNodos;
+    numTerminosPendientes = 0;
+    avanzarVocabularioIndice();
+    avanzarGeneracionIndice();
 }
 
 /**
  * @brief Agrega una palabra al indice invertido.
  *
- * Si la palabra ya existe en el indice, se agrega el identificador del documento
- * al conjunto de documentos asociados a la palabra. Si no, se crea una nueva entrada.
+ * Si la palabra ya existe en el indice, se registra una aparicion mas en el documento
+ * en curso; cada documento aparece una sola vez por palabra, con su frecuencia.
+ * Si no, se crea una nueva entrada. La tabla se duplica cuando su factor de carga
+ * supera 0.7.
  *
  * @param palabra Palabra a agregar.
  * @param docID Identificador del documento donde aparece la palabra.
  */
 void agregarPalabraIndice(const char *palabra, int docID) {
-    int hash = calcularHash(palabra);
-    NodoIndice *actual = tablaHash[hash];
+    size_t longitud = strlen(palabra);
+    agregarPostingIndice(palabra, longitud, calcularHash(palabra, longitud), docID, 1, NULL);
+}
 
-    while (actual) {
-        if (strcmp(actual->palabra, palabra) == 0) {
-            actual->docIDs[actual->conteoDocs++] = docID;
-            return;
+/**
+ * @brief Suma apariciones de una palabra en un documento, con el hash ya calculado.
+ *
+ * Las posiciones se codifican enseguida en el flujo del nodo: el posting del
+ * documento se codifica recien al finalizarlo, pero ningun otro posting de la
+ * palabra puede ir antes.
+ *
+ * @param palabra Palabra a agregar (no necesita terminar en '\0').
+ * @param longitud Longitud de la palabra en bytes.
+ * @param hash Hash de la palabra obtenido con calcularHash().
+ * @param docID Identificador del documento donde aparece la palabra.
+ * @param frecuencia Numero de apariciones a sumar.
+ * @param posiciones Posiciones de las apariciones en orden creciente, o NULL.
+ */
+void agregarPostingIndice(const char *palabra, size_t longitud, uint64_t hash, int docID, int frecuencia,
+                          const uint32_t *posiciones) {
+    EntradaIndice *ranura = buscarRanura(palabra, longitud, hash);
+    NodoIndice *nodo = ranura->nodo;
+
+    if (!nodo) {
+        nodo = crearNodoIndice(&arenaIndice, palabra, longitud);
+        ranura->hash = hash;
+        ranura->nodo = nodo;
+        palabrasIndexadas++;
+        avanzarVocabularioIndice();
+
+        if ((size_t)palabrasIndexadas * HASH_CARGA_MAXIMA_DEN > capacidadTablaHash * HASH_CARGA_MAXIMA_NUM) {
+            redimensionarTablaHash();
         }
-        actual = actual->siguiente;
     }
 
-    NodoIndice *nuevoNodo = malloc(sizeof(NodoIndice));
-    nuevoNodo->palabra = strdup(palabra);
-    nuevoNodo->docIDs[0] = docID;
-    nuevoNodo->conteoDocs = 1;
-    nuevoNodo->siguiente = tablaHash[hash];
-    tablaHash[hash] = nuevoNodo;
-    palabrasIndexadas++;
+    if (nodo->docPendiente == docID) {
+        nodo->frecuenciaPendiente += frecuencia;
+        return;
+    }
+    if (nodo->docPendiente != -1) {
+        // El documento anterior no se finalizo; se cierra aqui para no perderlo.
+        codificarPendiente(nodo);
+    }
+    if (docID <= nodo->ultimoDocID) {
+        fprintf(stderr, "docID %d fuera de orden para la palabra '%s'.\n", docID, nodo->palabra);
+        return;
+    }
+    nodo->docPendiente = docID;
+    nodo->frecuenciaPendiente = frecuencia;
+    if (posiciones) {
+        reservarPosiciones(nodo, 5 * (size_t)frecuencia);
+        nodo->bytesPosiciones += codificarPosiciones(posiciones, frecuencia, nodo->posiciones + nodo->bytesPosiciones);
+    }
+
+    if (numTerminosPendientes == capacidadTerminosPendientes) {
+        capacidadTerminosPendientes = capacidadTerminosPendientes ? capacidadTerminosPendientes * 2 : 256;
+        terminosPendientes = realloc(terminosPendientes, capacidadTerminosPendientes * sizeof(NodoIndice *));
+        if (!terminosPendientes) {
+            perror("No se pudo ampliar la lista de terminos pendientes");
+            exit(EXIT_FAILURE);
+        }
+    }
+    terminosPendientes[numTerminosPendientes++] = nodo;
 }
 
 /**
- * @brief Verifica si una palabra es una stopword.
+ * @brief Cierra el documento en curso en todas las palabras que aparecieron en el.
  *
- * Comprueba si la palabra pertenece a una lista de palabras comunes que no
- * deben ser indexadas.
+ * Codifica en las listas comprimidas el par (docID, frecuencia) acumulado de cada
+ * palabra tocada desde la ultima llamada y avanza la generacion del indice una
+ * sola vez por todo el documento.
+ */
+void finalizarDocumentoIndice() {
+    for (int i = 0; i < numTerminosPendientes; i++) {
+        if (terminosPendientes[i]->docPendiente != -1) {
+            codificarPendiente(terminosPendientes[i]);
+        }
+    }
+    numTerminosPendientes = 0;
+    avanzarGeneracionIndice();
+}
+
+/**
+ * @brief Decodifica el siguiente posting de la lista comprimida.
  *
- * @param palabra Palabra a verificar.
- * @return 1 si es una stopword, 0 en caso contrario.
+ * @param it Iterador de postings.
+ * @return 1 si se decodifico un posting, 0 al final de la lista comprimida.
  */
-int esStopword(const char *palabra) {
-    const char *stopwords[] = {"el", "la", "los", "las", "un", "una", "de", "y", "en", "que", NULL};
-    for (int i = 0; stopwords[i]; i++) {
-        if (strcmp(stopwords[i], palabra) == 0) {
+static int siguienteComprimido(IteradorPostings *it) {
+    if (it->actual >= it->fin) {
+        return 0;
+    }
+    it->docComprimido += (int)leerVarint(&it->actual);
+    it->frecuenciaComprimida = (int)leerVarint(&it->actual);
+    it->frecuenciaBase += (uint32_t)it->frecuenciaComprimida;
+    it->leidos++;
+    return 1;
+}
+
+/**
+ * @brief Avanza la lista comprimida hasta el primer posting con docID mayor o igual al indicado.
+ *
+ * Si el bloque actual termina antes del objetivo, busca de forma exponencial y
+ * luego binaria el primer bloque cuyo ultimo docID alcanza el objetivo, y reanuda
+ * la decodificacion al inicio de ese bloque.
+ *
+ * @param it Iterador de postings.
+ * @param docID Documento objetivo.
+ * @return 1 si quedo posicionado en un posting con docID >= objetivo, 0 si la lista se agoto.
+ */
+static int avanzarComprimido(IteradorPostings *it, int docID) {
+    if (it->leidos > 0 && it->docComprimido >= docID) {
+        return 1;
+    }
+
+    int bloque = it->leidos / POSTINGS_POR_BLOQUE;
+    if (bloque < it->numSaltos && it->saltos[bloque].ultimoDocID < docID) {
+        int bajo = bloque;
+        int paso = 1;
+        while (bajo + paso < it->numSaltos && it->saltos[bajo + paso].ultimoDocID < docID) {
+            bajo += paso;
+            paso *= 2;
+        }
+        int alto = bajo + paso < it->numSaltos ? bajo + paso : it->numSaltos;
+        // saltos[bajo] < docID; se busca el primer bloque en (bajo, alto] que lo alcance
+        while (bajo + 1 < alto) {
+            int medio = bajo + (alto - bajo) / 2;
+            if (it->saltos[medio].ultimoDocID < docID) {
+                bajo = medio;
+            } else {
+                alto = medio;
+            }
+        }
+        it->actual = it->inicio + it->saltos[bajo].offset;
+        it->docComprimido = it->saltos[bajo].ultimoDocID;
+        it->leidos = (bajo + 1) * POSTINGS_POR_BLOQUE;
+        it->bloqueBase = bajo + 1;
+        it->frecuenciaBase = 0;
+    }
+
+    while (siguienteComprimido(it)) {
+        if (it->docComprimido >= docID) {
             return 1;
         }
     }
@@ -98,75 +748,487 @@ int esStopword(const char *palabra) {
 }
 
 /**
- * @brief Busca documentos que contienen una palabra especifica.
+ * @brief Prepara un iterador sobre una lista de postings.
  *
- * Muestra los documentos que contienen la palabra buscada junto con su PageRank.
- * Permite al usuario abrir los documentos encontrados.
+ * @param it Iterador a inicializar.
+ * @param lista Lista de postings a recorrer.
+ */
+void iniciarIteradorPostings(IteradorPostings *it, const ListaPostings *lista) {
+    it->inicio = lista->datos;
+    it->actual = lista->datos;
+    it->fin = lista->datos + lista->bytes;
+    it->saltos = lista->saltos;
+    it->numSaltos = lista->numSaltos;
+    it->leidos = 0;
+    it->docComprimido = -1;
+    it->frecuenciaComprimida = 0;
+    it->estados = lista->estados;
+    it->numEstados = lista->numEstados;
+    it->docID = -1;
+    it->frecuencia = 0;
+    it->posiciones = lista->posiciones;
+    it->saltosPosiciones = lista->saltosPosiciones;
+    it->bloqueBase = 0;
+    it->frecuenciaBase = 0;
+    it->cursorPosiciones = lista->posiciones;
+    it->cursorBloque = 0;
+    it->cursorPrevias = 0;
+    if (it->estados) {
+        // Con cambios incrementales se combinan los segmentos: se carga el primer posting de cada uno.
+        it->cabeza[SEGMENTO_PRINCIPAL] = siguienteComprimido(it) ? it->docComprimido : INT_MAX;
+        for (int i = 0; i < SEGMENTOS_DELTA; i++) {
+            it->deltas[i] = lista->deltas[i];
+            it->numDeltas[i] = lista->numDeltas[i];
+            it->posicionesDeltas[i] = lista->posicionesDeltas[i];
+            it->posDeltas[i] = 0;
+            it->cabeza[1 + i] = it->numDeltas[i] > 0 ? it->deltas[i][0].docID : INT_MAX;
+        }
+    }
+}
+
+/**
+ * @brief Avanza el iterador al siguiente posting.
  *
- * @param consulta Palabra a buscar.
+ * Con cambios incrementales toma el menor docID entre los segmentos y descarta
+ * los postings de segmentos donde el documento ya no esta vigente.
+ *
+ * @param it Iterador de postings.
+ * @return 1 si se obtuvo un posting, 0 al final de la lista.
  */
-void buscarDocumentos(const char *consulta) {
-    int hash = calcularHash(consulta);
-    NodoIndice *actual = tablaHash[hash];
-    int documentosEncontrados[MAX_DOCS];
-    int conteoDocumentos = 0;
+int siguientePosting(IteradorPostings *it) {
+    if (!it->estados) {
+        if (!siguienteComprimido(it)) {
+            return 0;
+        }
+        it->docID = it->docComprimido;
+        it->frecuencia = it->frecuenciaComprimida;
+        return 1;
+    }
 
-    // Buscar documentos que contienen la palabra
-    while (actual) {
-        if (strcmp(actual->palabra, consulta) == 0) {
-            printf("Resultados para la palabra '%s':\n", consulta);
-            for (int i = 0; i < actual->conteoDocs; i++) {
-                int docID = actual->docIDs[i];
-                documentosEncontrados[conteoDocumentos++] = docID;
-                printf(" - Documento: %s (PageRank: %.4f)\n", nombresArchivos[docID], obtenerPageRank(docID));
+    for (;;) {
+        int segmento = SEGMENTO_PRINCIPAL;
+        for (int s = 1; s <= SEGMENTOS_DELTA; s++) {
+            if (it->cabeza[s] < it->cabeza[segmento]) {
+                segmento = s;
             }
-            break;
         }
-        actual = actual->siguiente;
+        int docID = it->cabeza[segmento];
+        int frecuencia;
+        int indice;
+        if (docID == INT_MAX) {
+            return 0;
+        }
+        if (segmento == SEGMENTO_PRINCIPAL) {
+            frecuencia = it->frecuenciaComprimida;
+            indice = it->leidos - 1;
+            // La cabeza siguiente se decodifica ya; las posiciones se ubican con los valores de ahora.
+            it->bloquePosting = it->bloqueBase;
+            it->previasPosting = it->frecuenciaBase - (uint32_t)frecuencia;
+            it->cabeza[segmento] = siguienteComprimido(it) ? it->docComprimido : INT_MAX;
+        } else {
+            int d = segmento - 1;
+            indice = it->posDeltas[d];
+            frecuencia = it->deltas[d][it->posDeltas[d]++].frecuencia;
+            it->cabeza[segmento] = it->posDeltas[d] < it->numDeltas[d] ? it->deltas[d][it->posDeltas[d]].docID
+                                                                      : INT_MAX;
+        }
+        int vigente = docID < it->numEstados ? it->estados[docID] : SEGMENTO_PRINCIPAL;
+        if (vigente == segmento) {
+            it->docID = docID;
+            it->frecuencia = frecuencia;
+            it->segmento = segmento;
+            it->indice = indice;
+            return 1;
+        }
     }
+}
 
-    if (conteoDocumentos == 0) {
-        printf("La palabra '%s' no fue encontrada.\n", consulta);
-        return;
+/**
+ * @brief Avanza el iterador hasta el primer posting con docID mayor o igual al indicado.
+ *
+ * @param it Iterador de postings.
+ * @param docID Documento objetivo.
+ * @return 1 si quedo posicionado en un posting con docID >= objetivo, 0 si la lista se agoto.
+ */
+int avanzarPosting(IteradorPostings *it, int docID) {
+    if (it->docID >= docID) {
+        return 1;
+    }
+    if (!it->estados) {
+        if (!avanzarComprimido(it, docID)) {
+            return 0;
+        }
+        it->docID = it->docComprimido;
+        it->frecuencia = it->frecuenciaComprimida;
+        return 1;
     }
 
-    // Preguntar si desea abrir algun documento
-    char respuesta;
-    printf("¿Desea abrir alguno de estos documentos? (s/n): ");
-    if (scanf(" %c", &respuesta) != 1) {
-        printf("Error al leer la respuesta. Asumiendo 'n'.\n");
-        respuesta = 'n';
+    if (it->cabeza[SEGMENTO_PRINCIPAL] < docID) {
+        it->cabeza[SEGMENTO_PRINCIPAL] = avanzarComprimido(it, docID) ? it->docComprimido : INT_MAX;
     }
-    if (respuesta == 's' || respuesta == 'S') {
-        for (int i = 0; i < conteoDocumentos; i++) {
-            printf("Abriendo el documento '%s'...\n", nombresArchivos[documentosEncontrados[i]]);
-            abrirDocumento(nombresArchivos[documentosEncontrados[i]]);
+    for (int d = 0; d < SEGMENTOS_DELTA; d++) {
+        if (it->cabeza[1 + d] < docID) {
+            int bajo = it->posDeltas[d];
+            int alto = it->numDeltas[d];
+            while (bajo < alto) {
+                int medio = bajo + (alto - bajo) / 2;
+                if (it->deltas[d][medio].docID < docID) {
+                    bajo = medio + 1;
+                } else {
+                    alto = medio;
+                }
+            }
+            it->posDeltas[d] = bajo;
+            it->cabeza[1 + d] = bajo < it->numDeltas[d] ? it->deltas[d][bajo].docID : INT_MAX;
         }
-    } else {
-        printf("No se abriran documentos.\n");
+    }
+    return siguientePosting(it);
+}
+
+/**
+ * @brief Devuelve los docID de una lista frecuente como conjunto Roaring.
+ *
+ * Si el conjunto todavia no existe lo arma el lector que lo pide, aunque haya
+ * otros leyendo: lo publica con una comparacion atomica y, si otro lector se
+ * adelanto, descarta el suyo y usa el publicado. Solo se libera cuando cambia o
+ * se libera la lista, lo que ocurre sin lectores.
+ *
+ * @param lista Lista obtenida con buscarPostings().
+ * @return Conjunto de la lista, o NULL si no corresponde.
+ */
+const ConjuntoRoaring *conjuntoPostings(const ListaPostings *lista) {
+    // Sin estados tampoco hay segmentos delta: la lista es solo la comprimida.
+    if (!lista->conjunto || lista->estados || lista->conteoDocs < CONJUNTO_MIN_DOCS ||
+        (long)lista->conteoDocs * CONJUNTO_DENSIDAD_MINIMA < totalDocumentosCargados()) {
+        return NULL;
+    }
+    ConjuntoRoaring *conjunto = atomic_load(lista->conjunto);
+    if (conjunto) {
+        return conjunto;
+    }
+    conjunto = crearConjuntoRoaring();
+    IteradorPostings it;
+    iniciarIteradorPostings(&it, lista);
+    while (siguientePosting(&it)) {
+        agregarAlFinalConjunto(conjunto, it.docID);
+    }
+    ajustarConjunto(conjunto);
+    ConjuntoRoaring *publicado = NULL;
+    if (!atomic_compare_exchange_strong(lista->conjunto, &publicado, conjunto)) {
+        liberarConjuntoRoaring(conjunto);
+        return publicado;
+    }
+    bytesConjuntos += bytesConjunto(conjunto);
+    numConjuntos++;
+    return conjunto;
+}
+
+/**
+ * @brief Libera el conjunto Roaring guardado en una ranura y la deja vacia.
+ *
+ * @param ranura Ranura del conjunto.
+ */
+void descartarConjuntoPostings(_Atomic(ConjuntoRoaring *) *ranura) {
+    ConjuntoRoaring *conjunto = atomic_exchange(ranura, NULL);
+    if (conjunto) {
+        bytesConjuntos -= bytesConjunto(conjunto);
+        numConjuntos--;
+        liberarConjuntoRoaring(conjunto);
     }
 }
 
+/**
+ * @brief Informa los conjuntos Roaring armados para las listas frecuentes.
+ *
+ * @param conjuntos Salida: conjuntos vivos (puede ser NULL).
+ * @return Bytes que ocupan.
+ */
+size_t memoriaConjuntosPostings(int *conjuntos) {
+    if (conjuntos) {
+        *conjuntos = numConjuntos;
+    }
+    return bytesConjuntos;
+}
+
+/**
+ * @brief Devuelve las posiciones codificadas del posting actual del iterador.
+ *
+ * En la lista comprimida, el iterador suma las frecuencias que decodifica desde
+ * el inicio del bloque en el que empezo (o al que salto), asi que sabe cuantas
+ * posiciones hay antes de las del posting actual sin volver a leer los postings.
+ * Un cursor propio avanza sobre las posiciones: vuelve al inicio del bloque con
+ * los punteros de salto de posiciones si el iterador salto, y si no solo cuenta
+ * los bytes de las posiciones que faltan.
+ *
+ * @param it Iterador posicionado en un posting.
+ * @param bytes Salida: bytes de las posiciones.
+ * @return Posiciones codificadas, o NULL si la lista no tiene posiciones.
+ */
+const unsigned char *posicionesPosting(IteradorPostings *it, size_t *bytes) {
+    int segmento = it->estados ? it->segmento : SEGMENTO_PRINCIPAL;
+    if (segmento != SEGMENTO_PRINCIPAL) {
+        int d = segmento - 1;
+        if (!it->posicionesDeltas[d]) {
+            return NULL;
+        }
+        const PostingSimple *posting = &it->deltas[d][it->indice];
+        const unsigned char *datos = it->posicionesDeltas[d] + posting->offsetPosiciones;
+        *bytes = largoPosiciones(datos, posting->frecuencia);
+        return datos;
+    }
+    if (!it->posiciones) {
+        return NULL;
+    }
+
+    int bloque = it->estados ? it->bloquePosting : it->bloqueBase;
+    uint32_t previas = it->estados ? it->previasPosting : it->frecuenciaBase - (uint32_t)it->frecuenciaComprimida;
+    if (it->cursorBloque != bloque || it->cursorPrevias > previas) {
+        it->cursorPosiciones = bloque > 0 ? it->posiciones + it->saltosPosiciones[bloque - 1] : it->posiciones;
+        it->cursorBloque = bloque;
+        it->cursorPrevias = 0;
+    }
+    it->cursorPosiciones += largoPosiciones(it->cursorPosiciones, (int)(previas - it->cursorPrevias));
+    it->cursorPrevias = previas;
+    *bytes = largoPosiciones(it->cursorPosiciones, it->frecuencia);
+    return it->cursorPosiciones;
+}
+
+/**
+ * @brief Copia al heap la tabla de documentos si pertenece a una instantanea.
+ *
+ * La instantanea es de solo lectura, por lo que hay que copiarla antes de modificarla.
+ */
+static void copiarTablaDocumentosExterna() {
+    if (!documentosExternos) {
+        return;
+    }
+    Documento *tabla = malloc((capacidadDocumentos ? capacidadDocumentos : 1) * sizeof(Documento));
+    char *nombres = malloc(capacidadNombres ? capacidadNombres : 1);
+    if (!tabla || !nombres) {
+        perror("No se pudo copiar la tabla de documentos");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(tabla, documentos, capacidadDocumentos * sizeof(Documento));
+    memcpy(nombres, almacenNombres, bytesNombres);
+    documentos = tabla;
+    almacenNombres = nombres;
+    documentosExternos = 0;
+}
+
 /**
  * @brief Agrega un documento al sistema.
  *
- * Almacena el nombre del documento y actualiza el contador total de documentos.
+ * Copia el nombre del documento al almacen de nombres, registra su posicion en la
+ * tabla de documentos y actualiza el contador total de documentos. La tabla y el
+ * almacen crecen al doble cuando se llenan.
  *
  * @param docID Identificador del documento.
  * @param nombre Nombre del archivo del documento.
  */
 void agregarDocumento(int docID, const char *nombre) {
-    strncpy(nombresArchivos[docID], nombre, sizeof(nombresArchivos[docID]));
+    if (docID < 0) {
+        fprintf(stderr, "docID invalido %d para '%s'.\n", docID, nombre);
+        return;
+    }
+    copiarTablaDocumentosExterna();
+    if (docID >= capacidadDocumentos) {
+        int capacidad = capacidadDocumentos ? capacidadDocumentos : 64;
+        while (capacidad <= docID) {
+            capacidad *= 2;
+        }
+        Documento *nuevos = realloc(documentos, capacidad * sizeof(Documento));
+        if (!nuevos) {
+            perror("No se pudo ampliar la tabla de documentos");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = capacidadDocumentos; i < capacidad; i++) {
+            nuevos[i].offsetNombre = SIZE_MAX;
+            nuevos[i].longitud = 0;
+            nuevos[i].reservado = 0;
+        }
+        documentos = nuevos;
+        capacidadDocumentos = capacidad;
+    }
+
+    size_t longitud = strlen(nombre) + 1;
+    if (bytesNombres + longitud > capacidadNombres) {
+        size_t capacidad = capacidadNombres ? capacidadNombres : 4096;
+        while (capacidad < bytesNombres + longitud) {
+            capacidad *= 2;
+        }
+        char *nuevo = realloc(almacenNombres, capacidad);
+        if (!nuevo) {
+            perror("No se pudo ampliar el almacen de nombres");
+            exit(EXIT_FAILURE);
+        }
+        almacenNombres = nuevo;
+        capacidadNombres = capacidad;
+    }
+    memcpy(almacenNombres + bytesNombres, nombre, longitud);
+    documentos[docID].offsetNombre = bytesNombres;
+    longitudTotalDocs -= documentos[docID].longitud;
+    documentos[docID].longitud = 0;
+    bytesNombres += longitud;
     totalDocs++;
 }
 
+/**
+ * @brief Usa una tabla de documentos externa, sin copiarla.
+ *
+ * @param tabla Tabla de documentos.
+ * @param numDocs Numero de entradas de la tabla.
+ * @param nombres Almacen de nombres al que apuntan los offsets de la tabla.
+ * @param bytes Bytes del almacen de nombres.
+ */
+void usarTablaDocumentosExterna(const Documento *tabla, int numDocs, const char *nombres, size_t bytes) {
+    if (!documentosExternos) {
+        free(documentos);
+        free(almacenNombres);
+    }
+    documentos = (Documento *)tabla;
+    capacidadDocumentos = numDocs;
+    almacenNombres = (char *)nombres;
+    bytesNombres = bytes;
+    capacidadNombres = bytes;
+    totalDocs = numDocs;
+    documentosExternos = 1;
+    longitudTotalDocs = 0;
+    for (int i = 0; i < numDocs; i++) {
+        longitudTotalDocs += tabla[i].longitud;
+    }
+    avanzarGeneracionIndice();
+}
+
+/**
+ * @brief Obtiene el nombre de archivo de un documento.
+ *
+ * @param docID Identificador del documento.
+ * @return Nombre del documento, o NULL si el docID no esta registrado.
+ */
+const char *obtenerNombreDocumento(int docID) {
+    if (docID < 0 || docID >= capacidadDocumentos || documentos[docID].offsetNombre == SIZE_MAX) {
+        return NULL;
+    }
+    return almacenNombres + documentos[docID].offsetNombre;
+}
+
+/**
+ * @brief Abre un documento con la aplicacion por defecto del sistema operativo.
+ *
+ * @param nombreArchivo Nombre o ruta del archivo a abrir.
+ */
+void abrirDocumento(const char *nombreArchivo) {
+    printf("Abriendo el documento '%s'...\n", nombreArchivo);
+    char comando[512];
+    snprintf(comando, sizeof(comando), "xdg-open \"%s\" 2>/dev/null || open \"%s\" 2>/dev/null || start \"%s\"",
+             nombreArchivo, nombreArchivo, nombreArchivo);
+    int status = system(comando);
+    if (status == -1) {
+        printf("Error al intentar abrir el documento '%s'.\n", nombreArchivo);
+    }
+}
+
+/**
+ * @brief Obtiene la longitud de un documento.
+ *
+ * @param docID Identificador del documento.
+ * @return Palabras indexadas del documento (con repeticiones), o 0 si no esta registrado.
+ */
+int obtenerLongitudDocumento(int docID) {
+    if (docID < 0 || docID >= capacidadDocumentos) {
+        return 0;
+    }
+    return (int)documentos[docID].longitud;
+}
+
+/**
+ * @brief Cambia la longitud registrada de un documento.
+ *
+ * @param docID Identificador del documento.
+ * @param longitud Palabras indexadas del documento, contando repeticiones.
+ */
+void establecerLongitudDocumento(int docID, int longitud) {
+    if (docID < 0 || docID >= capacidadDocumentos) {
+        return;
+    }
+    copiarTablaDocumentosExterna();
+    longitudTotalDocs -= documentos[docID].longitud;
+    documentos[docID].longitud = (uint32_t)longitud;
+    longitudTotalDocs += (uint64_t)longitud;
+    avanzarGeneracionIndice();
+}
+
+/**
+ * @brief Obtiene la longitud promedio de los documentos cargados.
+ *
+ * @return Promedio de palabras indexadas por documento, o 0 si no hay documentos.
+ */
+double longitudPromedioDocumentos() {
+    return totalDocs ? (double)longitudTotalDocs / totalDocs : 0.0;
+}
+
+/**
+ * @brief Marca que cambio el contenido visible para las consultas.
+ */
+void avanzarGeneracionIndice() {
+    atomic_fetch_add_explicit(&generacionIndice, 1, memory_order_release);
+}
+
+/**
+ * @brief Obtiene la generacion actual del indice.
+ *
+ * @return Generacion, desde 1; solo crece.
+ */
+long obtenerGeneracionIndice() {
+    return atomic_load_explicit(&generacionIndice, memory_order_acquire);
+}
+
+/**
+ * @brief Marca que cambio el conjunto de palabras del indice.
+ */
+void avanzarVocabularioIndice() {
+    atomic_fetch_add_explicit(&vocabularioIndice, 1, memory_order_release);
+}
+
+/**
+ * @brief Obtiene la version actual del conjunto de palabras del indice.
+ *
+ * @return Version, desde 1; solo crece.
+ */
+long obtenerVocabularioIndice() {
+    return atomic_load_explicit(&vocabularioIndice, memory_order_acquire);
+}
+
+/**
+ * @brief Obtiene el uso de memoria de la arena del indice en memoria.
+ *
+ * @param estadisticas Salida.
+ */
+void obtenerEstadisticasMemoriaIndice(EstadisticasArena *estadisticas) {
+    memset(estadisticas, 0, sizeof(*estadisticas));
+    acumularEstadisticasArena(&arenaIndice, estadisticas);
+}
+
+/**
+ * @brief Calcula los bytes que reserva el indice en memoria.
+ *
+ * Los bufers de postings se cuentan con un total que se actualiza al ampliarlos y
+ * al liberarlos, asi que la cuenta no recorre las palabras.
+ *
+ * @return Bytes de la tabla hash, la arena, las palabras pendientes y las listas de postings.
+ */
+size_t memoriaIndiceEnMemoria() {
+    return capacidadTablaHash * sizeof(EntradaIndice) + arenaIndice.bytesReservados +
+           (size_t)capacidadTerminosPendientes * sizeof(NodoIndice *) + bytesListas;
+}
+
 /**
  * @brief Obtiene el total de palabras indexadas.
  *
  * @return Total de palabras indexadas en el sistema.
  */
 int totalPalabrasIndexadas() {
-    return palabrasIndexadas;
+    return palabrasIndexadas + totalPalabrasSnapshot();
 }
 
 /**
@@ -9,23 +9,178 @@
 #ifndef INDEX_H
 #define INDEX_H
 
-#define MAX_DOCS 100 ///< Numero maximo de documentos que pueden ser indexados.
-#define MAX_WORDS 1000 ///< Numero maximo de palabras que pueden ser indexadas.
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "roaring.h"
+
+#define POSTINGS_POR_BLOQUE 128 ///< Postings entre dos punteros de salto consecutivos.
+#define SEGMENTOS_DELTA 2 ///< Segmentos delta que puede combinar una lista de postings.
+#define CONJUNTO_DENSIDAD_MINIMA 64 ///< Una lista en 1 de cada 64 documentos o mas tiene tambien conjunto Roaring.
+#define CONJUNTO_MIN_DOCS ROARING_MAX_ARREGLO ///< Documentos que necesita como minimo una lista para usar el conjunto.
+
+/**
+ * @brief Segmento que contiene la version vigente de cada documento.
+ *
+ * Un posting de un segmento solo cuenta si el documento esta vigente en ese
+ * segmento; asi una actualizacion o un borrado invalida los postings anteriores
+ * sin reescribirlos.
+ */
+#define SEGMENTO_PRINCIPAL 0 ///< Indice principal (en memoria o instantanea).
+#define SEGMENTO_FUSION 1 ///< Delta que se esta fusionando con el principal.
+#define SEGMENTO_DELTA 2 ///< Delta que recibe los cambios nuevos.
+#define DOCUMENTO_ELIMINADO 3 ///< El documento fue borrado (lapida).
+
+/**
+ * @struct SaltoPosting
+ * @brief Puntero de salto al final de un bloque completo de postings.
+ *
+ * Permite reanudar la decodificacion al inicio del bloque siguiente sin leer
+ * los postings intermedios.
+ */
+typedef struct {
+    int32_t ultimoDocID; ///< Ultimo docID del bloque.
+    uint32_t offset; ///< Posicion, en bytes, donde empieza el bloque siguiente.
+} SaltoPosting;
+
+/**
+ * @struct PostingSimple
+ * @brief Posting sin comprimir de un segmento delta.
+ */
+typedef struct {
+    int32_t docID; ///< Documento.
+    int32_t frecuencia; ///< Apariciones de la palabra en el documento.
+    uint32_t offsetPosiciones; ///< Con el indice posicional: inicio de sus posiciones en el flujo de la palabra.
+} PostingSimple;
+
+/**
+ * @struct Documento
+ * @brief Entrada de la tabla de documentos.
+ *
+ * El nombre no se guarda en la entrada sino en un almacen comun de cadenas,
+ * de modo que cada nombre ocupa solo los bytes que necesita.
+ */
+typedef struct {
+    size_t offsetNombre; ///< Posicion del nombre dentro del almacen de nombres.
+    uint32_t longitud; ///< Palabras indexadas del documento, contando repeticiones.
+    uint32_t reservado; ///< Relleno, siempre 0.
+} Documento;
 
 /**
  * @struct NodoIndice
  * @brief Representa un nodo en el indice invertido.
  *
- * Cada nodo contiene una palabra clave, una lista de identificadores de documentos
- * en los que aparece y un puntero a la siguiente palabra en caso de colision.
+ * Cada nodo contiene una palabra clave, su longitud y su lista de postings. Los
+ * postings de documentos ya finalizados se guardan comprimidos como pares
+ * (diferencia de docID, frecuencia) codificados en varint; el documento en curso
+ * se acumula aparte hasta que se llama a finalizarDocumentoIndice(). Cada
+ * POSTINGS_POR_BLOQUE postings se registra un puntero de salto.
+ *
+ * Con el indice posicional, las posiciones de cada posting van en un flujo
+ * aparte, en el mismo orden que los postings, para que las busquedas que no las
+ * usan no las lean. Cada posting aporta tantos varint como su frecuencia: la
+ * primera posicion y luego la diferencia con la anterior.
+ *
+ * Si la palabra es frecuente, sus docID se guardan ademas como conjunto Roaring
+ * (ver conjuntoPostings()), que se arma al pedirlo y se descarta si la lista cambia.
  */
 typedef struct NodoIndice {
     char *palabra; ///< Palabra clave del nodo.
-    int docIDs[MAX_DOCS]; ///< Lista de identificadores de documentos donde aparece la palabra.
-    int conteoDocs; ///< Numero de documentos en los que aparece la palabra.
-    struct NodoIndice *siguiente; ///< Puntero al siguiente nodo en caso de colision.
+    size_t longitud; ///< Longitud de la palabra en bytes.
+    unsigned char *postings; ///< Postings comprimidos (varint de diferencia de docID y frecuencia).
+    size_t bytesPostings; ///< Bytes usados en el bufer de postings.
+    size_t capacidadPostings; ///< Bytes reservados en el bufer de postings.
+    SaltoPosting *saltos; ///< Punteros de salto, uno por bloque completo.
+    int numSaltos; ///< Numero de punteros de salto.
+    int capacidadSaltos; ///< Capacidad reservada de saltos.
+    int conteoDocs; ///< Numero de documentos finalizados en los que aparece la palabra.
+    int frecuenciaMaxima; ///< Mayor frecuencia de la palabra en un documento finalizado.
+    int ultimoDocID; ///< Ultimo docID codificado, base de la siguiente diferencia (-1 si no hay).
+    int docPendiente; ///< Documento en curso donde aparece la palabra (-1 si no hay).
+    int frecuenciaPendiente; ///< Apariciones de la palabra en el documento en curso.
+    unsigned char *posiciones; ///< Posiciones de cada posting (NULL sin indice posicional).
+    size_t bytesPosiciones; ///< Bytes usados en el bufer de posiciones.
+    size_t capacidadPosiciones; ///< Bytes reservados en el bufer de posiciones.
+    uint32_t *saltosPosiciones; ///< Offset en posiciones donde empieza cada bloque siguiente, paralelo a saltos.
+    _Atomic(ConjuntoRoaring *) conjunto; ///< docID de la lista comprimida como conjunto Roaring, o NULL si no se armo.
 } NodoIndice;
 
+/**
+ * @struct ListaPostings
+ * @brief Vista de solo lectura de la lista de postings de una palabra.
+ *
+ * Apunta a los datos sin copiarlos, ya sea a un NodoIndice en memoria o a una
+ * instantanea proyectada con mmap. Si hubo cambios incrementales, agrega los
+ * postings de los segmentos delta y el estado de cada documento, y el iterador
+ * combina todo en orden de docID.
+ */
+typedef struct {
+    const char *palabra; ///< Palabra (terminada en '\0').
+    size_t longitud; ///< Longitud de la palabra en bytes.
+    const unsigned char *datos; ///< Postings comprimidos.
+    size_t bytes; ///< Bytes de postings comprimidos.
+    int conteoDocs; ///< Numero de documentos en la lista.
+    const SaltoPosting *saltos; ///< Punteros de salto de la lista.
+    int numSaltos; ///< Numero de punteros de salto.
+    int frecuenciaMaxima; ///< Mayor frecuencia de la palabra en un documento.
+    const PostingSimple *deltas[SEGMENTOS_DELTA]; ///< Postings de SEGMENTO_FUSION y SEGMENTO_DELTA.
+    int numDeltas[SEGMENTOS_DELTA]; ///< Postings de cada segmento delta.
+    const unsigned char *estados; ///< Segmento vigente de cada documento, o NULL sin cambios incrementales.
+    int numEstados; ///< Entradas de estados; los documentos posteriores estan en el principal.
+    const unsigned char *posiciones; ///< Posiciones de los postings comprimidos, o NULL sin indice posicional.
+    size_t bytesPosiciones; ///< Bytes de posiciones de los postings comprimidos.
+    const uint32_t *saltosPosiciones; ///< Inicio en posiciones de cada bloque siguiente (uno por salto).
+    const unsigned char *posicionesDeltas[SEGMENTOS_DELTA]; ///< Flujos de posiciones de los segmentos delta.
+    _Atomic(ConjuntoRoaring *) *conjunto; ///< Donde se guarda el conjunto Roaring de la lista comprimida, o NULL.
+} ListaPostings;
+
+/**
+ * @struct IteradorPostings
+ * @brief Cursor de lectura sobre la lista de postings comprimida de una palabra.
+ */
+typedef struct {
+    const unsigned char *inicio; ///< Inicio de los datos comprimidos.
+    const unsigned char *actual; ///< Proxima posicion a decodificar.
+    const unsigned char *fin; ///< Fin de los datos comprimidos.
+    const SaltoPosting *saltos; ///< Punteros de salto de la lista.
+    int numSaltos; ///< Numero de punteros de salto.
+    int leidos; ///< Postings decodificados hasta ahora.
+    int docComprimido; ///< Ultimo docID decodificado de la lista comprimida.
+    int frecuenciaComprimida; ///< Frecuencia del ultimo posting decodificado.
+    const PostingSimple *deltas[SEGMENTOS_DELTA]; ///< Postings de los segmentos delta.
+    int numDeltas[SEGMENTOS_DELTA]; ///< Postings de cada segmento delta.
+    int posDeltas[SEGMENTOS_DELTA]; ///< Proximo posting sin consumir de cada segmento delta.
+    const unsigned char *estados; ///< Segmento vigente de cada documento, o NULL.
+    int numEstados; ///< Entradas de estados.
+    int cabeza[1 + SEGMENTOS_DELTA]; ///< Proximo docID sin consumir de cada segmento (con estados).
+    int docID; ///< Documento del posting actual.
+    int frecuencia; ///< Apariciones de la palabra en el documento actual.
+    int segmento; ///< Segmento del posting actual (solo con estados).
+    int indice; ///< Posicion del posting actual dentro de su segmento (solo con estados).
+    const unsigned char *posiciones; ///< Posiciones de la lista comprimida, o NULL.
+    const uint32_t *saltosPosiciones; ///< Inicio en posiciones de cada bloque siguiente.
+    const unsigned char *posicionesDeltas[SEGMENTOS_DELTA]; ///< Flujos de posiciones de los segmentos delta.
+    int bloqueBase; ///< Bloque de la lista comprimida desde el que se cuenta frecuenciaBase.
+    uint32_t frecuenciaBase; ///< Suma de las frecuencias decodificadas desde el inicio de bloqueBase.
+    int bloquePosting; ///< bloqueBase del posting actual (solo con estados).
+    uint32_t previasPosting; ///< Posiciones entre el inicio de bloquePosting y las del posting actual (con estados).
+    const unsigned char *cursorPosiciones; ///< Cursor sobre las posiciones de la lista comprimida.
+    int cursorBloque; ///< Bloque en el que esta el cursor.
+    uint32_t cursorPrevias; ///< Posiciones entre el inicio de cursorBloque y el cursor.
+} IteradorPostings;
+
+/**
+ * @struct EntradaIndice
+ * @brief Ranura de la tabla hash de direccionamiento abierto.
+ *
+ * Guarda el hash completo de la palabra junto al puntero al nodo, de modo que
+ * la mayoria de las comparaciones fallidas se descartan sin acceder al nodo.
+ */
+typedef struct {
+    uint64_t hash; ///< Hash de 64 bits de la palabra almacenada.
+    NodoIndice *nodo; ///< Nodo asociado, o NULL si la ranura esta vacia.
+} EntradaIndice;
+
 /**
  * @brief Inicializa la estructura del indice invertido.
  *
@@ -33,11 +188,47 @@ typedef struct NodoIndice {
  */
 void inicializarIndice();
 
+/**
+ * @brief Vacia el indice en memoria conservando la capacidad de la tabla hash.
+ *
+ * Pensada para quien llena y vacia el indice varias veces, como la carga en
+ * memoria externa (ver externo.h). No toca la tabla de documentos.
+ */
+void vaciarIndice();
+
+/**
+ * @brief Calcula el hash de 64 bits de una palabra.
+ *
+ * @param palabra Palabra a la cual calcular el hash.
+ * @param longitud Longitud de la palabra en bytes.
+ * @return Hash de 64 bits de la palabra.
+ */
+uint64_t calcularHash(const char *palabra, size_t longitud);
+
+/**
+ * @brief Activa o desactiva el indice posicional.
+ *
+ * Con el indice posicional cada posting guarda ademas las posiciones de la
+ * palabra en el documento, lo que permite buscar frases y palabras cercanas.
+ * Debe fijarse antes de cargar documentos o abrir una instantanea.
+ *
+ * @param activar 1 para guardar las posiciones, 0 para no guardarlas.
+ */
+void activarIndicePosicional(int activar);
+
+/**
+ * @brief Indica si el indice guarda posiciones.
+ *
+ * @return 1 si el indice posicional esta activado, 0 si no.
+ */
+int indicePosicionalActivado();
+
 /**
  * @brief Agrega una palabra al indice junto con su identificador de documento.
  *
  * Si la palabra ya existe en el indice, se agrega el identificador del documento
- * a la lista correspondiente.
+ * a la lista correspondiente. No registra posiciones, asi que no debe usarse con
+ * el indice posicional.
  *
  * @param palabra Palabra a indexar.
  * @param docID Identificador del documento donde aparece la palabra.
@@ -45,34 +236,270 @@ void inicializarIndice();
 void agregarPalabraIndice(const char *palabra, int docID);
 
 /**
- * @brief Busca documentos que contienen una palabra clave especifica.
+ * @brief Suma apariciones de una palabra en un documento, con el hash ya calculado.
+ *
+ * Variante de agregarPalabraIndice() para quien ya agrupo las apariciones de cada
+ * palabra del documento, por ejemplo la carga en paralelo. Con el indice
+ * posicional, cada palabra debe recibir una sola llamada por documento con todas
+ * sus posiciones.
+ *
+ * @param palabra Palabra a agregar (no necesita terminar en '\0').
+ * @param longitud Longitud de la palabra en bytes.
+ * @param hash Hash de la palabra obtenido con calcularHash().
+ * @param docID Identificador del documento donde aparece la palabra.
+ * @param frecuencia Numero de apariciones a sumar.
+ * @param posiciones Posiciones de las apariciones en orden creciente (frecuencia
+ *                   elementos), o NULL sin indice posicional.
+ */
+void agregarPostingIndice(const char *palabra, size_t longitud, uint64_t hash, int docID, int frecuencia,
+                          const uint32_t *posiciones);
+
+/**
+ * @brief Cierra el documento en curso en todas las palabras que aparecieron en el.
+ *
+ * Codifica en las listas comprimidas el par (docID, frecuencia) acumulado de cada
+ * palabra tocada desde la ultima llamada. Debe llamarse al terminar cada documento,
+ * y los documentos deben agregarse con docID crecientes. Avanza la generacion del
+ * indice (ver avanzarGeneracionIndice()); agregarDocumento() y agregarPostingIndice()
+ * no la avanzan.
+ */
+void finalizarDocumentoIndice();
+
+/**
+ * @brief Crea un nodo de indice vacio para una palabra.
  *
- * Imprime los documentos que contienen la palabra, junto con sus valores de PageRank.
+ * El nodo y la palabra se reservan juntos en la arena; solo las listas de
+ * postings, que crecen, van al heap.
  *
- * @param consulta Palabra clave a buscar en el indice.
+ * @param arena Arena donde se reserva el nodo.
+ * @param palabra Palabra (no necesita terminar en '\0').
+ * @param longitud Longitud de la palabra en bytes.
+ * @return Nodo nuevo; termina el programa si no hay memoria.
  */
-void buscarDocumentos(const char *consulta);
+NodoIndice *crearNodoIndice(Arena *arena, const char *palabra, size_t longitud);
 
 /**
- * @brief Determina si una palabra es una stopword.
+ * @brief Agrega un posting al final de la lista comprimida de un nodo.
+ *
+ * No toca la tabla hash ni las longitudes de los documentos; sirve para armar
+ * listas nuevas, por ejemplo al fusionar segmentos.
  *
- * Las stopwords son palabras comunes que no se indexan, como "el", "la", "y".
+ * @param nodo Nodo de destino.
+ * @param docID Documento, mayor que el ultimo de la lista.
+ * @param frecuencia Apariciones de la palabra en el documento.
+ * @param posiciones Posiciones ya codificadas (ver codificarPosiciones()) que se
+ *                   copian al flujo del nodo, o NULL si no hay que copiar ninguna.
+ * @param bytesPosiciones Bytes de posiciones.
+ */
+void agregarPostingNodo(NodoIndice *nodo, int docID, int frecuencia, const unsigned char *posiciones,
+                        size_t bytesPosiciones);
+
+/**
+ * @brief Codifica las posiciones de un posting.
  *
- * @param palabra Palabra a verificar.
- * @return 1 si la palabra es una stopword, 0 en caso contrario.
+ * @param posiciones Posiciones en orden creciente.
+ * @param cantidad Numero de posiciones.
+ * @param destino Bufer de al menos 5 * cantidad bytes.
+ * @return Bytes escritos.
  */
-int esStopword(const char *palabra);
+size_t codificarPosiciones(const uint32_t *posiciones, int cantidad, unsigned char *destino);
+
+/**
+ * @brief Calcula cuantos bytes ocupan las posiciones codificadas de un posting.
+ *
+ * @param datos Posiciones codificadas.
+ * @param cantidad Numero de posiciones (la frecuencia del posting).
+ * @return Bytes que ocupan.
+ */
+size_t largoPosiciones(const unsigned char *datos, int cantidad);
+
+/**
+ * @brief Decodifica las posiciones de un posting.
+ *
+ * @param datos Posiciones codificadas.
+ * @param cantidad Numero de posiciones (la frecuencia del posting).
+ * @param destino Salida: cantidad posiciones en orden creciente.
+ */
+void decodificarPosiciones(const unsigned char *datos, int cantidad, uint32_t *destino);
+
+/**
+ * @brief Libera los postings de un nodo de indice.
+ *
+ * El nodo en si pertenece a su arena y se libera con ella.
+ *
+ * @param nodo Nodo cuyos postings se liberan (puede ser NULL).
+ */
+void liberarNodoIndice(NodoIndice *nodo);
+
+/**
+ * @brief Reemplaza el indice en memoria por un conjunto de nodos ya armados.
+ *
+ * Libera los nodos anteriores, con su arena, y construye una tabla hash nueva
+ * con los dados, que pasan a pertenecer al indice junto con la arena donde se
+ * crearon.
+ *
+ * @param nodos Nodos del nuevo indice, con palabras distintas.
+ * @param numNodos Numero de nodos.
+ * @param arena Arena de los nodos; el indice se queda con sus bloques y la deja vacia.
+ */
+void reemplazarIndice(NodoIndice **nodos, int numNodos, Arena *arena);
+
+/**
+ * @brief Busca la lista de postings de una palabra.
+ *
+ * Consulta primero el indice en memoria y luego la instantanea cargada, si la hay,
+ * y agrega los postings de los segmentos delta. Quien use la lista debe tener
+ * tomado el candado del indice (ver bloquearIndiceLectura()).
+ *
+ * @param palabra Palabra a buscar.
+ * @param lista Salida: vista de la lista de postings.
+ * @return 1 si la palabra esta indexada, 0 en caso contrario.
+ */
+int buscarPostings(const char *palabra, ListaPostings *lista);
+
+/**
+ * @brief Recorre todas las palabras del indice en memoria.
+ *
+ * @param visitar Funcion llamada con la lista de postings de cada palabra.
+ * @param contexto Puntero que se pasa sin cambios a visitar.
+ */
+void recorrerIndice(void (*visitar)(const ListaPostings *lista, void *contexto), void *contexto);
+
+/**
+ * @brief Prepara un iterador sobre una lista de postings.
+ *
+ * @param it Iterador a inicializar.
+ * @param lista Lista de postings a recorrer.
+ */
+void iniciarIteradorPostings(IteradorPostings *it, const ListaPostings *lista);
+
+/**
+ * @brief Avanza el iterador al siguiente posting.
+ *
+ * @param it Iterador de postings.
+ * @return 1 si se decodifico un posting (disponible en it->docID y it->frecuencia), 0 al final.
+ */
+int siguientePosting(IteradorPostings *it);
+
+/**
+ * @brief Avanza el iterador hasta el primer posting con docID mayor o igual al indicado.
+ *
+ * Usa busqueda exponencial sobre los punteros de salto para saltar bloques
+ * completos y decodifica solo el bloque donde puede estar el documento.
+ *
+ * @param it Iterador de postings.
+ * @param docID Documento objetivo.
+ * @return 1 si quedo posicionado en un posting con docID >= objetivo, 0 si la lista se agoto.
+ */
+int avanzarPosting(IteradorPostings *it, int docID);
+
+/**
+ * @brief Devuelve los docID de una lista frecuente como conjunto Roaring.
+ *
+ * Las palabras que estan en al menos uno de cada CONJUNTO_DENSIDAD_MINIMA
+ * documentos (y en CONJUNTO_MIN_DOCS o mas) guardan, junto a su lista
+ * comprimida, sus docID en contenedores Roaring: los tramos densos como mapas de
+ * bits y los demas como arreglos ordenados (ver roaring.h). Asi una consulta
+ * booleana combina palabras frecuentes con operaciones de conjuntos en lugar de
+ * recorrer sus listas de a un posting. El conjunto se arma la primera vez que se
+ * pide, recorriendo la lista, y queda con ella hasta que se libera o cambia. Las
+ * frecuencias y las posiciones siguen solo en la lista comprimida.
+ *
+ * Requiere el candado del indice, como la lista.
+ *
+ * @param lista Lista obtenida con buscarPostings().
+ * @return Conjunto de la lista (no liberar), o NULL si la lista es poco frecuente
+ *         o tiene cambios incrementales, que el conjunto no refleja.
+ */
+const ConjuntoRoaring *conjuntoPostings(const ListaPostings *lista);
+
+/**
+ * @brief Libera el conjunto Roaring guardado en una ranura y la deja vacia.
+ *
+ * Para quien guarda ranuras de conjuntos fuera de los nodos, como la instantanea.
+ *
+ * @param ranura Ranura del conjunto.
+ */
+void descartarConjuntoPostings(_Atomic(ConjuntoRoaring *) *ranura);
+
+/**
+ * @brief Informa los conjuntos Roaring armados para las listas frecuentes.
+ *
+ * @param conjuntos Salida: conjuntos vivos (puede ser NULL).
+ * @return Bytes que ocupan.
+ */
+size_t memoriaConjuntosPostings(int *conjuntos);
+
+/**
+ * @brief Devuelve las posiciones codificadas del posting actual del iterador.
+ *
+ * En la lista comprimida las posiciones se buscan recien al pedirlas: se parte
+ * del ultimo posting leido o del inicio del bloque, asi que recorrer la lista
+ * sin pedirlas no cuesta nada.
+ *
+ * @param it Iterador posicionado en un posting.
+ * @param bytes Salida: bytes de las posiciones.
+ * @return Posiciones codificadas (decodificar con decodificarPosiciones() y
+ *         it->frecuencia), o NULL si la lista no tiene posiciones.
+ */
+const unsigned char *posicionesPosting(IteradorPostings *it, size_t *bytes);
 
 /**
  * @brief Agrega un documento al sistema.
  *
- * Almacena el nombre del documento y lo registra en el indice global.
+ * Almacena el nombre del documento y lo registra en el indice global. No avanza
+ * la generacion del indice: lo hace quien termina de indexarlo, con
+ * finalizarDocumentoIndice() o establecerLongitudDocumento().
  *
  * @param docID Identificador del documento.
  * @param nombre Nombre del archivo del documento.
  */
 void agregarDocumento(int docID, const char *nombre);
 
+/**
+ * @brief Obtiene el nombre de archivo de un documento.
+ *
+ * @param docID Identificador del documento.
+ * @return Nombre del documento, o NULL si el docID no esta registrado.
+ */
+const char *obtenerNombreDocumento(int docID);
+
+/**
+ * @brief Obtiene la longitud de un documento.
+ *
+ * @param docID Identificador del documento.
+ * @return Palabras indexadas del documento (con repeticiones), o 0 si no esta registrado.
+ */
+int obtenerLongitudDocumento(int docID);
+
+/**
+ * @brief Cambia la longitud registrada de un documento.
+ *
+ * @param docID Identificador del documento.
+ * @param longitud Palabras indexadas del documento, contando repeticiones.
+ */
+void establecerLongitudDocumento(int docID, int longitud);
+
+/**
+ * @brief Obtiene la longitud promedio de los documentos cargados.
+ *
+ * @return Promedio de palabras indexadas por documento, o 0 si no hay documentos.
+ */
+double longitudPromedioDocumentos();
+
+/**
+ * @brief Usa una tabla de documentos externa, sin copiarla.
+ *
+ * Pensada para la instantanea proyectada con mmap. Si despues se agrega un
+ * documento, la tabla se copia al heap antes de modificarla.
+ *
+ * @param tabla Tabla de documentos.
+ * @param numDocs Numero de entradas de la tabla.
+ * @param nombres Almacen de nombres al que apuntan los offsets de la tabla.
+ * @param bytes Bytes del almacen de nombres.
+ */
+void usarTablaDocumentosExterna(const Documento *tabla, int numDocs, const char *nombres, size_t bytes);
+
 /**
  * @brief Abre un documento especificado por su nombre.
  *
@@ -83,6 +510,64 @@ void agregarDocumento(int docID, const char *nombre);
  */
 void abrirDocumento(const char *nombreArchivo);
 
+/**
+ * @brief Marca que cambio el contenido visible para las consultas.
+ *
+ * La llaman las funciones de este archivo que terminan un cambio del indice o de
+ * la tabla de documentos, una vez por documento o por reemplazo completo, y quien
+ * publica un PageRank nuevo. Las caches de resultados
+ * comparan la generacion para saber si un resultado guardado sigue valiendo.
+ */
+void avanzarGeneracionIndice();
+
+/**
+ * @brief Obtiene la generacion actual del indice.
+ *
+ * Quien guarda un resultado debe leerla antes de calcularlo; si el indice cambia
+ * durante el calculo, la generacion leida ya no es la vigente.
+ *
+ * @return Generacion, desde 1; solo crece.
+ */
+long obtenerGeneracionIndice();
+
+/**
+ * @brief Marca que cambio el conjunto de palabras del indice.
+ *
+ * La llaman quienes agregan una palabra nueva al indice en memoria o a un segmento
+ * delta, quienes vacian o reemplazan el indice y quien abre o descarta una
+ * instantanea. Cambiar los postings o el PageRank no la avanza, asi que el
+ * diccionario ordenado no se vuelve a armar por eso.
+ */
+void avanzarVocabularioIndice();
+
+/**
+ * @brief Obtiene la version actual del conjunto de palabras del indice.
+ *
+ * @return Version, desde 1; solo crece.
+ */
+long obtenerVocabularioIndice();
+
+/**
+ * @brief Obtiene el uso de memoria de la arena del indice en memoria.
+ *
+ * Cuenta los nodos y las palabras; las listas de postings no se incluyen.
+ *
+ * @param estadisticas Salida.
+ */
+void obtenerEstadisticasMemoriaIndice(EstadisticasArena *estadisticas);
+
+/**
+ * @brief Calcula los bytes que reserva el indice en memoria.
+ *
+ * A diferencia de obtenerEstadisticasMemoriaIndice(), incluye los bufers de las
+ * listas de postings, saltos y posiciones (tambien los de los nodos que arma una
+ * fusion de segmentos antes de pasarlos al indice). No incluye la tabla de
+ * documentos ni la instantanea proyectada.
+ *
+ * @return Bytes reservados.
+ */
+size_t memoriaIndiceEnMemoria();
+
 /**
  * @brief Devuelve el total de palabras indexadas en el sistema.
  *
@@ -0,0 +1,567 @@
+/**
+ * @file ingesta.c
+ * @brief Implementacion de la carga en paralelo de documentos.
+ *
+ * Los hilos de lectura toman archivos en orden, los proyectan con mmap y arman su
+ * indice parcial sin tocar el estado global. El hilo principal fusiona los
+ * documentos parciales en el indice y el grafo estrictamente en orden, asi los
+ * docID y las listas de postings quedan iguales con cualquier numero de hilos.
+ */
+
+#include "ingesta.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "enlaces.h"
+#include "index.h"
+#include "graph.h"
+#include "instrumentacion.h"
+#include "tokenizador.h"
+
+/**
+ * @struct ColaIngesta
+ * @brief Estado compartido entre los hilos de lectura y el hilo que fusiona.
+ *
+ * Los documentos parciales viven en un anillo de tamano ventana: un hilo solo puede
+ * tomar el archivo i cuando el archivo i - ventana ya fue fusionado.
+ */
+typedef struct {
+    char **rutas; ///< Rutas de los archivos, ordenadas por nombre.
+    int numArchivos; ///< Numero de archivos.
+    DocumentoParcial *anillo; ///< Documentos parciales en proceso.
+    int *listos; ///< 1 si el documento del anillo ya fue procesado.
+    int ventana; ///< Tamano del anillo.
+    int siguiente; ///< Proximo archivo a tomar por un hilo de lectura.
+    int fusionados; ///< Archivos ya fusionados en el indice global.
+    pthread_mutex_t mutex; ///< Protege los campos anteriores.
+    pthread_cond_t cambio; ///< Avisa de documentos listos o fusionados.
+} ColaIngesta;
+
+/**
+ * @brief Reserva o amplia un arreglo, terminando el programa si no hay memoria.
+ *
+ * @param bloque Arreglo actual (puede ser NULL).
+ * @param bytes Nuevo tamano en bytes.
+ * @return Arreglo ampliado.
+ */
+static void *ampliar(void *bloque, size_t bytes) {
+    void *nuevo = realloc(bloque, bytes);
+    if (!nuevo) {
+        perror("No se pudo reservar memoria durante la carga");
+        exit(EXIT_FAILURE);
+    }
+    return nuevo;
+}
+
+/**
+ * @brief Duplica la tabla hash local de un documento parcial.
+ *
+ * @param parcial Documento parcial.
+ */
+static void redimensionarRanuras(DocumentoParcial *parcial) {
+    size_t capacidad = parcial->capacidadRanuras ? parcial->capacidadRanuras * 2 : 256;
+    int *ranuras = calloc(capacidad, sizeof(int));
+    if (!ranuras) {
+        perror("No se pudo reservar memoria durante la carga");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < parcial->numTerminos; t++) {
+        size_t i = (size_t)parcial->terminos[t].hash & (capacidad - 1);
+        while (ranuras[i]) {
+            i = (i + 1) & (capacidad - 1);
+        }
+        ranuras[i] = t + 1;
+    }
+    free(parcial->ranuras);
+    parcial->ranuras = ranuras;
+    parcial->capacidadRanuras = capacidad;
+}
+
+/**
+ * @brief Cuenta una aparicion de una palabra en el documento parcial.
+ *
+ * @param parcial Documento parcial.
+ * @param palabra Palabra ya normalizada.
+ * @param longitud Longitud de la palabra.
+ * @return Indice de la palabra en parcial->terminos.
+ */
+static int contarPalabra(DocumentoParcial *parcial, const char *palabra, size_t longitud) {
+    if ((size_t)(parcial->numTerminos + 1) * 10 > parcial->capacidadRanuras * 7) {
+        redimensionarRanuras(parcial);
+    }
+    uint64_t hash = calcularHash(palabra, longitud);
+    size_t mascara = parcial->capacidadRanuras - 1;
+    size_t i = (size_t)hash & mascara;
+    while (parcial->ranuras[i]) {
+        TerminoParcial *termino = &parcial->terminos[parcial->ranuras[i] - 1];
+        if (termino->hash == hash && termino->longitud == longitud &&
+            memcmp(parcial->texto + termino->offset, palabra, longitud) == 0) {
+            termino->frecuencia++;
+            return parcial->ranuras[i] - 1;
+        }
+        i = (i + 1) & mascara;
+    }
+
+    if (parcial->numTerminos == parcial->capacidadTerminos) {
+        parcial->capacidadTerminos = parcial->capacidadTerminos ? parcial->capacidadTerminos * 2 : 128;
+        parcial->terminos = ampliar(parcial->terminos, parcial->capacidadTerminos * sizeof(TerminoParcial));
+    }
+    if (parcial->bytesTexto + longitud + 1 > parcial->capacidadTexto) {
+        size_t capacidad = parcial->capacidadTexto ? parcial->capacidadTexto : 4096;
+        while (capacidad < parcial->bytesTexto + longitud + 1) {
+            capacidad *= 2;
+        }
+        parcial->texto = ampliar(parcial->texto, capacidad);
+        parcial->capacidadTexto = capacidad;
+    }
+
+    TerminoParcial *termino = &parcial->terminos[parcial->numTerminos];
+    termino->hash = hash;
+    termino->offset = parcial->bytesTexto;
+    termino->longitud = longitud;
+    termino->frecuencia = 1;
+    memcpy(parcial->texto + parcial->bytesTexto, palabra, longitud);
+    parcial->texto[parcial->bytesTexto + longitud] = '\0';
+    parcial->bytesTexto += longitud + 1;
+    parcial->ranuras[i] = ++parcial->numTerminos;
+    return parcial->numTerminos - 1;
+}
+
+/**
+ * @brief Anota el destino de un token de enlace.
+ *
+ * Si el destino son solo digitos es un numero de documento; si no, el nombre de
+ * un archivo. Los numeros que no entran en un int se anotan como -1, que la
+ * validacion descarta.
+ *
+ * @param parcial Documento parcial.
+ * @param destino Texto despues de "link:".
+ * @param longitud Longitud del destino (mayor que 0).
+ */
+static void anotarEnlace(DocumentoParcial *parcial, const char *destino, size_t longitud) {
+    long long numero = 0;
+    size_t i = 0;
+    while (i < longitud && (unsigned)(destino[i] - '0') < 10) {
+        if (numero <= INT_MAX) {
+            numero = numero * 10 + (destino[i] - '0');
+        }
+        i++;
+    }
+    if (i == longitud) {
+        if (parcial->numEnlaces == parcial->capacidadEnlaces) {
+            parcial->capacidadEnlaces = parcial->capacidadEnlaces ? parcial->capacidadEnlaces * 2 : 16;
+            parcial->enlaces = ampliar(parcial->enlaces, parcial->capacidadEnlaces * sizeof(int));
+        }
+        parcial->enlaces[parcial->numEnlaces++] = numero <= INT_MAX ? (int)numero : -1;
+        return;
+    }
+    if (parcial->bytesNombresEnlaces + longitud + 1 > parcial->capacidadNombresEnlaces) {
+        size_t capacidad = parcial->capacidadNombresEnlaces ? parcial->capacidadNombresEnlaces : 256;
+        while (capacidad < parcial->bytesNombresEnlaces + longitud + 1) {
+            capacidad *= 2;
+        }
+        parcial->nombresEnlaces = ampliar(parcial->nombresEnlaces, capacidad);
+        parcial->capacidadNombresEnlaces = capacidad;
+    }
+    memcpy(parcial->nombresEnlaces + parcial->bytesNombresEnlaces, destino, longitud);
+    parcial->nombresEnlaces[parcial->bytesNombresEnlaces + longitud] = '\0';
+    parcial->bytesNombresEnlaces += longitud + 1;
+    parcial->numNombresEnlaces++;
+}
+
+/**
+ * @brief Procesa una palabra del documento: la cuenta y detecta enlaces.
+ *
+ * Con el indice posicional anota ademas el termino de cada token; las stopwords
+ * tambien ocupan una posicion, para que las frases las respeten.
+ *
+ * @param parcial Documento parcial.
+ * @param palabra Palabra normalizada por el tokenizador.
+ * @param longitud Longitud de la palabra (como maximo INGESTA_LARGO_PALABRA).
+ * @param posicional 1 si hay que anotar la posicion del token.
+ */
+static void procesarPalabra(DocumentoParcial *parcial, const char *palabra, size_t longitud, int posicional) {
+    uint32_t termino = UINT32_MAX;
+    if (!esStopword(palabra, longitud)) {
+        termino = (uint32_t)contarPalabra(parcial, palabra, longitud);
+    }
+    if (posicional) {
+        if (parcial->numTokens == parcial->capacidadSecuencia) {
+            parcial->capacidadSecuencia = parcial->capacidadSecuencia ? parcial->capacidadSecuencia * 2 : 256;
+            parcial->secuencia = ampliar(parcial->secuencia, parcial->capacidadSecuencia * sizeof(uint32_t));
+        }
+        parcial->secuencia[parcial->numTokens] = termino;
+    }
+    parcial->numTokens++;
+    if (longitud > 5 && strncmp(palabra, "link:", 5) == 0) {
+        anotarEnlace(parcial, palabra + 5, longitud - 5);
+    }
+}
+
+/**
+ * @brief Agrupa por termino las posiciones anotadas en la secuencia de tokens.
+ *
+ * Es un ordenamiento por conteo: las posiciones de cada termino quedan
+ * contiguas y en orden creciente, a partir de su primeraPosicion.
+ *
+ * @param parcial Documento parcial ya procesado.
+ */
+static void agruparPosiciones(DocumentoParcial *parcial) {
+    int total = 0;
+    for (int t = 0; t < parcial->numTerminos; t++) {
+        parcial->terminos[t].primeraPosicion = total;
+        total += parcial->terminos[t].frecuencia;
+    }
+    parcial->posiciones = ampliar(NULL, (size_t)(total ? total : 1) * sizeof(uint32_t));
+    for (int p = 0; p < parcial->numTokens; p++) {
+        uint32_t termino = parcial->secuencia[p];
+        if (termino != UINT32_MAX) {
+            parcial->posiciones[parcial->terminos[termino].primeraPosicion++] = (uint32_t)p;
+        }
+    }
+    for (int t = 0; t < parcial->numTerminos; t++) {
+        parcial->terminos[t].primeraPosicion -= parcial->terminos[t].frecuencia;
+    }
+    free(parcial->secuencia);
+    parcial->secuencia = NULL;
+    parcial->capacidadSecuencia = 0;
+}
+
+/**
+ * @brief Procesa un archivo y arma su indice parcial.
+ *
+ * Recorre el archivo proyectado con el tokenizador; las palabras de mas de
+ * INGESTA_LARGO_PALABRA bytes se parten en trozos de ese largo.
+ *
+ * @param ruta Ruta del archivo.
+ * @param parcial Documento parcial a llenar; debe estar en cero.
+ */
+void procesarArchivo(const char *ruta, DocumentoParcial *parcial) {
+    INSTRUMENTAR_INICIO(inicio);
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0) {
+        parcial->error = errno;
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        parcial->error = errno;
+        close(fd);
+        return;
+    }
+    if (info.st_size == 0) {
+        close(fd);
+        return;
+    }
+
+    size_t tamano = (size_t)info.st_size;
+    const char *datos = mmap(NULL, tamano, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (datos == MAP_FAILED) {
+        parcial->error = errno;
+        return;
+    }
+    madvise((void *)datos, tamano, MADV_SEQUENTIAL);
+
+    Tokenizador t;
+    char palabra[INGESTA_LARGO_PALABRA + 1];
+    size_t longitud;
+    int posicional = indicePosicionalActivado();
+    iniciarTokenizador(&t, datos, tamano);
+    while ((longitud = siguienteToken(&t, palabra)) > 0) {
+        procesarPalabra(parcial, palabra, longitud, posicional);
+    }
+    munmap((void *)datos, tamano);
+    if (posicional) {
+        agruparPosiciones(parcial);
+    }
+    INSTRUMENTAR_CONTADOR(CONTADOR_ARCHIVOS_LEIDOS, 1);
+    INSTRUMENTAR_CONTADOR(CONTADOR_BYTES_LEIDOS, tamano);
+    INSTRUMENTAR_FIN(TIEMPO_PROCESAR_ARCHIVO, inicio);
+}
+
+/**
+ * @brief Libera la memoria de un documento parcial y lo deja en cero.
+ *
+ * @param parcial Documento parcial a liberar.
+ */
+void liberarDocumentoParcial(DocumentoParcial *parcial) {
+    free(parcial->texto);
+    free(parcial->terminos);
+    free(parcial->ranuras);
+    free(parcial->enlaces);
+    free(parcial->nombresEnlaces);
+    free(parcial->secuencia);
+    free(parcial->posiciones);
+    memset(parcial, 0, sizeof(*parcial));
+}
+
+/**
+ * @brief Fusiona un documento parcial en el indice global y anota sus enlaces.
+ *
+ * @param ruta Ruta del archivo, usada como nombre del documento.
+ * @param parcial Documento parcial procesado.
+ * @param docID Identificador asignado al documento.
+ * @return 1 si el documento se agrego, 0 si el archivo no se pudo leer.
+ */
+static int fusionarDocumento(const char *ruta, const DocumentoParcial *parcial, int docID) {
+    printf("Procesando archivo: %s\n", ruta);
+    if (parcial->error) {
+        errno = parcial->error;
+        perror("No se pudo abrir el archivo");
+        return 0;
+    }
+
+    INSTRUMENTAR_INICIO(inicio);
+    agregarDocumento(docID, ruta);
+    asegurarDocumentosGrafo(docID + 1);
+    for (int t = 0; t < parcial->numTerminos; t++) {
+        const TerminoParcial *termino = &parcial->terminos[t];
+        agregarPostingIndice(parcial->texto + termino->offset, termino->longitud, termino->hash,
+                             docID, termino->frecuencia,
+                             parcial->posiciones ? parcial->posiciones + termino->primeraPosicion : NULL);
+    }
+    finalizarDocumentoIndice();
+    recolectarEnlaces(docID, parcial);
+    INSTRUMENTAR_FIN(TIEMPO_FUSIONAR_DOCUMENTO, inicio);
+    return 1;
+}
+
+/**
+ * @brief Cuerpo de cada hilo de lectura.
+ *
+ * Toma el siguiente archivo mientras quede lugar en el anillo, lo procesa fuera
+ * del candado y avisa al hilo principal cuando termina.
+ *
+ * @param argumento Puntero a la ColaIngesta.
+ * @return NULL.
+ */
+static void *ejecutarHiloIngesta(void *argumento) {
+    ColaIngesta *cola = argumento;
+    for (;;) {
+        pthread_mutex_lock(&cola->mutex);
+        while (cola->siguiente < cola->numArchivos && cola->siguiente >= cola->fusionados + cola->ventana) {
+            pthread_cond_wait(&cola->cambio, &cola->mutex);
+        }
+        if (cola->siguiente >= cola->numArchivos) {
+            pthread_mutex_unlock(&cola->mutex);
+            return NULL;
+        }
+        int i = cola->siguiente++;
+        pthread_mutex_unlock(&cola->mutex);
+
+        procesarArchivo(cola->rutas[i], &cola->anillo[i % cola->ventana]);
+
+        pthread_mutex_lock(&cola->mutex);
+        cola->listos[i % cola->ventana] = 1;
+        pthread_cond_broadcast(&cola->cambio);
+        pthread_mutex_unlock(&cola->mutex);
+    }
+}
+
+/**
+ * @brief Compara dos rutas para ordenarlas con qsort.
+ *
+ * @param a Puntero a la primera ruta.
+ * @param b Puntero a la segunda ruta.
+ * @return Resultado de strcmp entre ambas rutas.
+ */
+static int compararRutas(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/**
+ * @brief Lista los archivos .txt de un directorio ordenados por nombre.
+ *
+ * @param directorio Directorio a recorrer.
+ * @param numArchivos Salida: numero de archivos encontrados.
+ * @return Arreglo de rutas (directorio/nombre), o NULL si el directorio no se pudo abrir.
+ */
+char **listarArchivos(const char *directorio, int *numArchivos) {
+    DIR *dir;
+    struct dirent *entry;
+    char **rutas = NULL;
+    int capacidad = 0;
+
+    *numArchivos = 0;
+    if ((dir = opendir(directorio)) == NULL) {
+        perror("No se pudo abrir el directorio");
+        return NULL;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        if (strstr(entry->d_name, ".txt") != NULL) {
+            if (*numArchivos == capacidad) {
+                capacidad = capacidad ? capacidad * 2 : 256;
+                rutas = ampliar(rutas, capacidad * sizeof(char *));
+            }
+            size_t largo = strlen(directorio) + strlen(entry->d_name) + 2;
+            char *ruta = ampliar(NULL, largo);
+            snprintf(ruta, largo, "%s/%s", directorio, entry->d_name);
+            rutas[(*numArchivos)++] = ruta;
+        }
+    }
+    closedir(dir);
+    if (*numArchivos > 1) {
+        qsort(rutas, *numArchivos, sizeof(char *), compararRutas);
+    }
+    return rutas;
+}
+
+/**
+ * @brief Calcula una firma del contenido de un directorio de documentos.
+ *
+ * Recorre los archivos en el mismo orden en que se cargan, de modo que la firma
+ * cambia si se agrega, borra, renombra o modifica cualquiera de ellos. Incluye la
+ * firma del tokenizador, porque otra normalizacion u otras stopwords dan otro indice.
+ *
+ * @param directorio Directorio de documentos.
+ * @return Firma de 64 bits (0 si el directorio no se pudo abrir).
+ */
+uint64_t calcularFirmaCorpus(const char *directorio) {
+    int numArchivos;
+    char **rutas = listarArchivos(directorio, &numArchivos);
+    if (!rutas) {
+        return 0;
+    }
+    uint64_t firma = calcularHash(directorio, strlen(directorio)) ^ firmaTokenizador();
+    for (int i = 0; i < numArchivos; i++) {
+        struct stat info;
+        uint64_t datos[4] = {firma, 0, 0, 0};
+        if (stat(rutas[i], &info) == 0) {
+            datos[1] = (uint64_t)info.st_size;
+            datos[2] = (uint64_t)info.st_mtim.tv_sec;
+            datos[3] = (uint64_t)info.st_mtim.tv_nsec;
+        }
+        firma = calcularHash((const char *)datos, sizeof(datos)) ^ calcularHash(rutas[i], strlen(rutas[i]));
+        free(rutas[i]);
+    }
+    free(rutas);
+    return firma ? firma : 1;
+}
+
+/**
+ * @brief Carga archivos desde un directorio al indice y al grafo.
+ *
+ * @param directorio Ruta al directorio que contiene los archivos.
+ * @param hilos Numero de hilos de lectura (1 procesa todo en el hilo principal).
+ */
+void cargarArchivosEnIndiceYGrafo(const char *directorio, int hilos) {
+    cargarArchivosConAviso(directorio, hilos, NULL, NULL);
+}
+
+/**
+ * @brief Carga archivos avisando despues de cada documento.
+ *
+ * Con un solo hilo cada archivo se procesa y fusiona en el hilo principal. Con mas
+ * hilos, los de lectura procesan hasta ventana archivos por delante de la fusion,
+ * lo que acota la memoria usada por los documentos parciales. Los enlaces se
+ * anotan al fusionar cada documento y se instalan en el grafo al final, cuando ya
+ * se conocen todos los docID.
+ *
+ * @param directorio Ruta al directorio que contiene los archivos.
+ * @param hilos Numero de hilos de lectura (1 procesa todo en el hilo principal).
+ * @param aviso Funcion llamada despues de cada documento agregado, o NULL.
+ * @param contexto Puntero que se pasa sin cambios a aviso.
+ */
+void cargarArchivosConAviso(const char *directorio, int hilos, AvisoDocumentoCargado aviso, void *contexto) {
+    int numArchivos;
+    char **rutas = listarArchivos(directorio, &numArchivos);
+    if (!rutas) {
+        return;
+    }
+
+    printf("Leyendo archivos de la carpeta: %s\n", directorio);
+    INSTRUMENTAR_INICIO(inicio);
+
+    int docID = 0;
+    iniciarCargaEnlaces();
+    if (hilos <= 1 || numArchivos <= 1) {
+        for (int i = 0; i < numArchivos; i++) {
+            DocumentoParcial parcial;
+            memset(&parcial, 0, sizeof(parcial));
+            procesarArchivo(rutas[i], &parcial);
+            if (fusionarDocumento(rutas[i], &parcial, docID)) {
+                docID++;
+                if (aviso) {
+                    aviso(contexto);
+                }
+            }
+            liberarDocumentoParcial(&parcial);
+        }
+    } else {
+        ColaIngesta cola;
+        memset(&cola, 0, sizeof(cola));
+        cola.rutas = rutas;
+        cola.numArchivos = numArchivos;
+        cola.ventana = hilos * INGESTA_VENTANA_POR_HILO;
+        cola.anillo = calloc(cola.ventana, sizeof(DocumentoParcial));
+        cola.listos = calloc(cola.ventana, sizeof(int));
+        if (!cola.anillo || !cola.listos) {
+            perror("No se pudo reservar memoria durante la carga");
+            exit(EXIT_FAILURE);
+        }
+        pthread_mutex_init(&cola.mutex, NULL);
+        pthread_cond_init(&cola.cambio, NULL);
+
+        pthread_t *ids = ampliar(NULL, hilos * sizeof(pthread_t));
+        int lanzados = 0;
+        while (lanzados < hilos && pthread_create(&ids[lanzados], NULL, ejecutarHiloIngesta, &cola) == 0) {
+            lanzados++;
+        }
+        if (lanzados == 0) {
+            // Sin hilos de lectura, el hilo principal procesa cada archivo antes de fusionarlo.
+            fprintf(stderr, "No se pudieron crear los hilos de carga; se usara un solo hilo.\n");
+        }
+
+        for (int i = 0; i < numArchivos; i++) {
+            int ranura = i % cola.ventana;
+            if (lanzados == 0) {
+                procesarArchivo(rutas[i], &cola.anillo[ranura]);
+            } else {
+                pthread_mutex_lock(&cola.mutex);
+                while (!cola.listos[ranura]) {
+                    pthread_cond_wait(&cola.cambio, &cola.mutex);
+                }
+                pthread_mutex_unlock(&cola.mutex);
+            }
+
+            if (fusionarDocumento(rutas[i], &cola.anillo[ranura], docID)) {
+                docID++;
+                if (aviso) {
+                    aviso(contexto);
+                }
+            }
+            liberarDocumentoParcial(&cola.anillo[ranura]);
+
+            pthread_mutex_lock(&cola.mutex);
+            cola.listos[ranura] = 0;
+            cola.fusionados = i + 1;
+            pthread_cond_broadcast(&cola.cambio);
+            pthread_mutex_unlock(&cola.mutex);
+        }
+
+        for (int t = 0; t < lanzados; t++) {
+            pthread_join(ids[t], NULL);
+        }
+        free(ids);
+        pthread_cond_destroy(&cola.cambio);
+        pthread_mutex_destroy(&cola.mutex);
+        free(cola.anillo);
+        free(cola.listos);
+    }
+    terminarCargaEnlaces(docID);
+    INSTRUMENTAR_FIN(TIEMPO_CARGA, inicio);
+
+    for (int i = 0; i < numArchivos; i++) {
+        free(rutas[i]);
+    }
+    free(rutas);
+}
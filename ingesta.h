@@ -0,0 +1,138 @@
+/**
+ * @file ingesta.h
+ * @brief Carga en paralelo de los documentos del directorio al indice y al grafo.
+ *
+ * Los archivos se proyectan en memoria con mmap y se procesan en varios hilos.
+ * Cada hilo arma un indice parcial del documento (palabras distintas con su
+ * frecuencia) y su lista de enlaces; el hilo principal los fusiona en el indice
+ * global en orden de docID y anota los enlaces, que se validan y se agregan al
+ * grafo todos juntos al terminar (ver enlaces.h).
+ */
+
+#ifndef INGESTA_H
+#define INGESTA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "tokenizador.h"
+
+#define INGESTA_LARGO_PALABRA TOKENIZADOR_LARGO_MAXIMO ///< Largo maximo de una palabra; las mas largas se parten.
+#define INGESTA_VENTANA_POR_HILO 4 ///< Documentos que cada hilo puede adelantar respecto de la fusion.
+
+/**
+ * @struct TerminoParcial
+ * @brief Palabra distinta de un documento con su numero de apariciones.
+ */
+typedef struct {
+    uint64_t hash; ///< Hash de la palabra, calculado con calcularHash().
+    size_t offset; ///< Posicion de la palabra en el texto del documento parcial.
+    size_t longitud; ///< Longitud de la palabra en bytes.
+    int frecuencia; ///< Apariciones de la palabra en el documento.
+    int primeraPosicion; ///< Inicio de las posiciones de la palabra en DocumentoParcial::posiciones.
+} TerminoParcial;
+
+/**
+ * @struct DocumentoParcial
+ * @brief Indice parcial y enlaces de un documento, armados por un hilo de carga.
+ */
+typedef struct {
+    int error; ///< Valor de errno si el archivo no se pudo leer, 0 si se leyo bien.
+    char *texto; ///< Palabras distintas del documento, cada una terminada en '\0'.
+    size_t bytesTexto; ///< Bytes usados en texto.
+    size_t capacidadTexto; ///< Bytes reservados en texto.
+    TerminoParcial *terminos; ///< Palabras distintas en orden de primera aparicion.
+    int numTerminos; ///< Numero de palabras distintas.
+    int capacidadTerminos; ///< Capacidad reservada de terminos.
+    int *ranuras; ///< Tabla hash local: indice en terminos + 1, o 0 si esta vacia.
+    size_t capacidadRanuras; ///< Numero de ranuras (potencia de dos).
+    int *enlaces; ///< N de los tokens "link:N" en orden de aparicion (-1 si no entra en un int).
+    int numEnlaces; ///< Numero de enlaces.
+    int capacidadEnlaces; ///< Capacidad reservada de enlaces.
+    char *nombresEnlaces; ///< Nombres de los tokens "link:nombre", cada uno terminado en '\0'.
+    size_t bytesNombresEnlaces; ///< Bytes usados en nombresEnlaces.
+    size_t capacidadNombresEnlaces; ///< Bytes reservados en nombresEnlaces.
+    int numNombresEnlaces; ///< Numero de enlaces por nombre.
+    uint32_t *secuencia; ///< Termino de cada token en orden (UINT32_MAX si se descarto); solo con posiciones.
+    int numTokens; ///< Tokens leidos, contando los descartados.
+    int capacidadSecuencia; ///< Capacidad reservada de secuencia.
+    uint32_t *posiciones; ///< Posiciones agrupadas por termino, o NULL sin indice posicional.
+} DocumentoParcial;
+
+/**
+ * @brief Funcion que la carga llama despues de agregar cada documento al indice y al grafo.
+ *
+ * Se llama en el hilo que fusiona, con el documento ya finalizado en el indice,
+ * asi que puede leer o vaciar el indice en memoria.
+ *
+ * @param contexto Datos del llamador.
+ */
+typedef void (*AvisoDocumentoCargado)(void *contexto);
+
+/**
+ * @brief Carga archivos desde un directorio al indice y al grafo.
+ *
+ * Procesa todos los archivos con extension .txt del directorio especificado,
+ * agrega su contenido al indice y sus enlaces al grafo, que reemplazan a los que
+ * tuviera (ver enlaces.h). Los archivos se ordenan
+ * por nombre y reciben docID consecutivos en ese orden, por lo que el resultado
+ * no depende del orden de readdir ni del numero de hilos.
+ *
+ * @param directorio Ruta al directorio que contiene los archivos.
+ * @param hilos Numero de hilos de lectura (1 procesa todo en el hilo principal).
+ */
+void cargarArchivosEnIndiceYGrafo(const char *directorio, int hilos);
+
+/**
+ * @brief Carga archivos como cargarArchivosEnIndiceYGrafo() avisando despues de cada documento.
+ *
+ * @param directorio Ruta al directorio que contiene los archivos.
+ * @param hilos Numero de hilos de lectura (1 procesa todo en el hilo principal).
+ * @param aviso Funcion llamada despues de cada documento agregado, o NULL.
+ * @param contexto Puntero que se pasa sin cambios a aviso.
+ */
+void cargarArchivosConAviso(const char *directorio, int hilos, AvisoDocumentoCargado aviso, void *contexto);
+
+/**
+ * @brief Lista los archivos .txt de un directorio ordenados por nombre.
+ *
+ * Es el mismo orden en que cargarArchivosEnIndiceYGrafo() asigna los docID.
+ *
+ * @param directorio Directorio a recorrer.
+ * @param numArchivos Salida: numero de archivos encontrados.
+ * @return Arreglo de rutas (directorio/nombre), o NULL si el directorio no se pudo abrir.
+ *         El llamador libera cada ruta y el arreglo con free.
+ */
+char **listarArchivos(const char *directorio, int *numArchivos);
+
+/**
+ * @brief Calcula una firma del contenido de un directorio de documentos.
+ *
+ * Combina el nombre, el tamano y la fecha de modificacion de cada archivo .txt,
+ * sin leer su contenido, y la firma del tokenizador. Sirve para saber si una
+ * instantanea sigue vigente.
+ *
+ * @param directorio Directorio de documentos.
+ * @return Firma de 64 bits (0 si el directorio no se pudo abrir).
+ */
+uint64_t calcularFirmaCorpus(const char *directorio);
+
+/**
+ * @brief Procesa un archivo y arma su indice parcial.
+ *
+ * Proyecta el archivo en memoria, lo separa en palabras por espacios, las pasa a
+ * minusculas, descarta las stopwords y agrupa las repetidas. Los tokens "link:N"
+ * y "link:nombre" se registran ademas como enlaces.
+ *
+ * @param ruta Ruta del archivo.
+ * @param parcial Documento parcial a llenar; debe estar en cero.
+ */
+void procesarArchivo(const char *ruta, DocumentoParcial *parcial);
+
+/**
+ * @brief Libera la memoria de un documento parcial y lo deja en cero.
+ *
+ * @param parcial Documento parcial a liberar.
+ */
+void liberarDocumentoParcial(DocumentoParcial *parcial);
+
+#endif
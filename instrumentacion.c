@@ -0,0 +1,271 @@
+/**
+ * @file instrumentacion.c
+ * @brief Implementacion de los registros de instrumentacion y de su informe.
+ */
+
+#include "instrumentacion.h"
+#include <stdatomic.h>
+#include <time.h>
+
+/**
+ * @struct RegistroTiempo
+ * @brief Mediciones acumuladas de una etapa.
+ */
+typedef struct {
+    _Atomic uint64_t veces; ///< Mediciones.
+    _Atomic uint64_t total; ///< Suma de las duraciones, en nanosegundos.
+    _Atomic uint64_t maximo; ///< Mayor duracion, en nanosegundos.
+} RegistroTiempo;
+
+/**
+ * @struct IteracionPageRank
+ * @brief Una iteracion del ultimo calculo de PageRank.
+ */
+typedef struct {
+    double residuo; ///< Diferencia L1 con la iteracion anterior.
+    uint64_t nanosegundos; ///< Tiempo desde el inicio del calculo.
+} IteracionPageRank;
+
+static _Atomic uint64_t contadores[NUM_CONTADORES];
+static RegistroTiempo tiempos[NUM_TIEMPOS];
+static _Atomic uint64_t histogramas[NUM_HISTOGRAMAS][INSTRUMENTACION_CUBETAS];
+static IteracionPageRank iteraciones[INSTRUMENTACION_MAX_ITERACIONES];
+static _Atomic int numIteraciones;
+
+/**
+ * @brief Devuelve el reloj monotono en nanosegundos.
+ *
+ * @return Nanosegundos desde un origen arbitrario.
+ */
+uint64_t relojInstrumentacion() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Suma a un contador.
+ *
+ * @param contador Contador.
+ * @param valor Cantidad a sumar.
+ */
+void sumarContador(Contador contador, uint64_t valor) {
+    atomic_fetch_add_explicit(&contadores[contador], valor, memory_order_relaxed);
+}
+
+/**
+ * @brief Registra una medicion de una etapa.
+ *
+ * @param tiempo Etapa.
+ * @param nanosegundos Duracion.
+ */
+void registrarTiempo(Tiempo tiempo, uint64_t nanosegundos) {
+    RegistroTiempo *registro = &tiempos[tiempo];
+    atomic_fetch_add_explicit(&registro->veces, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&registro->total, nanosegundos, memory_order_relaxed);
+    uint64_t maximo = atomic_load_explicit(&registro->maximo, memory_order_relaxed);
+    while (nanosegundos > maximo &&
+           !atomic_compare_exchange_weak_explicit(&registro->maximo, &maximo, nanosegundos, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Agrega un valor a un histograma.
+ *
+ * @param histograma Histograma.
+ * @param valor Valor.
+ */
+void registrarHistograma(Histograma histograma, uint64_t valor) {
+    int cubeta = valor ? 64 - __builtin_clzll(valor) : 0;
+    if (cubeta >= INSTRUMENTACION_CUBETAS) {
+        cubeta = INSTRUMENTACION_CUBETAS - 1;
+    }
+    atomic_fetch_add_explicit(&histogramas[histograma][cubeta], 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Registra el residuo y la duracion de una iteracion de PageRank.
+ *
+ * @param iteracion Numero de la iteracion, desde 1.
+ * @param residuo Diferencia L1 con la iteracion anterior.
+ * @param nanosegundos Tiempo desde el inicio del calculo.
+ */
+void registrarIteracionPageRank(int iteracion, double residuo, uint64_t nanosegundos) {
+    // Los calculos de PageRank no se solapan; solo el hilo 0 de cada uno registra.
+    if (iteracion < 1 || iteracion > INSTRUMENTACION_MAX_ITERACIONES) {
+        return;
+    }
+    iteraciones[iteracion - 1].residuo = residuo;
+    iteraciones[iteracion - 1].nanosegundos = nanosegundos;
+    atomic_store_explicit(&numIteraciones, iteracion, memory_order_release);
+}
+
+/**
+ * @brief Pone en cero todos los registros.
+ */
+void reiniciarInstrumentacion() {
+    for (int c = 0; c < NUM_CONTADORES; c++) {
+        atomic_store(&contadores[c], 0);
+    }
+    for (int t = 0; t < NUM_TIEMPOS; t++) {
+        atomic_store(&tiempos[t].veces, 0);
+        atomic_store(&tiempos[t].total, 0);
+        atomic_store(&tiempos[t].maximo, 0);
+    }
+    for (int h = 0; h < NUM_HISTOGRAMAS; h++) {
+        for (int i = 0; i < INSTRUMENTACION_CUBETAS; i++) {
+            atomic_store(&histogramas[h][i], 0);
+        }
+    }
+    atomic_store(&numIteraciones, 0);
+}
+
+#ifdef MOTOR_INSTRUMENTACION
+static const char *const nombresContadores[NUM_CONTADORES] = {
+    "archivos_leidos", "bytes_leidos", "busquedas_hash", "sondeos_hash", "postings_codificados", "bytes_postings",
+    "consultas_booleanas", "consultas_rankeadas", "consultas_conjuntos", "iteraciones_pagerank",
+};
+static const char *const nombresTiempos[NUM_TIEMPOS] = {
+    "carga", "procesar_archivo", "fusionar_documento", "consulta_booleana", "consulta_rankeada", "pagerank",
+    "pagerank_incremental", "pagerank_lote", "diccionario", "volcar_corrida", "fusionar_corridas",
+    "enlaces_validar", "enlaces_ordenar", "enlaces_armar",
+};
+static const char *const nombresHistogramas[NUM_HISTOGRAMAS] = {"latencia_consulta_ns", "sondeos_hash"};
+
+/**
+ * @brief Estima un percentil de un histograma.
+ *
+ * @param cubetas Conteos de las cubetas.
+ * @param total Suma de los conteos.
+ * @param percentil Percentil entre 0 y 100.
+ * @return Limite superior de la cubeta que contiene el percentil.
+ */
+static uint64_t percentilHistograma(const uint64_t *cubetas, uint64_t total, int percentil) {
+    uint64_t objetivo = (total * (uint64_t)percentil + 99) / 100;
+    uint64_t acumulado = 0;
+    for (int i = 0; i < INSTRUMENTACION_CUBETAS; i++) {
+        acumulado += cubetas[i];
+        if (acumulado >= objetivo && cubetas[i] > 0) {
+            return i == 0 ? 0 : ((uint64_t)1 << i) - 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Escribe el informe como texto.
+ *
+ * @param salida Flujo de salida.
+ */
+static void volcarTexto(FILE *salida) {
+    fprintf(salida, "Contadores:\n");
+    for (int c = 0; c < NUM_CONTADORES; c++) {
+        fprintf(salida, "  %-22s %llu\n", nombresContadores[c], (unsigned long long)atomic_load(&contadores[c]));
+    }
+    uint64_t busquedas = atomic_load(&contadores[CONTADOR_BUSQUEDAS_HASH]);
+    uint64_t postings = atomic_load(&contadores[CONTADOR_POSTINGS_CODIFICADOS]);
+    fprintf(salida, "  sondeos por busqueda: %.2f; bytes por posting: %.2f\n",
+            busquedas ? (double)atomic_load(&contadores[CONTADOR_SONDEOS_HASH]) / busquedas : 0.0,
+            postings ? (double)atomic_load(&contadores[CONTADOR_BYTES_POSTINGS]) / postings : 0.0);
+
+    fprintf(salida, "Tiempos:\n");
+    fprintf(salida, "  %-22s %10s %12s %12s %12s\n", "etapa", "veces", "total ms", "media us", "max us");
+    for (int t = 0; t < NUM_TIEMPOS; t++) {
+        uint64_t veces = atomic_load(&tiempos[t].veces);
+        uint64_t total = atomic_load(&tiempos[t].total);
+        fprintf(salida, "  %-22s %10llu %12.3f %12.3f %12.3f\n", nombresTiempos[t], (unsigned long long)veces,
+                total / 1e6, veces ? total / 1e3 / veces : 0.0, atomic_load(&tiempos[t].maximo) / 1e3);
+    }
+
+    for (int h = 0; h < NUM_HISTOGRAMAS; h++) {
+        uint64_t cubetas[INSTRUMENTACION_CUBETAS];
+        uint64_t total = 0;
+        for (int i = 0; i < INSTRUMENTACION_CUBETAS; i++) {
+            cubetas[i] = atomic_load(&histogramas[h][i]);
+            total += cubetas[i];
+        }
+        fprintf(salida, "Histograma %s: %llu valores, p50 <= %llu, p90 <= %llu, p99 <= %llu\n", nombresHistogramas[h],
+                (unsigned long long)total, (unsigned long long)percentilHistograma(cubetas, total, 50),
+                (unsigned long long)percentilHistograma(cubetas, total, 90),
+                (unsigned long long)percentilHistograma(cubetas, total, 99));
+        for (int i = 0; i < INSTRUMENTACION_CUBETAS; i++) {
+            if (cubetas[i] > 0) {
+                fprintf(salida, "  < %-20llu %llu\n", (unsigned long long)1 << i, (unsigned long long)cubetas[i]);
+            }
+        }
+    }
+
+    int n = atomic_load_explicit(&numIteraciones, memory_order_acquire);
+    fprintf(salida, "Ultimo PageRank completo: %d iteraciones\n", n);
+    uint64_t anterior = 0;
+    for (int i = 0; i < n; i++) {
+        fprintf(salida, "  %3d  residuo %.3e  %.3f ms\n", i + 1, iteraciones[i].residuo,
+                (iteraciones[i].nanosegundos - anterior) / 1e6);
+        anterior = iteraciones[i].nanosegundos;
+    }
+}
+
+/**
+ * @brief Escribe el informe como un objeto JSON, sin saltos de linea.
+ *
+ * @param salida Flujo de salida.
+ */
+static void volcarJson(FILE *salida) {
+    fprintf(salida, "{\"activada\":true,\"contadores\":{");
+    for (int c = 0; c < NUM_CONTADORES; c++) {
+        fprintf(salida, "%s\"%s\":%llu", c ? "," : "", nombresContadores[c],
+                (unsigned long long)atomic_load(&contadores[c]));
+    }
+    fprintf(salida, "},\"tiempos\":{");
+    for (int t = 0; t < NUM_TIEMPOS; t++) {
+        fprintf(salida, "%s\"%s\":{\"veces\":%llu,\"total_ns\":%llu,\"max_ns\":%llu}", t ? "," : "", nombresTiempos[t],
+                (unsigned long long)atomic_load(&tiempos[t].veces), (unsigned long long)atomic_load(&tiempos[t].total),
+                (unsigned long long)atomic_load(&tiempos[t].maximo));
+    }
+    fprintf(salida, "},\"histogramas\":{");
+    for (int h = 0; h < NUM_HISTOGRAMAS; h++) {
+        // Cubetas hasta la ultima no vacia; la cubeta i cuenta valores menores que 2^i.
+        int ultima = 0;
+        for (int i = 0; i < INSTRUMENTACION_CUBETAS; i++) {
+            if (atomic_load(&histogramas[h][i]) > 0) {
+                ultima = i + 1;
+            }
+        }
+        fprintf(salida, "%s\"%s\":[", h ? "," : "", nombresHistogramas[h]);
+        for (int i = 0; i < ultima; i++) {
+            fprintf(salida, "%s%llu", i ? "," : "", (unsigned long long)atomic_load(&histogramas[h][i]));
+        }
+        fputc(']', salida);
+    }
+    fprintf(salida, "},\"pagerank\":[");
+    int n = atomic_load_explicit(&numIteraciones, memory_order_acquire);
+    for (int i = 0; i < n; i++) {
+        fprintf(salida, "%s{\"residuo\":%.6g,\"ns\":%llu}", i ? "," : "", iteraciones[i].residuo,
+                (unsigned long long)iteraciones[i].nanosegundos);
+    }
+    fprintf(salida, "]}");
+}
+#endif
+
+/**
+ * @brief Escribe el informe de instrumentacion.
+ *
+ * @param salida Flujo de salida.
+ * @param json 1 para un objeto JSON sin saltos de linea, 0 para texto.
+ */
+void volcarInstrumentacion(FILE *salida, int json) {
+#ifdef MOTOR_INSTRUMENTACION
+    if (json) {
+        volcarJson(salida);
+    } else {
+        volcarTexto(salida);
+    }
+#else
+    if (json) {
+        fprintf(salida, "{\"activada\":false}");
+    } else {
+        fprintf(salida, "Instrumentacion desactivada (compilar con -DMOTOR_INSTRUMENTACION).\n");
+    }
+#endif
+}
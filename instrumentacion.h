@@ -0,0 +1,158 @@
+/**
+ * @file instrumentacion.h
+ * @brief Contadores, tiempos e histogramas de los caminos criticos del motor.
+ *
+ * La carga, el indice, las consultas y el PageRank registran aqui cuanto tiempo
+ * toma cada etapa y cuanto trabajo hacen (sondeos de la tabla hash, bytes de
+ * postings, residuo de cada iteracion), para ver en produccion en que se va el
+ * tiempo sin conectar un perfilador. El informe se pide con
+ * volcarInstrumentacion(), como texto o como JSON.
+ *
+ * Se activa al compilar con -DMOTOR_INSTRUMENTACION, que el Makefile agrega
+ * salvo con "make INSTRUMENTACION=0". Sin esa macro los INSTRUMENTAR_* no
+ * generan codigo y el informe solo dice que la instrumentacion esta desactivada.
+ *
+ * Los registros son sumas atomicas relajadas, seguras desde cualquier hilo. Los
+ * tiempos usan CLOCK_MONOTONIC, en nanosegundos.
+ */
+
+#ifndef INSTRUMENTACION_H
+#define INSTRUMENTACION_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define INSTRUMENTACION_CUBETAS 32 ///< Cubetas de cada histograma; la cubeta i cuenta valores en [2^(i-1), 2^i).
+#define INSTRUMENTACION_MAX_ITERACIONES 128 ///< Iteraciones de PageRank que se guardan del ultimo calculo.
+
+/**
+ * @brief Contadores de eventos.
+ */
+typedef enum {
+    CONTADOR_ARCHIVOS_LEIDOS, ///< Archivos procesados por la carga.
+    CONTADOR_BYTES_LEIDOS, ///< Bytes de los archivos procesados.
+    CONTADOR_BUSQUEDAS_HASH, ///< Busquedas en la tabla hash del indice.
+    CONTADOR_SONDEOS_HASH, ///< Ranuras revisadas por esas busquedas.
+    CONTADOR_POSTINGS_CODIFICADOS, ///< Postings agregados a las listas comprimidas.
+    CONTADOR_BYTES_POSTINGS, ///< Bytes que ocupan esos postings comprimidos.
+    CONTADOR_CONSULTAS_BOOLEANAS, ///< Consultas booleanas evaluadas (sin contar las resueltas por la cache).
+    CONTADOR_CONSULTAS_RANKEADAS, ///< Consultas por relevancia evaluadas (sin contar las resueltas por la cache).
+    CONTADOR_CONSULTAS_CONJUNTOS, ///< Consultas booleanas resueltas con conjuntos Roaring.
+    CONTADOR_ITERACIONES_PAGERANK, ///< Iteraciones de todos los calculos completos de PageRank.
+    NUM_CONTADORES
+} Contador;
+
+/**
+ * @brief Etapas cronometradas.
+ */
+typedef enum {
+    TIEMPO_CARGA, ///< cargarArchivosEnIndiceYGrafo() completa.
+    TIEMPO_PROCESAR_ARCHIVO, ///< Lectura y tokenizacion de un archivo (en los hilos de lectura).
+    TIEMPO_FUSIONAR_DOCUMENTO, ///< Insercion de un documento en el indice y el grafo.
+    TIEMPO_CONSULTA_BOOLEANA, ///< ejecutarConsulta(), incluida la cache.
+    TIEMPO_CONSULTA_RANKEADA, ///< ejecutarConsultaRankeada(), incluida la cache.
+    TIEMPO_PAGERANK, ///< Calculo completo de PageRank.
+    TIEMPO_PAGERANK_INCREMENTAL, ///< actualizarPageRank().
+    TIEMPO_PAGERANK_LOTE, ///< calcularPageRankPorLotes().
+    TIEMPO_DICCIONARIO, ///< Armado del diccionario ordenado de palabras.
+    TIEMPO_VOLCAR_CORRIDA, ///< Escritura de una corrida ordenada de la carga en memoria externa.
+    TIEMPO_FUSIONAR_CORRIDAS, ///< Fusion de las corridas en la instantanea final.
+    TIEMPO_ENLACES_VALIDAR, ///< Resolucion y validacion de los enlaces anotados en la carga.
+    TIEMPO_ENLACES_ORDENAR, ///< Radix sort de los enlaces de la carga y eliminacion de repetidos.
+    TIEMPO_ENLACES_ARMAR, ///< Armado de los arreglos CSR/CSC a partir de los enlaces ordenados.
+    NUM_TIEMPOS
+} Tiempo;
+
+/**
+ * @brief Distribuciones.
+ */
+typedef enum {
+    HISTOGRAMA_LATENCIA_CONSULTA, ///< Latencia de cada consulta, en nanosegundos.
+    HISTOGRAMA_SONDEOS_HASH, ///< Ranuras revisadas por cada busqueda en la tabla hash.
+    NUM_HISTOGRAMAS
+} Histograma;
+
+#ifdef MOTOR_INSTRUMENTACION
+#define INSTRUMENTAR_CONTADOR(contador, valor) sumarContador((contador), (uint64_t)(valor))
+#define INSTRUMENTAR_HISTOGRAMA(histograma, valor) registrarHistograma((histograma), (uint64_t)(valor))
+#define INSTRUMENTAR_INICIO(variable) uint64_t variable = relojInstrumentacion()
+#define INSTRUMENTAR_FIN(tiempo, variable) registrarTiempo((tiempo), relojInstrumentacion() - (variable))
+#define INSTRUMENTAR_LATENCIA(tiempo, variable)                                                                     \
+    do {                                                                                                            \
+        uint64_t transcurrido = relojInstrumentacion() - (variable);                                               \
+        registrarTiempo((tiempo), transcurrido);                                                                   \
+        registrarHistograma(HISTOGRAMA_LATENCIA_CONSULTA, transcurrido);                                           \
+    } while (0)
+#define INSTRUMENTAR_ITERACION_PAGERANK(iteracion, residuo, variable)                                               \
+    registrarIteracionPageRank((iteracion), (residuo), relojInstrumentacion() - (variable))
+#else
+// sizeof no evalua el valor, pero cuenta como uso de las variables que nombra.
+#define INSTRUMENTAR_CONTADOR(contador, valor) ((void)sizeof(valor))
+#define INSTRUMENTAR_HISTOGRAMA(histograma, valor) ((void)sizeof(valor))
+#define INSTRUMENTAR_INICIO(variable) ((void)0)
+#define INSTRUMENTAR_FIN(tiempo, variable) ((void)0)
+#define INSTRUMENTAR_LATENCIA(tiempo, variable) ((void)0)
+#define INSTRUMENTAR_ITERACION_PAGERANK(iteracion, residuo, variable) ((void)0)
+#endif
+
+/**
+ * @brief Devuelve el reloj monotono en nanosegundos.
+ *
+ * @return Nanosegundos desde un origen arbitrario.
+ */
+uint64_t relojInstrumentacion();
+
+/**
+ * @brief Suma a un contador.
+ *
+ * @param contador Contador.
+ * @param valor Cantidad a sumar.
+ */
+void sumarContador(Contador contador, uint64_t valor);
+
+/**
+ * @brief Registra una medicion de una etapa.
+ *
+ * @param tiempo Etapa.
+ * @param nanosegundos Duracion.
+ */
+void registrarTiempo(Tiempo tiempo, uint64_t nanosegundos);
+
+/**
+ * @brief Agrega un valor a un histograma.
+ *
+ * @param histograma Histograma.
+ * @param valor Valor.
+ */
+void registrarHistograma(Histograma histograma, uint64_t valor);
+
+/**
+ * @brief Registra el residuo y la duracion de una iteracion de PageRank.
+ *
+ * La iteracion 1 empieza una serie nueva; se conserva solo la del ultimo calculo.
+ *
+ * @param iteracion Numero de la iteracion, desde 1.
+ * @param residuo Diferencia L1 con la iteracion anterior.
+ * @param nanosegundos Tiempo desde el inicio del calculo.
+ */
+void registrarIteracionPageRank(int iteracion, double residuo, uint64_t nanosegundos);
+
+/**
+ * @brief Pone en cero todos los registros.
+ */
+void reiniciarInstrumentacion();
+
+/**
+ * @brief Escribe el informe de instrumentacion.
+ *
+ * El JSON no lleva salto de linea, ni siquiera al final, para poder incluirlo
+ * dentro de otro objeto. Contiene los contadores, los tiempos en nanosegundos,
+ * las cubetas de cada histograma (la cubeta i cuenta valores menores que 2^i) y
+ * el residuo de cada iteracion del ultimo PageRank completo.
+ *
+ * @param salida Flujo de salida.
+ * @param json 1 para un objeto JSON sin saltos de linea, 0 para texto.
+ */
+void volcarInstrumentacion(FILE *salida, int json);
+
+#endif
@@ -9,26 +9,53 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <dirent.h>
+#include <time.h>
+#include <unistd.h>
 #include "index.h"
+#include "cache.h"
+#include "consulta.h"
+#include "enlaces.h"
+#include "externo.h"
 #include "graph.h"
+#include "incremental.h"
+#include "ingesta.h"
+#include "instrumentacion.h"
+#include "personalizacion.h"
+#include "servidor.h"
+#include "snapshot.h"
+#include "tokenizador.h"
 #include "utils.h"
 
+static const char *nombresPersonalizacion[PAGERANK_MAX_LOTE]; ///< Nombres dados con --personalizacion.
+static const char *consultasPersonalizacion[PAGERANK_MAX_LOTE]; ///< Consulta semilla de cada personalizacion.
+static int numPersonalizaciones = 0; ///< Personalizaciones dadas con --personalizacion.
+
 /**
- * @brief Carga archivos desde un directorio al indice y al grafo.
- *
- * Procesa todos los archivos con extension .txt del directorio especificado,
- * agrega su contenido al indice y sus enlaces al grafo.
+ * @brief Calcula y publica los PageRank personalizados de la linea de comandos.
  *
- * @param directorio Ruta al directorio que contiene los archivos.
+ * @return 1 si se calcularon (o no hay ninguno), 0 si alguno tiene un error.
  */
-void cargarArchivosEnIndiceYGrafo(const char *directorio);
+static int calcularPersonalizaciones() {
+    if (numPersonalizaciones == 0) {
+        return 1;
+    }
+    // El reloj monotono mide el tiempo transcurrido; clock() sumaria el de todos los hilos.
+    uint64_t inicio = relojInstrumentacion();
+    int iteraciones = personalizarPageRank(nombresPersonalizacion, consultasPersonalizacion, numPersonalizaciones);
+    if (iteraciones < 0) {
+        return 0;
+    }
+    printf("%d PageRank personalizados calculados en %d iteraciones (%.3f s).\n", numPersonalizaciones, iteraciones,
+           (relojInstrumentacion() - inicio) * 1e-9);
+    return 1;
+}
 
 /**
  * @brief Muestra estadisticas del sistema.
  *
- * Imprime la cantidad total de palabras indexadas, documentos cargados
- * y los documentos con mayor PageRank.
+ * Imprime la cantidad total de palabras indexadas, documentos cargados,
+ * el estado de los cambios incrementales, la efectividad de la cache de
+ * consultas y los documentos con mayor PageRank.
  */
 void mostrarEstadisticas();
 
@@ -36,112 +63,234 @@ void mostrarEstadisticas();
  * @brief Menu principal del sistema.
  *
  * Permite al usuario interactuar con el sistema, realizar busquedas,
- * consultar estadisticas y recalcular el PageRank.
+ * consultar estadisticas, recalcular el PageRank y aplicar los cambios de la
+ * carpeta de documentos.
  */
 void menuPrincipal();
 
-/**
- * @brief Abre un documento especificado.
- *
- * Utiliza el sistema operativo para abrir el archivo con la aplicacion por defecto.
- *
- * @param nombreArchivo Nombre o ruta del archivo a abrir.
- */
-void abrirDocumento(const char *nombreArchivo);
-
 /**
  * @brief Funcion principal.
  *
  * Inicializa el indice y el grafo, carga los archivos desde el directorio "docs",
- * calcula el PageRank inicial y lanza el menu principal.
+ * calcula el PageRank inicial y lanza el menu principal. La opcion "--hilos N"
+ * fija los hilos de la carga y del calculo de PageRank; por defecto se usan
+ * todos los nucleos.
+ *
+ * Si existe una instantanea vigente (por defecto "indice.snap", se cambia con
+ * "--snapshot RUTA") se abre en lugar de releer los documentos; si no existe o
+ * esta desactualizada, se reconstruye todo y se guarda una nueva. La opcion
+ * "--sin-snapshot" desactiva ambas cosas.
+ *
+ * "--peso-pagerank X" fija cuanto pesa el PageRank en la busqueda por relevancia, y
+ * "--stopwords RUTA" reemplaza las stopwords por las del archivo (una por linea).
+ * "--cache-consultas MB" fija la capacidad de la cache de resultados (0 la desactiva).
+ * "--posiciones" guarda las posiciones de cada palabra para poder buscar frases y
+ * NEAR; la instantanea recuerda si las tiene y se reconstruye si no coincide.
+ * "--memoria-indice MB" arma el indice en memoria externa (ver externo.h): cuando
+ * el indice en memoria llega a MB lo vuelca a disco y al final fusiona lo volcado
+ * en la instantanea, que se abre como si ya existiera. Sin instantanea
+ * ("--sin-snapshot") se usa una de paso que se borra apenas se abre.
  *
+ * "--personalizacion NOMBRE=CONSULTA" (repetible, hasta PAGERANK_MAX_LOTE veces)
+ * define un PageRank personalizado cuyo teletransporte va a los documentos que
+ * cumplen la consulta booleana (ver personalizacion.h); todos se calculan juntos
+ * despues del PageRank global y se recalculan con el.
+ *
+ * "--servidor" reemplaza el menu por el modo servidor sobre la entrada estandar
+ * (ver servidor.h), y "--socket RUTA" lo ejecuta sobre un socket de dominio Unix
+ * con "--hilos" hilos. En modo servidor la salida estandar queda reservada para
+ * las respuestas y los mensajes de la carga van a stderr.
+ *
+ * @param argc Numero de argumentos.
+ * @param argv Argumentos de la linea de comandos.
  * @return 0 si el programa termina correctamente.
  */
-int main() {
-    inicializarIndice();
-    inicializarGrafo(MAX_DOCS);
-
-    cargarArchivosEnIndiceYGrafo("docs");
-
-    calcularPageRank(0.85, 20);
-
-    menuPrincipal();
-    return 0;
-}
+int main(int argc, char *argv[]) {
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    int hilos = nucleos > 0 ? (int)nucleos : 1;
+    const char *rutaSnapshot = SNAPSHOT_RUTA_DEFECTO;
+    int modoServidor = 0;
+    const char *rutaSocket = NULL;
+    size_t memoriaIndice = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--hilos") == 0 && i + 1 < argc) {
+            hilos = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            rutaSnapshot = argv[++i];
+        } else if (strcmp(argv[i], "--sin-snapshot") == 0) {
+            rutaSnapshot = NULL;
+        } else if (strcmp(argv[i], "--peso-pagerank") == 0 && i + 1 < argc) {
+            establecerPesoPageRank(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--stopwords") == 0 && i + 1 < argc) {
+            if (cargarStopwords(argv[++i]) < 0) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--cache-consultas") == 0 && i + 1 < argc) {
+            double megabytes = atof(argv[++i]);
+            configurarCacheConsultas(megabytes > 0.0 ? (size_t)(megabytes * 1024 * 1024) : 0);
+        } else if (strcmp(argv[i], "--memoria-indice") == 0 && i + 1 < argc) {
+            double megabytes = atof(argv[++i]);
+            memoriaIndice = megabytes > 0.0 ? (size_t)(megabytes * 1024 * 1024) : 0;
+        } else if (strcmp(argv[i], "--posiciones") == 0) {
+            activarIndicePosicional(1);
+        } else if (strcmp(argv[i], "--personalizacion") == 0 && i + 1 < argc) {
+            char *igual = strchr(argv[++i], '=');
+            if (!igual || numPersonalizaciones == PAGERANK_MAX_LOTE) {
+                fprintf(stderr, "--personalizacion espera NOMBRE=CONSULTA, hasta %d veces.\n", PAGERANK_MAX_LOTE);
+                return 1;
+            }
+            *igual = '\0';
+            nombresPersonalizacion[numPersonalizaciones] = argv[i];
+            consultasPersonalizacion[numPersonalizaciones++] = igual + 1;
+        } else if (strcmp(argv[i], "--servidor") == 0) {
+            modoServidor = 1;
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            modoServidor = 1;
+            rutaSocket = argv[++i];
+        } else {
+            fprintf(stderr,
+                    "Uso: %s [--hilos N] [--snapshot RUTA | --sin-snapshot] [--peso-pagerank X] [--stopwords RUTA]"
+                    " [--cache-consultas MB] [--posiciones] [--memoria-indice MB] [--personalizacion NOMBRE=CONSULTA]"
+                    " [--servidor | --socket RUTA]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
 
-void cargarArchivosEnIndiceYGrafo(const char *directorio) {
-    DIR *dir;
-    struct dirent *entry;
-    int docID = 0;
+    establecerHilosPageRank(hilos);
 
-    if ((dir = opendir(directorio)) == NULL) {
-        perror("No se pudo abrir el directorio");
-        return;
+    FILE *respuestas = NULL;
+    if (modoServidor) {
+        respuestas = fdopen(dup(STDOUT_FILENO), "w");
+        if (!respuestas || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+            perror("No se pudo preparar la salida del servidor");
+            return 1;
+        }
     }
 
-    printf("Leyendo archivos de la carpeta: %s\n", directorio);
+    inicializarIndice();
+    inicializarGrafo(0);
 
-    while ((entry = readdir(dir)) != NULL) {
-        if (strstr(entry->d_name, ".txt") != NULL) {
-            char rutaArchivo[512];
-            snprintf(rutaArchivo, sizeof(rutaArchivo), "%s/%s", directorio, entry->d_name);
+    uint64_t firma = calcularFirmaCorpus("docs");
+    if (rutaSnapshot && firma && abrirSnapshot(rutaSnapshot, firma)) {
+        printf("Instantanea '%s' cargada: %d documentos, %d palabras.\n",
+               rutaSnapshot, totalDocumentosCargados(), totalPalabrasIndexadas());
+    } else {
+        const char *rutaExterna = rutaSnapshot ? rutaSnapshot : EXTERNO_RUTA_SIN_SNAPSHOT;
+        if (memoriaIndice > 0) {
+            cargarArchivosEnCorridas("docs", hilos, memoriaIndice, rutaExterna);
+        } else {
+            cargarArchivosEnIndiceYGrafo("docs", hilos);
+        }
 
-            printf("Procesando archivo: %s\n", rutaArchivo);
+        EstadisticasEnlaces enlaces;
+        obtenerEstadisticasEnlaces(&enlaces);
+        printf("Enlaces: %ld en el grafo de %ld leidos (%ld por nombre); descartados: %ld fuera de rango,"
+               " %ld nombres desconocidos, %ld repetidos (validar %.1f ms, ordenar %.1f ms, armar %.1f ms).\n",
+               enlaces.agregados, enlaces.leidos, enlaces.porNombre, enlaces.fueraDeRango,
+               enlaces.nombresDesconocidos, enlaces.repetidos, enlaces.nanosValidar / 1e6, enlaces.nanosOrdenar / 1e6,
+               enlaces.nanosArmar / 1e6);
 
-            FILE *archivo = fopen(rutaArchivo, "r");
-            if (!archivo) {
-                perror("No se pudo abrir el archivo");
-                continue;
-            }
+        calcularPageRank(PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES, PAGERANK_TOLERANCIA);
+        printf("PageRank calculado con %d hilos en %d iteraciones (residuo %.2e).\n",
+               obtenerHilosPageRank(), obtenerIteracionesPageRank(), obtenerResiduoPageRank());
 
-            agregarDocumento(docID, rutaArchivo);
-            char palabra[100];
-            while (fscanf(archivo, "%99s", palabra) == 1) {
-                convertirAMinusculas(palabra);
-                if (!esStopword(palabra)) {
-                    agregarPalabraIndice(palabra, docID);
-                }
-                if (strncmp(palabra, "link:", 5) == 0) {
-                    int enlaceID = atoi(palabra + 5);
-                    agregarEnlace(docID, enlaceID);
-                }
+        if (memoriaIndice > 0) {
+            if (!fusionarCorridas(rutaExterna, firma) || !abrirSnapshot(rutaExterna, firma)) {
+                fprintf(stderr, "No se pudo armar el indice en '%s'.\n", rutaExterna);
+                return 1;
+            }
+            if (!rutaSnapshot) {
+                remove(rutaExterna);
             }
-            fclose(archivo);
-            docID++;
+            EstadisticasExterno externo;
+            obtenerEstadisticasExterno(&externo);
+            printf("Indice armado en disco: %d corridas (%.1f MB, hasta %.1f MB en memoria, %d pasadas intermedias),"
+                   " %d palabras (%d listas combinadas).\n",
+                   externo.corridas, externo.bytesCorridas / (1024.0 * 1024.0),
+                   externo.memoriaMaxima / (1024.0 * 1024.0), externo.pasadas, externo.palabras,
+                   externo.palabrasCombinadas);
+        } else if (rutaSnapshot && firma && guardarSnapshot(rutaSnapshot, firma)) {
+            printf("Instantanea guardada en '%s'.\n", rutaSnapshot);
         }
     }
-    closedir(dir);
+
+    if (!calcularPersonalizaciones()) {
+        return 1;
+    }
+
+    iniciarIncremental("docs");
+    int resultado = 0;
+    if (modoServidor) {
+        fflush(stdout);
+        resultado = ejecutarServidor(rutaSocket, hilos, respuestas) == 0 ? 0 : 1;
+        fclose(respuestas);
+    } else {
+        menuPrincipal();
+    }
+    esperarFusionIndice();
+    return resultado;
 }
 
 void mostrarEstadisticas() {
     printf("\n--- Estadisticas del Sistema ---\n");
+    EstadisticasIncremental incremental;
+    obtenerEstadisticasIncremental(&incremental);
+    EstadisticasArena memoriaIndice;
+    EstadisticasArena memoriaGrafo;
+    bloquearIndiceLectura();
     printf("Total de palabras indexadas: %d\n", totalPalabrasIndexadas());
+    obtenerEstadisticasMemoriaIndice(&memoriaIndice);
+    desbloquearIndice();
+    obtenerEstadisticasMemoriaGrafo(&memoriaGrafo);
     printf("Total de documentos: %d\n", totalDocumentosCargados());
+    printf("Ultimo PageRank: %d iteraciones (residuo %.2e)\n",
+           obtenerIteracionesPageRank(), obtenerResiduoPageRank());
+    printf("Cambios sin fusionar: %ld postings de %d palabras, %d documentos invalidados\n",
+           incremental.postingsDelta, incremental.terminosDelta, incremental.lapidas);
+    printf("Fusiones terminadas: %d%s\n", incremental.fusiones,
+           incremental.postingsFusion ? " (una en curso)" : "");
+    printf("Memoria del indice: %ld palabras en %.1f KB usados de %.1f KB (%d bloques)\n",
+           memoriaIndice.reservas, memoriaIndice.bytesUsados / 1024.0, memoriaIndice.bytesReservados / 1024.0,
+           memoriaIndice.bloques);
+    int conjuntos;
+    size_t bytesConjuntos = memoriaConjuntosPostings(&conjuntos);
+    printf("Conjuntos Roaring: %d listas frecuentes en %.1f KB\n", conjuntos, bytesConjuntos / 1024.0);
+    printf("Memoria de enlaces pendientes: %ld enlaces en %.1f KB de %.1f KB; %ld enlaces (%.1f KB) desde el inicio\n",
+           memoriaGrafo.reservas, memoriaGrafo.bytesUsados / 1024.0, memoriaGrafo.bytesReservados / 1024.0,
+           memoriaGrafo.reservasAcumuladas, memoriaGrafo.bytesAcumulados / 1024.0);
+    EstadisticasEnlaces enlaces;
+    obtenerEstadisticasEnlaces(&enlaces);
+    printf("Enlaces desde la carga: %ld leidos (%ld por nombre), %ld agregados; descartados: %ld fuera de rango,"
+           " %ld nombres desconocidos, %ld repetidos\n",
+           enlaces.leidos, enlaces.porNombre, enlaces.agregados, enlaces.fueraDeRango, enlaces.nombresDesconocidos,
+           enlaces.repetidos);
+    EstadisticasCache cache;
+    obtenerEstadisticasCacheConsultas(&cache);
+    long busquedas = cache.aciertos + cache.fallos;
+    printf("Cache de consultas: %ld aciertos, %ld fallos (%.1f%% aciertos); %d entradas en %.1f KB de %.1f KB,"
+           " %ld invalidadas, %ld expulsadas\n",
+           cache.aciertos, cache.fallos, busquedas ? 100.0 * cache.aciertos / busquedas : 0.0, cache.entradas,
+           cache.bytes / 1024.0, cache.capacidad / 1024.0, cache.invalidadas, cache.expulsadas);
     printf("Top 5 documentos por PageRank:\n");
     mostrarTopPageRank(5);
+    printf("Instrumentacion:\n");
+    volcarInstrumentacion(stdout, 0);
     printf("--------------------------------\n");
 }
 
-void abrirDocumento(const char *nombreArchivo) {
-    printf("Abriendo el documento '%s'...\n", nombreArchivo);
-    char comando[512];
-    snprintf(comando, sizeof(comando), "xdg-open \"%s\" 2>/dev/null || open \"%s\" 2>/dev/null || start \"%s\"", 
-             nombreArchivo, nombreArchivo, nombreArchivo);
-    int status = system(comando);
-    if (status == -1) {
-        printf("Error al intentar abrir el documento '%s'.\n", nombreArchivo);
-    }
-}
-
 void menuPrincipal() {
     int opcion;
-    char consulta[100];
+    char consulta[512];
+    char personalizacion[64];
     do {
         printf("\n--- Motor de Busqueda ---\n");
-        printf("1. Buscar documentos por palabra clave\n");
-        printf("2. Mostrar estadisticas del sistema\n");
-        printf("3. Recalcular PageRank\n");
-        printf("4. Salir\n");
+        printf("1. Buscar documentos (palabras, OR, NOT, \"frases\", NEAR/k, pref*, palabra~)\n");
+        printf("2. Buscar por relevancia (BM25 + PageRank)\n");
+        printf("3. Mostrar estadisticas del sistema\n");
+        printf("4. Recalcular PageRank\n");
+        printf("5. Sincronizar cambios de la carpeta docs\n");
+        printf("6. Salir\n");
         printf("Seleccione una opcion: ");
         if (scanf("%d", &opcion) != 1) {
             printf("Error al leer la opcion. Intente nuevamente.\n");
@@ -153,28 +302,64 @@ void menuPrincipal() {
 
         switch (opcion) {
             case 1:
-                printf("Ingrese una palabra o frase para buscar: ");
+            case 2:
+                printf("Ingrese la consulta (ej: motor busqueda, perro OR gato, -borrador, busq*, "
+                       "\"motor de busqueda\"): ");
                 if (fgets(consulta, sizeof(consulta), stdin) == NULL) {
                     printf("Error al leer la consulta. Intente nuevamente.\n");
                     consulta[0] = '\0'; // Evitar procesar una consulta invalida
                 } else {
                     consulta[strcspn(consulta, "\n")] = 0; // Eliminar salto de linea
-                    convertirAMinusculas(consulta);
-                    buscarDocumentos(consulta);
+                    // Normalizan cada palabra y conservan los operadores
+                    if (opcion == 1) {
+                        buscarDocumentos(consulta);
+                        break;
+                    }
+                    personalizacion[0] = '\0';
+                    if (numPersonalizaciones > 0) {
+                        printf("Personalizacion (");
+                        for (int i = 0; i < numPersonalizaciones; i++) {
+                            printf("%s, ", nombresPersonalizacion[i]);
+                        }
+                        printf("o Enter para el PageRank global): ");
+                        if (fgets(personalizacion, sizeof(personalizacion), stdin) == NULL) {
+                            personalizacion[0] = '\0';
+                        }
+                        personalizacion[strcspn(personalizacion, "\n")] = 0;
+                    }
+                    buscarDocumentosRankeados(consulta, CONSULTA_TOP_K, personalizacion[0] ? personalizacion : NULL);
                 }
                 break;
-            case 2:
-                mostrarEstadisticas();
-                break;
             case 3:
-                calcularPageRank(0.85, 20);
-                printf("PageRank recalculado.\n");
+                mostrarEstadisticas();
                 break;
             case 4:
+                calcularPageRank(PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES, PAGERANK_TOLERANCIA);
+                printf("PageRank recalculado en %d iteraciones (residuo %.2e).\n",
+                       obtenerIteracionesPageRank(), obtenerResiduoPageRank());
+                calcularPersonalizaciones();
+                break;
+            case 5: {
+                ResumenSincronizacion resumen;
+                uint64_t inicio = relojInstrumentacion();
+                int cambios = sincronizarDocumentos(&resumen);
+                if (cambios < 0) {
+                    break;
+                }
+                printf("%d documentos nuevos, %d modificados, %d eliminados", resumen.agregados,
+                       resumen.actualizados, resumen.eliminados);
+                if (cambios > 0) {
+                    printf("; PageRank actualizado con %ld empujes y %d iteraciones (residuo %.2e)",
+                           obtenerEmpujesPageRank(), obtenerIteracionesPageRank(), obtenerResiduoPageRank());
+                }
+                printf(" (%.3f s).\n", (relojInstrumentacion() - inicio) * 1e-9);
+                break;
+            }
+            case 6:
                 printf("Saliendo del programa...\n");
                 break;
             default:
                 printf("Opcion no valida. Intente nuevamente.\n");
         }
-    } while (opcion != 4);
+    } while (opcion != 6);
 }
@@ -0,0 +1,119 @@
+/**
+ * @file personalizacion.c
+ * @brief Implementacion del PageRank personalizado por tema.
+ */
+
+#include "personalizacion.h"
+#include "consulta.h"
+#include "contexto.h"
+#include "graph.h"
+#include "index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Indica si un nombre de personalizacion es valido.
+ *
+ * @param nombre Nombre a revisar.
+ * @return 1 si tiene entre 1 y CONTEXTO_LARGO_PERSONALIZACION - 1 caracteres permitidos, 0 si no.
+ */
+static int nombreValido(const char *nombre) {
+    size_t largo = strlen(nombre);
+    if (largo == 0 || largo >= CONTEXTO_LARGO_PERSONALIZACION) {
+        return 0;
+    }
+    for (size_t i = 0; i < largo; i++) {
+        char c = nombre[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_')) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Calcula y publica un conjunto de vectores de PageRank personalizado.
+ *
+ * @param nombres Nombre de cada personalizacion.
+ * @param consultas Consulta booleana que define las semillas de cada una.
+ * @param numPersonalizaciones Cantidad (como maximo PAGERANK_MAX_LOTE).
+ * @return Iteraciones del calculo, o -1 si hay un error; en ese caso no publica nada.
+ */
+int personalizarPageRank(const char *const *nombres, const char *const *consultas, int numPersonalizaciones) {
+    if (numPersonalizaciones < 0 || numPersonalizaciones > PAGERANK_MAX_LOTE ||
+        numPersonalizaciones > CONTEXTO_MAX_PERSONALIZACIONES) {
+        fprintf(stderr, "Se admiten como maximo %d personalizaciones.\n", PAGERANK_MAX_LOTE);
+        return -1;
+    }
+    if (numPersonalizaciones == 0) {
+        publicarPageRankPersonalizado(NULL);
+        avanzarGeneracionIndice();
+        return 0;
+    }
+    for (int b = 0; b < numPersonalizaciones; b++) {
+        if (!nombreValido(nombres[b])) {
+            fprintf(stderr, "Nombre de personalizacion no valido: '%s'.\n", nombres[b]);
+            return -1;
+        }
+        for (int a = 0; a < b; a++) {
+            if (strcmp(nombres[a], nombres[b]) == 0) {
+                fprintf(stderr, "Personalizacion repetida: '%s'.\n", nombres[b]);
+                return -1;
+            }
+        }
+    }
+
+    int n = obtenerGrafo()->numDocs;
+    int B = numPersonalizaciones;
+    double *teletransporte = calloc((size_t)n * B > 0 ? (size_t)n * B : 1, sizeof(double));
+    if (!teletransporte) {
+        perror("No se pudo reservar memoria para el PageRank personalizado");
+        exit(EXIT_FAILURE);
+    }
+    for (int b = 0; b < B; b++) {
+        int *documentos = NULL;
+        int encontrados = ejecutarConsulta(consultas[b], &documentos);
+        int semillas = 0;
+        for (int i = 0; i < encontrados; i++) {
+            if (documentos[i] >= 0 && documentos[i] < n) {
+                teletransporte[(size_t)documentos[i] * B + b] = 1.0;
+                semillas++;
+            }
+        }
+        free(documentos);
+        if (semillas == 0) {
+            if (encontrados >= 0) {
+                fprintf(stderr, "La consulta de la personalizacion '%s' no encuentra documentos.\n", nombres[b]);
+            }
+            free(teletransporte);
+            return -1;
+        }
+    }
+
+    PageRankPersonalizado *personalizado = crearPageRankPersonalizado(n, B);
+    int iteraciones = calcularPageRankPorLotes(teletransporte, B, PAGERANK_AMORTIGUAMIENTO, PAGERANK_MAX_ITERACIONES,
+                                               PAGERANK_TOLERANCIA, personalizado->rank, &personalizado->residuo);
+    free(teletransporte);
+    if (iteraciones < 0) {
+        free(personalizado);
+        return -1;
+    }
+    personalizado->iteraciones = iteraciones;
+    for (int b = 0; b < B; b++) {
+        strcpy(personalizado->nombres[b], nombres[b]);
+        personalizado->maximo[b] = 0.0;
+    }
+    for (int v = 0; v < n; v++) {
+        for (int b = 0; b < B; b++) {
+            double valor = personalizado->rank[(size_t)v * B + b];
+            if (valor > personalizado->maximo[b]) {
+                personalizado->maximo[b] = valor;
+            }
+        }
+    }
+    publicarPageRankPersonalizado(personalizado);
+    // Los resultados en cache de las consultas personalizadas dejan de valer.
+    avanzarGeneracionIndice();
+    return iteraciones;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file personalizacion.h
+ * @brief PageRank personalizado por tema, calculado por lotes.
+ *
+ * Una personalizacion es un nombre y una consulta booleana: los documentos que
+ * la cumplen forman el conjunto semilla y reciben, por partes iguales, todo el
+ * teletransporte de su vector. Todas las personalizaciones se calculan juntas con
+ * calcularPageRankPorLotes(), que recorre el grafo una sola vez por iteracion
+ * para todo el lote, y se publican en el contexto de lectura (ver contexto.h),
+ * donde las consultas por relevancia las eligen por nombre.
+ *
+ * Los vectores no se guardan en la instantanea: se recalculan al arrancar y al
+ * recalcular el PageRank. Los documentos agregados despues del calculo no tienen
+ * valor personalizado hasta el siguiente.
+ */
+
+#ifndef PERSONALIZACION_H
+#define PERSONALIZACION_H
+
+/**
+ * @brief Calcula y publica un conjunto de vectores de PageRank personalizado.
+ *
+ * Reemplaza el conjunto publicado. Los nombres tienen letras minusculas, digitos,
+ * '-' o '_', menos de CONTEXTO_LARGO_PERSONALIZACION caracteres y no se repiten.
+ * Con cero personalizaciones quita el conjunto vigente.
+ *
+ * @param nombres Nombre de cada personalizacion.
+ * @param consultas Consulta booleana que define las semillas de cada una.
+ * @param numPersonalizaciones Cantidad (como maximo PAGERANK_MAX_LOTE).
+ * @return Iteraciones del calculo, o -1 si un nombre no es valido, una consulta
+ *         tiene un error o no encuentra documentos; en ese caso no publica nada.
+ */
+int personalizarPageRank(const char *const *nombres, const char *const *consultas, int numPersonalizaciones);
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ * @file prueba_consulta.c
+ * @brief Prueba el analisis de las consultas booleanas sobre un corpus chico.
+ *
+ * Arma un directorio temporal con pocos documentos, lo carga y compara el
+ * resultado de cada consulta con los docID esperados. Cubre en especial a que
+ * clausula se une un OR cuando su palabra izquierda es una stopword y que OR no
+ * se combine con palabras negadas.
+ *
+ * Compilacion y ejecucion desde la raiz del repositorio:
+ *     make pruebas
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "consulta.h"
+#include "graph.h"
+#include "index.h"
+#include "ingesta.h"
+
+#define SIN_RESULTADO -1 ///< Marca de las consultas que deben ser rechazadas.
+
+/**
+ * @struct CasoConsulta
+ * @brief Consulta y documentos que debe devolver.
+ */
+typedef struct {
+    const char *consulta; ///< Texto de la consulta.
+    int esperados[8]; ///< docID esperados en orden creciente, terminados en -1; SIN_RESULTADO si es invalida.
+} CasoConsulta;
+
+/**
+ * @brief Contenido de los documentos; el docID es la posicion (los nombres se ordenan igual).
+ */
+static const char *const documentos[] = {
+    "gato", "perro", "casa", "casa perro", "gato perro", "gato casa",
+};
+
+/**
+ * @brief Escribe un archivo.
+ *
+ * @param ruta Ruta del archivo.
+ * @param texto Contenido.
+ * @return 1 si se escribio, 0 si no.
+ */
+static int escribirArchivo(const char *ruta, const char *texto) {
+    FILE *f = fopen(ruta, "w");
+    if (!f) {
+        perror(ruta);
+        return 0;
+    }
+    fprintf(f, "%s\n", texto);
+    return fclose(f) == 0;
+}
+
+/**
+ * @brief Evalua un caso e informa si fallo.
+ *
+ * @param caso Caso a evaluar.
+ * @return 1 si el resultado es el esperado, 0 si no.
+ */
+static int probarConsulta(const CasoConsulta *caso) {
+    int *docs = NULL;
+    int num = ejecutarConsulta(caso->consulta, &docs);
+    int correcto;
+    if (caso->esperados[0] == SIN_RESULTADO) {
+        correcto = num < 0;
+    } else {
+        int esperados = 0;
+        while (caso->esperados[esperados] >= 0) {
+            esperados++;
+        }
+        correcto = num == esperados && (num == 0 || memcmp(docs, caso->esperados, num * sizeof(int)) == 0);
+    }
+    if (!correcto) {
+        fprintf(stderr, "FALLA \"%s\": %d documentos:", caso->consulta, num);
+        for (int i = 0; i < num; i++) {
+            fprintf(stderr, " %d", docs[i]);
+        }
+        fprintf(stderr, "\n");
+    }
+    free(docs);
+    return correcto;
+}
+
+int main() {
+    char directorio[] = "/tmp/prueba_consulta_XXXXXX";
+    if (!mkdtemp(directorio)) {
+        perror("No se pudo crear el directorio de la prueba");
+        return EXIT_FAILURE;
+    }
+    int numDocumentos = (int)(sizeof(documentos) / sizeof(documentos[0]));
+    char ruta[256];
+    for (int i = 0; i < numDocumentos; i++) {
+        snprintf(ruta, sizeof(ruta), "%s/d%d.txt", directorio, i);
+        if (!escribirArchivo(ruta, documentos[i])) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Los mensajes de la carga no son parte de la prueba.
+    FILE *salida = stdout;
+    stdout = fopen("/dev/null", "w");
+    inicializarIndice();
+    inicializarGrafo(0);
+    cargarArchivosEnIndiceYGrafo(directorio, 1);
+    fclose(stdout);
+    stdout = salida;
+
+    static const CasoConsulta casos[] = {
+        {"gato perro", {4, -1}},
+        {"gato OR casa", {0, 2, 3, 4, 5, -1}},
+        {"perro -gato", {1, 3, -1}},
+        // La stopword de la izquierda se descarta y el OR no tiene a que unirse: casa abre su clausula.
+        {"el OR casa perro", {3, -1}},
+        {"gato el OR casa", {5, -1}},
+        {"gato la OR casa OR perro", {4, 5, -1}},
+        // OR con una palabra negada cambiaria cual se excluye: se rechaza.
+        {"-gato OR perro", {SIN_RESULTADO}},
+        {"NOT gato OR perro", {SIN_RESULTADO}},
+        {"casa OR -gato", {SIN_RESULTADO}},
+        {"OR gato", {SIN_RESULTADO}},
+    };
+    int fallas = 0;
+    int numCasos = (int)(sizeof(casos) / sizeof(casos[0]));
+    for (int i = 0; i < numCasos; i++) {
+        fallas += !probarConsulta(&casos[i]);
+    }
+
+    for (int i = 0; i < numDocumentos; i++) {
+        snprintf(ruta, sizeof(ruta), "%s/d%d.txt", directorio, i);
+        unlink(ruta);
+    }
+    rmdir(directorio);
+    printf("prueba_consulta: %d de %d casos correctos\n", numCasos - fallas, numCasos);
+    return fallas ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file prueba_enlaces.c
+ * @brief Prueba que "link:N" se resuelva igual en la carga y en la sincronizacion.
+ *
+ * Arma un directorio temporal en el que el segundo archivo no se puede leer (un
+ * enlace simbolico roto, que falla aunque la prueba corra como root), de modo que
+ * los archivos siguientes tienen un docID menor que su posicion. Carga el
+ * directorio, vuelve a indexar un archivo como lo hace la sincronizacion y
+ * compara los enlaces salientes de cada documento con los esperados. Al final
+ * sincroniza dos archivos nuevos, el primero con enlaces al segundo, que recibe
+ * su docID despues.
+ *
+ * Compilacion y ejecucion desde la raiz del repositorio:
+ *     make pruebas
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "enlaces.h"
+#include "graph.h"
+#include "incremental.h"
+#include "index.h"
+#include "ingesta.h"
+
+/**
+ * @brief Escribe un archivo.
+ *
+ * @param directorio Directorio del archivo.
+ * @param nombre Nombre del archivo.
+ * @param texto Contenido.
+ * @return 1 si se escribio, 0 si no.
+ */
+static int escribirArchivo(const char *directorio, const char *nombre, const char *texto) {
+    char ruta[256];
+    snprintf(ruta, sizeof(ruta), "%s/%s", directorio, nombre);
+    FILE *f = fopen(ruta, "w");
+    if (!f) {
+        perror(ruta);
+        return 0;
+    }
+    fprintf(f, "%s\n", texto);
+    return fclose(f) == 0;
+}
+
+/**
+ * @brief Compara dos docID para ordenarlos con qsort.
+ *
+ * @param a Puntero al primer docID.
+ * @param b Puntero al segundo docID.
+ * @return Negativo, cero o positivo segun el orden.
+ */
+static int compararDestinos(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Compara los enlaces salientes de un documento con los esperados e informa si difieren.
+ *
+ * El orden de los enlaces de un documento sincronizado no esta definido, asi que se ordenan.
+ *
+ * @param caso Descripcion del caso, para el mensaje.
+ * @param origen docID del documento.
+ * @param esperados Destinos esperados en orden creciente, terminados en -1.
+ * @return 1 si coinciden, 0 si no.
+ */
+static int probarEnlaces(const char *caso, int origen, const int *esperados) {
+    congelarGrafo();
+    const Grafo *grafo = obtenerGrafo();
+    size_t inicio = grafo->inicioSalida[origen];
+    size_t fin = grafo->inicioSalida[origen + 1];
+    int numEsperados = 0;
+    while (esperados[numEsperados] >= 0) {
+        numEsperados++;
+    }
+    int destinos[16];
+    int numDestinos = fin - inicio < 16 ? (int)(fin - inicio) : 16;
+    memcpy(destinos, grafo->destinosSalida + inicio, numDestinos * sizeof(int));
+    qsort(destinos, numDestinos, sizeof(int), compararDestinos);
+    int correcto = fin - inicio == (size_t)numEsperados && memcmp(destinos, esperados, numEsperados * sizeof(int)) == 0;
+    if (!correcto) {
+        fprintf(stderr, "FALLA %s: el documento %d enlaza a", caso, origen);
+        for (int e = 0; e < numDestinos; e++) {
+            fprintf(stderr, " %d", destinos[e]);
+        }
+        fprintf(stderr, "\n");
+    }
+    return correcto;
+}
+
+int main() {
+    char directorio[] = "/tmp/prueba_enlaces_XXXXXX";
+    if (!mkdtemp(directorio)) {
+        perror("No se pudo crear el directorio de la prueba");
+        return EXIT_FAILURE;
+    }
+    // docID: a.txt 0, b.txt ninguno, c.txt 1, d.txt 2. "link:2" es d.txt, no c.txt (tercer archivo).
+    char roto[256];
+    snprintf(roto, sizeof(roto), "%s/b.txt", directorio);
+    if (!escribirArchivo(directorio, "a.txt", "alfa link:2 link:c") ||
+        !escribirArchivo(directorio, "c.txt", "gama link:0 link:7") || !escribirArchivo(directorio, "d.txt", "delta") ||
+        symlink("no_existe.txt", roto) != 0) {
+        perror("No se pudo armar el directorio de la prueba");
+        return EXIT_FAILURE;
+    }
+
+    // Los mensajes de la carga no son parte de la prueba.
+    FILE *salida = stdout;
+    FILE *errores = stderr;
+    stdout = fopen("/dev/null", "w");
+    stderr = stdout;
+    inicializarIndice();
+    inicializarGrafo(0);
+    cargarArchivosEnIndiceYGrafo(directorio, 1);
+    iniciarIncremental(directorio);
+    stderr = errores;
+
+    int fallas = 0;
+    int casos = 0;
+    fallas += !probarEnlaces("carga", 0, (const int[]){1, 2, -1});
+    fallas += !probarEnlaces("carga", 1, (const int[]){0, -1});
+    fallas += !probarEnlaces("carga", 2, (const int[]){-1});
+    casos += 3;
+    EstadisticasEnlaces estadisticas;
+    obtenerEstadisticasEnlaces(&estadisticas);
+    if (estadisticas.fueraDeRango != 1) {
+        fprintf(stderr, "FALLA carga: %ld enlaces fuera de rango, se esperaba 1\n", estadisticas.fueraDeRango);
+        fallas++;
+    }
+    casos++;
+
+    // La sincronizacion toma el mismo numero como el mismo documento.
+    char ruta[256];
+    snprintf(ruta, sizeof(ruta), "%s/c.txt", directorio);
+    escribirArchivo(directorio, "c.txt", "gama link:2 link:a");
+    stderr = stdout;
+    int docID = actualizarArchivo(ruta);
+    stderr = errores;
+    if (docID != 1) {
+        fprintf(stderr, "FALLA sincronizacion: c.txt recibio el docID %d\n", docID);
+        fallas++;
+    } else {
+        fallas += !probarEnlaces("sincronizacion", 1, (const int[]){0, 2, -1});
+    }
+    fallas += !probarEnlaces("sincronizacion", 0, (const int[]){1, 2, -1});
+    casos += 2;
+
+    // e.txt (docID 3) enlaza por numero y por nombre a f.txt (docID 4), que se registra despues.
+    escribirArchivo(directorio, "e.txt", "epsilon link:4 link:f");
+    escribirArchivo(directorio, "f.txt", "zeta link:e");
+    EstadisticasEnlaces antes;
+    obtenerEstadisticasEnlaces(&antes);
+    ResumenSincronizacion resumen;
+    stderr = stdout;
+    sincronizarDocumentos(&resumen);
+    stderr = errores;
+    fclose(stdout);
+    stdout = salida;
+    if (resumen.agregados != 2) {
+        fprintf(stderr, "FALLA archivos nuevos: se agregaron %d archivos, se esperaban 2\n", resumen.agregados);
+        fallas++;
+    } else {
+        fallas += !probarEnlaces("archivos nuevos", 3, (const int[]){4, -1});
+        fallas += !probarEnlaces("archivos nuevos", 4, (const int[]){3, -1});
+    }
+    obtenerEstadisticasEnlaces(&estadisticas);
+    if (estadisticas.fueraDeRango != antes.fueraDeRango ||
+        estadisticas.nombresDesconocidos != antes.nombresDesconocidos) {
+        fprintf(stderr, "FALLA archivos nuevos: %ld enlaces fuera de rango y %ld nombres desconocidos nuevos\n",
+                estadisticas.fueraDeRango - antes.fueraDeRango,
+                estadisticas.nombresDesconocidos - antes.nombresDesconocidos);
+        fallas++;
+    }
+    casos += 3;
+
+    unlink(roto);
+    const char *nombres[] = {"a.txt", "c.txt", "d.txt", "e.txt", "f.txt"};
+    for (int i = 0; i < 5; i++) {
+        snprintf(ruta, sizeof(ruta), "%s/%s", directorio, nombres[i]);
+        unlink(ruta);
+    }
+    rmdir(directorio);
+    printf("prueba_enlaces: %d de %d casos correctos\n", casos - fallas, casos);
+    return fallas ? EXIT_FAILURE : 0;
+}
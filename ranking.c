@@ -0,0 +1,153 @@
+/**
+ * @file ranking.c
+ * @brief Implementacion del monticulo de los k mejores resultados.
+ */
+
+#include "ranking.h"
+
+/**
+ * @brief Indica si un resultado es peor que otro.
+ *
+ * @param a Primer resultado.
+ * @param b Segundo resultado.
+ * @return 1 si a va despues de b en el ranking.
+ */
+static int esPeor(const ResultadoRanking *a, const ResultadoRanking *b) {
+    if (a->puntaje != b->puntaje) {
+        return a->puntaje < b->puntaje;
+    }
+    return a->docID > b->docID;
+}
+
+/**
+ * @brief Hunde un elemento hasta restaurar la propiedad de monticulo.
+ *
+ * @param elementos Arreglo del monticulo.
+ * @param tamano Elementos validos.
+ * @param i Posicion del elemento a hundir.
+ */
+static void hundir(ResultadoRanking *elementos, int tamano, int i) {
+    ResultadoRanking x = elementos[i];
+    for (;;) {
+        int hijo = 2 * i + 1;
+        if (hijo >= tamano) {
+            break;
+        }
+        if (hijo + 1 < tamano && esPeor(&elementos[hijo + 1], &elementos[hijo])) {
+            hijo++;
+        }
+        if (!esPeor(&elementos[hijo], &x)) {
+            break;
+        }
+        elementos[i] = elementos[hijo];
+        i = hijo;
+    }
+    elementos[i] = x;
+}
+
+/**
+ * @brief Prepara un monticulo sobre un arreglo provisto por el llamador.
+ *
+ * @param m Monticulo a inicializar.
+ * @param elementos Arreglo de al menos k elementos.
+ * @param k Maximo de resultados a conservar.
+ */
+void iniciarTopK(MonticuloTopK *m, ResultadoRanking *elementos, int k) {
+    m->elementos = elementos;
+    m->tamano = 0;
+    m->k = k > 0 ? k : 0;
+}
+
+/**
+ * @brief Ofrece un resultado al monticulo.
+ *
+ * Mientras no esta lleno, el resultado se agrega y sube a su lugar. Lleno, solo
+ * entra si es mejor que la raiz, a la que reemplaza.
+ *
+ * @param m Monticulo.
+ * @param docID Documento.
+ * @param puntaje Puntaje del documento.
+ * @return 1 si el resultado quedo entre los k mejores, 0 si se descarto.
+ */
+int ofrecerTopK(MonticuloTopK *m, int docID, double puntaje) {
+    ResultadoRanking nuevo = {docID, puntaje};
+    if (m->tamano < m->k) {
+        int i = m->tamano++;
+        while (i > 0) {
+            int padre = (i - 1) / 2;
+            if (!esPeor(&nuevo, &m->elementos[padre])) {
+                break;
+            }
+            m->elementos[i] = m->elementos[padre];
+            i = padre;
+        }
+        m->elementos[i] = nuevo;
+        return 1;
+    }
+    if (m->k == 0 || !esPeor(&m->elementos[0], &nuevo)) {
+        return 0;
+    }
+    m->elementos[0] = nuevo;
+    hundir(m->elementos, m->tamano, 0);
+    return 1;
+}
+
+/**
+ * @brief Indica si el monticulo ya tiene k resultados.
+ *
+ * @param m Monticulo.
+ * @return 1 si esta lleno, 0 en caso contrario.
+ */
+int topKLleno(const MonticuloTopK *m) {
+    return m->tamano == m->k;
+}
+
+/**
+ * @brief Devuelve el puntaje que un resultado nuevo debe superar para entrar.
+ *
+ * @param m Monticulo.
+ * @return Puntaje del peor resultado guardado.
+ */
+double umbralTopK(const MonticuloTopK *m) {
+    return m->elementos[0].puntaje;
+}
+
+/**
+ * @brief Ordena los resultados del mejor al peor.
+ *
+ * Extrae la raiz repetidamente y la deja al final de la zona ya ordenada,
+ * como en heapsort.
+ *
+ * @param m Monticulo.
+ * @return Numero de resultados, ordenados en m->elementos.
+ */
+int ordenarTopK(MonticuloTopK *m) {
+    for (int fin = m->tamano - 1; fin > 0; fin--) {
+        ResultadoRanking peor = m->elementos[0];
+        m->elementos[0] = m->elementos[fin];
+        m->elementos[fin] = peor;
+        hundir(m->elementos, fin, 0);
+    }
+    return m->tamano;
+}
+
+/**
+ * @brief Selecciona los k mayores puntajes de un vector indexado por docID.
+ *
+ * @param puntajes Puntaje de cada documento.
+ * @param n Numero de documentos.
+ * @param k Numero de resultados pedidos.
+ * @param salida Arreglo de al menos k elementos; queda ordenado del mejor al peor.
+ * @return Numero de resultados (el menor entre k y n).
+ */
+int seleccionarTopK(const double *puntajes, int n, int k, ResultadoRanking *salida) {
+    MonticuloTopK m;
+    iniciarTopK(&m, salida, k < n ? k : n);
+    for (int i = 0; i < n; i++) {
+        // Con el monticulo lleno, la mayoria de los valores se descarta con esta comparacion.
+        if (!topKLleno(&m) || puntajes[i] > umbralTopK(&m)) {
+            ofrecerTopK(&m, i, puntajes[i]);
+        }
+    }
+    return ordenarTopK(&m);
+}
@@ -0,0 +1,95 @@
+/**
+ * @file ranking.h
+ * @brief Seleccion de los k mejores documentos con un monticulo acotado.
+ *
+ * El monticulo guarda a lo sumo k resultados y tiene en la raiz el peor de
+ * ellos, de modo que cada candidato se compara en tiempo constante con el
+ * umbral de entrada y solo los que lo superan cuestan O(log k).
+ */
+
+#ifndef RANKING_H
+#define RANKING_H
+
+/**
+ * @struct ResultadoRanking
+ * @brief Documento con su puntaje.
+ */
+typedef struct {
+    int docID; ///< Identificador del documento.
+    double puntaje; ///< Puntaje del documento; mayor es mejor.
+} ResultadoRanking;
+
+/**
+ * @struct MonticuloTopK
+ * @brief Monticulo de minimos con los k mejores resultados vistos.
+ *
+ * A igual puntaje gana el docID menor, para que el orden sea determinista.
+ */
+typedef struct {
+    ResultadoRanking *elementos; ///< Resultados; elementos[0] es el peor.
+    int tamano; ///< Resultados guardados.
+    int k; ///< Maximo de resultados.
+} MonticuloTopK;
+
+/**
+ * @brief Prepara un monticulo sobre un arreglo provisto por el llamador.
+ *
+ * @param m Monticulo a inicializar.
+ * @param elementos Arreglo de al menos k elementos.
+ * @param k Maximo de resultados a conservar.
+ */
+void iniciarTopK(MonticuloTopK *m, ResultadoRanking *elementos, int k);
+
+/**
+ * @brief Ofrece un resultado al monticulo.
+ *
+ * @param m Monticulo.
+ * @param docID Documento.
+ * @param puntaje Puntaje del documento.
+ * @return 1 si el resultado quedo entre los k mejores, 0 si se descarto.
+ */
+int ofrecerTopK(MonticuloTopK *m, int docID, double puntaje);
+
+/**
+ * @brief Indica si el monticulo ya tiene k resultados.
+ *
+ * @param m Monticulo.
+ * @return 1 si esta lleno, 0 en caso contrario.
+ */
+int topKLleno(const MonticuloTopK *m);
+
+/**
+ * @brief Devuelve el puntaje que un resultado nuevo debe superar para entrar.
+ *
+ * Solo tiene sentido con el monticulo lleno.
+ *
+ * @param m Monticulo.
+ * @return Puntaje del peor resultado guardado.
+ */
+double umbralTopK(const MonticuloTopK *m);
+
+/**
+ * @brief Ordena los resultados del mejor al peor.
+ *
+ * Despues de llamarla el arreglo deja de ser un monticulo.
+ *
+ * @param m Monticulo.
+ * @return Numero de resultados, ordenados en m->elementos.
+ */
+int ordenarTopK(MonticuloTopK *m);
+
+/**
+ * @brief Selecciona los k mayores puntajes de un vector indexado por docID.
+ *
+ * Recorre el vector una vez con un monticulo de k elementos: O(n log k) en el
+ * peor caso y casi O(n) cuando pocos valores superan el umbral.
+ *
+ * @param puntajes Puntaje de cada documento.
+ * @param n Numero de documentos.
+ * @param k Numero de resultados pedidos.
+ * @param salida Arreglo de al menos k elementos; queda ordenado del mejor al peor.
+ * @return Numero de resultados (el menor entre k y n).
+ */
+int seleccionarTopK(const double *puntajes, int n, int k, ResultadoRanking *salida);
+
+#endif
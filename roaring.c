@@ -0,0 +1,694 @@
+/**
+ * @file roaring.c
+ * @brief Implementacion de los conjuntos de docID al estilo Roaring.
+ */
+
+#include "roaring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define ROARING_BYTES_MAPA (ROARING_PALABRAS_MAPA * sizeof(uint64_t)) ///< Bytes del mapa de bits de un contenedor.
+#define ROARING_CAPACIDAD_INICIAL 8 ///< Elementos que reserva un arreglo nuevo armado de a uno.
+#define ROARING_PROPORCION_GALOPE 64 ///< Diferencia de tamanos desde la que se interseca con busqueda exponencial.
+
+/**
+ * @brief Operacion entre dos mapas de bits.
+ */
+typedef enum {
+    MAPA_Y, ///< Interseccion.
+    MAPA_O, ///< Union.
+    MAPA_Y_NO, ///< Diferencia.
+} OperacionMapa;
+
+/**
+ * @brief Reserva memoria o termina el programa.
+ *
+ * @param bytes Bytes a reservar.
+ * @return Memoria reservada.
+ */
+static void *reservarRoaring(size_t bytes) {
+    void *memoria = malloc(bytes ? bytes : 1);
+    if (!memoria) {
+        perror("No se pudo reservar memoria para un conjunto de documentos");
+        exit(EXIT_FAILURE);
+    }
+    return memoria;
+}
+
+/**
+ * @brief Cambia el tamano de un bloque o termina el programa.
+ *
+ * @param memoria Bloque a cambiar.
+ * @param bytes Bytes nuevos.
+ * @return Bloque con el tamano nuevo.
+ */
+static void *ampliarRoaring(void *memoria, size_t bytes) {
+    void *nueva = realloc(memoria, bytes ? bytes : 1);
+    if (!nueva) {
+        perror("No se pudo reservar memoria para un conjunto de documentos");
+        exit(EXIT_FAILURE);
+    }
+    return nueva;
+}
+
+/**
+ * @brief Cuenta los bits en 1 de una palabra.
+ *
+ * Sin la instruccion popcnt, la suma en paralelo por campos evita la llamada a
+ * la rutina de la biblioteca del compilador.
+ *
+ * @param x Palabra.
+ * @return Bits en 1.
+ */
+static inline int contarBits(uint64_t x) {
+#if defined(__POPCNT__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * @brief Cuenta los bits en 1 de un mapa completo.
+ *
+ * @param mapa Mapa de bits.
+ * @return Bits en 1.
+ */
+static int contarMapa(const uint64_t *mapa) {
+    int total = 0;
+    for (int i = 0; i < ROARING_PALABRAS_MAPA; i++) {
+        total += contarBits(mapa[i]);
+    }
+    return total;
+}
+
+/**
+ * @brief Combina dos mapas de bits y cuenta el resultado.
+ *
+ * @param a Primer mapa.
+ * @param b Segundo mapa.
+ * @param destino Salida (puede ser a o b).
+ * @param operacion Operacion a aplicar.
+ * @return Bits en 1 del resultado.
+ */
+static int combinarMapas(const uint64_t *a, const uint64_t *b, uint64_t *destino, OperacionMapa operacion) {
+#if defined(__SSE2__)
+    const __m128i *x = (const __m128i *)a;
+    const __m128i *y = (const __m128i *)b;
+    __m128i *z = (__m128i *)destino;
+    switch (operacion) {
+        case MAPA_Y:
+            for (int i = 0; i < ROARING_PALABRAS_MAPA / 2; i++) {
+                _mm_storeu_si128(z + i, _mm_and_si128(_mm_loadu_si128(x + i), _mm_loadu_si128(y + i)));
+            }
+            break;
+        case MAPA_O:
+            for (int i = 0; i < ROARING_PALABRAS_MAPA / 2; i++) {
+                _mm_storeu_si128(z + i, _mm_or_si128(_mm_loadu_si128(x + i), _mm_loadu_si128(y + i)));
+            }
+            break;
+        case MAPA_Y_NO:
+            for (int i = 0; i < ROARING_PALABRAS_MAPA / 2; i++) {
+                _mm_storeu_si128(z + i, _mm_andnot_si128(_mm_loadu_si128(y + i), _mm_loadu_si128(x + i)));
+            }
+            break;
+    }
+#else
+    for (int i = 0; i < ROARING_PALABRAS_MAPA; i++) {
+        destino[i] = operacion == MAPA_Y ? a[i] & b[i] : operacion == MAPA_O ? a[i] | b[i] : a[i] & ~b[i];
+    }
+#endif
+    return contarMapa(destino);
+}
+
+/**
+ * @brief Copia los elementos de un mapa de bits a un arreglo ordenado.
+ *
+ * @param mapa Mapa de bits.
+ * @param destino Arreglo con lugar para todos los elementos.
+ * @return Elementos escritos.
+ */
+static int extraerMapa(const uint64_t *mapa, uint16_t *destino) {
+    int n = 0;
+    for (int i = 0; i < ROARING_PALABRAS_MAPA; i++) {
+        uint64_t palabra = mapa[i];
+        while (palabra) {
+            destino[n++] = (uint16_t)(i * 64 + __builtin_ctzll(palabra));
+            palabra &= palabra - 1;
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Pasa un contenedor de mapa a arreglo si tiene pocos elementos.
+ *
+ * @param c Contenedor con su cardinalidad ya calculada.
+ */
+static void normalizarContenedor(ContenedorRoaring *c) {
+    if (c->tipo == CONTENEDOR_MAPA && c->cardinalidad <= ROARING_MAX_ARREGLO) {
+        uint16_t *arreglo = reservarRoaring((size_t)c->cardinalidad * sizeof(uint16_t));
+        extraerMapa(c->mapa, arreglo);
+        free(c->mapa);
+        c->tipo = CONTENEDOR_ARREGLO;
+        c->arreglo = arreglo;
+    }
+}
+
+/**
+ * @brief Agrega un contenedor al final de un conjunto, o lo libera si quedo vacio.
+ *
+ * @param conjunto Conjunto de destino.
+ * @param c Contenedor con clave mayor que la del ultimo; sus datos pasan al conjunto.
+ */
+static void agregarContenedor(ConjuntoRoaring *conjunto, const ContenedorRoaring *c) {
+    if (c->cardinalidad == 0) {
+        free(c->tipo == CONTENEDOR_MAPA ? (void *)c->mapa : (void *)c->arreglo);
+        return;
+    }
+    if (conjunto->numContenedores == conjunto->capacidad) {
+        conjunto->capacidad = conjunto->capacidad ? conjunto->capacidad * 2 : 4;
+        conjunto->contenedores =
+            ampliarRoaring(conjunto->contenedores, (size_t)conjunto->capacidad * sizeof(ContenedorRoaring));
+    }
+    conjunto->contenedores[conjunto->numContenedores++] = *c;
+    conjunto->cardinalidad += c->cardinalidad;
+}
+
+/**
+ * @brief Agrega al conjunto una copia de un contenedor.
+ *
+ * @param conjunto Conjunto de destino.
+ * @param c Contenedor a copiar.
+ */
+static void copiarContenedor(ConjuntoRoaring *conjunto, const ContenedorRoaring *c) {
+    ContenedorRoaring copia = *c;
+    if (c->tipo == CONTENEDOR_MAPA) {
+        copia.mapa = reservarRoaring(ROARING_BYTES_MAPA);
+        memcpy(copia.mapa, c->mapa, ROARING_BYTES_MAPA);
+    } else {
+        copia.arreglo = reservarRoaring((size_t)c->cardinalidad * sizeof(uint16_t));
+        memcpy(copia.arreglo, c->arreglo, (size_t)c->cardinalidad * sizeof(uint16_t));
+    }
+    agregarContenedor(conjunto, &copia);
+}
+
+/**
+ * @brief Crea un conjunto vacio.
+ *
+ * @return Conjunto nuevo.
+ */
+ConjuntoRoaring *crearConjuntoRoaring() {
+    ConjuntoRoaring *conjunto = reservarRoaring(sizeof(ConjuntoRoaring));
+    memset(conjunto, 0, sizeof(*conjunto));
+    return conjunto;
+}
+
+/**
+ * @brief Agrega un documento mayor que todos los del conjunto.
+ *
+ * Los arreglos en construccion tienen como capacidad la potencia de dos que
+ * sigue a su cardinalidad (al menos ROARING_CAPACIDAD_INICIAL), asi que no hace
+ * falta guardarla.
+ *
+ * @param conjunto Conjunto a ampliar.
+ * @param docID Documento, mayor que el ultimo agregado.
+ */
+void agregarAlFinalConjunto(ConjuntoRoaring *conjunto, int docID) {
+    uint16_t clave = (uint16_t)((uint32_t)docID >> 16);
+    uint16_t bajo = (uint16_t)docID;
+    ContenedorRoaring *c = conjunto->numContenedores ? &conjunto->contenedores[conjunto->numContenedores - 1] : NULL;
+    if (!c || c->clave != clave) {
+        ContenedorRoaring nuevo;
+        nuevo.clave = clave;
+        nuevo.tipo = CONTENEDOR_ARREGLO;
+        nuevo.cardinalidad = 1;
+        nuevo.arreglo = reservarRoaring(ROARING_CAPACIDAD_INICIAL * sizeof(uint16_t));
+        nuevo.arreglo[0] = bajo;
+        agregarContenedor(conjunto, &nuevo);
+        return;
+    }
+    if (c->tipo == CONTENEDOR_MAPA) {
+        c->mapa[bajo >> 6] |= 1ULL << (bajo & 63);
+    } else if (c->cardinalidad == ROARING_MAX_ARREGLO) {
+        uint64_t *mapa = reservarRoaring(ROARING_BYTES_MAPA);
+        memset(mapa, 0, ROARING_BYTES_MAPA);
+        for (int i = 0; i < c->cardinalidad; i++) {
+            mapa[c->arreglo[i] >> 6] |= 1ULL << (c->arreglo[i] & 63);
+        }
+        mapa[bajo >> 6] |= 1ULL << (bajo & 63);
+        free(c->arreglo);
+        c->tipo = CONTENEDOR_MAPA;
+        c->mapa = mapa;
+    } else {
+        int n = c->cardinalidad;
+        if (n >= ROARING_CAPACIDAD_INICIAL && (n & (n - 1)) == 0) {
+            c->arreglo = ampliarRoaring(c->arreglo, 2 * (size_t)n * sizeof(uint16_t));
+        }
+        c->arreglo[n] = bajo;
+    }
+    c->cardinalidad++;
+    conjunto->cardinalidad++;
+}
+
+/**
+ * @brief Ajusta los arreglos de un conjunto armado con agregarAlFinalConjunto() a su tamano justo.
+ *
+ * @param conjunto Conjunto terminado.
+ */
+void ajustarConjunto(ConjuntoRoaring *conjunto) {
+    for (int i = 0; i < conjunto->numContenedores; i++) {
+        ContenedorRoaring *c = &conjunto->contenedores[i];
+        if (c->tipo == CONTENEDOR_ARREGLO) {
+            c->arreglo = ampliarRoaring(c->arreglo, (size_t)c->cardinalidad * sizeof(uint16_t));
+        }
+    }
+    if (conjunto->capacidad > conjunto->numContenedores) {
+        conjunto->capacidad = conjunto->numContenedores;
+        conjunto->contenedores =
+            ampliarRoaring(conjunto->contenedores, (size_t)conjunto->capacidad * sizeof(ContenedorRoaring));
+    }
+}
+
+/**
+ * @brief Crea un conjunto a partir de un arreglo ordenado.
+ *
+ * @param docs docID en orden estrictamente creciente, no negativos.
+ * @param num Elementos de docs.
+ * @return Conjunto nuevo.
+ */
+ConjuntoRoaring *crearConjuntoDesdeArreglo(const int *docs, long num) {
+    ConjuntoRoaring *conjunto = crearConjuntoRoaring();
+    for (long i = 0; i < num; i++) {
+        agregarAlFinalConjunto(conjunto, docs[i]);
+    }
+    ajustarConjunto(conjunto);
+    return conjunto;
+}
+
+/**
+ * @brief Libera un conjunto.
+ *
+ * @param conjunto Conjunto a liberar (puede ser NULL).
+ */
+void liberarConjuntoRoaring(ConjuntoRoaring *conjunto) {
+    if (!conjunto) {
+        return;
+    }
+    for (int i = 0; i < conjunto->numContenedores; i++) {
+        ContenedorRoaring *c = &conjunto->contenedores[i];
+        free(c->tipo == CONTENEDOR_MAPA ? (void *)c->mapa : (void *)c->arreglo);
+    }
+    free(conjunto->contenedores);
+    free(conjunto);
+}
+
+/**
+ * @brief Busca con pasos exponenciales la primera posicion de un arreglo con valor >= objetivo.
+ *
+ * @param valores Arreglo ordenado.
+ * @param num Elementos del arreglo.
+ * @param desde Posicion desde la que buscar.
+ * @param objetivo Valor buscado.
+ * @return Primera posicion con valores[pos] >= objetivo, o num si no hay.
+ */
+static int galopar(const uint16_t *valores, int num, int desde, uint16_t objetivo) {
+    if (desde >= num || valores[desde] >= objetivo) {
+        return desde;
+    }
+    int bajo = desde;
+    int paso = 1;
+    while (bajo + paso < num && valores[bajo + paso] < objetivo) {
+        bajo += paso;
+        paso *= 2;
+    }
+    int alto = bajo + paso < num ? bajo + paso : num;
+    while (bajo + 1 < alto) {
+        int medio = bajo + (alto - bajo) / 2;
+        if (valores[medio] < objetivo) {
+            bajo = medio;
+        } else {
+            alto = medio;
+        }
+    }
+    return alto;
+}
+
+/**
+ * @brief Interseca dos contenedores con la misma clave.
+ *
+ * @param a Primer contenedor.
+ * @param b Segundo contenedor.
+ * @param resultado Salida: contenedor con sus datos reservados (cardinalidad 0 si quedo vacio).
+ */
+static void intersecarContenedores(const ContenedorRoaring *a, const ContenedorRoaring *b,
+                                   ContenedorRoaring *resultado) {
+    resultado->clave = a->clave;
+    if (a->tipo == CONTENEDOR_MAPA && b->tipo == CONTENEDOR_MAPA) {
+        resultado->tipo = CONTENEDOR_MAPA;
+        resultado->mapa = reservarRoaring(ROARING_BYTES_MAPA);
+        resultado->cardinalidad = combinarMapas(a->mapa, b->mapa, resultado->mapa, MAPA_Y);
+        normalizarContenedor(resultado);
+        return;
+    }
+    if (a->tipo == CONTENEDOR_MAPA || (b->tipo == CONTENEDOR_ARREGLO && a->cardinalidad > b->cardinalidad)) {
+        const ContenedorRoaring *temporal = a;
+        a = b;
+        b = temporal;
+    }
+    // a es un arreglo y, si b tambien lo es, el mas chico de los dos.
+    const uint16_t *x = a->arreglo;
+    int n = 0;
+    resultado->tipo = CONTENEDOR_ARREGLO;
+    resultado->arreglo = reservarRoaring((size_t)a->cardinalidad * sizeof(uint16_t));
+    if (b->tipo == CONTENEDOR_MAPA) {
+        for (int i = 0; i < a->cardinalidad; i++) {
+            resultado->arreglo[n] = x[i];
+            n += (int)((b->mapa[x[i] >> 6] >> (x[i] & 63)) & 1);
+        }
+    } else if (b->cardinalidad / a->cardinalidad >= ROARING_PROPORCION_GALOPE) {
+        int j = 0;
+        for (int i = 0; i < a->cardinalidad && j < b->cardinalidad; i++) {
+            j = galopar(b->arreglo, b->cardinalidad, j, x[i]);
+            if (j < b->cardinalidad && b->arreglo[j] == x[i]) {
+                resultado->arreglo[n++] = x[i];
+            }
+        }
+    } else {
+        const uint16_t *y = b->arreglo;
+        int i = 0;
+        int j = 0;
+        while (i < a->cardinalidad && j < b->cardinalidad) {
+            if (x[i] < y[j]) {
+                i++;
+            } else if (x[i] > y[j]) {
+                j++;
+            } else {
+                resultado->arreglo[n++] = x[i];
+                i++;
+                j++;
+            }
+        }
+    }
+    resultado->cardinalidad = n;
+    if (n > 0 && n < a->cardinalidad) {
+        resultado->arreglo = ampliarRoaring(resultado->arreglo, (size_t)n * sizeof(uint16_t));
+    }
+}
+
+/**
+ * @brief Une dos contenedores con la misma clave.
+ *
+ * @param a Primer contenedor.
+ * @param b Segundo contenedor.
+ * @param resultado Salida: contenedor con sus datos reservados.
+ */
+static void unirContenedores(const ContenedorRoaring *a, const ContenedorRoaring *b, ContenedorRoaring *resultado) {
+    resultado->clave = a->clave;
+    if (a->tipo == CONTENEDOR_MAPA && b->tipo == CONTENEDOR_MAPA) {
+        resultado->tipo = CONTENEDOR_MAPA;
+        resultado->mapa = reservarRoaring(ROARING_BYTES_MAPA);
+        resultado->cardinalidad = combinarMapas(a->mapa, b->mapa, resultado->mapa, MAPA_O);
+        return;
+    }
+    if (a->tipo == CONTENEDOR_MAPA) {
+        const ContenedorRoaring *temporal = a;
+        a = b;
+        b = temporal;
+    }
+    // a es un arreglo.
+    if (b->tipo == CONTENEDOR_ARREGLO && a->cardinalidad + b->cardinalidad <= ROARING_MAX_ARREGLO) {
+        const uint16_t *x = a->arreglo;
+        const uint16_t *y = b->arreglo;
+        int i = 0;
+        int j = 0;
+        int n = 0;
+        resultado->tipo = CONTENEDOR_ARREGLO;
+        resultado->arreglo = reservarRoaring((size_t)(a->cardinalidad + b->cardinalidad) * sizeof(uint16_t));
+        while (i < a->cardinalidad && j < b->cardinalidad) {
+            uint16_t menor = x[i] < y[j] ? x[i] : y[j];
+            i += x[i] == menor;
+            j += y[j] == menor;
+            resultado->arreglo[n++] = menor;
+        }
+        while (i < a->cardinalidad) {
+            resultado->arreglo[n++] = x[i++];
+        }
+        while (j < b->cardinalidad) {
+            resultado->arreglo[n++] = y[j++];
+        }
+        resultado->cardinalidad = n;
+        if (n < a->cardinalidad + b->cardinalidad) {
+            resultado->arreglo = ampliarRoaring(resultado->arreglo, (size_t)n * sizeof(uint16_t));
+        }
+        return;
+    }
+    resultado->tipo = CONTENEDOR_MAPA;
+    resultado->mapa = reservarRoaring(ROARING_BYTES_MAPA);
+    int cardinalidad;
+    if (b->tipo == CONTENEDOR_MAPA) {
+        memcpy(resultado->mapa, b->mapa, ROARING_BYTES_MAPA);
+        cardinalidad = b->cardinalidad;
+    } else {
+        memset(resultado->mapa, 0, ROARING_BYTES_MAPA);
+        for (int j = 0; j < b->cardinalidad; j++) {
+            resultado->mapa[b->arreglo[j] >> 6] |= 1ULL << (b->arreglo[j] & 63);
+        }
+        cardinalidad = b->cardinalidad;
+    }
+    for (int i = 0; i < a->cardinalidad; i++) {
+        uint64_t *palabra = &resultado->mapa[a->arreglo[i] >> 6];
+        uint64_t bit = 1ULL << (a->arreglo[i] & 63);
+        cardinalidad += (*palabra & bit) == 0;
+        *palabra |= bit;
+    }
+    resultado->cardinalidad = cardinalidad;
+    normalizarContenedor(resultado);
+}
+
+/**
+ * @brief Resta dos contenedores con la misma clave.
+ *
+ * @param a Contenedor del que se restan elementos.
+ * @param b Elementos a quitar.
+ * @param resultado Salida: contenedor con sus datos reservados (cardinalidad 0 si quedo vacio).
+ */
+static void restarContenedores(const ContenedorRoaring *a, const ContenedorRoaring *b, ContenedorRoaring *resultado) {
+    resultado->clave = a->clave;
+    if (a->tipo == CONTENEDOR_MAPA) {
+        resultado->tipo = CONTENEDOR_MAPA;
+        resultado->mapa = reservarRoaring(ROARING_BYTES_MAPA);
+        if (b->tipo == CONTENEDOR_MAPA) {
+            resultado->cardinalidad = combinarMapas(a->mapa, b->mapa, resultado->mapa, MAPA_Y_NO);
+        } else {
+            memcpy(resultado->mapa, a->mapa, ROARING_BYTES_MAPA);
+            int cardinalidad = a->cardinalidad;
+            for (int j = 0; j < b->cardinalidad; j++) {
+                uint64_t *palabra = &resultado->mapa[b->arreglo[j] >> 6];
+                uint64_t bit = 1ULL << (b->arreglo[j] & 63);
+                cardinalidad -= (*palabra & bit) != 0;
+                *palabra &= ~bit;
+            }
+            resultado->cardinalidad = cardinalidad;
+        }
+        normalizarContenedor(resultado);
+        return;
+    }
+    const uint16_t *x = a->arreglo;
+    int n = 0;
+    resultado->tipo = CONTENEDOR_ARREGLO;
+    resultado->arreglo = reservarRoaring((size_t)a->cardinalidad * sizeof(uint16_t));
+    if (b->tipo == CONTENEDOR_MAPA) {
+        for (int i = 0; i < a->cardinalidad; i++) {
+            resultado->arreglo[n] = x[i];
+            n += (int)(((b->mapa[x[i] >> 6] >> (x[i] & 63)) & 1) ^ 1);
+        }
+    } else {
+        const uint16_t *y = b->arreglo;
+        int j = 0;
+        for (int i = 0; i < a->cardinalidad; i++) {
+            while (j < b->cardinalidad && y[j] < x[i]) {
+                j++;
+            }
+            if (j == b->cardinalidad || y[j] != x[i]) {
+                resultado->arreglo[n++] = x[i];
+            }
+        }
+    }
+    resultado->cardinalidad = n;
+    if (n > 0 && n < a->cardinalidad) {
+        resultado->arreglo = ampliarRoaring(resultado->arreglo, (size_t)n * sizeof(uint16_t));
+    }
+}
+
+/**
+ * @brief Calcula la interseccion de dos conjuntos.
+ *
+ * @param a Primer conjunto.
+ * @param b Segundo conjunto.
+ * @return Conjunto nuevo con los documentos que estan en ambos.
+ */
+ConjuntoRoaring *intersecarConjuntos(const ConjuntoRoaring *a, const ConjuntoRoaring *b) {
+    ConjuntoRoaring *resultado = crearConjuntoRoaring();
+    int i = 0;
+    int j = 0;
+    while (i < a->numContenedores && j < b->numContenedores) {
+        const ContenedorRoaring *x = &a->contenedores[i];
+        const ContenedorRoaring *y = &b->contenedores[j];
+        if (x->clave < y->clave) {
+            i++;
+        } else if (x->clave > y->clave) {
+            j++;
+        } else {
+            ContenedorRoaring c;
+            intersecarContenedores(x, y, &c);
+            agregarContenedor(resultado, &c);
+            i++;
+            j++;
+        }
+    }
+    return resultado;
+}
+
+/**
+ * @brief Calcula la union de dos conjuntos.
+ *
+ * @param a Primer conjunto.
+ * @param b Segundo conjunto.
+ * @return Conjunto nuevo con los documentos que estan en alguno.
+ */
+ConjuntoRoaring *unirConjuntos(const ConjuntoRoaring *a, const ConjuntoRoaring *b) {
+    ConjuntoRoaring *resultado = crearConjuntoRoaring();
+    int i = 0;
+    int j = 0;
+    while (i < a->numContenedores || j < b->numContenedores) {
+        const ContenedorRoaring *x = i < a->numContenedores ? &a->contenedores[i] : NULL;
+        const ContenedorRoaring *y = j < b->numContenedores ? &b->contenedores[j] : NULL;
+        if (x && (!y || x->clave < y->clave)) {
+            copiarContenedor(resultado, x);
+            i++;
+        } else if (!x || y->clave < x->clave) {
+            copiarContenedor(resultado, y);
+            j++;
+        } else {
+            ContenedorRoaring c;
+            unirContenedores(x, y, &c);
+            agregarContenedor(resultado, &c);
+            i++;
+            j++;
+        }
+    }
+    return resultado;
+}
+
+/**
+ * @brief Calcula la diferencia de dos conjuntos.
+ *
+ * @param a Conjunto del que se restan documentos.
+ * @param b Documentos a quitar.
+ * @return Conjunto nuevo con los documentos de a que no estan en b.
+ */
+ConjuntoRoaring *restarConjuntos(const ConjuntoRoaring *a, const ConjuntoRoaring *b) {
+    ConjuntoRoaring *resultado = crearConjuntoRoaring();
+    int j = 0;
+    for (int i = 0; i < a->numContenedores; i++) {
+        const ContenedorRoaring *x = &a->contenedores[i];
+        while (j < b->numContenedores && b->contenedores[j].clave < x->clave) {
+            j++;
+        }
+        if (j < b->numContenedores && b->contenedores[j].clave == x->clave) {
+            ContenedorRoaring c;
+            restarContenedores(x, &b->contenedores[j], &c);
+            agregarContenedor(resultado, &c);
+        } else {
+            copiarContenedor(resultado, x);
+        }
+    }
+    return resultado;
+}
+
+/**
+ * @brief Indica si un documento esta en un conjunto.
+ *
+ * @param conjunto Conjunto.
+ * @param docID Documento.
+ * @return 1 si esta, 0 si no.
+ */
+int contieneConjunto(const ConjuntoRoaring *conjunto, int docID) {
+    if (docID < 0) {
+        return 0;
+    }
+    uint16_t clave = (uint16_t)((uint32_t)docID >> 16);
+    uint16_t bajo = (uint16_t)docID;
+    int inicio = 0;
+    int fin = conjunto->numContenedores;
+    while (inicio < fin) {
+        int medio = inicio + (fin - inicio) / 2;
+        if (conjunto->contenedores[medio].clave < clave) {
+            inicio = medio + 1;
+        } else {
+            fin = medio;
+        }
+    }
+    if (inicio == conjunto->numContenedores || conjunto->contenedores[inicio].clave != clave) {
+        return 0;
+    }
+    const ContenedorRoaring *c = &conjunto->contenedores[inicio];
+    if (c->tipo == CONTENEDOR_MAPA) {
+        return (int)((c->mapa[bajo >> 6] >> (bajo & 63)) & 1);
+    }
+    int posicion = galopar(c->arreglo, c->cardinalidad, 0, bajo);
+    return posicion < c->cardinalidad && c->arreglo[posicion] == bajo;
+}
+
+/**
+ * @brief Copia los documentos de un conjunto a un arreglo, en orden creciente.
+ *
+ * @param conjunto Conjunto.
+ * @param destino Arreglo de al menos conjunto->cardinalidad elementos.
+ * @return Elementos escritos.
+ */
+long extraerConjunto(const ConjuntoRoaring *conjunto, int *destino) {
+    long n = 0;
+    for (int i = 0; i < conjunto->numContenedores; i++) {
+        const ContenedorRoaring *c = &conjunto->contenedores[i];
+        int base = (int)c->clave << 16;
+        if (c->tipo == CONTENEDOR_MAPA) {
+            for (int w = 0; w < ROARING_PALABRAS_MAPA; w++) {
+                uint64_t palabra = c->mapa[w];
+                while (palabra) {
+                    destino[n++] = base + w * 64 + __builtin_ctzll(palabra);
+                    palabra &= palabra - 1;
+                }
+            }
+        } else {
+            for (int k = 0; k < c->cardinalidad; k++) {
+                destino[n++] = base + c->arreglo[k];
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Calcula los bytes que ocupa un conjunto.
+ *
+ * @param conjunto Conjunto.
+ * @return Bytes de la estructura, los contenedores y sus datos.
+ */
+size_t bytesConjunto(const ConjuntoRoaring *conjunto) {
+    size_t bytes = sizeof(ConjuntoRoaring) + (size_t)conjunto->capacidad * sizeof(ContenedorRoaring);
+    for (int i = 0; i < conjunto->numContenedores; i++) {
+        const ContenedorRoaring *c = &conjunto->contenedores[i];
+        bytes += c->tipo == CONTENEDOR_MAPA ? ROARING_BYTES_MAPA : (size_t)c->cardinalidad * sizeof(uint16_t);
+    }
+    return bytes;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file roaring.h
+ * @brief Conjuntos de docID comprimidos al estilo Roaring, con interseccion, union y diferencia.
+ *
+ * Los docID se agrupan por sus 16 bits altos en contenedores de hasta 2^16
+ * elementos. Cada contenedor elige su representacion segun su densidad: hasta
+ * ROARING_MAX_ARREGLO elementos es un arreglo ordenado de los 16 bits bajos (2
+ * bytes por documento); con mas, un mapa de bits fijo de 8 KB, que ocupa menos y
+ * se combina palabra a palabra. Las operaciones trabajan contenedor por
+ * contenedor con un nucleo para cada par de representaciones, y el resultado
+ * vuelve a elegir la suya segun cuantos elementos quedaron.
+ *
+ * Los mapas se combinan con SSE2 cuando esta disponible y se cuentan con
+ * popcount; los arreglos se intersecan por mezcla, o con busqueda exponencial
+ * si uno es mucho mas chico que el otro.
+ */
+
+#ifndef ROARING_H
+#define ROARING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ROARING_MAX_ARREGLO 4096 ///< Elementos hasta los que un contenedor es un arreglo ordenado.
+#define ROARING_PALABRAS_MAPA 1024 ///< Palabras de 64 bits del mapa de bits de un contenedor (2^16 bits).
+
+/**
+ * @brief Representacion de un contenedor.
+ */
+typedef enum {
+    CONTENEDOR_ARREGLO, ///< Arreglo ordenado de los 16 bits bajos.
+    CONTENEDOR_MAPA, ///< Mapa de bits de 2^16 posiciones.
+} TipoContenedor;
+
+/**
+ * @struct ContenedorRoaring
+ * @brief Documentos de un conjunto que comparten los 16 bits altos.
+ */
+typedef struct {
+    uint16_t clave; ///< 16 bits altos de los docID del contenedor.
+    uint16_t tipo; ///< TipoContenedor.
+    int cardinalidad; ///< Elementos del contenedor (nunca 0).
+    union {
+        uint16_t *arreglo; ///< 16 bits bajos en orden creciente (CONTENEDOR_ARREGLO).
+        uint64_t *mapa; ///< ROARING_PALABRAS_MAPA palabras (CONTENEDOR_MAPA).
+    };
+} ContenedorRoaring;
+
+/**
+ * @struct ConjuntoRoaring
+ * @brief Conjunto de docID no negativos.
+ */
+typedef struct ConjuntoRoaring {
+    ContenedorRoaring *contenedores; ///< Contenedores en orden creciente de clave.
+    int numContenedores; ///< Contenedores en uso.
+    int capacidad; ///< Contenedores reservados.
+    long cardinalidad; ///< Elementos del conjunto.
+} ConjuntoRoaring;
+
+/**
+ * @brief Crea un conjunto vacio.
+ *
+ * Termina el programa si no hay memoria, como todas las funciones de este archivo.
+ *
+ * @return Conjunto nuevo (liberar con liberarConjuntoRoaring()).
+ */
+ConjuntoRoaring *crearConjuntoRoaring();
+
+/**
+ * @brief Crea un conjunto a partir de un arreglo ordenado.
+ *
+ * @param docs docID en orden estrictamente creciente, no negativos.
+ * @param num Elementos de docs.
+ * @return Conjunto nuevo.
+ */
+ConjuntoRoaring *crearConjuntoDesdeArreglo(const int *docs, long num);
+
+/**
+ * @brief Agrega un documento mayor que todos los del conjunto.
+ *
+ * Pensada para armar un conjunto recorriendo una lista ordenada. El contenedor
+ * en curso pasa a mapa de bits al superar ROARING_MAX_ARREGLO elementos.
+ *
+ * @param conjunto Conjunto a ampliar.
+ * @param docID Documento, mayor que el ultimo agregado.
+ */
+void agregarAlFinalConjunto(ConjuntoRoaring *conjunto, int docID);
+
+/**
+ * @brief Ajusta los arreglos de un conjunto armado con agregarAlFinalConjunto() a su tamano justo.
+ *
+ * @param conjunto Conjunto terminado.
+ */
+void ajustarConjunto(ConjuntoRoaring *conjunto);
+
+/**
+ * @brief Libera un conjunto.
+ *
+ * @param conjunto Conjunto a liberar (puede ser NULL).
+ */
+void liberarConjuntoRoaring(ConjuntoRoaring *conjunto);
+
+/**
+ * @brief Calcula la interseccion de dos conjuntos.
+ *
+ * @param a Primer conjunto.
+ * @param b Segundo conjunto.
+ * @return Conjunto nuevo con los documentos que estan en ambos.
+ */
+ConjuntoRoaring *intersecarConjuntos(const ConjuntoRoaring *a, const ConjuntoRoaring *b);
+
+/**
+ * @brief Calcula la union de dos conjuntos.
+ *
+ * @param a Primer conjunto.
+ * @param b Segundo conjunto.
+ * @return Conjunto nuevo con los documentos que estan en alguno.
+ */
+ConjuntoRoaring *unirConjuntos(const ConjuntoRoaring *a, const ConjuntoRoaring *b);
+
+/**
+ * @brief Calcula la diferencia de dos conjuntos.
+ *
+ * @param a Conjunto del que se restan documentos.
+ * @param b Documentos a quitar.
+ * @return Conjunto nuevo con los documentos de a que no estan en b.
+ */
+ConjuntoRoaring *restarConjuntos(const ConjuntoRoaring *a, const ConjuntoRoaring *b);
+
+/**
+ * @brief Indica si un documento esta en un conjunto.
+ *
+ * @param conjunto Conjunto.
+ * @param docID Documento.
+ * @return 1 si esta, 0 si no.
+ */
+int contieneConjunto(const ConjuntoRoaring *conjunto, int docID);
+
+/**
+ * @brief Copia los documentos de un conjunto a un arreglo, en orden creciente.
+ *
+ * @param conjunto Conjunto.
+ * @param destino Arreglo de al menos conjunto->cardinalidad elementos.
+ * @return Elementos escritos.
+ */
+long extraerConjunto(const ConjuntoRoaring *conjunto, int *destino);
+
+/**
+ * @brief Calcula los bytes que ocupa un conjunto.
+ *
+ * @param conjunto Conjunto.
+ * @return Bytes de la estructura, los contenedores y sus datos.
+ */
+size_t bytesConjunto(const ConjuntoRoaring *conjunto);
+
+#endif
@@ -0,0 +1,594 @@
+/**
+ * @file servidor.c
+ * @brief Implementacion del modo servidor.
+ */
+
+#define _GNU_SOURCE
+#include "servidor.h"
+#include "cache.h"
+#include "consulta.h"
+#include "contexto.h"
+#include "graph.h"
+#include "incremental.h"
+#include "index.h"
+#include "instrumentacion.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @struct EstadoServidor
+ * @brief Cola de conexiones aceptadas y contadores compartidos por los hilos.
+ */
+typedef struct {
+    pthread_mutex_t mutex; ///< Protege los campos siguientes.
+    pthread_cond_t hayConexion; ///< Se avisa al encolar una conexion o al cerrar.
+    pthread_cond_t hayLugar; ///< Se avisa al sacar una conexion de la cola.
+    int cola[SERVIDOR_COLA_CONEXIONES]; ///< Descriptores aceptados que esperan un hilo.
+    int primero; ///< Posicion del proximo descriptor a atender.
+    int enCola; ///< Descriptores en la cola.
+    int cerrando; ///< 1 cuando el servidor deja de aceptar conexiones.
+    int *activas; ///< Conexion que atiende cada hilo, o -1.
+    int numHilos; ///< Hilos del grupo.
+    int conexionesAbiertas; ///< Conexiones atendidas en este momento.
+    long ordenes; ///< Ordenes atendidas desde el arranque.
+} EstadoServidor;
+
+static EstadoServidor estado = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .hayConexion = PTHREAD_COND_INITIALIZER,
+    .hayLugar = PTHREAD_COND_INITIALIZER,
+};
+
+static volatile sig_atomic_t detener = 0;
+static pthread_mutex_t mutexSincronizacion = PTHREAD_MUTEX_INITIALIZER; ///< Una sola sincronizacion a la vez.
+
+/**
+ * @brief Devuelve el tiempo monotono actual en microsegundos.
+ *
+ * @return Microsegundos desde un origen arbitrario.
+ */
+static long long microsegundosActuales() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Escribe una cadena como literal JSON, con comillas y escapes.
+ *
+ * @param salida Flujo de salida.
+ * @param cadena Cadena (NULL se escribe como null).
+ */
+static void escribirCadenaJson(FILE *salida, const char *cadena) {
+    if (!cadena) {
+        fputs("null", salida);
+        return;
+    }
+    putc('"', salida);
+    for (const unsigned char *c = (const unsigned char *)cadena; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            putc('\\', salida);
+            putc(*c, salida);
+        } else if (*c == '\n') {
+            fputs("\\n", salida);
+        } else if (*c == '\t') {
+            fputs("\\t", salida);
+        } else if (*c < 0x20) {
+            fprintf(salida, "\\u%04x", *c);
+        } else {
+            putc(*c, salida);
+        }
+    }
+    putc('"', salida);
+}
+
+/**
+ * @brief Escribe una respuesta de error.
+ *
+ * @param salida Flujo de respuestas.
+ * @param id Numero de la orden.
+ * @param mensaje Descripcion del error.
+ */
+static void responderError(FILE *salida, long id, const char *mensaje) {
+    fprintf(salida, "{\"id\":%ld,\"error\":", id);
+    escribirCadenaJson(salida, mensaje);
+    fputs("}\n", salida);
+}
+
+/**
+ * @brief Escribe los datos de un documento dentro de una lista de resultados.
+ *
+ * Requiere el candado del indice, porque una sincronizacion puede mover la tabla
+ * de nombres.
+ *
+ * @param salida Flujo de respuestas.
+ * @param docID Documento.
+ * @param pageRank PageRank que se informa del documento.
+ * @param primero 1 si es el primer elemento de la lista.
+ */
+static void escribirDocumento(FILE *salida, int docID, double pageRank, int primero) {
+    fprintf(salida, "%s{\"docID\":%d,\"nombre\":", primero ? "" : ",", docID);
+    escribirCadenaJson(salida, obtenerNombreDocumento(docID));
+    fprintf(salida, ",\"pagerank\":%.6g", pageRank);
+}
+
+/**
+ * @brief Atiende la orden "buscar".
+ *
+ * @param salida Flujo de respuestas.
+ * @param id Numero de la orden.
+ * @param consulta Texto de la consulta.
+ */
+static void responderBusqueda(FILE *salida, long id, const char *consulta) {
+    long long inicio = microsegundosActuales();
+    int *documentos = NULL;
+    int total = ejecutarConsulta(consulta, &documentos);
+    long long transcurrido = microsegundosActuales() - inicio;
+    if (total < 0) {
+        responderError(salida, id, "consulta invalida");
+        return;
+    }
+    int mostrados = total < SERVIDOR_MAX_RESULTADOS ? total : SERVIDOR_MAX_RESULTADOS;
+    fprintf(salida, "{\"id\":%ld,\"orden\":\"buscar\",\"total\":%d,\"documentos\":[", id, total);
+    bloquearIndiceLectura();
+    for (int i = 0; i < mostrados; i++) {
+        escribirDocumento(salida, documentos[i], obtenerPageRank(documentos[i]), i == 0);
+        putc('}', salida);
+    }
+    desbloquearIndice();
+    fprintf(salida, "],\"microsegundos\":%lld}\n", transcurrido);
+    free(documentos);
+}
+
+/**
+ * @brief Atiende las ordenes "relevancia" y "personalizada" una vez separado el nombre.
+ *
+ * @param salida Flujo de respuestas.
+ * @param id Numero de la orden.
+ * @param argumentos Texto con K y la consulta.
+ * @param personalizacion Nombre del PageRank personalizado, o NULL para el global.
+ */
+static void responderRanking(FILE *salida, long id, const char *argumentos, const char *personalizacion) {
+    char *fin;
+    long k = strtol(argumentos, &fin, 10);
+    if (fin == argumentos || k < 1 || k > SERVIDOR_MAX_K) {
+        char mensaje[64];
+        snprintf(mensaje, sizeof(mensaje), "K debe ser un numero entre 1 y %d", SERVIDOR_MAX_K);
+        responderError(salida, id, mensaje);
+        return;
+    }
+    ResultadoRanking *resultados = malloc((size_t)k * sizeof(ResultadoRanking));
+    if (!resultados) {
+        perror("No se pudo reservar memoria para los resultados");
+        exit(EXIT_FAILURE);
+    }
+    // La respuesta muestra el mismo PageRank con el que se calcularon los puntajes: el global o el personalizado.
+    const ContextoLectura *contexto = entrarLectura();
+    long long inicio = microsegundosActuales();
+    int total = ejecutarConsultaPersonalizada(fin, (int)k, personalizacion, resultados);
+    long long transcurrido = microsegundosActuales() - inicio;
+    if (total == CONSULTA_PERSONALIZACION_DESCONOCIDA) {
+        responderError(salida, id, "personalizacion desconocida");
+    } else if (total < 0) {
+        responderError(salida, id, "consulta invalida");
+    } else {
+        if (personalizacion) {
+            // El nombre ya se valido al publicarlo: no tiene caracteres que escapar.
+            fprintf(salida, "{\"id\":%ld,\"orden\":\"personalizada\",\"personalizacion\":\"%s\",", id,
+                    personalizacion);
+        } else {
+            fprintf(salida, "{\"id\":%ld,\"orden\":\"relevancia\",", id);
+        }
+        fprintf(salida, "\"total\":%d,\"generacion\":%ld,\"documentos\":[", total,
+                contexto ? contexto->generacion : 0L);
+        int vector = personalizacion ? buscarPersonalizacion(contexto ? contexto->personalizado : NULL, personalizacion)
+                                     : -1;
+        bloquearIndiceLectura();
+        for (int i = 0; i < total; i++) {
+            escribirDocumento(salida, resultados[i].docID, pageRankContexto(contexto, vector, resultados[i].docID),
+                              i == 0);
+            fprintf(salida, ",\"puntaje\":%.6g}", resultados[i].puntaje);
+        }
+        desbloquearIndice();
+        fprintf(salida, "],\"microsegundos\":%lld}\n", transcurrido);
+    }
+    salirLectura();
+    free(resultados);
+}
+
+/**
+ * @brief Atiende la orden "relevancia".
+ *
+ * @param salida Flujo de respuestas.
+ * @param id Numero de la orden.
+ * @param argumentos Texto despues de la orden: K y la consulta.
+ */
+static void responderRelevancia(FILE *salida, long id, const char *argumentos) {
+    responderRanking(salida, id, argumentos, NULL);
+}
+
+/**
+ * @brief Atiende la orden "personalizada".
+ *
+ * @param salida Flujo de respuestas.
+ * @param id Numero de la orden.
+ * @param argumentos Texto despues de la orden: el nombre, K y la consulta.
+ */
+static void responderPersonalizada(FILE *salida, long id, const char *argumentos) {
+    size_t largoNombre = strcspn(argumentos, " \t");
+    if (largoNombre == 0 || largoNombre >= CONTEXTO_LARGO_PERSONALIZACION) {
+        responderError(salida, id, "personalizacion desconocida");
+        return;
+    }
+    char nombre[CONTEXTO_LARGO_PERSONALIZACION];
+    memcpy(nombre, argumentos, largoNombre);
+    nombre[largoNombre] = '\0';
+    responderRanking(salida, id, argumentos + largoNombre, nombre);
+}
+
+/**
+ * @brief Atiende la orden "estadisticas".
+ *
+ * @param salida Flujo de respuestas.
+ * @param id Numero de la orden.
+ */
+static void responderEstadisticas(FILE *salida, long id) {
+    bloquearIndiceLectura();
+    int documentos = totalDocumentosCargados();
+    int palabras = totalPalabrasIndexadas();
+    desbloquearIndice();
+    const ContextoLectura *contexto = entrarLectura();
+    long generacion = contexto ? contexto->generacion : 0;
+    int iteraciones = contexto ? contexto->iteraciones : 0;
+    char personalizaciones[CONTEXTO_MAX_PERSONALIZACIONES][CONTEXTO_LARGO_PERSONALIZACION];
+    int numPersonalizaciones = contexto && contexto->personalizado ? contexto->personalizado->numVectores : 0;
+    for (int v = 0; v < numPersonalizaciones; v++) {
+        strcpy(personalizaciones[v], contexto->personalizado->nombres[v]);
+    }
+    salirLectura();
+    pthread_mutex_lock(&estado.mutex);
+    long ordenes = estado.ordenes;
+    int conexiones = estado.conexionesAbiertas;
+    pthread_mutex_unlock(&estado.mutex);
+    EstadisticasCache cache;
+    obtenerEstadisticasCacheConsultas(&cache);
+    fprintf(salida,
+            "{\"id\":%ld,\"orden\":\"estadisticas\",\"documentos\":%d,\"palabras\":%d,\"generacion\":%ld,"
+            "\"iteraciones\":%d,\"ordenes\":%ld,\"conexiones\":%d,\"hilos\":%d,"
+            "\"cache\":{\"aciertos\":%ld,\"fallos\":%ld,\"entradas\":%d,\"bytes\":%zu,\"invalidadas\":%ld},"
+            "\"personalizaciones\":[",
+            id, documentos, palabras, generacion, iteraciones, ordenes, conexiones, estado.numHilos, cache.aciertos,
+            cache.fallos, cache.entradas, cache.bytes, cache.invalidadas);
+    for (int v = 0; v < numPersonalizaciones; v++) {
+        fprintf(salida, "%s\"%s\"", v > 0 ? "," : "", personalizaciones[v]);
+    }
+    fprintf(salida, "]}\n");
+}
+
+/**
+ * @brief Atiende la orden "instrumentacion".
+ *
+ * @param salida Flujo de respuestas.
+ * @param id Numero de la orden.
+ */
+static void responderInstrumentacion(FILE *salida, long id) {
+    fprintf(salida, "{\"id\":%ld,\"orden\":\"instrumentacion\",\"datos\":", id);
+    volcarInstrumentacion(salida, 1);
+    fprintf(salida, "}\n");
+}
+
+/**
+ * @brief Atiende la orden "sincronizar".
+ *
+ * Aplica los cambios de la carpeta de documentos mientras los demas hilos siguen
+ * respondiendo: el indice solo se bloquea al indexar cada archivo, y el PageRank
+ * nuevo se publica de una vez al terminar.
+ *
+ * @param salida Flujo de respuestas.
+ * @param id Numero de la orden.
+ */
+static void responderSincronizacion(FILE *salida, long id) {
+    pthread_mutex_lock(&mutexSincronizacion);
+    long long inicio = microsegundosActuales();
+    ResumenSincronizacion resumen;
+    int cambios = sincronizarDocumentos(&resumen);
+    long long transcurrido = microsegundosActuales() - inicio;
+    pthread_mutex_unlock(&mutexSincronizacion);
+    if (cambios < 0) {
+        responderError(salida, id, "no se pudo leer la carpeta de documentos");
+        return;
+    }
+    const ContextoLectura *contexto = entrarLectura();
+    long generacion = contexto ? contexto->generacion : 0;
+    salirLectura();
+    fprintf(salida,
+            "{\"id\":%ld,\"orden\":\"sincronizar\",\"agregados\":%d,\"actualizados\":%d,\"eliminados\":%d,"
+            "\"generacion\":%ld,\"microsegundos\":%lld}\n",
+            id, resumen.agregados, resumen.actualizados, resumen.eliminados, generacion, transcurrido);
+}
+
+/**
+ * @brief Atiende las ordenes de un flujo hasta que se termina o llega "salir".
+ *
+ * @param entrada Flujo de ordenes.
+ * @param salida Flujo de respuestas; se vacia despues de cada respuesta.
+ * @return Numero de ordenes atendidas.
+ */
+long atenderFlujo(FILE *entrada, FILE *salida) {
+    char *linea = NULL;
+    size_t capacidad = 0;
+    ssize_t largo;
+    long id = 0;
+    while ((largo = getline(&linea, &capacidad, entrada)) >= 0) {
+        linea[strcspn(linea, "\r\n")] = '\0';
+        char *orden = linea + strspn(linea, " \t");
+        if (*orden == '\0') {
+            continue;
+        }
+        id++;
+        size_t largoOrden = strcspn(orden, " \t");
+        char *argumentos = orden + largoOrden + strspn(orden + largoOrden, " \t");
+        if (largoOrden == 5 && strncmp(orden, "salir", 5) == 0) {
+            break;
+        }
+        // La respuesta se arma en memoria y se envia sin candados tomados, para que
+        // un cliente lento no demore a los demas.
+        char *texto = NULL;
+        size_t bytes = 0;
+        FILE *respuesta = open_memstream(&texto, &bytes);
+        if (!respuesta) {
+            perror("No se pudo reservar memoria para la respuesta");
+            exit(EXIT_FAILURE);
+        }
+        if (largo > SERVIDOR_LARGO_LINEA) {
+            responderError(respuesta, id, "orden demasiado larga");
+        } else if (largoOrden == 6 && strncmp(orden, "buscar", 6) == 0) {
+            responderBusqueda(respuesta, id, argumentos);
+        } else if (largoOrden == 10 && strncmp(orden, "relevancia", 10) == 0) {
+            responderRelevancia(respuesta, id, argumentos);
+        } else if (largoOrden == 13 && strncmp(orden, "personalizada", 13) == 0) {
+            responderPersonalizada(respuesta, id, argumentos);
+        } else if (largoOrden == 12 && strncmp(orden, "estadisticas", 12) == 0) {
+            responderEstadisticas(respuesta, id);
+        } else if (largoOrden == 15 && strncmp(orden, "instrumentacion", 15) == 0) {
+            responderInstrumentacion(respuesta, id);
+        } else if (largoOrden == 11 && strncmp(orden, "sincronizar", 11) == 0) {
+            responderSincronizacion(respuesta, id);
+        } else {
+            responderError(respuesta, id, "orden desconocida");
+        }
+        fclose(respuesta);
+        pthread_mutex_lock(&estado.mutex);
+        estado.ordenes++;
+        pthread_mutex_unlock(&estado.mutex);
+        int enviada = fwrite(texto, 1, bytes, salida) == bytes && fflush(salida) == 0;
+        free(texto);
+        if (!enviada) {
+            break; // El cliente cerro la conexion.
+        }
+    }
+    free(linea);
+    return id;
+}
+
+/**
+ * @brief Atiende una conexion aceptada y la cierra.
+ *
+ * @param indice Hilo que la atiende.
+ * @param descriptor Descriptor del socket de la conexion.
+ */
+static void atenderConexion(int indice, int descriptor) {
+    int copia = dup(descriptor);
+    FILE *entrada = fdopen(descriptor, "r");
+    FILE *salida = copia >= 0 ? fdopen(copia, "w") : NULL;
+    if (entrada && salida) {
+        atenderFlujo(entrada, salida);
+    } else {
+        perror("No se pudo abrir la conexion");
+    }
+    // Deja de publicar el descriptor antes de cerrarlo, para que no se reutilice.
+    pthread_mutex_lock(&estado.mutex);
+    estado.activas[indice] = -1;
+    estado.conexionesAbiertas--;
+    pthread_mutex_unlock(&estado.mutex);
+    if (salida) {
+        fclose(salida);
+    } else if (copia >= 0) {
+        close(copia);
+    }
+    if (entrada) {
+        fclose(entrada);
+    } else {
+        close(descriptor);
+    }
+}
+
+/**
+ * @brief Hilo del grupo: saca conexiones de la cola y las atiende de a una.
+ *
+ * @param argumento Indice del hilo.
+ * @return NULL.
+ */
+static void *hiloServidor(void *argumento) {
+    int indice = (int)(intptr_t)argumento;
+    for (;;) {
+        pthread_mutex_lock(&estado.mutex);
+        while (estado.enCola == 0 && !estado.cerrando) {
+            pthread_cond_wait(&estado.hayConexion, &estado.mutex);
+        }
+        if (estado.cerrando) {
+            pthread_mutex_unlock(&estado.mutex);
+            return NULL;
+        }
+        int descriptor = estado.cola[estado.primero];
+        estado.primero = (estado.primero + 1) % SERVIDOR_COLA_CONEXIONES;
+        estado.enCola--;
+        estado.activas[indice] = descriptor;
+        estado.conexionesAbiertas++;
+        pthread_cond_signal(&estado.hayLugar);
+        pthread_mutex_unlock(&estado.mutex);
+        atenderConexion(indice, descriptor);
+    }
+}
+
+/**
+ * @brief Marca el servidor para terminar al recibir SIGINT o SIGTERM.
+ *
+ * @param senal Senal recibida.
+ */
+static void pedirDetencion(int senal) {
+    (void)senal;
+    detener = 1;
+}
+
+/**
+ * @brief Crea el socket de escucha.
+ *
+ * @param ruta Ruta del socket.
+ * @return Descriptor del socket, o -1 si hubo un error.
+ */
+static int abrirSocket(const char *ruta) {
+    struct sockaddr_un direccion;
+    memset(&direccion, 0, sizeof(direccion));
+    direccion.sun_family = AF_UNIX;
+    if (strlen(ruta) >= sizeof(direccion.sun_path)) {
+        fprintf(stderr, "La ruta del socket '%s' es demasiado larga.\n", ruta);
+        return -1;
+    }
+    strcpy(direccion.sun_path, ruta);
+    int escucha = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (escucha < 0) {
+        perror("No se pudo crear el socket");
+        return -1;
+    }
+    unlink(ruta);
+    if (bind(escucha, (struct sockaddr *)&direccion, sizeof(direccion)) != 0 ||
+        listen(escucha, SERVIDOR_COLA_CONEXIONES) != 0) {
+        fprintf(stderr, "No se pudo escuchar en '%s': %s\n", ruta, strerror(errno));
+        close(escucha);
+        return -1;
+    }
+    return escucha;
+}
+
+/**
+ * @brief Acepta conexiones y las reparte entre los hilos hasta recibir una senal.
+ *
+ * @param escucha Socket de escucha.
+ * @param hilos Hilos del grupo.
+ */
+static void atenderSocket(int escucha, int hilos) {
+    estado.numHilos = hilos;
+    estado.activas = malloc((size_t)hilos * sizeof(int));
+    pthread_t *grupo = malloc((size_t)hilos * sizeof(pthread_t));
+    if (!estado.activas || !grupo) {
+        perror("No se pudo reservar memoria para los hilos del servidor");
+        exit(EXIT_FAILURE);
+    }
+
+    // Los hilos del grupo heredan las senales bloqueadas, asi que solo este hilo
+    // las recibe y accept() vuelve con EINTR.
+    sigset_t senales;
+    sigset_t anteriores;
+    sigemptyset(&senales);
+    sigaddset(&senales, SIGINT);
+    sigaddset(&senales, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &senales, &anteriores);
+    for (int i = 0; i < hilos; i++) {
+        estado.activas[i] = -1;
+        if (pthread_create(&grupo[i], NULL, hiloServidor, (void *)(intptr_t)i) != 0) {
+            perror("No se pudo crear un hilo del servidor");
+            exit(EXIT_FAILURE);
+        }
+    }
+    struct sigaction accion;
+    memset(&accion, 0, sizeof(accion));
+    accion.sa_handler = pedirDetencion; // Sin SA_RESTART, para interrumpir accept().
+    sigaction(SIGINT, &accion, NULL);
+    sigaction(SIGTERM, &accion, NULL);
+    pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+
+    while (!detener) {
+        int descriptor = accept(escucha, NULL, NULL);
+        if (descriptor < 0) {
+            if (errno != EINTR && errno != ECONNABORTED) {
+                perror("Error al aceptar una conexion");
+                break;
+            }
+            continue;
+        }
+        pthread_mutex_lock(&estado.mutex);
+        while (estado.enCola == SERVIDOR_COLA_CONEXIONES) {
+            pthread_cond_wait(&estado.hayLugar, &estado.mutex);
+        }
+        estado.cola[(estado.primero + estado.enCola) % SERVIDOR_COLA_CONEXIONES] = descriptor;
+        estado.enCola++;
+        pthread_cond_signal(&estado.hayConexion);
+        pthread_mutex_unlock(&estado.mutex);
+    }
+
+    // Corta las conexiones en curso: su lectura termina y el hilo vuelve a la cola.
+    pthread_mutex_lock(&estado.mutex);
+    estado.cerrando = 1;
+    for (int i = 0; i < hilos; i++) {
+        if (estado.activas[i] >= 0) {
+            shutdown(estado.activas[i], SHUT_RDWR);
+        }
+    }
+    pthread_cond_broadcast(&estado.hayConexion);
+    pthread_mutex_unlock(&estado.mutex);
+    for (int i = 0; i < hilos; i++) {
+        pthread_join(grupo[i], NULL);
+    }
+    while (estado.enCola > 0) {
+        close(estado.cola[estado.primero]);
+        estado.primero = (estado.primero + 1) % SERVIDOR_COLA_CONEXIONES;
+        estado.enCola--;
+    }
+    free(grupo);
+    free(estado.activas);
+    estado.activas = NULL;
+}
+
+/**
+ * @brief Ejecuta el servidor hasta que se termina la entrada o llega una senal.
+ *
+ * @param rutaSocket Ruta del socket de dominio Unix, o NULL para la entrada estandar.
+ * @param hilos Hilos que atienden conexiones (solo con socket).
+ * @param salida Flujo de respuestas cuando se atiende la entrada estandar.
+ * @return 0 si el servidor termino normalmente, -1 si no se pudo crear el socket.
+ */
+int ejecutarServidor(const char *rutaSocket, int hilos, FILE *salida) {
+    // Un cliente que se va sin leer sus respuestas no debe terminar el programa.
+    signal(SIGPIPE, SIG_IGN);
+    if (hilos < 1) {
+        hilos = 1;
+    }
+    long long inicio = microsegundosActuales();
+    if (!rutaSocket) {
+        estado.numHilos = 1;
+        fprintf(stderr, "Servidor listo: leyendo ordenes de la entrada estandar.\n");
+        atenderFlujo(stdin, salida);
+    } else {
+        int escucha = abrirSocket(rutaSocket);
+        if (escucha < 0) {
+            return -1;
+        }
+        fprintf(stderr, "Servidor listo en '%s' con %d hilos.\n", rutaSocket, hilos);
+        atenderSocket(escucha, hilos);
+        close(escucha);
+        unlink(rutaSocket);
+    }
+    double segundos = (microsegundosActuales() - inicio) / 1e6;
+    fprintf(stderr, "Servidor detenido: %ld ordenes en %.3f s (%.0f ordenes/s).\n", estado.ordenes, segundos,
+            segundos > 0 ? estado.ordenes / segundos : 0.0);
+    return 0;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file servidor.h
+ * @brief Modo servidor: ordenes por lineas y respuestas en JSON, sin menu.
+ *
+ * Cada linea de entrada es una orden y recibe exactamente una linea de respuesta
+ * con un objeto JSON, en el mismo orden, asi que un cliente puede enviar muchas
+ * ordenes seguidas sin esperar cada respuesta. Las ordenes son:
+ *
+ *     buscar CONSULTA          documentos que cumplen una consulta booleana
+ *     relevancia K CONSULTA    los K documentos de mayor puntaje (BM25 + PageRank)
+ *     personalizada NOMBRE K CONSULTA
+ *                              lo mismo con el PageRank personalizado NOMBRE (ver personalizacion.h)
+ *     estadisticas             tamano del indice, actividad del servidor y de la cache
+ *     instrumentacion          contadores, tiempos e histogramas (ver instrumentacion.h)
+ *     sincronizar              aplica los cambios de la carpeta de documentos
+ *     salir                    termina la conexion
+ *
+ * Las consultas usan la sintaxis de consulta.h. Las lineas vacias se ignoran.
+ * Ejemplos de respuesta:
+ *
+ *     {"id":1,"orden":"buscar","total":2,"documentos":[{"docID":4,"nombre":"docs/a.txt","pagerank":0.0123}],"microsegundos":41}
+ *     {"id":2,"error":"consulta invalida"}
+ *
+ * "id" cuenta las ordenes de la conexion desde 1. Una busqueda booleana devuelve
+ * como maximo SERVIDOR_MAX_RESULTADOS documentos; "total" siempre es el numero
+ * completo.
+ *
+ * Una personalizada con un nombre que no existe responde el error
+ * "personalizacion desconocida".
+ *
+ * "generacion" identifica la version publicada del PageRank (ver contexto.h) con
+ * la que se calcularon los puntajes; cambia despues de cada sincronizacion que
+ * modifica el PageRank.
+ *
+ * El servidor atiende la entrada estandar o un socket de dominio Unix. Con un
+ * socket, un grupo fijo de hilos atiende las conexiones, una por hilo, y las
+ * consultas se evaluan en paralelo con el candado del indice en modo compartido.
+ * Una sincronizacion corre en el hilo de su conexion mientras los demas siguen
+ * respondiendo.
+ */
+
+#ifndef SERVIDOR_H
+#define SERVIDOR_H
+
+#include <stdio.h>
+
+#define SERVIDOR_LARGO_LINEA 4096 ///< Bytes maximos de una orden.
+#define SERVIDOR_MAX_RESULTADOS 1000 ///< Documentos que devuelve como maximo una busqueda booleana.
+#define SERVIDOR_MAX_K 1000 ///< Maximo de K en una busqueda por relevancia.
+#define SERVIDOR_COLA_CONEXIONES 64 ///< Conexiones aceptadas que pueden esperar un hilo libre.
+
+/**
+ * @brief Atiende las ordenes de un flujo hasta que se termina o llega "salir".
+ *
+ * @param entrada Flujo de ordenes.
+ * @param salida Flujo de respuestas; se vacia despues de cada respuesta.
+ * @return Numero de ordenes atendidas.
+ */
+long atenderFlujo(FILE *entrada, FILE *salida);
+
+/**
+ * @brief Ejecuta el servidor hasta que se termina la entrada o llega una senal.
+ *
+ * Sin ruta de socket atiende la entrada estandar. Con ruta crea el socket (si ya
+ * existe un archivo con ese nombre lo reemplaza) y atiende conexiones hasta
+ * recibir SIGINT o SIGTERM; al terminar cierra las conexiones abiertas y borra
+ * el socket. Requiere iniciarIncremental(), y solo el servidor debe modificar el
+ * indice y el grafo mientras tanto. Al final informa en stderr las ordenes
+ * atendidas por segundo.
+ *
+ * @param rutaSocket Ruta del socket de dominio Unix, o NULL para la entrada estandar.
+ * @param hilos Hilos que atienden conexiones (solo con socket).
+ * @param salida Flujo de respuestas cuando se atiende la entrada estandar.
+ * @return 0 si el servidor termino normalmente, -1 si no se pudo crear el socket.
+ */
+int ejecutarServidor(const char *rutaSocket, int hilos, FILE *salida);
+
+#endif
@@ -0,0 +1,907 @@
+/**
+ * @file snapshot.c
+ * @brief Implementacion de la instantanea binaria del indice y del grafo.
+ *
+ * Al abrir la instantanea no se copia el diccionario ni los postings: las
+ * busquedas sondean la tabla hash guardada y decodifican los postings desde el
+ * archivo proyectado. La tabla de documentos y los arreglos CSR/CSC tambien se
+ * usan en su lugar; solo el vector de PageRank se copia para poder recalcularlo.
+ */
+
+#include "snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "graph.h"
+
+#define SNAPSHOT_BUFER_COPIA (1024 * 1024) ///< Bytes del bufer con que se copian las secciones temporales.
+
+_Static_assert(sizeof(size_t) == sizeof(uint64_t), "La instantanea requiere size_t de 64 bits");
+_Static_assert(sizeof(Documento) == 2 * sizeof(uint64_t), "Documento debe ocupar 16 bytes");
+_Static_assert(sizeof(CabeceraSnapshot) % 8 == 0, "La cabecera debe ocupar un multiplo de 8 bytes");
+
+/**
+ * @struct Snapshot
+ * @brief Instantanea abierta en el proceso.
+ */
+typedef struct {
+    void *mapa; ///< Archivo proyectado, o NULL si no hay instantanea abierta.
+    size_t tamano; ///< Tamano del archivo proyectado.
+    const CabeceraSnapshot *cabecera; ///< Cabecera al inicio del archivo.
+    const RanuraSnapshot *ranuras; ///< Tabla hash del diccionario, o NULL si el diccionario se descarto.
+    const TerminoSnapshot *terminos; ///< Entradas del diccionario.
+    const char *palabras; ///< Bytes de las palabras.
+    const unsigned char *postings; ///< Postings comprimidos.
+    const SaltoPosting *saltos; ///< Punteros de salto.
+    const unsigned char *posiciones; ///< Posiciones codificadas, o NULL sin indice posicional.
+    const uint32_t *saltosPosiciones; ///< Inicio en posiciones de cada bloque siguiente.
+    _Atomic(ConjuntoRoaring *) *conjuntos; ///< Conjunto Roaring de cada termino, armado al pedirlo, o NULL.
+    size_t numConjuntos; ///< Entradas de conjuntos (una por termino).
+} Snapshot;
+
+/**
+ * @struct EscritorSnapshot
+ * @brief Estado de escritura de una instantanea.
+ *
+ * Acumula la suma de verificacion por palabras de 8 bytes a medida que se escribe.
+ */
+typedef struct {
+    FILE *archivo; ///< Archivo temporal de salida.
+    uint64_t posicion; ///< Bytes escritos desde el inicio del archivo.
+    uint64_t suma; ///< Suma de verificacion acumulada.
+    unsigned char pendiente[8]; ///< Bytes que aun no completan una palabra de 8.
+    int numPendiente; ///< Bytes usados en pendiente.
+    int error; ///< 1 si fallo alguna escritura.
+    CabeceraSnapshot cabecera; ///< Cabecera que se reescribe al final.
+} EscritorSnapshot;
+
+Snapshot snapshot; ///< Instantanea abierta, si la hay.
+
+/**
+ * @brief Incorpora una palabra de 8 bytes a la suma de verificacion.
+ *
+ * @param suma Suma acumulada.
+ * @param palabra Palabra de 8 bytes.
+ * @return Nueva suma.
+ */
+static uint64_t sumarPalabra(uint64_t suma, uint64_t palabra) {
+    palabra *= 0x87c37b91114253d5ULL;
+    palabra = (palabra << 31) | (palabra >> 33);
+    suma ^= palabra * 0x4cf5ad432745937fULL;
+    return ((suma << 27) | (suma >> 37)) * 5 + 0x52dce729ULL;
+}
+
+/**
+ * @brief Calcula la suma de verificacion de un bloque alineado a 8 bytes.
+ *
+ * @param datos Bloque de datos.
+ * @param bytes Tamano del bloque (multiplo de 8).
+ * @return Suma de verificacion.
+ */
+static uint64_t sumarBloque(const unsigned char *datos, size_t bytes) {
+    uint64_t suma = 0;
+    for (size_t i = 0; i + 8 <= bytes; i += 8) {
+        uint64_t palabra;
+        memcpy(&palabra, datos + i, 8);
+        suma = sumarPalabra(suma, palabra);
+    }
+    return suma;
+}
+
+/**
+ * @brief Escribe bytes en la instantanea actualizando la suma de verificacion.
+ *
+ * @param e Escritor.
+ * @param datos Bytes a escribir.
+ * @param bytes Numero de bytes.
+ */
+static void escribirBytes(EscritorSnapshot *e, const void *datos, size_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+    if (fwrite(datos, 1, bytes, e->archivo) != bytes) {
+        e->error = 1;
+    }
+    e->posicion += bytes;
+    const unsigned char *p = datos;
+    for (size_t i = 0; i < bytes; i++) {
+        e->pendiente[e->numPendiente++] = p[i];
+        if (e->numPendiente == 8) {
+            uint64_t palabra;
+            memcpy(&palabra, e->pendiente, 8);
+            e->suma = sumarPalabra(e->suma, palabra);
+            e->numPendiente = 0;
+        }
+    }
+}
+
+/**
+ * @brief Marca el inicio de una seccion en la posicion actual.
+ *
+ * @param e Escritor.
+ * @param id Seccion que empieza.
+ */
+static void abrirSeccion(EscritorSnapshot *e, SeccionSnapshotId id) {
+    e->cabecera.secciones[id].offset = e->posicion;
+}
+
+/**
+ * @brief Cierra una seccion y rellena con ceros hasta el siguiente multiplo de 8.
+ *
+ * @param e Escritor.
+ * @param id Seccion que termina.
+ */
+static void cerrarSeccion(EscritorSnapshot *e, SeccionSnapshotId id) {
+    static const unsigned char ceros[8] = {0};
+    e->cabecera.secciones[id].bytes = e->posicion - e->cabecera.secciones[id].offset;
+    escribirBytes(e, ceros, (8 - e->posicion % 8) % 8);
+}
+
+/**
+ * @brief Escribe una seccion completa a partir de un arreglo.
+ *
+ * @param e Escritor.
+ * @param id Seccion a escribir.
+ * @param datos Contenido de la seccion.
+ * @param bytes Tamano del contenido.
+ */
+static void escribirSeccion(EscritorSnapshot *e, SeccionSnapshotId id, const void *datos, size_t bytes) {
+    abrirSeccion(e, id);
+    escribirBytes(e, datos, bytes);
+    cerrarSeccion(e, id);
+}
+
+/**
+ * @struct ListaTerminos
+ * @brief Arreglo dinamico con las listas de postings del indice en memoria.
+ */
+typedef struct {
+    ListaPostings *listas; ///< Listas recolectadas.
+    size_t num; ///< Numero de listas.
+    size_t capacidad; ///< Capacidad reservada.
+    int error; ///< 1 si no hubo memoria.
+} ListaTerminos;
+
+/**
+ * @brief Agrega una lista de postings a la coleccion (usada con recorrerIndice()).
+ *
+ * @param lista Lista visitada.
+ * @param contexto Puntero a ListaTerminos.
+ */
+static void recolectarTermino(const ListaPostings *lista, void *contexto) {
+    ListaTerminos *terminos = contexto;
+    if (terminos->num == terminos->capacidad) {
+        size_t capacidad = terminos->capacidad ? terminos->capacidad * 2 : 1024;
+        ListaPostings *nuevas = realloc(terminos->listas, capacidad * sizeof(ListaPostings));
+        if (!nuevas) {
+            terminos->error = 1;
+            return;
+        }
+        terminos->listas = nuevas;
+        terminos->capacidad = capacidad;
+    }
+    terminos->listas[terminos->num++] = *lista;
+}
+
+/**
+ * @brief Compara dos listas de postings por palabra para ordenarlas con qsort.
+ *
+ * @param a Primera lista.
+ * @param b Segunda lista.
+ * @return Resultado de strcmp entre las palabras.
+ */
+static int compararTerminos(const void *a, const void *b) {
+    return strcmp(((const ListaPostings *)a)->palabra, ((const ListaPostings *)b)->palabra);
+}
+
+/**
+ * @brief Arma la tabla de documentos que se guarda, con offsets en el almacen de nombres guardado.
+ *
+ * @param numDocs Documentos del grafo.
+ * @return Tabla reservada con malloc, o NULL si no hay memoria.
+ */
+static Documento *armarTablaDocumentos(uint64_t numDocs) {
+    Documento *tabla = malloc((numDocs ? numDocs : 1) * sizeof(Documento));
+    if (!tabla) {
+        return NULL;
+    }
+    size_t bytesNombres = 0;
+    for (uint64_t d = 0; d < numDocs; d++) {
+        const char *nombre = obtenerNombreDocumento((int)d);
+        tabla[d].offsetNombre = nombre ? bytesNombres : SIZE_MAX;
+        tabla[d].longitud = (uint32_t)obtenerLongitudDocumento((int)d);
+        tabla[d].reservado = 0;
+        bytesNombres += nombre ? strlen(nombre) + 1 : 0;
+    }
+    return tabla;
+}
+
+/**
+ * @brief Crea el archivo temporal de una instantanea y deja el escritor despues de la cabecera.
+ *
+ * @param e Escritor a inicializar.
+ * @param ruta Ruta final de la instantanea.
+ * @return Ruta del archivo temporal (liberar con free), o NULL si no se pudo crear.
+ */
+static char *crearEscritor(EscritorSnapshot *e, const char *ruta) {
+    size_t largoTemporal = strlen(ruta) + 5;
+    char *temporal = malloc(largoTemporal);
+    memset(e, 0, sizeof(*e));
+    if (temporal) {
+        snprintf(temporal, largoTemporal, "%s.tmp", ruta);
+        e->archivo = fopen(temporal, "wb");
+    }
+    if (!e->archivo) {
+        perror("No se pudo crear la instantanea");
+        free(temporal);
+        return NULL;
+    }
+    // La cabecera se escribe al final, cuando se conocen las secciones y la suma.
+    fseek(e->archivo, sizeof(CabeceraSnapshot), SEEK_SET);
+    e->posicion = sizeof(CabeceraSnapshot);
+    return temporal;
+}
+
+/**
+ * @brief Escribe las secciones de la tabla de documentos y del grafo.
+ *
+ * @param e Escritor, con las secciones del diccionario ya escritas.
+ * @param tabla Tabla de documentos armada con armarTablaDocumentos().
+ */
+static void escribirDocumentosYGrafo(EscritorSnapshot *e, const Documento *tabla) {
+    const Grafo *g = obtenerGrafo();
+    uint64_t numDocs = (uint64_t)g->numDocs;
+    escribirSeccion(e, SECCION_DOCUMENTOS, tabla, numDocs * sizeof(Documento));
+    abrirSeccion(e, SECCION_NOMBRES);
+    for (uint64_t d = 0; d < numDocs; d++) {
+        const char *nombre = obtenerNombreDocumento((int)d);
+        if (nombre) {
+            escribirBytes(e, nombre, strlen(nombre) + 1);
+        }
+    }
+    cerrarSeccion(e, SECCION_NOMBRES);
+    escribirSeccion(e, SECCION_INICIO_SALIDA, g->inicioSalida, (numDocs + 1) * sizeof(size_t));
+    escribirSeccion(e, SECCION_DESTINOS_SALIDA, g->destinosSalida, g->numEnlaces * sizeof(int));
+    escribirSeccion(e, SECCION_INICIO_ENTRADA, g->inicioEntrada, (numDocs + 1) * sizeof(size_t));
+    escribirSeccion(e, SECCION_ORIGENES_ENTRADA, g->origenesEntrada, g->numEnlaces * sizeof(int));
+    escribirSeccion(e, SECCION_INVERSO_GRADO, g->inversoGradoSalida, numDocs * sizeof(double));
+    escribirSeccion(e, SECCION_PAGERANK, g->pageRank, numDocs * sizeof(double));
+}
+
+/**
+ * @brief Completa la cabecera, cierra el archivo temporal y lo renombra a la ruta final.
+ *
+ * @param e Escritor con todas las secciones escritas; numTerminos y capacidadRanuras
+ *          de la cabecera ya deben estar fijados.
+ * @param ruta Ruta final de la instantanea.
+ * @param temporal Ruta del archivo temporal; se libera.
+ * @param firmaCorpus Firma del directorio indexado.
+ * @return 1 si se escribio correctamente, 0 en caso de error (el temporal se borra).
+ */
+static int cerrarEscritor(EscritorSnapshot *e, const char *ruta, char *temporal, uint64_t firmaCorpus) {
+    const Grafo *g = obtenerGrafo();
+    memcpy(e->cabecera.magia, SNAPSHOT_MAGIA, sizeof(e->cabecera.magia));
+    e->cabecera.version = SNAPSHOT_VERSION;
+    e->cabecera.marcaEndian = SNAPSHOT_MARCA_ENDIAN;
+    e->cabecera.sumaVerificacion = e->suma;
+    e->cabecera.tamanoTotal = e->posicion;
+    e->cabecera.firmaCorpus = firmaCorpus;
+    e->cabecera.numDocs = (uint64_t)g->numDocs;
+    e->cabecera.numEnlaces = g->numEnlaces;
+    e->cabecera.iteracionesPageRank = g->iteracionesPageRank;
+    e->cabecera.posiciones = indicePosicionalActivado();
+    e->cabecera.residuoPageRank = g->residuoPageRank;
+    if (fseek(e->archivo, 0, SEEK_SET) != 0 ||
+        fwrite(&e->cabecera, sizeof(CabeceraSnapshot), 1, e->archivo) != 1) {
+        e->error = 1;
+    }
+    if (fclose(e->archivo) != 0) {
+        e->error = 1;
+    }
+
+    int correcto = !e->error && rename(temporal, ruta) == 0;
+    if (!correcto) {
+        perror("No se pudo escribir la instantanea");
+        remove(temporal);
+    }
+    free(temporal);
+    return correcto;
+}
+
+/**
+ * @brief Calcula la capacidad de la tabla hash guardada para un numero de palabras.
+ *
+ * @param numTerminos Palabras del diccionario.
+ * @return Potencia de dos de al menos el doble de palabras.
+ */
+static size_t capacidadRanurasSnapshot(size_t numTerminos) {
+    size_t capacidad = 16;
+    while (capacidad < numTerminos * 2) {
+        capacidad *= 2;
+    }
+    return capacidad;
+}
+
+/**
+ * @brief Ubica una palabra en la tabla hash guardada.
+ *
+ * @param ranuras Tabla hash, inicialmente en cero.
+ * @param capacidad Ranuras de la tabla (potencia de dos).
+ * @param hash Hash de la palabra.
+ * @param termino Indice de la palabra en la seccion de terminos.
+ */
+static void ubicarRanura(RanuraSnapshot *ranuras, size_t capacidad, uint64_t hash, size_t termino) {
+    size_t i = (size_t)hash & (capacidad - 1);
+    while (ranuras[i].termino) {
+        i = (i + 1) & (capacidad - 1);
+    }
+    ranuras[i].hash = hash;
+    ranuras[i].termino = (uint32_t)(termino + 1);
+}
+
+/**
+ * @brief Escribe la instantanea del estado actual del indice y del grafo.
+ *
+ * @param ruta Ruta del archivo de instantanea.
+ * @param firmaCorpus Firma del directorio indexado (ver calcularFirmaCorpus()).
+ * @return 1 si se escribio correctamente, 0 en caso de error.
+ */
+int guardarSnapshot(const char *ruta, uint64_t firmaCorpus) {
+    ListaTerminos terminos = {NULL, 0, 0, 0};
+    recorrerIndice(recolectarTermino, &terminos);
+    if (terminos.error) {
+        fprintf(stderr, "No hay memoria para escribir la instantanea.\n");
+        free(terminos.listas);
+        return 0;
+    }
+    qsort(terminos.listas, terminos.num, sizeof(ListaPostings), compararTerminos);
+
+    uint64_t numDocs = (uint64_t)obtenerGrafo()->numDocs;
+    size_t capacidadRanuras = capacidadRanurasSnapshot(terminos.num);
+    RanuraSnapshot *ranuras = calloc(capacidadRanuras, sizeof(RanuraSnapshot));
+    TerminoSnapshot *entradas = calloc(terminos.num ? terminos.num : 1, sizeof(TerminoSnapshot));
+    Documento *tabla = armarTablaDocumentos(numDocs);
+    if (!ranuras || !entradas || !tabla) {
+        fprintf(stderr, "No hay memoria para escribir la instantanea.\n");
+        free(ranuras);
+        free(entradas);
+        free(tabla);
+        free(terminos.listas);
+        return 0;
+    }
+
+    uint64_t offsetPalabra = 0;
+    uint64_t offsetPostings = 0;
+    uint64_t primerSalto = 0;
+    uint64_t offsetPosiciones = 0;
+    int posicional = indicePosicionalActivado();
+    for (size_t t = 0; t < terminos.num; t++) {
+        const ListaPostings *lista = &terminos.listas[t];
+        entradas[t].offsetPalabra = offsetPalabra;
+        entradas[t].offsetPostings = offsetPostings;
+        entradas[t].bytesPostings = lista->bytes;
+        entradas[t].primerSalto = primerSalto;
+        entradas[t].offsetPosiciones = offsetPosiciones;
+        entradas[t].bytesPosiciones = lista->posiciones ? lista->bytesPosiciones : 0;
+        entradas[t].numSaltos = (uint32_t)lista->numSaltos;
+        entradas[t].longitud = (uint32_t)lista->longitud;
+        entradas[t].conteoDocs = (uint32_t)lista->conteoDocs;
+        entradas[t].frecuenciaMaxima = (uint32_t)lista->frecuenciaMaxima;
+        offsetPalabra += lista->longitud + 1;
+        offsetPostings += lista->bytes;
+        primerSalto += (uint64_t)lista->numSaltos;
+        offsetPosiciones += entradas[t].bytesPosiciones;
+        ubicarRanura(ranuras, capacidadRanuras, calcularHash(lista->palabra, lista->longitud), t);
+    }
+
+    EscritorSnapshot e;
+    char *temporal = crearEscritor(&e, ruta);
+    if (!temporal) {
+        free(ranuras);
+        free(entradas);
+        free(tabla);
+        free(terminos.listas);
+        return 0;
+    }
+
+    escribirSeccion(&e, SECCION_RANURAS, ranuras, capacidadRanuras * sizeof(RanuraSnapshot));
+    escribirSeccion(&e, SECCION_TERMINOS, entradas, terminos.num * sizeof(TerminoSnapshot));
+    abrirSeccion(&e, SECCION_PALABRAS);
+    for (size_t t = 0; t < terminos.num; t++) {
+        escribirBytes(&e, terminos.listas[t].palabra, terminos.listas[t].longitud + 1);
+    }
+    cerrarSeccion(&e, SECCION_PALABRAS);
+    abrirSeccion(&e, SECCION_POSTINGS);
+    for (size_t t = 0; t < terminos.num; t++) {
+        escribirBytes(&e, terminos.listas[t].datos, terminos.listas[t].bytes);
+    }
+    cerrarSeccion(&e, SECCION_POSTINGS);
+    abrirSeccion(&e, SECCION_SALTOS);
+    for (size_t t = 0; t < terminos.num; t++) {
+        escribirBytes(&e, terminos.listas[t].saltos, terminos.listas[t].numSaltos * sizeof(SaltoPosting));
+    }
+    cerrarSeccion(&e, SECCION_SALTOS);
+    abrirSeccion(&e, SECCION_POSICIONES);
+    for (size_t t = 0; t < terminos.num; t++) {
+        if (terminos.listas[t].posiciones) {
+            escribirBytes(&e, terminos.listas[t].posiciones, terminos.listas[t].bytesPosiciones);
+        }
+    }
+    cerrarSeccion(&e, SECCION_POSICIONES);
+    abrirSeccion(&e, SECCION_SALTOS_POSICIONES);
+    for (size_t t = 0; posicional && t < terminos.num; t++) {
+        // Una palabra sin posiciones no tiene saltos de posiciones; se rellenan para no correr los indices.
+        for (int b = 0; b < terminos.listas[t].numSaltos; b++) {
+            uint32_t salto = terminos.listas[t].saltosPosiciones ? terminos.listas[t].saltosPosiciones[b] : 0;
+            escribirBytes(&e, &salto, sizeof(salto));
+        }
+    }
+    cerrarSeccion(&e, SECCION_SALTOS_POSICIONES);
+    escribirDocumentosYGrafo(&e, tabla);
+
+    e.cabecera.numTerminos = terminos.num;
+    e.cabecera.capacidadRanuras = capacidadRanuras;
+    int correcto = cerrarEscritor(&e, ruta, temporal, firmaCorpus);
+    free(ranuras);
+    free(entradas);
+    free(tabla);
+    free(terminos.listas);
+    return correcto;
+}
+
+/**
+ * @struct EscritorTerminosSnapshot
+ * @brief Instantanea que recibe sus palabras de a una (ver iniciarSnapshotPorTerminos()).
+ *
+ * Las secciones del diccionario se escriben en archivos temporales sin nombre
+ * junto a la instantanea; en memoria solo queda el hash de cada palabra, con el
+ * que al final se arma la tabla hash.
+ */
+struct EscritorTerminosSnapshot {
+    char *ruta; ///< Ruta final de la instantanea.
+    FILE *secciones[NUM_SECCIONES]; ///< Temporal de cada seccion de TERMINOS a SALTOS_POSICIONES.
+    uint64_t *hashes; ///< Hash de cada palabra, en orden.
+    size_t numTerminos; ///< Palabras recibidas.
+    size_t capacidadHashes; ///< Capacidad reservada de hashes.
+    TerminoSnapshot siguiente; ///< Offsets de la proxima palabra dentro de cada seccion.
+    int error; ///< 1 si fallo alguna escritura o reserva.
+};
+
+/**
+ * @brief Indica si una seccion del diccionario se arma en un archivo temporal.
+ *
+ * @param id Seccion.
+ * @return 1 para las secciones de TERMINOS a SALTOS_POSICIONES.
+ */
+static int seccionPorTerminos(int id) {
+    return id >= SECCION_TERMINOS && id <= SECCION_SALTOS_POSICIONES;
+}
+
+/**
+ * @brief Empieza una instantanea cuyo diccionario se recibe palabra por palabra.
+ *
+ * @param ruta Ruta final de la instantanea; los temporales se crean junto a ella.
+ * @return Escritor, o NULL si no se pudieron crear los temporales.
+ */
+EscritorTerminosSnapshot *iniciarSnapshotPorTerminos(const char *ruta) {
+    EscritorTerminosSnapshot *escritor = calloc(1, sizeof(EscritorTerminosSnapshot));
+    size_t largo = strlen(ruta) + 32;
+    char *temporal = malloc(largo);
+    if (!escritor || !temporal || !(escritor->ruta = strdup(ruta))) {
+        fprintf(stderr, "No hay memoria para escribir la instantanea.\n");
+        free(temporal);
+        if (escritor) {
+            free(escritor->ruta);
+        }
+        free(escritor);
+        return NULL;
+    }
+    for (int id = 0; id < NUM_SECCIONES && !escritor->error; id++) {
+        if (!seccionPorTerminos(id)) {
+            continue;
+        }
+        // El temporal se borra enseguida: el archivo abierto sigue valido y no queda basura si el proceso muere.
+        snprintf(temporal, largo, "%s.tmp.%d", ruta, id);
+        escritor->secciones[id] = fopen(temporal, "w+b");
+        if (!escritor->secciones[id]) {
+            perror("No se pudo crear un temporal de la instantanea");
+            escritor->error = 1;
+        } else {
+            remove(temporal);
+        }
+    }
+    free(temporal);
+    if (escritor->error) {
+        cancelarSnapshotPorTerminos(escritor);
+        return NULL;
+    }
+    return escritor;
+}
+
+/**
+ * @brief Escribe bytes en el temporal de una seccion.
+ *
+ * @param escritor Escritor.
+ * @param id Seccion.
+ * @param datos Bytes a escribir.
+ * @param bytes Numero de bytes.
+ */
+static void escribirTemporal(EscritorTerminosSnapshot *escritor, SeccionSnapshotId id, const void *datos,
+                             size_t bytes) {
+    if (bytes > 0 && fwrite(datos, 1, bytes, escritor->secciones[id]) != bytes) {
+        escritor->error = 1;
+    }
+}
+
+/**
+ * @brief Agrega la siguiente palabra del diccionario.
+ *
+ * @param escritor Escritor.
+ * @param lista Lista de postings completa de la palabra.
+ * @return 1 si se agrego, 0 si fallo la escritura o no hay memoria.
+ */
+int agregarTerminoSnapshot(EscritorTerminosSnapshot *escritor, const ListaPostings *lista) {
+    if (escritor->error) {
+        return 0;
+    }
+    if (escritor->numTerminos == escritor->capacidadHashes) {
+        size_t capacidad = escritor->capacidadHashes ? escritor->capacidadHashes * 2 : 4096;
+        uint64_t *hashes = realloc(escritor->hashes, capacidad * sizeof(uint64_t));
+        if (!hashes) {
+            escritor->error = 1;
+            return 0;
+        }
+        escritor->hashes = hashes;
+        escritor->capacidadHashes = capacidad;
+    }
+    escritor->hashes[escritor->numTerminos++] = calcularHash(lista->palabra, lista->longitud);
+
+    TerminoSnapshot *entrada = &escritor->siguiente;
+    entrada->bytesPostings = lista->bytes;
+    entrada->bytesPosiciones = lista->posiciones ? lista->bytesPosiciones : 0;
+    entrada->numSaltos = (uint32_t)lista->numSaltos;
+    entrada->longitud = (uint32_t)lista->longitud;
+    entrada->conteoDocs = (uint32_t)lista->conteoDocs;
+    entrada->frecuenciaMaxima = (uint32_t)lista->frecuenciaMaxima;
+    escribirTemporal(escritor, SECCION_TERMINOS, entrada, sizeof(TerminoSnapshot));
+    escribirTemporal(escritor, SECCION_PALABRAS, lista->palabra, lista->longitud + 1);
+    escribirTemporal(escritor, SECCION_POSTINGS, lista->datos, lista->bytes);
+    escribirTemporal(escritor, SECCION_SALTOS, lista->saltos, lista->numSaltos * sizeof(SaltoPosting));
+    escribirTemporal(escritor, SECCION_POSICIONES, lista->posiciones, entrada->bytesPosiciones);
+    for (int b = 0; indicePosicionalActivado() && b < lista->numSaltos; b++) {
+        uint32_t salto = lista->saltosPosiciones ? lista->saltosPosiciones[b] : 0;
+        escribirTemporal(escritor, SECCION_SALTOS_POSICIONES, &salto, sizeof(salto));
+    }
+    entrada->offsetPalabra += lista->longitud + 1;
+    entrada->offsetPostings += lista->bytes;
+    entrada->primerSalto += (uint64_t)lista->numSaltos;
+    entrada->offsetPosiciones += entrada->bytesPosiciones;
+    return !escritor->error;
+}
+
+/**
+ * @brief Descarta una instantanea sin terminarla.
+ *
+ * @param escritor Escritor; se libera.
+ */
+void cancelarSnapshotPorTerminos(EscritorTerminosSnapshot *escritor) {
+    escritor->error = 1;
+    terminarSnapshotPorTerminos(escritor, 0);
+}
+
+/**
+ * @brief Copia el temporal de una seccion a la instantanea.
+ *
+ * @param e Escritor de la instantanea.
+ * @param id Seccion.
+ * @param temporal Archivo temporal de la seccion.
+ * @param bufer Bufer de copia.
+ * @param capacidad Bytes del bufer.
+ */
+static void copiarSeccion(EscritorSnapshot *e, SeccionSnapshotId id, FILE *temporal, unsigned char *bufer,
+                          size_t capacidad) {
+    abrirSeccion(e, id);
+    if (fflush(temporal) != 0 || fseek(temporal, 0, SEEK_SET) != 0) {
+        e->error = 1;
+    }
+    size_t leidos;
+    while (!e->error && (leidos = fread(bufer, 1, capacidad, temporal)) > 0) {
+        escribirBytes(e, bufer, leidos);
+    }
+    if (ferror(temporal)) {
+        e->error = 1;
+    }
+    cerrarSeccion(e, id);
+}
+
+/**
+ * @brief Termina la instantanea con la tabla de documentos y el grafo actuales.
+ *
+ * @param escritor Escritor; se libera en cualquier caso.
+ * @param firmaCorpus Firma del directorio indexado.
+ * @return 1 si se escribio correctamente, 0 en caso de error.
+ */
+int terminarSnapshotPorTerminos(EscritorTerminosSnapshot *escritor, uint64_t firmaCorpus) {
+    int correcto = 0;
+    size_t capacidadRanuras = capacidadRanurasSnapshot(escritor->numTerminos);
+    RanuraSnapshot *ranuras = NULL;
+    Documento *tabla = NULL;
+    unsigned char *bufer = NULL;
+    if (!escritor->error) {
+        ranuras = calloc(capacidadRanuras, sizeof(RanuraSnapshot));
+        tabla = armarTablaDocumentos((uint64_t)obtenerGrafo()->numDocs);
+        bufer = malloc(SNAPSHOT_BUFER_COPIA);
+        if (!ranuras || !tabla || !bufer) {
+            fprintf(stderr, "No hay memoria para escribir la instantanea.\n");
+            escritor->error = 1;
+        }
+    }
+    EscritorSnapshot e;
+    char *temporal = escritor->error ? NULL : crearEscritor(&e, escritor->ruta);
+    if (temporal) {
+        for (size_t t = 0; t < escritor->numTerminos; t++) {
+            ubicarRanura(ranuras, capacidadRanuras, escritor->hashes[t], t);
+        }
+        free(escritor->hashes);
+        escritor->hashes = NULL;
+        escribirSeccion(&e, SECCION_RANURAS, ranuras, capacidadRanuras * sizeof(RanuraSnapshot));
+        free(ranuras);
+        ranuras = NULL;
+        for (int id = 0; id < NUM_SECCIONES; id++) {
+            if (seccionPorTerminos(id)) {
+                copiarSeccion(&e, (SeccionSnapshotId)id, escritor->secciones[id], bufer, SNAPSHOT_BUFER_COPIA);
+            }
+        }
+        escribirDocumentosYGrafo(&e, tabla);
+        e.cabecera.numTerminos = escritor->numTerminos;
+        e.cabecera.capacidadRanuras = capacidadRanuras;
+        correcto = cerrarEscritor(&e, escritor->ruta, temporal, firmaCorpus);
+    }
+    for (int id = 0; id < NUM_SECCIONES; id++) {
+        if (escritor->secciones[id]) {
+            fclose(escritor->secciones[id]);
+        }
+    }
+    free(bufer);
+    free(tabla);
+    free(ranuras);
+    free(escritor->hashes);
+    free(escritor->ruta);
+    free(escritor);
+    return correcto;
+}
+
+/**
+ * @brief Comprueba que una seccion este dentro del archivo y tenga el tamano esperado.
+ *
+ * @param c Cabecera del archivo.
+ * @param tamano Tamano del archivo.
+ * @param id Seccion a comprobar.
+ * @param bytesEsperados Tamano que debe tener la seccion, o UINT64_MAX si no se comprueba.
+ * @return 1 si la seccion es valida, 0 en caso contrario.
+ */
+static int seccionValida(const CabeceraSnapshot *c, size_t tamano, SeccionSnapshotId id, uint64_t bytesEsperados) {
+    const SeccionSnapshot *s = &c->secciones[id];
+    if (s->offset % 8 != 0 || s->offset < sizeof(CabeceraSnapshot) || s->offset > tamano ||
+        s->bytes > tamano - s->offset) {
+        return 0;
+    }
+    return bytesEsperados == UINT64_MAX || s->bytes == bytesEsperados;
+}
+
+/**
+ * @brief Libera los conjuntos Roaring armados para los terminos de la instantanea.
+ */
+static void liberarConjuntosSnapshot() {
+    for (size_t t = 0; t < snapshot.numConjuntos; t++) {
+        descartarConjuntoPostings(&snapshot.conjuntos[t]);
+    }
+    free(snapshot.conjuntos);
+    snapshot.conjuntos = NULL;
+    snapshot.numConjuntos = 0;
+}
+
+/**
+ * @brief Abre una instantanea y la usa como indice, tabla de documentos y grafo.
+ *
+ * @param ruta Ruta del archivo de instantanea.
+ * @param firmaCorpus Firma esperada del directorio de documentos.
+ * @return 1 si la instantanea se cargo, 0 en caso contrario.
+ */
+int abrirSnapshot(const char *ruta, uint64_t firmaCorpus) {
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(CabeceraSnapshot)) {
+        close(fd);
+        return 0;
+    }
+    size_t tamano = (size_t)info.st_size;
+    void *mapa = mmap(NULL, tamano, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED) {
+        return 0;
+    }
+
+    const CabeceraSnapshot *c = mapa;
+    const char *motivo = NULL;
+    if (memcmp(c->magia, SNAPSHOT_MAGIA, sizeof(c->magia)) != 0 || c->marcaEndian != SNAPSHOT_MARCA_ENDIAN) {
+        motivo = "formato desconocido";
+    } else if (c->version != SNAPSHOT_VERSION) {
+        motivo = "version distinta";
+    } else if (c->tamanoTotal != tamano || tamano % 8 != 0) {
+        motivo = "tamano incorrecto";
+    } else if (c->firmaCorpus != firmaCorpus) {
+        motivo = "los documentos cambiaron";
+    } else if (c->posiciones != indicePosicionalActivado()) {
+        motivo = "indice posicional distinto";
+    } else if (c->numDocs > INT32_MAX || c->numTerminos > UINT32_MAX - 1 ||
+               (c->capacidadRanuras & (c->capacidadRanuras - 1)) != 0 || c->capacidadRanuras <= c->numTerminos ||
+               !seccionValida(c, tamano, SECCION_RANURAS, c->capacidadRanuras * sizeof(RanuraSnapshot)) ||
+               !seccionValida(c, tamano, SECCION_TERMINOS, c->numTerminos * sizeof(TerminoSnapshot)) ||
+               !seccionValida(c, tamano, SECCION_PALABRAS, UINT64_MAX) ||
+               !seccionValida(c, tamano, SECCION_POSTINGS, UINT64_MAX) ||
+               !seccionValida(c, tamano, SECCION_SALTOS, UINT64_MAX) ||
+               !seccionValida(c, tamano, SECCION_POSICIONES, UINT64_MAX) ||
+               !seccionValida(c, tamano, SECCION_SALTOS_POSICIONES, UINT64_MAX) ||
+               !seccionValida(c, tamano, SECCION_DOCUMENTOS, c->numDocs * sizeof(Documento)) ||
+               !seccionValida(c, tamano, SECCION_NOMBRES, UINT64_MAX) ||
+               !seccionValida(c, tamano, SECCION_INICIO_SALIDA, (c->numDocs + 1) * sizeof(uint64_t)) ||
+               !seccionValida(c, tamano, SECCION_DESTINOS_SALIDA, c->numEnlaces * sizeof(int32_t)) ||
+               !seccionValida(c, tamano, SECCION_INICIO_ENTRADA, (c->numDocs + 1) * sizeof(uint64_t)) ||
+               !seccionValida(c, tamano, SECCION_ORIGENES_ENTRADA, c->numEnlaces * sizeof(int32_t)) ||
+               !seccionValida(c, tamano, SECCION_INVERSO_GRADO, c->numDocs * sizeof(double)) ||
+               !seccionValida(c, tamano, SECCION_PAGERANK, c->numDocs * sizeof(double))) {
+        motivo = "secciones inconsistentes";
+    } else if (sumarBloque((const unsigned char *)mapa + sizeof(CabeceraSnapshot),
+                           tamano - sizeof(CabeceraSnapshot)) != c->sumaVerificacion) {
+        motivo = "suma de verificacion incorrecta";
+    }
+    if (motivo) {
+        printf("Instantanea '%s' descartada: %s.\n", ruta, motivo);
+        munmap(mapa, tamano);
+        return 0;
+    }
+
+    if (snapshot.mapa) {
+        munmap(snapshot.mapa, snapshot.tamano);
+    }
+    liberarConjuntosSnapshot();
+    snapshot.conjuntos = calloc(c->numTerminos ? c->numTerminos : 1, sizeof(*snapshot.conjuntos));
+    if (!snapshot.conjuntos) {
+        perror("No se pudo reservar memoria para la instantanea");
+        exit(EXIT_FAILURE);
+    }
+    snapshot.numConjuntos = c->numTerminos;
+    const char *base = mapa;
+    snapshot.mapa = mapa;
+    snapshot.tamano = tamano;
+    snapshot.cabecera = c;
+    snapshot.ranuras = (const RanuraSnapshot *)(base + c->secciones[SECCION_RANURAS].offset);
+    snapshot.terminos = (const TerminoSnapshot *)(base + c->secciones[SECCION_TERMINOS].offset);
+    snapshot.palabras = base + c->secciones[SECCION_PALABRAS].offset;
+    snapshot.postings = (const unsigned char *)(base + c->secciones[SECCION_POSTINGS].offset);
+    snapshot.saltos = (const SaltoPosting *)(base + c->secciones[SECCION_SALTOS].offset);
+    snapshot.posiciones =
+        c->posiciones ? (const unsigned char *)(base + c->secciones[SECCION_POSICIONES].offset) : NULL;
+    snapshot.saltosPosiciones = (const uint32_t *)(base + c->secciones[SECCION_SALTOS_POSICIONES].offset);
+
+    int numDocs = (int)c->numDocs;
+    usarTablaDocumentosExterna((const Documento *)(base + c->secciones[SECCION_DOCUMENTOS].offset), numDocs,
+                               base + c->secciones[SECCION_NOMBRES].offset,
+                               c->secciones[SECCION_NOMBRES].bytes);
+    usarGrafoExterno(numDocs, c->numEnlaces,
+                     (const size_t *)(base + c->secciones[SECCION_INICIO_SALIDA].offset),
+                     (const int *)(base + c->secciones[SECCION_DESTINOS_SALIDA].offset),
+                     (const size_t *)(base + c->secciones[SECCION_INICIO_ENTRADA].offset),
+                     (const int *)(base + c->secciones[SECCION_ORIGENES_ENTRADA].offset),
+                     (const double *)(base + c->secciones[SECCION_INVERSO_GRADO].offset),
+                     (const double *)(base + c->secciones[SECCION_PAGERANK].offset),
+                     c->iteracionesPageRank, c->residuoPageRank);
+    avanzarVocabularioIndice();
+    return 1;
+}
+
+/**
+ * @brief Busca una palabra en la instantanea abierta.
+ *
+ * Sondea linealmente la tabla hash guardada; las ranuras con otro hash se
+ * descartan sin leer la palabra.
+ *
+ * @param palabra Palabra a buscar.
+ * @param longitud Longitud de la palabra.
+ * @param hash Hash de la palabra obtenido con calcularHash().
+ * @param lista Salida: vista de los postings dentro del archivo proyectado.
+ * @return 1 si la palabra esta en la instantanea, 0 si no esta o no hay instantanea.
+ */
+int buscarPostingsSnapshot(const char *palabra, size_t longitud, uint64_t hash, ListaPostings *lista) {
+    if (!snapshot.mapa || !snapshot.ranuras) {
+        return 0;
+    }
+    size_t mascara = (size_t)snapshot.cabecera->capacidadRanuras - 1;
+    size_t i = (size_t)hash & mascara;
+    while (snapshot.ranuras[i].termino) {
+        if (snapshot.ranuras[i].hash == hash) {
+            const TerminoSnapshot *t = &snapshot.terminos[snapshot.ranuras[i].termino - 1];
+            const char *guardada = snapshot.palabras + t->offsetPalabra;
+            if (t->longitud == longitud && memcmp(guardada, palabra, longitud) == 0) {
+                lista->palabra = guardada;
+                lista->longitud = t->longitud;
+                lista->datos = snapshot.postings + t->offsetPostings;
+                lista->bytes = t->bytesPostings;
+                lista->conteoDocs = (int)t->conteoDocs;
+                lista->saltos = snapshot.saltos + t->primerSalto;
+                lista->numSaltos = (int)t->numSaltos;
+                lista->frecuenciaMaxima = (int)t->frecuenciaMaxima;
+                lista->conjunto = &snapshot.conjuntos[snapshot.ranuras[i].termino - 1];
+                if (snapshot.posiciones) {
+                    lista->posiciones = snapshot.posiciones + t->offsetPosiciones;
+                    lista->bytesPosiciones = t->bytesPosiciones;
+                    lista->saltosPosiciones = snapshot.saltosPosiciones + t->primerSalto;
+                }
+                return 1;
+            }
+        }
+        i = (i + 1) & mascara;
+    }
+    return 0;
+}
+
+/**
+ * @brief Devuelve el numero de palabras de la instantanea abierta.
+ *
+ * @return Palabras del diccionario guardado, o 0 si no hay instantanea.
+ */
+int totalPalabrasSnapshot() {
+    return snapshot.mapa && snapshot.ranuras ? (int)snapshot.cabecera->numTerminos : 0;
+}
+
+/**
+ * @brief Recorre todas las palabras del diccionario de la instantanea abierta.
+ *
+ * @param visitar Funcion llamada con la lista de postings de cada palabra.
+ * @param contexto Puntero que se pasa sin cambios a visitar.
+ */
+void recorrerSnapshot(void (*visitar)(const ListaPostings *lista, void *contexto), void *contexto) {
+    if (!snapshot.mapa || !snapshot.ranuras) {
+        return;
+    }
+    for (uint64_t t = 0; t < snapshot.cabecera->numTerminos; t++) {
+        const TerminoSnapshot *termino = &snapshot.terminos[t];
+        ListaPostings lista;
+        memset(&lista, 0, sizeof(lista));
+        lista.palabra = snapshot.palabras + termino->offsetPalabra;
+        lista.longitud = termino->longitud;
+        lista.datos = snapshot.postings + termino->offsetPostings;
+        lista.bytes = termino->bytesPostings;
+        lista.conteoDocs = (int)termino->conteoDocs;
+        lista.saltos = snapshot.saltos + termino->primerSalto;
+        lista.numSaltos = (int)termino->numSaltos;
+        lista.frecuenciaMaxima = (int)termino->frecuenciaMaxima;
+        lista.conjunto = &snapshot.conjuntos[t];
+        if (snapshot.posiciones) {
+            lista.posiciones = snapshot.posiciones + termino->offsetPosiciones;
+            lista.bytesPosiciones = termino->bytesPosiciones;
+            lista.saltosPosiciones = snapshot.saltosPosiciones + termino->primerSalto;
+        }
+        visitar(&lista, contexto);
+    }
+}
+
+/**
+ * @brief Deja de usar el diccionario y los postings de la instantanea.
+ *
+ * El archivo sigue proyectado porque la tabla de documentos y el grafo pueden
+ * apuntar a el.
+ */
+void descartarDiccionarioSnapshot() {
+    snapshot.ranuras = NULL;
+    avanzarVocabularioIndice();
+    liberarConjuntosSnapshot();
+}
@@ -0,0 +1,210 @@
+/**
+ * @file snapshot.h
+ * @brief Instantanea binaria del indice, la tabla de documentos, el grafo y el PageRank.
+ *
+ * La instantanea se escribe despues de cargar los documentos y calcular el PageRank.
+ * En el siguiente arranque se proyecta con mmap en modo de solo lectura y las
+ * busquedas leen el diccionario y los postings directamente del archivo.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "index.h"
+
+#define SNAPSHOT_MAGIA "TAR3IDX" ///< Identificador al inicio del archivo (8 bytes con el '\0').
+#define SNAPSHOT_VERSION 4 ///< Version del formato; se incrementa con cada cambio incompatible.
+#define SNAPSHOT_MARCA_ENDIAN 0x01020304u ///< Detecta archivos escritos con otro orden de bytes.
+#define SNAPSHOT_RUTA_DEFECTO "indice.snap" ///< Ruta de la instantanea si no se indica otra.
+
+/**
+ * @brief Secciones del archivo, en el orden en que se escriben.
+ */
+typedef enum {
+    SECCION_RANURAS, ///< Tabla hash del diccionario (RanuraSnapshot).
+    SECCION_TERMINOS, ///< Entradas del diccionario (TerminoSnapshot), ordenadas por palabra.
+    SECCION_PALABRAS, ///< Bytes de las palabras, cada una terminada en '\0'.
+    SECCION_POSTINGS, ///< Postings comprimidos de todas las palabras.
+    SECCION_SALTOS, ///< Punteros de salto de todas las palabras (SaltoPosting).
+    SECCION_POSICIONES, ///< Posiciones codificadas de todas las palabras (vacia sin indice posicional).
+    SECCION_SALTOS_POSICIONES, ///< Inicio en posiciones de cada bloque siguiente (uint32_t, uno por salto).
+    SECCION_DOCUMENTOS, ///< Tabla de documentos (Documento), con la longitud de cada uno.
+    SECCION_NOMBRES, ///< Almacen de nombres de documentos.
+    SECCION_INICIO_SALIDA, ///< CSR: inicio de enlaces salientes (uint64_t).
+    SECCION_DESTINOS_SALIDA, ///< CSR: destinos (int32_t).
+    SECCION_INICIO_ENTRADA, ///< CSC: inicio de enlaces entrantes (uint64_t).
+    SECCION_ORIGENES_ENTRADA, ///< CSC: origenes (int32_t).
+    SECCION_INVERSO_GRADO, ///< Inverso del grado de salida (double).
+    SECCION_PAGERANK, ///< Vector de PageRank (double).
+    NUM_SECCIONES ///< Numero de secciones.
+} SeccionSnapshotId;
+
+/**
+ * @struct SeccionSnapshot
+ * @brief Posicion y tamano de una seccion dentro del archivo.
+ */
+typedef struct {
+    uint64_t offset; ///< Posicion desde el inicio del archivo (alineada a 8 bytes).
+    uint64_t bytes; ///< Tamano en bytes.
+} SeccionSnapshot;
+
+/**
+ * @struct CabeceraSnapshot
+ * @brief Cabecera fija al inicio del archivo.
+ *
+ * La suma de verificacion cubre todo lo que sigue a la cabecera. Todas las
+ * secciones empiezan en multiplos de 8 bytes y se rellenan con ceros.
+ */
+typedef struct {
+    char magia[8]; ///< SNAPSHOT_MAGIA.
+    uint32_t version; ///< SNAPSHOT_VERSION.
+    uint32_t marcaEndian; ///< SNAPSHOT_MARCA_ENDIAN.
+    uint64_t sumaVerificacion; ///< Suma de 64 bits, por palabras de 8 bytes, del contenido posterior a la cabecera.
+    uint64_t tamanoTotal; ///< Tamano del archivo en bytes.
+    uint64_t firmaCorpus; ///< Firma del directorio de documentos indexado.
+    uint64_t numTerminos; ///< Palabras del diccionario.
+    uint64_t capacidadRanuras; ///< Ranuras de la tabla hash (potencia de dos).
+    uint64_t numDocs; ///< Documentos del grafo y de la tabla de documentos.
+    uint64_t numEnlaces; ///< Enlaces del grafo.
+    int32_t iteracionesPageRank; ///< Iteraciones del PageRank guardado.
+    int32_t posiciones; ///< 1 si se escribio con el indice posicional.
+    double residuoPageRank; ///< Residuo del PageRank guardado.
+    SeccionSnapshot secciones[NUM_SECCIONES]; ///< Tabla de secciones.
+} CabeceraSnapshot;
+
+/**
+ * @struct RanuraSnapshot
+ * @brief Ranura de la tabla hash del diccionario guardado.
+ */
+typedef struct {
+    uint64_t hash; ///< Hash de la palabra.
+    uint32_t termino; ///< Indice en la seccion de terminos + 1, o 0 si esta vacia.
+    uint32_t reservado; ///< Relleno, siempre 0.
+} RanuraSnapshot;
+
+/**
+ * @struct TerminoSnapshot
+ * @brief Entrada del diccionario guardado.
+ */
+typedef struct {
+    uint64_t offsetPalabra; ///< Posicion de la palabra en la seccion de palabras.
+    uint64_t offsetPostings; ///< Posicion de los postings en la seccion de postings.
+    uint64_t bytesPostings; ///< Bytes de postings.
+    uint64_t primerSalto; ///< Indice del primer puntero de salto en la seccion de saltos.
+    uint64_t offsetPosiciones; ///< Posicion de las posiciones en la seccion de posiciones.
+    uint64_t bytesPosiciones; ///< Bytes de posiciones.
+    uint32_t numSaltos; ///< Punteros de salto de la palabra.
+    uint32_t longitud; ///< Longitud de la palabra.
+    uint32_t conteoDocs; ///< Documentos en la lista de postings.
+    uint32_t frecuenciaMaxima; ///< Mayor frecuencia de la palabra en un documento.
+} TerminoSnapshot;
+
+/**
+ * @brief Escribe la instantanea del estado actual del indice y del grafo.
+ *
+ * Se escribe primero a un archivo temporal que luego se renombra, de modo que
+ * una escritura interrumpida nunca deja una instantanea a medias.
+ *
+ * @param ruta Ruta del archivo de instantanea.
+ * @param firmaCorpus Firma del directorio indexado (ver calcularFirmaCorpus()).
+ * @return 1 si se escribio correctamente, 0 en caso de error.
+ */
+int guardarSnapshot(const char *ruta, uint64_t firmaCorpus);
+
+/**
+ * @brief Instantanea en escritura cuyo diccionario llega palabra por palabra.
+ */
+typedef struct EscritorTerminosSnapshot EscritorTerminosSnapshot;
+
+/**
+ * @brief Empieza una instantanea cuyo diccionario se recibe palabra por palabra.
+ *
+ * Sirve para escribir un indice que no entra en memoria (ver externo.h): cada
+ * palabra se pasa con agregarTerminoSnapshot(), en orden creciente de bytes, y
+ * sus postings pueden liberarse enseguida. Las secciones se acumulan en archivos
+ * temporales junto a la instantanea; en memoria solo quedan 8 bytes por palabra.
+ *
+ * @param ruta Ruta final de la instantanea.
+ * @return Escritor, o NULL si no se pudieron crear los archivos temporales.
+ */
+EscritorTerminosSnapshot *iniciarSnapshotPorTerminos(const char *ruta);
+
+/**
+ * @brief Agrega la siguiente palabra del diccionario.
+ *
+ * @param escritor Escritor.
+ * @param lista Lista de postings completa de la palabra, sin segmentos delta;
+ *              la palabra debe ser mayor (por bytes) que la anterior.
+ * @return 1 si se agrego, 0 si fallo la escritura o no hay memoria.
+ */
+int agregarTerminoSnapshot(EscritorTerminosSnapshot *escritor, const ListaPostings *lista);
+
+/**
+ * @brief Termina la instantanea con la tabla de documentos y el grafo actuales.
+ *
+ * Como guardarSnapshot(), escribe a un temporal que luego se renombra.
+ *
+ * @param escritor Escritor; se libera en cualquier caso.
+ * @param firmaCorpus Firma del directorio indexado (ver calcularFirmaCorpus()).
+ * @return 1 si se escribio correctamente, 0 en caso de error.
+ */
+int terminarSnapshotPorTerminos(EscritorTerminosSnapshot *escritor, uint64_t firmaCorpus);
+
+/**
+ * @brief Descarta una instantanea sin terminarla; no se escribe ningun archivo.
+ *
+ * @param escritor Escritor; se libera.
+ */
+void cancelarSnapshotPorTerminos(EscritorTerminosSnapshot *escritor);
+
+/**
+ * @brief Abre una instantanea y la usa como indice, tabla de documentos y grafo.
+ *
+ * Comprueba la magia, la version, el orden de bytes, el tamano, la suma de
+ * verificacion y la firma del corpus. Si algo no coincide no modifica nada y
+ * devuelve 0, para que el llamador reconstruya el indice desde los documentos.
+ *
+ * @param ruta Ruta del archivo de instantanea.
+ * @param firmaCorpus Firma esperada del directorio de documentos.
+ * @return 1 si la instantanea se cargo, 0 en caso contrario.
+ */
+int abrirSnapshot(const char *ruta, uint64_t firmaCorpus);
+
+/**
+ * @brief Busca una palabra en la instantanea abierta.
+ *
+ * @param palabra Palabra a buscar.
+ * @param longitud Longitud de la palabra.
+ * @param hash Hash de la palabra obtenido con calcularHash().
+ * @param lista Salida: vista de los postings dentro del archivo proyectado.
+ * @return 1 si la palabra esta en la instantanea, 0 si no esta o no hay instantanea.
+ */
+int buscarPostingsSnapshot(const char *palabra, size_t longitud, uint64_t hash, ListaPostings *lista);
+
+/**
+ * @brief Devuelve el numero de palabras de la instantanea abierta.
+ *
+ * @return Palabras del diccionario guardado, o 0 si no hay instantanea.
+ */
+int totalPalabrasSnapshot();
+
+/**
+ * @brief Recorre todas las palabras del diccionario de la instantanea abierta.
+ *
+ * @param visitar Funcion llamada con la lista de postings de cada palabra.
+ * @param contexto Puntero que se pasa sin cambios a visitar.
+ */
+void recorrerSnapshot(void (*visitar)(const ListaPostings *lista, void *contexto), void *contexto);
+
+/**
+ * @brief Deja de usar el diccionario y los postings de la instantanea.
+ *
+ * Se llama cuando el indice en memoria pasa a contener todas las palabras, por
+ * ejemplo despues de fusionar los cambios incrementales. El archivo sigue
+ * proyectado porque la tabla de documentos y el grafo pueden apuntar a el.
+ */
+void descartarDiccionarioSnapshot();
+
+#endif
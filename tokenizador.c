@@ -0,0 +1,396 @@
+/**
+ * @file tokenizador.c
+ * @brief Implementacion del tokenizador y del conjunto de stopwords.
+ */
+
+#include "tokenizador.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define STOPWORDS_RANURAS (2 * TOKENIZADOR_MAX_STOPWORDS) ///< Ranuras de la tabla de stopwords (potencia de dos).
+
+/**
+ * @struct RanuraStopword
+ * @brief Ranura de la tabla hash de stopwords.
+ */
+typedef struct {
+    uint64_t hash; ///< Hash de la palabra.
+    uint32_t offset; ///< Posicion de la palabra en textoStopwords.
+    uint32_t longitud; ///< Longitud de la palabra; 0 si la ranura esta vacia.
+} RanuraStopword;
+
+static RanuraStopword ranurasStopwords[STOPWORDS_RANURAS];
+static char *textoStopwords = NULL;
+static size_t bytesStopwords = 0;
+static int numStopwords = 0;
+static size_t largoMaximoStopword = 0;
+static uint64_t firmaStopwords = 0;
+static pthread_once_t stopwordsIniciadas = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Forma normalizada de cada caracter entre U+00C0 y U+00FF.
+ *
+ * Las vocales y la "c" pierden el acento; la "ñ" y las letras sin equivalente
+ * ASCII solo pasan a minuscula. NULL indica un signo que separa palabras.
+ */
+static const char *const plegadoLatin1[64] = {
+    "a", "a", "a", "a", "a", "a", "\xc3\xa6", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    "\xc3\xb0", "\xc3\xb1", "o", "o", "o", "o", "o", NULL, "o", "u", "u", "u", "u", "y", "\xc3\xbe", "\xc3\x9f",
+    "a", "a", "a", "a", "a", "a", "\xc3\xa6", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    "\xc3\xb0", "\xc3\xb1", "o", "o", "o", "o", "o", NULL, "o", "u", "u", "u", "u", "y", "\xc3\xbe", "y",
+};
+
+/**
+ * @brief Calcula el hash FNV-1a de 64 bits de una palabra.
+ *
+ * Las stopwords son cortas, asi que basta un hash byte a byte sin dependencias.
+ *
+ * @param palabra Palabra.
+ * @param longitud Longitud en bytes.
+ * @return Hash de la palabra.
+ */
+static uint64_t hashStopword(const char *palabra, size_t longitud) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < longitud; i++) {
+        hash = (hash ^ (unsigned char)palabra[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Indica si un byte ASCII es letra o digito.
+ *
+ * @param b Byte.
+ * @return 1 si es [A-Za-z0-9].
+ */
+static int esAlfanumericoAscii(unsigned char b) {
+    return (unsigned)((b | 0x20) - 'a') < 26 || (unsigned)(b - '0') < 10;
+}
+
+/**
+ * @brief Indica si un byte es continuacion de una secuencia UTF-8.
+ *
+ * @param b Byte.
+ * @return 1 si es de la forma 10xxxxxx.
+ */
+static int esContinuacion(unsigned char b) {
+    return (b & 0xC0) == 0x80;
+}
+
+/**
+ * @brief Decodifica el caracter que empieza en p.
+ *
+ * Si los bytes no forman una secuencia UTF-8 valida (truncada, demasiado larga o
+ * sustituto), el primer byte se toma como un caracter Latin-1.
+ *
+ * @param p Primer byte, mayor o igual que 0x80.
+ * @param fin Fin del texto.
+ * @param bytes Salida: bytes que ocupa el caracter.
+ * @return Punto de codigo.
+ */
+static uint32_t leerCaracter(const unsigned char *p, const unsigned char *fin, int *bytes) {
+    size_t resto = (size_t)(fin - p);
+    unsigned char b = p[0];
+    if (b >= 0xC2 && b <= 0xDF && resto >= 2 && esContinuacion(p[1])) {
+        *bytes = 2;
+        return ((uint32_t)(b & 0x1F) << 6) | (p[1] & 0x3F);
+    }
+    if (b >= 0xE0 && b <= 0xEF && resto >= 3 && esContinuacion(p[1]) && esContinuacion(p[2])) {
+        uint32_t c = ((uint32_t)(b & 0x0F) << 12) | ((uint32_t)(p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+        if (c >= 0x800 && (c < 0xD800 || c > 0xDFFF)) {
+            *bytes = 3;
+            return c;
+        }
+    }
+    if (b >= 0xF0 && b <= 0xF4 && resto >= 4 && esContinuacion(p[1]) && esContinuacion(p[2]) &&
+        esContinuacion(p[3])) {
+        uint32_t c = ((uint32_t)(b & 0x07) << 18) | ((uint32_t)(p[1] & 0x3F) << 12) |
+                     ((uint32_t)(p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+        if (c >= 0x10000 && c <= 0x10FFFF) {
+            *bytes = 4;
+            return c;
+        }
+    }
+    *bytes = 1;
+    return b;
+}
+
+/**
+ * @brief Indica si un caracter no ASCII separa palabras.
+ *
+ * Separan los controles y signos de Latin-1 (incluidos "¿", "¡", "«" y el espacio
+ * duro), la puntuacion general de Unicode, la puntuacion CJK, la marca de orden
+ * de bytes y el caracter de reemplazo.
+ *
+ * @param c Punto de codigo, mayor o igual que 0x80.
+ * @return 1 si separa palabras.
+ */
+static int esSeparadorUnicode(uint32_t c) {
+    if (c < 0xC0) {
+        return 1;
+    }
+    if (c < 0x100) {
+        return plegadoLatin1[c - 0xC0] == NULL;
+    }
+    return (c >= 0x2000 && c <= 0x206F) || (c >= 0x2E00 && c <= 0x2E7F) || (c >= 0x3000 && c <= 0x303F) ||
+           c == 0xFEFF || c == 0xFFFD;
+}
+
+#if defined(__SSE2__)
+/**
+ * @brief Copia en minusculas hasta 16 letras o digitos ASCII.
+ *
+ * Clasifica 16 bytes a la vez con comparaciones con signo: los bytes de 0x80 en
+ * adelante son negativos y nunca caen en los rangos de letras o digitos. Escribe
+ * siempre 16 bytes en salida, pero solo los primeros valen.
+ *
+ * @param p Texto, con al menos 16 bytes disponibles.
+ * @param salida Destino, con al menos 16 bytes disponibles.
+ * @return Cantidad de bytes iniciales que son letras o digitos (0 a 16).
+ */
+static size_t copiarAsciiSimd(const unsigned char *p, unsigned char *salida) {
+    __m128i c = _mm_loadu_si128((const __m128i *)p);
+    __m128i minuscula = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i letra = _mm_and_si128(_mm_cmpgt_epi8(minuscula, _mm_set1_epi8('a' - 1)),
+                                  _mm_cmplt_epi8(minuscula, _mm_set1_epi8('z' + 1)));
+    __m128i digito = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                   _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    _mm_storeu_si128((__m128i *)salida, _mm_or_si128(_mm_and_si128(letra, minuscula), _mm_andnot_si128(letra, c)));
+    unsigned mascara = (unsigned)_mm_movemask_epi8(_mm_or_si128(letra, digito));
+    return mascara == 0xFFFF ? 16 : (size_t)__builtin_ctz(~mascara);
+}
+#endif
+
+/**
+ * @brief Prepara la lectura de un texto.
+ *
+ * @param t Tokenizador.
+ * @param texto Texto (no necesita terminar en '\0').
+ * @param longitud Longitud del texto en bytes.
+ */
+void iniciarTokenizador(Tokenizador *t, const char *texto, size_t longitud) {
+    t->actual = (const unsigned char *)texto;
+    t->fin = t->actual + longitud;
+}
+
+/**
+ * @brief Lee la siguiente palabra del texto y la normaliza.
+ *
+ * Salta separadores y copia caracteres hasta el siguiente separador o hasta
+ * llenar TOKENIZADOR_LARGO_MAXIMO bytes; en ese caso el resto de la palabra sale
+ * en la llamada siguiente. Un caracter de varios bytes nunca se parte.
+ *
+ * @param t Tokenizador.
+ * @param destino Bufer de al menos TOKENIZADOR_LARGO_MAXIMO + 1 bytes.
+ * @return Longitud de la palabra en bytes, o 0 si el texto se termino.
+ */
+size_t siguienteToken(Tokenizador *t, char *destino) {
+    const unsigned char *p = t->actual;
+    const unsigned char *fin = t->fin;
+    unsigned char *salida = (unsigned char *)destino;
+    size_t n = 0;
+    int bytes;
+    int enlace = 0;
+
+    while (p < fin && !esAlfanumericoAscii(*p)) {
+        if (*p < 0x80) {
+            p++;
+        } else if (esSeparadorUnicode(leerCaracter(p, fin, &bytes))) {
+            p += bytes;
+        } else {
+            break;
+        }
+    }
+
+    while (p < fin) {
+#if defined(__SSE2__)
+        if (fin - p >= 16 && TOKENIZADOR_LARGO_MAXIMO - n >= 16) {
+            size_t copiados = copiarAsciiSimd(p, salida + n);
+            p += copiados;
+            n += copiados;
+            if (copiados == 16) {
+                continue;
+            }
+        }
+#endif
+        unsigned char b = *p;
+        if (b < 0x80) {
+            if (esAlfanumericoAscii(b)) {
+                if (n == TOKENIZADOR_LARGO_MAXIMO) {
+                    break;
+                }
+                salida[n++] = (unsigned char)((unsigned)(b - 'A') < 26 ? b | 0x20 : b);
+                p++;
+                continue;
+            }
+            // "link:N" y "link:nombre" marcan un enlace: el ':' queda dentro de la palabra y, en
+            // el nombre, tambien los '.', '-' y '_' de un nombre de archivo.
+            if (b == ':' && n == 4 && memcmp(salida, "link", 4) == 0 && fin - p >= 2 && esAlfanumericoAscii(p[1])) {
+                salida[n++] = ':';
+                p++;
+                enlace = 1;
+                continue;
+            }
+            if (enlace && (b == '.' || b == '-' || b == '_') && n < TOKENIZADOR_LARGO_MAXIMO) {
+                salida[n++] = b;
+                p++;
+                continue;
+            }
+            break;
+        }
+        uint32_t c = leerCaracter(p, fin, &bytes);
+        if (esSeparadorUnicode(c)) {
+            break;
+        }
+        const char *forma = c < 0x100 ? plegadoLatin1[c - 0xC0] : (const char *)p;
+        size_t largo = c < 0x100 ? strlen(forma) : (size_t)bytes;
+        if (n + largo > TOKENIZADOR_LARGO_MAXIMO) {
+            break;
+        }
+        memcpy(salida + n, forma, largo);
+        n += largo;
+        p += bytes;
+    }
+
+    // La puntuacion al final de un enlace ("ver link:a.txt.") no es parte del nombre.
+    while (enlace && (salida[n - 1] == '.' || salida[n - 1] == '-' || salida[n - 1] == '_')) {
+        n--;
+    }
+    t->actual = p;
+    salida[n] = '\0';
+    return n;
+}
+
+/**
+ * @brief Agrega una palabra normalizada al conjunto de stopwords.
+ *
+ * @param palabra Palabra.
+ * @param longitud Longitud de la palabra (mayor que 0).
+ * @return 1 si se agrego, 0 si ya estaba o el conjunto esta lleno.
+ */
+static int agregarStopword(const char *palabra, size_t longitud) {
+    uint64_t hash = hashStopword(palabra, longitud);
+    size_t i = (size_t)hash & (STOPWORDS_RANURAS - 1);
+    while (ranurasStopwords[i].longitud) {
+        const RanuraStopword *r = &ranurasStopwords[i];
+        if (r->hash == hash && r->longitud == longitud && memcmp(textoStopwords + r->offset, palabra, longitud) == 0) {
+            return 0;
+        }
+        i = (i + 1) & (STOPWORDS_RANURAS - 1);
+    }
+    if (numStopwords == TOKENIZADOR_MAX_STOPWORDS) {
+        return 0;
+    }
+    char *texto = realloc(textoStopwords, bytesStopwords + longitud);
+    if (!texto) {
+        perror("No se pudo reservar memoria para las stopwords");
+        exit(EXIT_FAILURE);
+    }
+    textoStopwords = texto;
+    memcpy(textoStopwords + bytesStopwords, palabra, longitud);
+    ranurasStopwords[i].hash = hash;
+    ranurasStopwords[i].offset = (uint32_t)bytesStopwords;
+    ranurasStopwords[i].longitud = (uint32_t)longitud;
+    bytesStopwords += longitud;
+    numStopwords++;
+    if (longitud > largoMaximoStopword) {
+        largoMaximoStopword = longitud;
+    }
+    // La suma no depende del orden en que se agregan las palabras.
+    firmaStopwords += hash;
+    return 1;
+}
+
+/**
+ * @brief Vacia el conjunto de stopwords.
+ */
+static void vaciarStopwords() {
+    memset(ranurasStopwords, 0, sizeof(ranurasStopwords));
+    bytesStopwords = 0;
+    numStopwords = 0;
+    largoMaximoStopword = 0;
+    firmaStopwords = 0;
+}
+
+/**
+ * @brief Carga las stopwords por defecto.
+ */
+static void cargarStopwordsPorDefecto() {
+    static const char *const porDefecto[] = {"el", "la", "los", "las", "un", "una", "de", "y", "en", "que", NULL};
+    for (int i = 0; porDefecto[i]; i++) {
+        agregarStopword(porDefecto[i], strlen(porDefecto[i]));
+    }
+}
+
+/**
+ * @brief Reemplaza el conjunto de stopwords por las palabras de un archivo.
+ *
+ * @param ruta Ruta del archivo.
+ * @return Numero de stopwords cargadas, o -1 si el archivo no se pudo leer.
+ */
+int cargarStopwords(const char *ruta) {
+    pthread_once(&stopwordsIniciadas, cargarStopwordsPorDefecto);
+    FILE *archivo = fopen(ruta, "r");
+    if (!archivo) {
+        perror("No se pudo abrir el archivo de stopwords");
+        return -1;
+    }
+    vaciarStopwords();
+    char linea[512];
+    char palabra[TOKENIZADOR_LARGO_MAXIMO + 1];
+    while (fgets(linea, sizeof(linea), archivo)) {
+        if (linea[0] == '#') {
+            continue;
+        }
+        Tokenizador t;
+        iniciarTokenizador(&t, linea, strcspn(linea, "\r\n"));
+        size_t longitud = siguienteToken(&t, palabra);
+        if (longitud > 0 && !agregarStopword(palabra, longitud) && numStopwords == TOKENIZADOR_MAX_STOPWORDS) {
+            fprintf(stderr, "Se ignoran las stopwords despues de las primeras %d.\n", TOKENIZADOR_MAX_STOPWORDS);
+            break;
+        }
+    }
+    fclose(archivo);
+    return numStopwords;
+}
+
+/**
+ * @brief Determina si una palabra normalizada es una stopword.
+ *
+ * @param palabra Palabra normalizada.
+ * @param longitud Longitud de la palabra en bytes.
+ * @return 1 si la palabra es una stopword, 0 en caso contrario.
+ */
+int esStopword(const char *palabra, size_t longitud) {
+    pthread_once(&stopwordsIniciadas, cargarStopwordsPorDefecto);
+    if (longitud == 0 || longitud > largoMaximoStopword) {
+        return 0;
+    }
+    uint64_t hash = hashStopword(palabra, longitud);
+    size_t i = (size_t)hash & (STOPWORDS_RANURAS - 1);
+    while (ranurasStopwords[i].longitud) {
+        const RanuraStopword *r = &ranurasStopwords[i];
+        if (r->hash == hash && r->longitud == longitud && memcmp(textoStopwords + r->offset, palabra, longitud) == 0) {
+            return 1;
+        }
+        i = (i + 1) & (STOPWORDS_RANURAS - 1);
+    }
+    return 0;
+}
+
+/**
+ * @brief Devuelve una firma de la normalizacion y del conjunto de stopwords.
+ *
+ * @return Firma de 64 bits.
+ */
+uint64_t firmaTokenizador() {
+    pthread_once(&stopwordsIniciadas, cargarStopwordsPorDefecto);
+    uint64_t datos[3] = {TOKENIZADOR_VERSION, (uint64_t)numStopwords, firmaStopwords};
+    return hashStopword((const char *)datos, sizeof(datos));
+}
@@ -0,0 +1,87 @@
+/**
+ * @file tokenizador.h
+ * @brief Separacion del texto en palabras normalizadas y conjunto de stopwords.
+ *
+ * Una palabra es una secuencia de letras y digitos; todo lo demas (espacios,
+ * signos de puntuacion ASCII, Latin-1 y Unicode) la termina. El texto se lee como
+ * UTF-8 y, si una secuencia no es UTF-8 valido, cada byte se toma como Latin-1.
+ * Las letras se pasan a minusculas y se les quitan los acentos (la "ñ" se
+ * conserva); los caracteres fuera de Latin-1 se copian sin cambios. El tramo ASCII
+ * de cada palabra se procesa de a 16 bytes con SSE2 cuando esta disponible.
+ *
+ * Los tokens "link:N" y "link:nombre" se conservan enteros, porque marcan enlaces
+ * del grafo; en el nombre se admiten ademas '.', '-' y '_' (ver enlaces.h).
+ */
+
+#ifndef TOKENIZADOR_H
+#define TOKENIZADOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TOKENIZADOR_LARGO_MAXIMO 99 ///< Bytes maximos de una palabra normalizada; las mas largas se parten.
+#define TOKENIZADOR_MAX_STOPWORDS 4096 ///< Stopwords que admite el conjunto.
+#define TOKENIZADOR_VERSION 2 ///< Cambia cuando cambia la normalizacion; invalida las instantaneas.
+
+/**
+ * @struct Tokenizador
+ * @brief Posicion de lectura dentro de un texto.
+ */
+typedef struct {
+    const unsigned char *actual; ///< Proximo byte a leer.
+    const unsigned char *fin; ///< Fin del texto.
+} Tokenizador;
+
+/**
+ * @brief Prepara la lectura de un texto.
+ *
+ * @param t Tokenizador.
+ * @param texto Texto (no necesita terminar en '\0').
+ * @param longitud Longitud del texto en bytes.
+ */
+void iniciarTokenizador(Tokenizador *t, const char *texto, size_t longitud);
+
+/**
+ * @brief Lee la siguiente palabra del texto y la normaliza.
+ *
+ * @param t Tokenizador.
+ * @param destino Bufer de al menos TOKENIZADOR_LARGO_MAXIMO + 1 bytes; recibe la
+ *                palabra terminada en '\0'.
+ * @return Longitud de la palabra en bytes, o 0 si el texto se termino.
+ */
+size_t siguienteToken(Tokenizador *t, char *destino);
+
+/**
+ * @brief Reemplaza el conjunto de stopwords por las palabras de un archivo.
+ *
+ * El archivo tiene una palabra por linea; las lineas vacias y las que empiezan
+ * con '#' se ignoran. Cada palabra se normaliza igual que el texto indexado.
+ * Debe llamarse antes de cargar documentos.
+ *
+ * @param ruta Ruta del archivo.
+ * @return Numero de stopwords cargadas, o -1 si el archivo no se pudo leer.
+ */
+int cargarStopwords(const char *ruta);
+
+/**
+ * @brief Determina si una palabra normalizada es una stopword.
+ *
+ * Las stopwords son palabras comunes que no se indexan, como "el", "la", "y".
+ * La busqueda cuesta un hash y, casi siempre, una sola comparacion.
+ *
+ * @param palabra Palabra normalizada.
+ * @param longitud Longitud de la palabra en bytes.
+ * @return 1 si la palabra es una stopword, 0 en caso contrario.
+ */
+int esStopword(const char *palabra, size_t longitud);
+
+/**
+ * @brief Devuelve una firma de la normalizacion y del conjunto de stopwords.
+ *
+ * Cambia si cambia TOKENIZADOR_VERSION o las stopwords, que alteran el indice.
+ *
+ * @return Firma de 64 bits.
+ */
+uint64_t firmaTokenizador();
+
+#endif